@@ -109,6 +109,13 @@ typedef struct
 #endif
 } NETSOCKET_BUFFER;
 
+typedef struct
+{
+	int num;
+	NETUDPPACKET packets[VLEN];
+	char bufs[VLEN][PACKETSIZE];
+} NETSOCKET_SEND_QUEUE;
+
 void net_buffer_init(NETSOCKET_BUFFER *buffer);
 void net_buffer_reinit(NETSOCKET_BUFFER *buffer);
 void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size);
@@ -122,6 +129,7 @@ struct NETSOCKET_INTERNAL
 	int web_ipv6sock;
 
 	NETSOCKET_BUFFER buffer;
+	NETSOCKET_SEND_QUEUE *send_queue;
 };
 static NETSOCKET_INTERNAL invalid_socket = {NETTYPE_INVALID, -1, -1, -1, -1};
 
@@ -1778,7 +1786,7 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
-int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
+static int priv_net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
 	int d = -1;
 
@@ -1881,6 +1889,146 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 	return d;
 }
 
+int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
+{
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queue;
+	if(!queue)
+		return priv_net_udp_send(sock, addr, data, size);
+
+	if(size < 0 || size > PACKETSIZE)
+	{
+		// keep the order of the packets
+		net_udp_flush(sock);
+		return priv_net_udp_send(sock, addr, data, size);
+	}
+
+	if(queue->num == VLEN)
+		net_udp_flush(sock);
+
+	mem_copy(queue->bufs[queue->num], data, size);
+	queue->packets[queue->num].addr = *addr;
+	queue->packets[queue->num].data = queue->bufs[queue->num];
+	queue->packets[queue->num].size = size;
+	queue->num++;
+	return size;
+}
+
+#if defined(CONF_PLATFORM_LINUX)
+// returns the system socket if the packet can be sent with sendmmsg
+static int priv_net_udp_batch_socket(NETSOCKET sock, const NETADDR *addr)
+{
+	if(addr->type == NETTYPE_IPV4)
+		return sock->ipv4sock;
+	if(addr->type == NETTYPE_IPV6)
+		return sock->ipv6sock;
+	return -1;
+}
+#endif
+
+int net_udp_send_batch(NETSOCKET sock, const NETUDPPACKET *packets, int num)
+{
+	int sent = 0;
+#if defined(CONF_PLATFORM_LINUX)
+	union
+	{
+		sockaddr_in ipv4;
+		sockaddr_in6 ipv6;
+	} sockaddrs[VLEN];
+	mmsghdr msgs[VLEN];
+	iovec iovecs[VLEN];
+
+	int i = 0;
+	while(i < num)
+	{
+		const int system_socket = priv_net_udp_batch_socket(sock, &packets[i].addr);
+		if(system_socket < 0)
+		{
+			// broadcasts, websockets and errors
+			if(priv_net_udp_send(sock, &packets[i].addr, packets[i].data, packets[i].size) >= 0)
+				sent++;
+			i++;
+			continue;
+		}
+
+		// collect the following packets for the same system socket
+		int n = 0;
+		mem_zero(msgs, sizeof(msgs));
+		while(n < VLEN && i + n < num && packets[i + n].addr.type == packets[i].addr.type)
+		{
+			const NETUDPPACKET *packet = &packets[i + n];
+			if(packet->addr.type == NETTYPE_IPV4)
+			{
+				netaddr_to_sockaddr_in(&packet->addr, &sockaddrs[n].ipv4);
+				msgs[n].msg_hdr.msg_namelen = sizeof(sockaddrs[n].ipv4);
+			}
+			else
+			{
+				netaddr_to_sockaddr_in6(&packet->addr, &sockaddrs[n].ipv6);
+				msgs[n].msg_hdr.msg_namelen = sizeof(sockaddrs[n].ipv6);
+			}
+			msgs[n].msg_hdr.msg_name = &sockaddrs[n];
+			iovecs[n].iov_base = (void *)packet->data;
+			iovecs[n].iov_len = packet->size;
+			msgs[n].msg_hdr.msg_iov = &iovecs[n];
+			msgs[n].msg_hdr.msg_iovlen = 1;
+			network_stats.sent_bytes += packet->size;
+			network_stats.sent_packets++;
+			n++;
+		}
+
+		// sendmmsg stops at the first packet that fails, skip it like sendto would
+		int done = 0;
+		while(done < n)
+		{
+			const int result = sendmmsg(system_socket, &msgs[done], n - done, 0);
+			if(result > 0)
+			{
+				sent += result;
+				done += result;
+			}
+			else
+			{
+				done++;
+			}
+		}
+		i += n;
+	}
+#else
+	for(int i = 0; i < num; i++)
+	{
+		if(priv_net_udp_send(sock, &packets[i].addr, packets[i].data, packets[i].size) >= 0)
+			sent++;
+	}
+#endif
+	return sent;
+}
+
+void net_udp_set_send_queue(NETSOCKET sock, bool enabled)
+{
+	if(enabled && !sock->send_queue)
+	{
+		sock->send_queue = (NETSOCKET_SEND_QUEUE *)malloc(sizeof(*sock->send_queue));
+		sock->send_queue->num = 0;
+	}
+	else if(!enabled && sock->send_queue)
+	{
+		net_udp_flush(sock);
+		free(sock->send_queue);
+		sock->send_queue = nullptr;
+	}
+}
+
+int net_udp_flush(NETSOCKET sock)
+{
+	NETSOCKET_SEND_QUEUE *queue = sock->send_queue;
+	if(!queue || queue->num == 0)
+		return 0;
+
+	const int sent = net_udp_send_batch(sock, queue->packets, queue->num);
+	queue->num = 0;
+	return sent;
+}
+
 void net_buffer_init(NETSOCKET_BUFFER *buffer)
 {
 #if defined(CONF_PLATFORM_LINUX)
@@ -2025,6 +2173,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 
 void net_udp_close(NETSOCKET sock)
 {
+	net_udp_set_send_queue(sock, false);
 	priv_net_close_all_sockets(sock);
 }
 
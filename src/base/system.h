@@ -1040,6 +1040,50 @@ NETSOCKET net_udp_create(NETADDR bindaddr);
  */
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size);
 
+/**
+ * Sends multiple packets over an UDP socket, using as few system calls as
+ * possible. The packets are sent in the given order.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ * @param packets Packets to send.
+ * @param num Number of packets.
+ *
+ * @return The number of packets that were sent successfully.
+ *
+ * @remark Packets that fail to send are skipped like with @link net_udp_send @endlink,
+ *         the remaining packets are still sent.
+ * @remark Uses `sendmmsg` on Linux and sends the packets one by one elsewhere.
+ */
+int net_udp_send_batch(NETSOCKET sock, const NETUDPPACKET *packets, int num);
+
+/**
+ * Enables or disables the send queue of an UDP socket. While enabled,
+ * @link net_udp_send @endlink only copies the packets into the queue,
+ * which is sent with @link net_udp_send_batch @endlink once it is full
+ * or @link net_udp_flush @endlink is called.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ * @param enabled Whether packets should be queued.
+ *
+ * @remark Disabling the queue flushes it.
+ */
+void net_udp_set_send_queue(NETSOCKET sock, bool enabled);
+
+/**
+ * Sends the packets in the send queue of an UDP socket.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ *
+ * @return The number of packets that were sent successfully.
+ */
+int net_udp_flush(NETSOCKET sock);
+
 /**
  * Receives a packet over an UDP socket.
  *
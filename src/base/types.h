@@ -96,6 +96,18 @@ typedef struct NETSTATS
 	uint64_t recv_bytes;
 } NETSTATS;
 
+/**
+ * @ingroup Network-UDP
+ *
+ * @see net_udp_send_batch
+ */
+typedef struct NETUDPPACKET
+{
+	NETADDR addr;
+	const void *data;
+	int size;
+} NETUDPPACKET;
+
 #if defined(CONF_FAMILY_WINDOWS)
 /**
  * A handle for a process.
@@ -0,0 +1,307 @@
+#include "benchmark.h"
+#include "fixtures.h"
+
+#include <base/detect.h>
+#include <base/logger.h>
+#include <base/system.h>
+
+#include <engine/shared/jsonwriter.h>
+#include <engine/shared/simd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// count the allocations of the benchmarked code, allocations with malloc are not counted
+
+static std::atomic<int64_t> gs_Allocations{0};
+
+void *operator new(size_t Size)
+{
+	gs_Allocations.fetch_add(1, std::memory_order_relaxed);
+	void *pPtr = malloc(Size ? Size : 1);
+	if(!pPtr)
+		throw std::bad_alloc();
+	return pPtr;
+}
+
+void *operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void *operator new(size_t Size, std::align_val_t Alignment)
+{
+	gs_Allocations.fetch_add(1, std::memory_order_relaxed);
+#if defined(CONF_FAMILY_WINDOWS)
+	void *pPtr = _aligned_malloc(Size ? Size : 1, (size_t)Alignment);
+#else
+	void *pPtr;
+	if(posix_memalign(&pPtr, std::max((size_t)Alignment, sizeof(void *)), Size ? Size : 1) != 0)
+		pPtr = nullptr;
+#endif
+	if(!pPtr)
+		throw std::bad_alloc();
+	return pPtr;
+}
+
+void *operator new[](size_t Size, std::align_val_t Alignment)
+{
+	return operator new(Size, Alignment);
+}
+
+void operator delete(void *pPtr) noexcept
+{
+	free(pPtr);
+}
+
+void operator delete[](void *pPtr) noexcept
+{
+	free(pPtr);
+}
+
+void operator delete(void *pPtr, size_t) noexcept
+{
+	free(pPtr);
+}
+
+void operator delete[](void *pPtr, size_t) noexcept
+{
+	free(pPtr);
+}
+
+static void AlignedFree(void *pPtr)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	_aligned_free(pPtr);
+#else
+	free(pPtr);
+#endif
+}
+
+void operator delete(void *pPtr, std::align_val_t) noexcept
+{
+	AlignedFree(pPtr);
+}
+
+void operator delete[](void *pPtr, std::align_val_t) noexcept
+{
+	AlignedFree(pPtr);
+}
+
+void operator delete(void *pPtr, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(pPtr);
+}
+
+void operator delete[](void *pPtr, size_t, std::align_val_t) noexcept
+{
+	AlignedFree(pPtr);
+}
+
+int64_t BenchmarkAllocations()
+{
+	return gs_Allocations.load(std::memory_order_relaxed);
+}
+
+static volatile int64_t gs_Sink;
+
+void BenchmarkUse(const void *pData)
+{
+	gs_Sink = (int64_t)(uintptr_t)pData;
+}
+
+void BenchmarkUse(int64_t Value)
+{
+	gs_Sink = Value;
+}
+
+CBenchmark *CBenchmark::ms_pFirst = nullptr;
+
+CBenchmark::CBenchmark(const char *pName, FBenchmark pfnBenchmark) :
+	m_pName(pName), m_pfnBenchmark(pfnBenchmark), m_pNext(ms_pFirst)
+{
+	ms_pFirst = this;
+}
+
+CBenchmarkState::CBenchmarkState(int64_t Iterations) :
+	m_Iterations(Iterations), m_Remaining(Iterations)
+{
+}
+
+bool CBenchmarkState::KeepRunning()
+{
+	if(m_Remaining == m_Iterations)
+	{
+		m_StartAllocations = BenchmarkAllocations();
+		m_StartTime = time_get_nanoseconds().count();
+	}
+	if(m_Remaining-- > 0)
+		return true;
+
+	m_ElapsedTime = time_get_nanoseconds().count() - m_StartTime;
+	m_Allocations = BenchmarkAllocations() - m_StartAllocations;
+	return false;
+}
+
+class CResult
+{
+public:
+	const char *m_pName;
+	const char *m_pSkipReason;
+	int64_t m_Iterations;
+	double m_NsPerOp;
+	int64_t m_BytesPerOp;
+	double m_AllocsPerOp;
+};
+
+static CResult RunBenchmark(const CBenchmark *pBenchmark, int64_t MinTimeNs)
+{
+	static const int64_t MAX_ITERATIONS = 1000000000;
+
+	int64_t Iterations = 1;
+	while(true)
+	{
+		CBenchmarkState State(Iterations);
+		pBenchmark->m_pfnBenchmark(State);
+
+		CResult Result;
+		Result.m_pName = pBenchmark->m_pName;
+		Result.m_pSkipReason = State.SkipReason();
+		Result.m_Iterations = Iterations;
+		Result.m_NsPerOp = (double)State.ElapsedTime() / Iterations;
+		Result.m_BytesPerOp = State.BytesPerOp();
+		Result.m_AllocsPerOp = (double)State.Allocations() / Iterations;
+		if(State.SkipReason() || State.ElapsedTime() >= MinTimeNs || Iterations >= MAX_ITERATIONS)
+			return Result;
+
+		// aim a bit above the minimum time, but grow by at most 10x per attempt
+		const double Predicted = State.ElapsedTime() > 0 ? 1.4 * MinTimeNs * Iterations / State.ElapsedTime() : 10.0 * Iterations;
+		Iterations = std::clamp<int64_t>((int64_t)Predicted, Iterations + 1, std::min(Iterations * 10, MAX_ITERATIONS));
+	}
+}
+
+static void WriteJson(const char *pFilename, const std::vector<CResult> &vResults, int64_t MinTimeNs)
+{
+	IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+	if(!File)
+	{
+		log_error("benchmark", "failed to open '%s' for writing", pFilename);
+		return;
+	}
+
+	char aTimestamp[64];
+	str_timestamp_format(aTimestamp, sizeof(aTimestamp), FORMAT_SPACE);
+
+	CJsonFileWriter Writer(File);
+	Writer.BeginObject();
+	Writer.WriteAttribute("context");
+	Writer.BeginObject();
+	Writer.WriteAttribute("date");
+	Writer.WriteStrValue(aTimestamp);
+	Writer.WriteAttribute("platform");
+	Writer.WriteStrValue(CONF_PLATFORM_STRING);
+	Writer.WriteAttribute("arch");
+	Writer.WriteStrValue(CONF_ARCH_STRING);
+	Writer.WriteAttribute("simd");
+	Writer.WriteStrValue(CSimd::LevelName(CSimd::Level()));
+	Writer.WriteAttribute("min_time_ms");
+	Writer.WriteIntValue(MinTimeNs / 1000000);
+	Writer.WriteAttribute("allocs_counted");
+	Writer.WriteStrValue("operator new and new[], including aligned, but not malloc");
+	Writer.EndObject();
+
+	Writer.WriteAttribute("benchmarks");
+	Writer.BeginArray();
+	for(const CResult &Result : vResults)
+	{
+		Writer.BeginObject();
+		Writer.WriteAttribute("name");
+		Writer.WriteStrValue(Result.m_pName);
+		if(Result.m_pSkipReason)
+		{
+			Writer.WriteAttribute("skipped");
+			Writer.WriteStrValue(Result.m_pSkipReason);
+		}
+		else
+		{
+			Writer.WriteAttribute("iterations");
+			Writer.WriteIntValue(Result.m_Iterations);
+			Writer.WriteAttribute("ns_per_op");
+			Writer.WriteDoubleValue(Result.m_NsPerOp);
+			Writer.WriteAttribute("bytes_per_op");
+			Writer.WriteIntValue(Result.m_BytesPerOp);
+			Writer.WriteAttribute("allocs_per_op");
+			Writer.WriteDoubleValue(Result.m_AllocsPerOp);
+		}
+		Writer.EndObject();
+	}
+	Writer.EndArray();
+	Writer.EndObject();
+}
+
+static void Usage(const char *pProgram)
+{
+	log_info("benchmark", "usage: %s [--filter <substring>] [--min-time <ms>] [--json <file>] [--demo <file>] [--scalar]", pProgram);
+}
+
+int main(int argc, const char **argv)
+{
+	CCmdlineFix CmdlineFix(&argc, &argv);
+	log_set_global_logger_default();
+
+	const char *pFilter = "";
+	const char *pJsonFilename = nullptr;
+	const char *pDemoFilename = nullptr;
+	int64_t MinTimeNs = 500000000;
+	for(int i = 1; i < argc; i++)
+	{
+		if(str_comp(argv[i], "--filter") == 0 && i + 1 < argc)
+			pFilter = argv[++i];
+		else if(str_comp(argv[i], "--min-time") == 0 && i + 1 < argc)
+			MinTimeNs = str_toint(argv[++i]) * (int64_t)1000000;
+		else if(str_comp(argv[i], "--json") == 0 && i + 1 < argc)
+			pJsonFilename = argv[++i];
+		else if(str_comp(argv[i], "--demo") == 0 && i + 1 < argc)
+			pDemoFilename = argv[++i];
+		else if(str_comp(argv[i], "--scalar") == 0)
+			CSimd::SetLevel(CSimd::LEVEL_SCALAR);
+		else
+		{
+			Usage(argv[0]);
+			return -1;
+		}
+	}
+
+	if(pDemoFilename && !LoadDemoSnapshots(pDemoFilename))
+		return -1;
+
+	std::vector<const CBenchmark *> vpBenchmarks;
+	for(const CBenchmark *pBenchmark = CBenchmark::ms_pFirst; pBenchmark; pBenchmark = pBenchmark->m_pNext)
+	{
+		if(str_find(pBenchmark->m_pName, pFilter))
+			vpBenchmarks.push_back(pBenchmark);
+	}
+	std::sort(vpBenchmarks.begin(), vpBenchmarks.end(), [](const CBenchmark *pA, const CBenchmark *pB) {
+		return str_comp(pA->m_pName, pB->m_pName) < 0;
+	});
+
+	log_info("benchmark", "%-32s %12s %14s %12s %12s", "name", "iterations", "ns/op", "bytes/op", "allocs/op");
+	std::vector<CResult> vResults;
+	for(const CBenchmark *pBenchmark : vpBenchmarks)
+	{
+		const CResult Result = RunBenchmark(pBenchmark, MinTimeNs);
+		if(Result.m_pSkipReason)
+			log_info("benchmark", "%-32s skipped: %s", Result.m_pName, Result.m_pSkipReason);
+		else
+			log_info("benchmark", "%-32s %12" PRId64 " %14.1f %12" PRId64 " %12.2f", Result.m_pName, Result.m_Iterations, Result.m_NsPerOp, Result.m_BytesPerOp, Result.m_AllocsPerOp);
+		vResults.push_back(Result);
+	}
+
+	if(pJsonFilename)
+		WriteJson(pJsonFilename, vResults, MinTimeNs);
+	return 0;
+}
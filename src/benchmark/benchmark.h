@@ -0,0 +1,78 @@
+#ifndef BENCHMARK_BENCHMARK_H
+#define BENCHMARK_BENCHMARK_H
+
+#include <cstdint>
+
+/**
+ * Controls the iterations of one benchmark run and measures them.
+ *
+ * The benchmark function does its setup, then runs the measured operation
+ * while @link KeepRunning @endlink returns true.
+ */
+class CBenchmarkState
+{
+	int64_t m_Iterations;
+	int64_t m_Remaining;
+	int64_t m_StartTime = 0;
+	int64_t m_ElapsedTime = 0;
+	int64_t m_StartAllocations = 0;
+	int64_t m_Allocations = 0;
+	int64_t m_BytesPerOp = 0;
+	const char *m_pSkipReason = nullptr;
+
+public:
+	CBenchmarkState(int64_t Iterations);
+
+	bool KeepRunning();
+
+	/**
+	 * Sets the number of bytes produced or consumed by one operation,
+	 * e.g. the size of a compressed snapshot delta.
+	 */
+	void SetBytesPerOp(int64_t Bytes) { m_BytesPerOp = Bytes; }
+
+	/**
+	 * Marks the benchmark as skipped, e.g. because a fixture is missing.
+	 * The benchmark function must return without calling @link KeepRunning @endlink.
+	 */
+	void Skip(const char *pReason) { m_pSkipReason = pReason; }
+
+	int64_t Iterations() const { return m_Iterations; }
+	int64_t ElapsedTime() const { return m_ElapsedTime; }
+	int64_t Allocations() const { return m_Allocations; }
+	int64_t BytesPerOp() const { return m_BytesPerOp; }
+	const char *SkipReason() const { return m_pSkipReason; }
+};
+
+class CBenchmark
+{
+public:
+	typedef void (*FBenchmark)(CBenchmarkState &State);
+
+	CBenchmark(const char *pName, FBenchmark pfnBenchmark);
+
+	const char *m_pName;
+	FBenchmark m_pfnBenchmark;
+	CBenchmark *m_pNext;
+
+	static CBenchmark *ms_pFirst;
+};
+
+/**
+ * Number of allocations done with `operator new` so far.
+ */
+int64_t BenchmarkAllocations();
+
+/**
+ * Keeps the compiler from optimizing away a computation whose result
+ * is otherwise unused.
+ */
+void BenchmarkUse(const void *pData);
+void BenchmarkUse(int64_t Value);
+
+#define BENCHMARK(Name) \
+	static void Benchmark##Name(CBenchmarkState &State); \
+	static CBenchmark gs_Benchmark##Name(#Name, Benchmark##Name); \
+	static void Benchmark##Name(CBenchmarkState &State)
+
+#endif
@@ -0,0 +1,52 @@
+#include "benchmark.h"
+#include "fixtures.h"
+
+#include <engine/shared/compression.h>
+#include <engine/shared/snapshot.h>
+
+#include <vector>
+
+// the snapshot deltas are the largest user of the variable int packing
+static const CDeltaSequence &WorldDeltas()
+{
+	static CSnapshotDelta s_Delta;
+	static const CDeltaSequence s_Deltas(WorldSnapshots(), s_Delta);
+	return s_Deltas;
+}
+
+BENCHMARK(VariableIntCompress)
+{
+	const CDeltaSequence &Deltas = WorldDeltas();
+	State.SetBytesPerOp(Deltas.AverageSize());
+
+	char aCompressed[CSnapshot::MAX_SIZE];
+	int Index = 0;
+	while(State.KeepRunning())
+	{
+		BenchmarkUse(CVariableInt::Compress(Deltas.Get(Index), Deltas.Size(Index), aCompressed, sizeof(aCompressed)));
+		Index = Index + 1 < Deltas.Num() ? Index + 1 : 0;
+	}
+}
+
+BENCHMARK(VariableIntDecompress)
+{
+	const CDeltaSequence &Deltas = WorldDeltas();
+	std::vector<std::vector<char>> vvCompressed;
+	int64_t TotalSize = 0;
+	for(int i = 0; i < Deltas.Num(); i++)
+	{
+		char aCompressed[CSnapshot::MAX_SIZE];
+		const int Size = CVariableInt::Compress(Deltas.Get(i), Deltas.Size(i), aCompressed, sizeof(aCompressed));
+		vvCompressed.emplace_back(aCompressed, aCompressed + Size);
+		TotalSize += Size;
+	}
+	State.SetBytesPerOp(TotalSize / (int64_t)vvCompressed.size());
+
+	char aDecompressed[CSnapshot::MAX_SIZE];
+	size_t Index = 0;
+	while(State.KeepRunning())
+	{
+		BenchmarkUse(CVariableInt::Decompress(vvCompressed[Index].data(), vvCompressed[Index].size(), aDecompressed, sizeof(aDecompressed)));
+		Index = Index + 1 < vvCompressed.size() ? Index + 1 : 0;
+	}
+}
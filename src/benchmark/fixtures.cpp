@@ -0,0 +1,228 @@
+#include "fixtures.h"
+
+#include <base/logger.h>
+#include <base/math.h>
+#include <base/system.h>
+
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/storage.h>
+
+#include <generated/protocol.h>
+
+#include <game/gamecore.h>
+#include <game/prng.h>
+
+#include <memory>
+
+void CSnapshotSequence::Add(const CSnapshot *pSnapshot, int Size)
+{
+	const size_t Offset = m_vData.size();
+	m_vData.resize(Offset + (Size + sizeof(int) - 1) / sizeof(int));
+	mem_copy(&m_vData[Offset], pSnapshot, Size);
+	m_vOffsets.push_back(Offset);
+	m_vSizes.push_back(Size);
+}
+
+CDeltaSequence::CDeltaSequence(const CSnapshotSequence &Snapshots, const CSnapshotDelta &Delta)
+{
+	char aDelta[CSnapshot::MAX_SIZE];
+	for(int i = 1; i < Snapshots.Num(); i++)
+	{
+		const int Size = Delta.CreateDelta(Snapshots.Get(i - 1), Snapshots.Get(i), aDelta);
+		m_vvDeltas.emplace_back(aDelta, aDelta + Size);
+	}
+}
+
+int CDeltaSequence::AverageSize() const
+{
+	int64_t Total = 0;
+	for(const auto &vDelta : m_vvDeltas)
+		Total += vDelta.size();
+	return m_vvDeltas.empty() ? 0 : Total / (int64_t)m_vvDeltas.size();
+}
+
+template<typename T>
+static T *NewItem(CSnapshotBuilder *pBuilder, int Id)
+{
+	T *pItem = static_cast<T *>(pBuilder->NewItem(T::ms_MsgId, Id, sizeof(T)));
+	dbg_assert(pItem != nullptr, "snapshot fixture too large");
+	mem_zero(pItem, sizeof(T));
+	return pItem;
+}
+
+void SynthesizeWorldSnapshot(CSnapshotBuilder *pBuilder, int Tick)
+{
+	// the same random players in every snapshot
+	CPrng Prng;
+	uint64_t aSeed[2] = {0x5eed, 64};
+	Prng.Seed(aSeed);
+
+	CNetObj_GameInfo *pGameInfo = NewItem<CNetObj_GameInfo>(pBuilder, 0);
+	pGameInfo->m_GameStateFlags = 0;
+
+	CNetObj_GameInfoEx *pGameInfoEx = NewItem<CNetObj_GameInfoEx>(pBuilder, 0);
+	pGameInfoEx->m_Flags = GAMEINFOFLAG_GAMETYPE_DDRACE | GAMEINFOFLAG_RACE | GAMEINFOFLAG_PREDICT_DDRACE | GAMEINFOFLAG_ENTITIES_DDRACE;
+	pGameInfoEx->m_Version = GAMEINFO_CURVERSION;
+
+	for(int i = 0; i < FIXTURE_PLAYERS; i++)
+	{
+		const int Seed = Prng.RandomBits();
+		const int Team = Seed % 8;
+		const float Phase = (Seed % 1000) / 1000.0f * 2 * pi;
+		const float Speed = 0.02f + (Seed % 7) * 0.01f;
+		const bool Frozen = (Seed >> 3) % 5 == 0;
+		const int ActiveTick = Frozen ? 0 : Tick;
+
+		CNetObj_ClientInfo *pClientInfo = NewItem<CNetObj_ClientInfo>(pBuilder, i);
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "player %d", i);
+		StrToInts(pClientInfo->m_aName, std::size(pClientInfo->m_aName), aName);
+		StrToInts(pClientInfo->m_aClan, std::size(pClientInfo->m_aClan), "bench");
+		StrToInts(pClientInfo->m_aSkin, std::size(pClientInfo->m_aSkin), "default");
+		pClientInfo->m_Country = -1;
+		pClientInfo->m_UseCustomColor = Seed % 2;
+		pClientInfo->m_ColorBody = Seed & 0xffffff;
+		pClientInfo->m_ColorFeet = (Seed >> 8) & 0xffffff;
+
+		CNetObj_PlayerInfo *pPlayerInfo = NewItem<CNetObj_PlayerInfo>(pBuilder, i);
+		pPlayerInfo->m_Local = i == 0;
+		pPlayerInfo->m_ClientId = i;
+		pPlayerInfo->m_Score = -9999;
+		pPlayerInfo->m_Latency = 20 + (Seed + Tick / 50) % 80;
+
+		CNetObj_DDNetPlayer *pDDNetPlayer = NewItem<CNetObj_DDNetPlayer>(pBuilder, i);
+		pDDNetPlayer->m_Flags = Seed % 16 == 0 ? EXPLAYERFLAG_AFK : 0;
+
+		// circling around their team's part of the map
+		const float Angle = Phase + ActiveTick * Speed;
+		const vec2 Center = vec2(2000.0f + Team * 1500.0f, 1500.0f + (Seed % 3) * 400.0f);
+		const vec2 Pos = Center + direction(Angle) * 300.0f;
+		const vec2 Vel = direction(Angle + pi / 2) * 300.0f * Speed;
+
+		CNetObj_Character *pCharacter = NewItem<CNetObj_Character>(pBuilder, i);
+		pCharacter->m_Tick = Tick;
+		pCharacter->m_X = round_to_int(Pos.x);
+		pCharacter->m_Y = round_to_int(Pos.y);
+		pCharacter->m_VelX = round_to_int(Vel.x * 256.0f);
+		pCharacter->m_VelY = round_to_int(Vel.y * 256.0f);
+		pCharacter->m_Angle = round_to_int(Angle * 256.0f) % 1608;
+		pCharacter->m_Direction = Vel.x < 0 ? -1 : 1;
+		pCharacter->m_Jumped = (ActiveTick / 25) % 2;
+		pCharacter->m_HookedPlayer = -1;
+		pCharacter->m_HookState = (ActiveTick / 40) % 3 == 0 ? HOOK_GRABBED : HOOK_IDLE;
+		if(pCharacter->m_HookState == HOOK_GRABBED)
+		{
+			pCharacter->m_HookTick = ActiveTick % 40;
+			pCharacter->m_HookX = pCharacter->m_X + 200;
+			pCharacter->m_HookY = pCharacter->m_Y - 150;
+		}
+		pCharacter->m_PlayerFlags = PLAYERFLAG_PLAYING;
+		pCharacter->m_Health = 10;
+		pCharacter->m_Armor = 0;
+		pCharacter->m_AmmoCount = -1;
+		pCharacter->m_Weapon = (Seed >> 5) % 2 ? WEAPON_GUN : WEAPON_HAMMER;
+		pCharacter->m_Emote = Frozen ? EMOTE_BLINK : EMOTE_NORMAL;
+		pCharacter->m_AttackTick = ActiveTick - ActiveTick % 30;
+
+		CNetObj_DDNetCharacter *pDDNetCharacter = NewItem<CNetObj_DDNetCharacter>(pBuilder, i);
+		pDDNetCharacter->m_Flags = CHARACTERFLAG_WEAPON_HAMMER | CHARACTERFLAG_WEAPON_GUN | (Frozen ? CHARACTERFLAG_IN_FREEZE : 0);
+		pDDNetCharacter->m_FreezeEnd = Frozen ? -1 : 0;
+		pDDNetCharacter->m_Jumps = 2;
+		pDDNetCharacter->m_TeleCheckpoint = Seed % 10;
+		pDDNetCharacter->m_StrongWeakId = i;
+		pDDNetCharacter->m_JumpedTotal = pCharacter->m_Jumped;
+		pDDNetCharacter->m_NinjaActivationTick = -1;
+		pDDNetCharacter->m_FreezeStart = Frozen ? 1 : 0;
+		pDDNetCharacter->m_TargetX = round_to_int(direction(Angle).x * 100.0f);
+		pDDNetCharacter->m_TargetY = round_to_int(direction(Angle).y * 100.0f);
+		pDDNetCharacter->m_TuneZoneOverride = -1;
+
+		// some players shoot every now and then
+		if(!Frozen && pCharacter->m_Weapon == WEAPON_GUN && ActiveTick % 30 < 10)
+		{
+			CNetObj_Projectile *pProjectile = NewItem<CNetObj_Projectile>(pBuilder, FIXTURE_PLAYERS + i);
+			pProjectile->m_X = pCharacter->m_X;
+			pProjectile->m_Y = pCharacter->m_Y;
+			pProjectile->m_VelX = pDDNetCharacter->m_TargetX;
+			pProjectile->m_VelY = pDDNetCharacter->m_TargetY;
+			pProjectile->m_Type = WEAPON_GUN;
+			pProjectile->m_StartTick = pCharacter->m_AttackTick;
+		}
+	}
+
+	// pickups of the map
+	for(int i = 0; i < 32; i++)
+	{
+		CNetObj_Pickup *pPickup = NewItem<CNetObj_Pickup>(pBuilder, 2 * FIXTURE_PLAYERS + i);
+		pPickup->m_X = 500 + i * 320;
+		pPickup->m_Y = 900;
+		pPickup->m_Type = i % 2 ? POWERUP_WEAPON : POWERUP_ARMOR;
+		pPickup->m_Subtype = i % 2 ? WEAPON_SHOTGUN : 0;
+	}
+}
+
+const CSnapshotSequence &WorldSnapshots()
+{
+	static CSnapshotSequence s_Snapshots;
+	if(s_Snapshots.Num() == 0)
+	{
+		CSnapshotBuilder Builder;
+		char aData[CSnapshot::MAX_SIZE];
+		for(int Tick = 1; Tick <= FIXTURE_TICKS; Tick++)
+		{
+			Builder.Init();
+			SynthesizeWorldSnapshot(&Builder, Tick);
+			const int Size = Builder.Finish(aData);
+			s_Snapshots.Add((const CSnapshot *)aData, Size);
+		}
+	}
+	return s_Snapshots;
+}
+
+static CSnapshotSequence gs_DemoSnapshots;
+
+const CSnapshotSequence &DemoSnapshots()
+{
+	return gs_DemoSnapshots;
+}
+
+class CDemoSnapshotListener : public CDemoPlayer::IListener
+{
+public:
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		gs_DemoSnapshots.Add((const CSnapshot *)pData, Size);
+	}
+
+	void OnDemoPlayerMessage(void *pData, int Size) override {}
+};
+
+bool LoadDemoSnapshots(const char *pFilename)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	if(!pStorage)
+	{
+		log_error("benchmark", "failed to create storage");
+		return false;
+	}
+
+	std::unique_ptr<CSnapshotDelta> pSnapshotDelta = std::make_unique<CSnapshotDelta>();
+	CDemoPlayer DemoPlayer(pSnapshotDelta.get(), false);
+	if(DemoPlayer.Load(pStorage.get(), nullptr, pFilename, IStorage::TYPE_ALL_OR_ABSOLUTE) == -1)
+	{
+		log_error("benchmark", "failed to load demo '%s': %s", pFilename, DemoPlayer.ErrorMessage());
+		return false;
+	}
+
+	CDemoSnapshotListener Listener;
+	DemoPlayer.SetListener(&Listener);
+	CNetBase::Init();
+	DemoPlayer.Play();
+	while(DemoPlayer.IsPlaying() && !DemoPlayer.Info()->m_Info.m_Paused)
+		DemoPlayer.Update(false);
+	DemoPlayer.Stop();
+
+	log_info("benchmark", "captured %d snapshots from '%s'", gs_DemoSnapshots.Num(), pFilename);
+	return gs_DemoSnapshots.Num() > 1;
+}
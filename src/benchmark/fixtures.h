@@ -0,0 +1,53 @@
+#ifndef BENCHMARK_FIXTURES_H
+#define BENCHMARK_FIXTURES_H
+
+#include <engine/shared/snapshot.h>
+
+#include <vector>
+
+// Snapshots as sent to one client, one per tick.
+class CSnapshotSequence
+{
+	std::vector<int> m_vData;
+	std::vector<size_t> m_vOffsets;
+	std::vector<int> m_vSizes;
+
+public:
+	void Add(const CSnapshot *pSnapshot, int Size);
+	int Num() const { return m_vOffsets.size(); }
+	const CSnapshot *Get(int Index) const { return (const CSnapshot *)&m_vData[m_vOffsets[Index]]; }
+	int Size(int Index) const { return m_vSizes[Index]; }
+};
+
+// The deltas between the consecutive snapshots of a sequence, as created
+// by the server.
+class CDeltaSequence
+{
+	std::vector<std::vector<char>> m_vvDeltas;
+
+public:
+	CDeltaSequence(const CSnapshotSequence &Snapshots, const CSnapshotDelta &Delta);
+	int Num() const { return m_vvDeltas.size(); }
+	const void *Get(int Index) const { return m_vvDeltas[Index].data(); }
+	int Size(int Index) const { return m_vvDeltas[Index].size(); }
+	int AverageSize() const;
+};
+
+enum
+{
+	FIXTURE_PLAYERS = 64,
+	FIXTURE_TICKS = 250,
+};
+
+// Adds the items of a synthesized DDRace world with FIXTURE_PLAYERS players,
+// moving, hooking and shooting, as seen by the first player at the given tick.
+void SynthesizeWorldSnapshot(CSnapshotBuilder *pBuilder, int Tick);
+
+// FIXTURE_TICKS snapshots of the synthesized world.
+const CSnapshotSequence &WorldSnapshots();
+
+// Snapshots captured from the demo passed with `--demo`, empty otherwise.
+const CSnapshotSequence &DemoSnapshots();
+bool LoadDemoSnapshots(const char *pFilename);
+
+#endif
@@ -0,0 +1,75 @@
+#include "benchmark.h"
+#include "fixtures.h"
+
+#include <base/math.h>
+
+#include <engine/shared/compression.h>
+#include <engine/shared/huffman.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+
+#include <vector>
+
+// packet payloads as sent by the server: the compressed snapshot deltas,
+// split into chunks of the maximum snapshot packet size
+static const std::vector<std::vector<unsigned char>> &Payloads()
+{
+	static std::vector<std::vector<unsigned char>> s_vvPayloads;
+	if(s_vvPayloads.empty())
+	{
+		CSnapshotDelta Delta;
+		const CDeltaSequence Deltas(WorldSnapshots(), Delta);
+		for(int i = 0; i < Deltas.Num(); i++)
+		{
+			unsigned char aCompressed[CSnapshot::MAX_SIZE];
+			const int Size = CVariableInt::Compress(Deltas.Get(i), Deltas.Size(i), aCompressed, sizeof(aCompressed));
+			for(int Offset = 0; Offset < Size; Offset += 900)
+				s_vvPayloads.emplace_back(aCompressed + Offset, aCompressed + minimum(Offset + 900, Size));
+		}
+	}
+	return s_vvPayloads;
+}
+
+BENCHMARK(HuffmanCompress)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+	const auto &vvPayloads = Payloads();
+
+	unsigned char aCompressed[NET_MAX_PACKETSIZE];
+	int64_t TotalSize = 0;
+	for(const auto &vPayload : vvPayloads)
+		TotalSize += vPayload.size();
+	State.SetBytesPerOp(TotalSize / (int64_t)vvPayloads.size());
+
+	size_t Index = 0;
+	while(State.KeepRunning())
+	{
+		BenchmarkUse(Huffman.Compress(vvPayloads[Index].data(), vvPayloads[Index].size(), aCompressed, sizeof(aCompressed)));
+		Index = Index + 1 < vvPayloads.size() ? Index + 1 : 0;
+	}
+}
+
+BENCHMARK(HuffmanDecompress)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+	std::vector<std::vector<unsigned char>> vvCompressed;
+	int64_t TotalSize = 0;
+	for(const auto &vPayload : Payloads())
+	{
+		unsigned char aCompressed[NET_MAX_PACKETSIZE];
+		const int Size = Huffman.Compress(vPayload.data(), vPayload.size(), aCompressed, sizeof(aCompressed));
+		vvCompressed.emplace_back(aCompressed, aCompressed + Size);
+		TotalSize += Size;
+	}
+	State.SetBytesPerOp(TotalSize / (int64_t)vvCompressed.size());
+
+	unsigned char aDecompressed[NET_MAX_PACKETSIZE];
+	size_t Index = 0;
+	while(State.KeepRunning())
+	{
+		BenchmarkUse(Huffman.Decompress(vvCompressed[Index].data(), vvCompressed[Index].size(), aDecompressed, sizeof(aDecompressed)));
+		Index = Index + 1 < vvCompressed.size() ? Index + 1 : 0;
+	}
+}
@@ -0,0 +1,49 @@
+#include "benchmark.h"
+
+#include <engine/shared/packer.h>
+
+// the server sends inputs, chat and player info messages most often
+
+static void PackMessages(CPacker *pPacker, int Seed)
+{
+	pPacker->Reset();
+	for(int i = 0; i < 10; i++)
+		pPacker->AddInt(Seed * 31 + i * 1000);
+	pPacker->AddString("player name");
+	pPacker->AddString("a chat message of a typical length, sent to everyone");
+	for(int i = 0; i < 10; i++)
+		pPacker->AddInt(-i);
+}
+
+BENCHMARK(PackerAdd)
+{
+	CPacker Packer;
+	int Seed = 0;
+	while(State.KeepRunning())
+	{
+		PackMessages(&Packer, Seed++);
+		BenchmarkUse(Packer.Size());
+	}
+	State.SetBytesPerOp(Packer.Size());
+}
+
+BENCHMARK(UnpackerGet)
+{
+	CPacker Packer;
+	PackMessages(&Packer, 12345);
+	State.SetBytesPerOp(Packer.Size());
+
+	CUnpacker Unpacker;
+	while(State.KeepRunning())
+	{
+		Unpacker.Reset(Packer.Data(), Packer.Size());
+		int Sum = 0;
+		for(int i = 0; i < 10; i++)
+			Sum += Unpacker.GetInt();
+		BenchmarkUse(Unpacker.GetString());
+		BenchmarkUse(Unpacker.GetString());
+		for(int i = 0; i < 10; i++)
+			Sum += Unpacker.GetInt();
+		BenchmarkUse(Sum);
+	}
+}
@@ -0,0 +1,98 @@
+#include "benchmark.h"
+#include "fixtures.h"
+
+#include <engine/shared/snapshot.h>
+
+BENCHMARK(SnapshotBuilderWorld)
+{
+	CSnapshotBuilder Builder;
+	char aData[CSnapshot::MAX_SIZE];
+	int Tick = 0;
+	int Size = 0;
+	while(State.KeepRunning())
+	{
+		Builder.Init();
+		SynthesizeWorldSnapshot(&Builder, Tick++ % FIXTURE_TICKS + 1);
+		Size = Builder.Finish(aData);
+		BenchmarkUse(aData);
+	}
+	State.SetBytesPerOp(Size);
+}
+
+static void CreateDelta(CBenchmarkState &State, const CSnapshotSequence &Snapshots)
+{
+	if(Snapshots.Num() < 2)
+	{
+		State.Skip("no snapshots");
+		return;
+	}
+
+	CSnapshotDelta Delta;
+	State.SetBytesPerOp(CDeltaSequence(Snapshots, Delta).AverageSize());
+
+	char aDelta[CSnapshot::MAX_SIZE];
+	int Index = 1;
+	while(State.KeepRunning())
+	{
+		BenchmarkUse(Delta.CreateDelta(Snapshots.Get(Index - 1), Snapshots.Get(Index), aDelta));
+		Index = Index + 1 < Snapshots.Num() ? Index + 1 : 1;
+	}
+}
+
+static void UnpackDelta(CBenchmarkState &State, const CSnapshotSequence &Snapshots)
+{
+	if(Snapshots.Num() < 2)
+	{
+		State.Skip("no snapshots");
+		return;
+	}
+
+	CSnapshotDelta Delta;
+	const CDeltaSequence Deltas(Snapshots, Delta);
+	State.SetBytesPerOp(Deltas.AverageSize());
+
+	char aTo[CSnapshot::MAX_SIZE];
+	int Index = 0;
+	while(State.KeepRunning())
+	{
+		BenchmarkUse(Delta.UnpackDelta(Snapshots.Get(Index), (CSnapshot *)aTo, Deltas.Get(Index), Deltas.Size(Index), false));
+		Index = Index + 1 < Deltas.Num() ? Index + 1 : 0;
+	}
+}
+
+BENCHMARK(SnapshotCreateDeltaWorld)
+{
+	CreateDelta(State, WorldSnapshots());
+}
+
+BENCHMARK(SnapshotCreateDeltaDemo)
+{
+	CreateDelta(State, DemoSnapshots());
+}
+
+BENCHMARK(SnapshotUnpackDeltaWorld)
+{
+	UnpackDelta(State, WorldSnapshots());
+}
+
+BENCHMARK(SnapshotUnpackDeltaDemo)
+{
+	UnpackDelta(State, DemoSnapshots());
+}
+
+BENCHMARK(SnapshotStorageAddPurge)
+{
+	const CSnapshotSequence &Snapshots = WorldSnapshots();
+	CSnapshotStorage Storage;
+	int Tick = 0;
+	while(State.KeepRunning())
+	{
+		// like the server, keeping 3 seconds of snapshots
+		const int Index = Tick % Snapshots.Num();
+		Storage.PurgeUntil(Tick - 150);
+		Storage.Add(Tick, 0, Snapshots.Size(Index), Snapshots.Get(Index), 0, nullptr);
+		Tick++;
+	}
+	Storage.PurgeAll();
+	State.SetBytesPerOp(Snapshots.Size(0));
+}
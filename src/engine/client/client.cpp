@@ -91,7 +91,7 @@ CClient::CClient() :
 {
 	m_StateStartTime = time_get();
 	for(auto &DemoRecorder : m_aDemoRecorder)
-		DemoRecorder = CDemoRecorder(&m_SnapshotDelta);
+		DemoRecorder = CDemoRecorder(&m_SnapshotDelta, false, &m_DemoRecordWriter);
 	m_LastRenderTime = time_get();
 	mem_zero(m_aInputs, sizeof(m_aInputs));
 	mem_zero(m_aapSnapshots, sizeof(m_aapSnapshots));
@@ -904,10 +904,11 @@ void CClient::LoadDebugFont()
 IClient::CSnapItem CClient::SnapGetItem(int SnapId, int Index) const
 {
 	dbg_assert(SnapId >= 0 && SnapId < NUM_SNAPSHOT_TYPES, "invalid SnapId");
-	const CSnapshot *pSnapshot = m_aapSnapshots[g_Config.m_ClDummy][SnapId]->m_pAltSnap;
+	const CSnapshotStorage::CHolder *pHolder = m_aapSnapshots[g_Config.m_ClDummy][SnapId];
+	const CSnapshot *pSnapshot = pHolder->m_pAltSnap;
 	const CSnapshotItem *pSnapshotItem = pSnapshot->GetItem(Index);
 	CSnapItem Item;
-	Item.m_Type = pSnapshot->GetItemType(Index);
+	Item.m_Type = pHolder->m_pAltSnapIndex ? pSnapshot->GetItemType(Index, *pHolder->m_pAltSnapIndex) : pSnapshot->GetItemType(Index);
 	Item.m_Id = pSnapshotItem->Id();
 	Item.m_pData = pSnapshotItem->Data();
 	Item.m_DataSize = pSnapshot->GetItemSize(Index);
@@ -919,7 +920,10 @@ const void *CClient::SnapFindItem(int SnapId, int Type, int Id) const
 	if(!m_aapSnapshots[g_Config.m_ClDummy][SnapId])
 		return nullptr;
 
-	return m_aapSnapshots[g_Config.m_ClDummy][SnapId]->m_pAltSnap->FindItem(Type, Id);
+	const CSnapshotStorage::CHolder *pHolder = m_aapSnapshots[g_Config.m_ClDummy][SnapId];
+	if(pHolder->m_pAltSnapIndex)
+		return pHolder->m_pAltSnap->FindItem(Type, Id, *pHolder->m_pAltSnapIndex);
+	return pHolder->m_pAltSnap->FindItem(Type, Id);
 }
 
 int CClient::SnapNumItems(int SnapId) const
@@ -2728,6 +2732,7 @@ void CClient::OnDemoPlayerSnapshot(void *pData, int Size)
 	std::swap(m_aapSnapshots[0][SNAP_PREV], m_aapSnapshots[0][SNAP_CURRENT]);
 	mem_copy(m_aapSnapshots[0][SNAP_CURRENT]->m_pSnap, pData, Size);
 	mem_copy(m_aapSnapshots[0][SNAP_CURRENT]->m_pAltSnap, pAltSnapBuffer, AltSnapSize);
+	m_aapSnapshots[0][SNAP_CURRENT]->m_pAltSnapIndex->Build(m_aapSnapshots[0][SNAP_CURRENT]->m_pAltSnap);
 
 	GameClient()->OnNewSnapshot();
 }
@@ -4077,6 +4082,8 @@ const char *CClient::DemoPlayer_Play(const char *pFilename, int StorageType)
 		m_aapSnapshots[0][SnapshotType] = &m_aDemorecSnapshotHolders[SnapshotType];
 		m_aapSnapshots[0][SnapshotType]->m_pSnap = (CSnapshot *)&m_aaaDemorecSnapshotData[SnapshotType][0];
 		m_aapSnapshots[0][SnapshotType]->m_pAltSnap = (CSnapshot *)&m_aaaDemorecSnapshotData[SnapshotType][1];
+		m_aapSnapshots[0][SnapshotType]->m_pAltSnapIndex = &m_aDemorecSnapshotIndices[SnapshotType];
+		m_aapSnapshots[0][SnapshotType]->m_pAltSnapIndex->Clear();
 		m_aapSnapshots[0][SnapshotType]->m_SnapSize = 0;
 		m_aapSnapshots[0][SnapshotType]->m_AltSnapSize = 0;
 		m_aapSnapshots[0][SnapshotType]->m_Tick = -1;
@@ -4169,7 +4176,8 @@ void CClient::DemoRecorder_Start(const char *pFilename, bool WithTimestamp, int
 			nullptr,
 			m_pMap->File(),
 			nullptr,
-			nullptr);
+			nullptr,
+			g_Config.m_ClDemoIndex >= (Recorder == RECORDER_MANUAL ? 1 : 2));
 	}
 }
 
@@ -4961,7 +4969,7 @@ int main(int argc, const char **argv)
 	pKernel->RegisterInterface(pEngineTextRender); // IEngineTextRender
 	pKernel->RegisterInterface(static_cast<ITextRender *>(pEngineTextRender), false);
 
-	IEngineMap *pEngineMap = CreateEngineMap();
+	IEngineMap *pEngineMap = CreateEngineMap(pEngine);
 	pKernel->RegisterInterface(pEngineMap); // IEngineMap
 	pKernel->RegisterInterface(static_cast<IMap *>(pEngineMap), false);
 
@@ -5180,7 +5188,8 @@ void CClient::RaceRecord_Start(const char *pFilename)
 			nullptr,
 			m_pMap->File(),
 			nullptr,
-			nullptr);
+			nullptr,
+			g_Config.m_ClDemoIndex >= 2);
 }
 
 void CClient::RaceRecord_Stop()
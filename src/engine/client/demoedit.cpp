@@ -23,5 +23,10 @@ void CDemoEdit::Run()
 	m_Success = m_DemoEditor.Slice(m_aDemo, m_aDst, m_StartTick, m_EndTick, nullptr, nullptr);
 	// We remove the temporary demo file if slicing is successful
 	if(m_Success)
+	{
+		char aIndexFilename[IO_MAX_PATH_LENGTH];
+		CDemoRecorder::IndexFilename(m_aDemo, aIndexFilename, sizeof(aIndexFilename));
+		m_pStorage->RemoveFile(aIndexFilename, IStorage::TYPE_SAVE);
 		m_pStorage->RemoveFile(m_aDemo, IStorage::TYPE_SAVE);
+	}
 }
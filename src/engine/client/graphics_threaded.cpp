@@ -698,6 +698,7 @@ public:
 		m_Image(std::move(Image))
 	{
 		str_copy(m_aName, pName);
+		SetPriority(PRIORITY_BACKGROUND);
 	}
 
 	~CScreenshotSaveJob() override
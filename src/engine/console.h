@@ -89,12 +89,26 @@ public:
 		virtual EAccessLevel GetAccessLevel() const = 0;
 	};
 
+	/**
+	 * A line which is split into its commands once, so it can be executed repeatedly without
+	 * looking up the commands and parsing their arguments again, e.g. for binds.
+	 *
+	 * @see CompileLine
+	 */
+	class ICompiledLine
+	{
+	public:
+		virtual ~ICompiledLine() = default;
+		virtual const char *Line() const = 0;
+	};
+
 	typedef void (*FTeeHistorianCommandCallback)(int ClientId, int FlagMask, const char *pCmd, IResult *pResult, void *pUser);
 	typedef void (*FPossibleCallback)(int Index, const char *pCmd, void *pUser);
 	typedef void (*FCommandCallback)(IResult *pResult, void *pUserData);
 	typedef void (*FChainCommandCallback)(IResult *pResult, void *pUserData, FCommandCallback pfnCallback, void *pCallbackUserData);
 	typedef bool (*FUnknownCommandCallback)(const char *pCommand, void *pUser); // returns true if the callback has handled the argument
 	typedef bool (*FCanUseCommandCallback)(int ClientId, const ICommandInfo *pCommand, void *pUser);
+	typedef void (*FParsedCommandCallback)(const ICommandInfo *pCommand, IResult *pResult, void *pUser);
 
 	static void EmptyPossibleCommandCallback(int Index, const char *pCmd, void *pUser) {}
 	static bool EmptyUnknownCommandCallback(const char *pCommand, void *pUser) { return false; }
@@ -114,10 +128,31 @@ public:
 	virtual void StoreCommands(bool Store) = 0;
 
 	virtual bool LineIsValid(const char *pStr) = 0;
+	/**
+	 * Splits a line into its commands and parses their arguments like @link ExecuteLine @endlink, without executing them.
+	 * Unknown commands and commands with invalid arguments are skipped.
+	 *
+	 * @param pStr The line.
+	 * @param pfnCallback Called for every command with its parsed arguments.
+	 * @param pUser Passed to the callback.
+	 */
+	virtual void ParseLine(const char *pStr, FParsedCommandCallback pfnCallback, void *pUser) = 0;
 	virtual void ExecuteLine(const char *pStr, int ClientId = CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) = 0;
 	virtual void ExecuteLineFlag(const char *pStr, int FlasgMask, int ClientId = CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) = 0;
 	virtual void ExecuteLineStroked(int Stroke, const char *pStr, int ClientId = CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) = 0;
 	virtual bool ExecuteFile(const char *pFilename, int ClientId = CLIENT_ID_UNSPECIFIED, bool LogFailure = false, int StorageType = IStorage::TYPE_ALL) = 0;
+	/**
+	 * Compiles a line, so it can be executed like @link ExecuteLineStroked @endlink without splitting it again.
+	 * The commands are looked up and their arguments parsed on first use, and again after commands changed.
+	 *
+	 * @param pStr The line, it is copied.
+	 * @param InterpretSemicolons Whether semicolons separate commands, like for @link ExecuteLine @endlink.
+	 *
+	 * @return The compiled line, it must only be executed by this console.
+	 */
+	virtual std::unique_ptr<ICompiledLine> CompileLine(const char *pStr, bool InterpretSemicolons = true) = 0;
+	virtual void ExecuteCompiledLine(ICompiledLine *pLine, int ClientId = CLIENT_ID_UNSPECIFIED) = 0;
+	virtual void ExecuteCompiledLineStroked(int Stroke, ICompiledLine *pLine, int ClientId = CLIENT_ID_UNSPECIFIED) = 0;
 
 	/**
 	 * @deprecated Prefer using the `log_*` functions from base/log.h instead of this function for the following reasons:
@@ -5,7 +5,9 @@
 
 #include "kernel.h"
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 class CFutureLogger;
 class IJob;
@@ -18,6 +20,8 @@ class IEngine : public IInterface
 public:
 	virtual void Init() = 0;
 	virtual void AddJob(std::shared_ptr<IJob> pJob) = 0;
+	virtual void AddJobAfter(std::shared_ptr<IJob> pJob, const std::vector<std::shared_ptr<IJob>> &vpDependencies) = 0;
+	virtual void ParallelFor(int Begin, int End, int Grain, const std::function<void(int Begin, int End)> &Function) = 0;
 	virtual void ShutdownJobs() = 0;
 	virtual void SetAdditionalLogger(std::shared_ptr<ILogger> &&pLogger) = 0;
 };
@@ -8,6 +8,8 @@
 #include <base/hash.h>
 #include <base/types.h>
 
+#include <vector>
+
 enum
 {
 	MAX_MAP_LENGTH = 128
@@ -22,6 +24,10 @@ public:
 	virtual void *GetDataSwapped(int Index) = 0;
 	virtual const char *GetDataString(int Index) = 0;
 	virtual void UnloadData(int Index) = 0;
+	/**
+	 * Loads the data with the given indices in parallel, so getting it afterwards is fast.
+	 */
+	virtual void LoadData(const std::vector<int> &vIndices) = 0;
 	virtual int NumData() const = 0;
 
 	virtual int GetItemSize(int Index) = 0;
@@ -37,6 +43,12 @@ class IEngineMap : public IMap
 	MACRO_INTERFACE("enginemap")
 public:
 	[[nodiscard]] virtual bool Load(const char *pMapName) = 0;
+	/**
+	 * Replaces the loaded map with the map of another instance, e.g. one that was loaded in the background.
+	 *
+	 * @param pOther The map to take over, it is not loaded anymore afterwards.
+	 */
+	virtual void Take(IEngineMap *pOther) = 0;
 	virtual void Unload() = 0;
 	virtual bool IsLoaded() const = 0;
 	virtual IOHANDLE File() const = 0;
@@ -44,8 +56,15 @@ public:
 	virtual SHA256_DIGEST Sha256() const = 0;
 	virtual unsigned Crc() const = 0;
 	virtual int MapSize() const = 0;
+	/**
+	 * Returns the content of the map file, if it is mapped into memory.
+	 *
+	 * @return The content with @link MapSize @endlink bytes, which stays valid until the map is unloaded,
+	 *         or `nullptr` if the file is not mapped.
+	 */
+	virtual const unsigned char *MapData() = 0;
 };
 
-extern IEngineMap *CreateEngineMap();
+extern IEngineMap *CreateEngineMap(class IEngine *pEngine = nullptr);
 
 #endif
@@ -22,6 +22,7 @@
 #include <type_traits>
 
 struct CAntibotRoundData;
+class CTickProfiler;
 
 // When recording a demo on the server, the ClientId -1 is used
 enum
@@ -262,6 +263,16 @@ public:
 	virtual void RedirectClient(int ClientId, int Port) = 0;
 	virtual void ChangeMap(const char *pMap) = 0;
 	virtual void ReloadMap() = 0;
+	/**
+	 * Starts loading a map in the background, so changing to it later does not stall the server.
+	 *
+	 * @param pMap The name of the map, like for @link ChangeMap @endlink.
+	 */
+	virtual void PreloadMap(const char *pMapName) = 0;
+	/**
+	 * Discards a map which is loaded in the background, e.g. because the vote for it failed.
+	 */
+	virtual void CancelMapPreload() = 0;
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 
@@ -295,6 +306,8 @@ public:
 	virtual const char *GetMapName() const = 0;
 
 	virtual bool IsSixup(int ClientId) const = 0;
+
+	virtual CTickProfiler *TickProfiler() = 0;
 };
 
 class IGameServer : public IInterface
@@ -314,6 +327,12 @@ public:
 
 	virtual void OnTick() = 0;
 
+	// Called once before any snapshots of the current tick are created.
+	//
+	// Used to prepare snapshot data that does not depend on the snapping
+	// client, so it can be shared by all the following `OnSnap` calls.
+	virtual void OnPreSnap() = 0;
+
 	// Snap for a specific client.
 	//
 	// GlobalSnap is true when sending snapshots to all clients,
@@ -51,7 +51,16 @@ public:
 	// has to be called to return the connection back to the pool
 	virtual void Disconnect() = 0;
 
+	// groups the following statements until they are committed or rolled back,
+	// connection has to be established
+	//
+	// returns true on success
+	virtual bool BeginTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool CommitTransaction(char *pError, int ErrorSize) = 0;
+	virtual bool RollbackTransaction(char *pError, int ErrorSize) = 0;
+
 	// ? for Placeholders, connection has to be established, can overwrite previous prepared statements
+	// statements are cached per connection, so preparing the same query text again is cheap
 	//
 	// returns true on success
 	virtual bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize) = 0;
@@ -93,6 +102,12 @@ private:
 	char m_aPrefix[64];
 
 protected:
+	enum
+	{
+		// prepared statements kept per connection, the least recently used one is dropped
+		MAX_CACHED_STATEMENTS = 64,
+	};
+
 	void FormatCreateRace(char *aBuf, unsigned int BufferSize, bool Backup) const;
 	void FormatCreateTeamrace(char *aBuf, unsigned int BufferSize, const char *pIdType, bool Backup) const;
 	void FormatCreateMaps(char *aBuf, unsigned int BufferSize) const;
@@ -7,7 +7,9 @@
 #include <engine/console.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cinttypes>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -67,8 +69,18 @@ struct CSqlExecData
 
 	std::unique_ptr<const ISqlData> m_pThreadData;
 	const char *m_pName;
+	// when the query was added to the queue
+	int64_t m_QueueTime = time_get();
+
+	// creates the connection of ADD_MYSQL and ADD_SQLITE
+	std::unique_ptr<IDbConnection> CreateConnection() const;
+	// passes the result to the main thread
+	void Complete(bool Success);
 };
 
+// number of queued writes which are executed in a single transaction at most
+static constexpr int MAX_WRITE_BATCH = 32;
+
 CSqlExecData::CSqlExecData(
 	CDbConnectionPool::FRead pFunc,
 	std::unique_ptr<const ISqlData> pThreadData,
@@ -120,15 +132,49 @@ CSqlExecData::CSqlExecData(IConsole *pConsole, CDbConnectionPool::Mode m) :
 	m_Ptr.m_Print.m_Mode = m;
 }
 
+std::unique_ptr<IDbConnection> CSqlExecData::CreateConnection() const
+{
+	if(m_Mode == ADD_MYSQL)
+		return CreateMysqlConnection(m_Ptr.m_Mysql.m_Config);
+	dbg_assert(m_Mode == ADD_SQLITE, "query doesn't add a database");
+	return CreateSqliteConnection(m_Ptr.m_Sqlite.m_Filename, true);
+}
+
+void CSqlExecData::Complete(bool Success)
+{
+	if(m_pThreadData != nullptr && m_pThreadData->m_pResult != nullptr)
+	{
+		m_pThreadData->m_pResult->m_Success = Success;
+		m_pThreadData->m_pResult->m_Completed.store(true);
+	}
+}
+
 void CDbConnectionPool::Print(IConsole *pConsole, Mode DatabaseMode)
 {
+	if(DatabaseMode == Mode::READ)
+	{
+		AddRead(std::make_unique<CSqlExecData>(pConsole, DatabaseMode));
+		return;
+	}
 	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pConsole, DatabaseMode);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
 }
 
+CDbConnectionPool::CWriteStats CDbConnectionPool::WriteStats() const
+{
+	const CLockScope LockScope(m_pShared->m_WriteStatsLock);
+	return m_pShared->m_WriteStats;
+}
+
 void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64])
 {
+	if(DatabaseMode == Mode::READ)
+	{
+		const CLockScope LockScope(m_pShared->m_ReadLock);
+		m_pShared->m_vpReadServers.push_back(std::make_unique<CSqlExecData>(DatabaseMode, aFilename));
+		return;
+	}
 	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, aFilename);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
@@ -136,6 +182,12 @@ void CDbConnectionPool::RegisterSqliteDatabase(Mode DatabaseMode, const char aFi
 
 void CDbConnectionPool::RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig)
 {
+	if(DatabaseMode == Mode::READ)
+	{
+		const CLockScope LockScope(m_pShared->m_ReadLock);
+		m_pShared->m_vpReadServers.push_back(std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig));
+		return;
+	}
 	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(DatabaseMode, pMysqlConfig);
 	m_InsertIdx %= std::size(m_pShared->m_aQueries);
 	m_pShared->m_NumBackup.Signal();
@@ -146,9 +198,17 @@ void CDbConnectionPool::Execute(
 	std::unique_ptr<const ISqlData> pSqlRequestData,
 	const char *pName)
 {
-	m_pShared->m_aQueries[m_InsertIdx++] = std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName);
-	m_InsertIdx %= std::size(m_pShared->m_aQueries);
-	m_pShared->m_NumBackup.Signal();
+	AddRead(std::make_unique<CSqlExecData>(pFunc, std::move(pSqlRequestData), pName));
+}
+
+void CDbConnectionPool::AddRead(std::unique_ptr<CSqlExecData> pData)
+{
+	StartReadWorkers();
+	{
+		const CLockScope LockScope(m_pShared->m_ReadLock);
+		m_pShared->m_vpReadQueries.push_back(std::move(pData));
+	}
+	m_pShared->m_NumReads.Signal();
 }
 
 void CDbConnectionPool::ExecuteWrite(
@@ -161,6 +221,41 @@ void CDbConnectionPool::ExecuteWrite(
 	m_pShared->m_NumBackup.Signal();
 }
 
+bool CDbConnectionPool::CSharedData::IsQueuedWrite(CSemaphore &Semaphore, int JobNum)
+{
+	if(Semaphore.GetApproximateValue() <= 0)
+		return false;
+	const CSqlExecData *pData = m_aQueries[JobNum % std::size(m_aQueries)].get();
+	return pData != nullptr && pData->m_Mode == CSqlExecData::WRITE_ACCESS;
+}
+
+void CDbConnectionPool::CSharedData::RecordQuery(bool Write, const char *pName, int64_t QueueTime, int64_t StartTime, bool Success)
+{
+	const int64_t Now = time_get();
+	const CLockScope LockScope(m_StatsLock);
+	CQueryStats &Stats = m_aQueryStats[Write][pName];
+	Stats.m_NumQueries++;
+	if(!Success)
+		Stats.m_NumFailed++;
+	Stats.m_WaitSum += StartTime - QueueTime;
+	Stats.m_ExecuteSum += Now - StartTime;
+	Stats.m_MaxLatency = std::max(Stats.m_MaxLatency, Now - QueueTime);
+}
+
+void CDbConnectionPool::CSharedData::PrintQueryStats(IConsole *pConsole, bool Write)
+{
+	const CLockScope LockScope(m_StatsLock);
+	for(const auto &[Name, Stats] : m_aQueryStats[Write])
+	{
+		const double ToMs = 1000.0 / time_freq() / Stats.m_NumQueries;
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "%s: %" PRId64 " queries (%" PRId64 " failed), waited avg %.2fms, executed avg %.2fms, latency max %.2fms",
+			Name.c_str(), Stats.m_NumQueries, Stats.m_NumFailed, Stats.m_WaitSum * ToMs, Stats.m_ExecuteSum * ToMs,
+			Stats.m_MaxLatency * 1000.0 / time_freq());
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+}
+
 void CDbConnectionPool::OnShutdown()
 {
 	if(m_Shutdown)
@@ -168,6 +263,15 @@ void CDbConnectionPool::OnShutdown()
 	m_Shutdown = true;
 	m_pShared->m_Shutdown.store(true);
 	m_pShared->m_NumBackup.Signal();
+	// the read workers dismiss the remaining reads and exit
+	for(size_t i = 0; i < m_vpReadWorkerThreads.size(); i++)
+	{
+		{
+			const CLockScope LockScope(m_pShared->m_ReadLock);
+			m_pShared->m_vpReadQueries.push_back(nullptr);
+		}
+		m_pShared->m_NumReads.Signal();
+	}
 	int i = 0;
 	while(m_pShared->m_Shutdown.load())
 	{
@@ -182,7 +286,7 @@ void CDbConnectionPool::OnShutdown()
 }
 
 // The backup worker thread looks at write queries and stores them
-// in the sqlite database (WRITE_BACKUP). It skips over read queries.
+// in the sqlite database (WRITE_BACKUP). It skips over the other queries.
 // After processing the query, it gets passed on to the Worker thread.
 // This is done to not loose ranks when the server shuts down before all
 // queries are executed on the mysql server
@@ -232,18 +336,34 @@ void CBackup::ProcessQueries()
 		}
 		else if(pThreadData->m_Mode == CSqlExecData::WRITE_ACCESS && m_pWriteBackup.get())
 		{
-			bool Success = CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData, Write::BACKUP_FIRST);
-			if(m_DebugSql || !Success)
-				dbg_msg("sql", "[%i] %s done on write backup database, Success=%i", JobNum, pThreadData->m_pName, Success);
+			// store the writes which are already queued behind this one in the same transaction
+			CSqlExecData *apWrites[MAX_WRITE_BATCH] = {pThreadData};
+			int NumWrites = 1;
+			while(NumWrites < MAX_WRITE_BATCH && m_pShared->IsQueuedWrite(m_pShared->m_NumBackup, JobNum + NumWrites))
+			{
+				m_pShared->m_NumBackup.Wait();
+				apWrites[NumWrites] = m_pShared->m_aQueries[(JobNum + NumWrites) % std::size(m_pShared->m_aQueries)].get();
+				NumWrites++;
+			}
+			bool aSuccess[MAX_WRITE_BATCH];
+			CDbConnectionPool::ExecSqlWrites(m_pWriteBackup.get(), apWrites, NumWrites, Write::BACKUP_FIRST, aSuccess);
+			for(int i = 0; i < NumWrites; i++)
+			{
+				if(m_DebugSql || !aSuccess[i])
+					dbg_msg("sql", "[%i] %s done on write backup database, Success=%i", JobNum + i, apWrites[i]->m_pName, aSuccess[i]);
+			}
+			// the last one is passed on below
+			for(int i = 1; i < NumWrites; i++)
+				m_pShared->m_NumWorker.Signal();
+			JobNum += NumWrites - 1;
 		}
 		m_pShared->m_NumWorker.Signal();
 	}
 }
 
-// the worker threads executes queries on mysql or sqlite. If we write on
-// a mysql server and have a backup server configured, we'll remove the
-// entry from the backup server after completing it on the write server.
-// static void Worker(void *pUser);
+// the worker thread executes the writes on mysql or sqlite in order. If we
+// write on a mysql server and have a backup server configured, we'll remove
+// the entry from the backup server after completing it on the write server.
 class CWorker
 {
 public:
@@ -254,6 +374,8 @@ public:
 
 private:
 	void Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode);
+	void ProcessWrites(int FirstJobNum, std::unique_ptr<CSqlExecData> *ppWrites, int NumWrites, bool *pFailMode);
+	void Complete(int JobNum, CSqlExecData *pData, bool Success);
 
 	bool m_DebugSql;
 
@@ -264,8 +386,7 @@ private:
 	//                most one WRITE server. The WRITE server for all DDNet
 	//                Servers must be the same (to counteract double loads).
 	//                There may be one WRITE_BACKUP sqlite server.
-	// This variable should only change, before the worker threads
-	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+	// The READ servers are used by the read workers.
 	std::unique_ptr<IDbConnection> m_pWriteConnection;
 	std::unique_ptr<IDbConnection> m_pWriteBackup;
 
@@ -282,10 +403,8 @@ void CWorker::Start(void *pUser)
 
 void CWorker::ProcessQueries()
 {
-	// remember last working server and try to connect to it first
-	int ReadServer = 0;
-	// enter fail mode when a sql request fails, skip read request during it and
-	// write to the backup database until all requests are handled
+	// enter fail mode when a sql request fails, write to the backup database
+	// during it until all requests are handled
 	bool FailMode = false;
 	for(int JobNum = 0;; JobNum++)
 	{
@@ -301,136 +420,172 @@ void CWorker::ProcessQueries()
 			m_pShared->m_Shutdown.store(false);
 			return;
 		}
+		const int QueueDepth = 1 + m_pShared->m_NumWorker.GetApproximateValue() + m_pShared->m_NumBackup.GetApproximateValue();
+		{
+			const CLockScope LockScope(m_pShared->m_WriteStatsLock);
+			m_pShared->m_WriteStats.m_MaxQueueDepth = std::max(m_pShared->m_WriteStats.m_MaxQueueDepth, QueueDepth);
+		}
 		bool Success = false;
 		switch(pThreadData->m_Mode)
 		{
-		case CSqlExecData::READ_ACCESS:
-		{
-			for(size_t i = 0; i < m_vpReadConnections.size(); i++)
-			{
-				if(m_pShared->m_Shutdown)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during shutdown", JobNum, pThreadData->m_pName);
-					break;
-				}
-				if(FailMode)
-				{
-					dbg_msg("sql", "[%i] %s dismissed read request during FailMode", JobNum, pThreadData->m_pName);
-					break;
-				}
-				int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
-				if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
-				{
-					ReadServer = CurServer;
-					if(m_DebugSql)
-						dbg_msg("sql", "[%i] %s done on read database %d", JobNum, pThreadData->m_pName, CurServer);
-					Success = true;
-					break;
-				}
-			}
-			if(!Success)
-			{
-				FailMode = true;
-			}
-		}
-		break;
 		case CSqlExecData::WRITE_ACCESS:
 		{
-			if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, pThreadData->m_pName);
-			}
-			else if(FailMode && m_pWriteBackup != nullptr)
-			{
-				dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, pThreadData->m_pName);
-			}
-			else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), pThreadData.get(), Write::NORMAL))
-			{
-				if(m_DebugSql)
-					dbg_msg("sql", "[%i] %s done on write database", JobNum, pThreadData->m_pName);
-				Success = true;
-			}
-			// enter fail mode if not successful
-			FailMode = FailMode || !Success;
-			const Write w = Success ? Write::NORMAL_SUCCEEDED : Write::NORMAL_FAILED;
-			if(m_pWriteBackup && CDbConnectionPool::ExecSqlFunc(m_pWriteBackup.get(), pThreadData.get(), w))
+			// writes which are already queued behind this one are committed together
+			std::unique_ptr<CSqlExecData> apWrites[MAX_WRITE_BATCH];
+			apWrites[0] = std::move(pThreadData);
+			const int FirstJobNum = JobNum;
+			int NumWrites = 1;
+			while(NumWrites < MAX_WRITE_BATCH && m_pShared->IsQueuedWrite(m_pShared->m_NumWorker, JobNum + 1))
 			{
-				if(m_DebugSql)
-					dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", JobNum, pThreadData->m_pName);
-				Success = true;
+				m_pShared->m_NumWorker.Wait();
+				JobNum++;
+				apWrites[NumWrites++] = std::move(m_pShared->m_aQueries[JobNum % std::size(m_pShared->m_aQueries)]);
 			}
+			ProcessWrites(FirstJobNum, apWrites, NumWrites, &FailMode);
 		}
-		break;
+		// the writes are already completed
+		continue;
 		case CSqlExecData::ADD_MYSQL:
-		{
-			auto pMysql = CreateMysqlConnection(pThreadData->m_Ptr.m_Mysql.m_Config);
-			switch(pThreadData->m_Ptr.m_Mysql.m_Mode)
-			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pMysql));
-				break;
-			case CDbConnectionPool::Mode::WRITE:
-				m_pWriteConnection = std::move(pMysql);
-				break;
-			case CDbConnectionPool::Mode::WRITE_BACKUP:
-				m_pWriteBackup = std::move(pMysql);
-				break;
-			case CDbConnectionPool::Mode::NUM_MODES:
-				break;
-			}
-			Success = true;
-			break;
-		}
 		case CSqlExecData::ADD_SQLITE:
 		{
-			auto pSqlite = CreateSqliteConnection(pThreadData->m_Ptr.m_Sqlite.m_Filename, true);
-			switch(pThreadData->m_Ptr.m_Sqlite.m_Mode)
-			{
-			case CDbConnectionPool::Mode::READ:
-				m_vpReadConnections.push_back(std::move(pSqlite));
-				break;
-			case CDbConnectionPool::Mode::WRITE:
-				m_pWriteConnection = std::move(pSqlite);
-				break;
-			case CDbConnectionPool::Mode::WRITE_BACKUP:
-				m_pWriteBackup = std::move(pSqlite);
-				break;
-			case CDbConnectionPool::Mode::NUM_MODES:
-				break;
-			}
+			const CDbConnectionPool::Mode Mode = pThreadData->m_Mode == CSqlExecData::ADD_MYSQL ? pThreadData->m_Ptr.m_Mysql.m_Mode : pThreadData->m_Ptr.m_Sqlite.m_Mode;
+			if(Mode == CDbConnectionPool::Mode::WRITE)
+				m_pWriteConnection = pThreadData->CreateConnection();
+			else if(Mode == CDbConnectionPool::Mode::WRITE_BACKUP)
+				m_pWriteBackup = pThreadData->CreateConnection();
+			else
+				dbg_assert_failed("read databases are added to the read workers");
 			Success = true;
 			break;
 		}
+		case CSqlExecData::READ_ACCESS:
+			dbg_assert_failed("reads are executed by the read workers");
 		case CSqlExecData::PRINT:
 			Print(pThreadData->m_Ptr.m_Print.m_pConsole, pThreadData->m_Ptr.m_Print.m_Mode);
 			Success = true;
 			break;
 		}
-		if(!Success)
-			dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pThreadData->m_pName);
-		if(pThreadData->m_pThreadData != nullptr && pThreadData->m_pThreadData->m_pResult != nullptr)
+		Complete(JobNum, pThreadData.get(), Success);
+	}
+}
+
+void CWorker::ProcessWrites(int FirstJobNum, std::unique_ptr<CSqlExecData> *ppWrites, int NumWrites, bool *pFailMode)
+{
+	const int64_t StartTime = time_get();
+	CSqlExecData *apWrites[MAX_WRITE_BATCH];
+	for(int i = 0; i < NumWrites; i++)
+		apWrites[i] = ppWrites[i].get();
+
+	const bool SkipToBackup = (m_pShared->m_Shutdown || *pFailMode) && m_pWriteBackup != nullptr;
+	bool Batched = false;
+	if(!SkipToBackup && NumWrites > 1)
+	{
+		Batched = CDbConnectionPool::ExecSqlBatch(m_pWriteConnection.get(), apWrites, NumWrites, Write::NORMAL);
+		const CLockScope LockScope(m_pShared->m_WriteStatsLock);
+		m_pShared->m_WriteStats.m_NumTransactions++;
+		if(Batched)
+			m_pShared->m_WriteStats.m_NumBatchedWrites += NumWrites;
+		else
+			m_pShared->m_WriteStats.m_NumFailedTransactions++;
+	}
+
+	bool aWritten[MAX_WRITE_BATCH] = {};
+	for(int i = 0; i < NumWrites; i++)
+	{
+		const int JobNum = FirstJobNum + i;
+		if(Batched)
+		{
+			if(m_DebugSql)
+				dbg_msg("sql", "[%i] %s done on write database", JobNum, apWrites[i]->m_pName);
+			aWritten[i] = true;
+		}
+		else if(m_pShared->m_Shutdown && m_pWriteBackup != nullptr)
+		{
+			dbg_msg("sql", "[%i] %s skipped to backup database during shutdown", JobNum, apWrites[i]->m_pName);
+		}
+		else if(*pFailMode && m_pWriteBackup != nullptr)
+		{
+			dbg_msg("sql", "[%i] %s skipped to backup database during FailMode", JobNum, apWrites[i]->m_pName);
+		}
+		else if(CDbConnectionPool::ExecSqlFunc(m_pWriteConnection.get(), apWrites[i], Write::NORMAL))
 		{
-			pThreadData->m_pThreadData->m_pResult->m_Success = Success;
-			pThreadData->m_pThreadData->m_pResult->m_Completed.store(true);
+			if(m_DebugSql)
+				dbg_msg("sql", "[%i] %s done on write database", JobNum, apWrites[i]->m_pName);
+			aWritten[i] = true;
 		}
+		// enter fail mode if not successful
+		*pFailMode = *pFailMode || !aWritten[i];
+	}
+
+	bool aSuccess[MAX_WRITE_BATCH];
+	std::copy(aWritten, aWritten + NumWrites, aSuccess);
+	if(m_pWriteBackup)
+	{
+		for(const Write w : {Write::NORMAL_SUCCEEDED, Write::NORMAL_FAILED})
+		{
+			CSqlExecData *apMoves[MAX_WRITE_BATCH];
+			int aMoveIndices[MAX_WRITE_BATCH];
+			int NumMoves = 0;
+			for(int i = 0; i < NumWrites; i++)
+			{
+				if(aWritten[i] == (w == Write::NORMAL_SUCCEEDED))
+				{
+					apMoves[NumMoves] = apWrites[i];
+					aMoveIndices[NumMoves] = i;
+					NumMoves++;
+				}
+			}
+			if(NumMoves == 0)
+				continue;
+			bool aMoved[MAX_WRITE_BATCH];
+			CDbConnectionPool::ExecSqlWrites(m_pWriteBackup.get(), apMoves, NumMoves, w, aMoved);
+			for(int i = 0; i < NumMoves; i++)
+			{
+				if(!aMoved[i])
+					continue;
+				if(m_DebugSql)
+					dbg_msg("sql", "[%i] %s done move write on backup database to non-backup table", FirstJobNum + aMoveIndices[i], apMoves[i]->m_pName);
+				aSuccess[aMoveIndices[i]] = true;
+			}
+		}
+	}
+
+	for(int i = 0; i < NumWrites; i++)
+	{
+		m_pShared->RecordQuery(true, apWrites[i]->m_pName, apWrites[i]->m_QueueTime, StartTime, aSuccess[i]);
+		Complete(FirstJobNum + i, apWrites[i], aSuccess[i]);
 	}
 }
 
+void CWorker::Complete(int JobNum, CSqlExecData *pData, bool Success)
+{
+	if(!Success)
+		dbg_msg("sql", "[%i] %s failed on all databases", JobNum, pData->m_pName);
+	pData->Complete(Success);
+}
+
 void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 {
-	if(DatabaseMode == CDbConnectionPool::Mode::READ)
-	{
-		for(auto &pReadConnection : m_vpReadConnections)
-			pReadConnection->Print(pConsole, "Read");
-		if(m_vpReadConnections.empty())
-			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
-	}
-	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
+	if(DatabaseMode == CDbConnectionPool::Mode::WRITE)
 	{
 		if(m_pWriteConnection)
 			m_pWriteConnection->Print(pConsole, "Write");
 		else
 			pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no write databases");
+
+		CDbConnectionPool::CWriteStats Stats;
+		{
+			const CLockScope LockScope(m_pShared->m_WriteStatsLock);
+			Stats = m_pShared->m_WriteStats;
+		}
+		char aBuf[256];
+		str_format(aBuf, sizeof(aBuf), "Queue: %d waiting, at most %d",
+			m_pShared->m_NumWorker.GetApproximateValue() + m_pShared->m_NumBackup.GetApproximateValue(), Stats.m_MaxQueueDepth);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		str_format(aBuf, sizeof(aBuf), "Transactions: %" PRId64 " with %" PRId64 " writes (%" PRId64 " rolled back)",
+			Stats.m_NumTransactions, Stats.m_NumBatchedWrites, Stats.m_NumFailedTransactions);
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+		m_pShared->PrintQueryStats(pConsole, true);
 	}
 	else if(DatabaseMode == CDbConnectionPool::Mode::WRITE_BACKUP)
 	{
@@ -441,6 +596,135 @@ void CWorker::Print(IConsole *pConsole, CDbConnectionPool::Mode DatabaseMode)
 	}
 }
 
+// the read workers execute the read queries concurrently, each with its
+// own connection to every READ server
+class CReadWorker
+{
+public:
+	CReadWorker(std::shared_ptr<CDbConnectionPool::CSharedData> pShared, int Id, int DebugSql) :
+		m_Id(Id), m_DebugSql(DebugSql), m_pShared(std::move(pShared)) {}
+	static void Start(void *pUser);
+
+private:
+	int m_Id;
+	bool m_DebugSql;
+
+	void ProcessQueries();
+	// connects to the READ servers registered since the last query
+	void UpdateConnections();
+	void Print(IConsole *pConsole);
+
+	std::vector<std::unique_ptr<IDbConnection>> m_vpReadConnections;
+
+	std::shared_ptr<CDbConnectionPool::CSharedData> m_pShared;
+};
+
+/* static */
+void CReadWorker::Start(void *pUser)
+{
+	CReadWorker *pThis = (CReadWorker *)pUser;
+	pThis->ProcessQueries();
+	delete pThis;
+}
+
+void CReadWorker::ProcessQueries()
+{
+	// remember last working server and try to connect to it first
+	int ReadServer = 0;
+	// enter fail mode when a sql request fails, skip read requests during it
+	// until all requests are handled
+	bool FailMode = false;
+	for(int JobNum = 0;; JobNum++)
+	{
+		if(FailMode && m_pShared->m_NumReads.GetApproximateValue() == 0)
+		{
+			FailMode = false;
+		}
+		m_pShared->m_NumReads.Wait();
+		std::unique_ptr<CSqlExecData> pThreadData;
+		{
+			const CLockScope LockScope(m_pShared->m_ReadLock);
+			pThreadData = std::move(m_pShared->m_vpReadQueries.front());
+			m_pShared->m_vpReadQueries.pop_front();
+		}
+		if(pThreadData == nullptr)
+			return;
+		UpdateConnections();
+
+		if(pThreadData->m_Mode == CSqlExecData::PRINT)
+		{
+			Print(pThreadData->m_Ptr.m_Print.m_pConsole);
+			continue;
+		}
+		dbg_assert(pThreadData->m_Mode == CSqlExecData::READ_ACCESS, "read worker got a query which isn't a read");
+
+		const int64_t StartTime = time_get();
+		bool Success = false;
+		for(size_t i = 0; i < m_vpReadConnections.size(); i++)
+		{
+			if(m_pShared->m_Shutdown)
+			{
+				dbg_msg("sql", "[read %d:%i] %s dismissed read request during shutdown", m_Id, JobNum, pThreadData->m_pName);
+				break;
+			}
+			if(FailMode)
+			{
+				dbg_msg("sql", "[read %d:%i] %s dismissed read request during FailMode", m_Id, JobNum, pThreadData->m_pName);
+				break;
+			}
+			int CurServer = (ReadServer + i) % (int)m_vpReadConnections.size();
+			if(CDbConnectionPool::ExecSqlFunc(m_vpReadConnections[CurServer].get(), pThreadData.get(), Write::NORMAL))
+			{
+				ReadServer = CurServer;
+				if(m_DebugSql)
+					dbg_msg("sql", "[read %d:%i] %s done on read database %d", m_Id, JobNum, pThreadData->m_pName, CurServer);
+				Success = true;
+				break;
+			}
+		}
+		if(!Success)
+		{
+			FailMode = true;
+			dbg_msg("sql", "[read %d:%i] %s failed on all databases", m_Id, JobNum, pThreadData->m_pName);
+		}
+		m_pShared->RecordQuery(false, pThreadData->m_pName, pThreadData->m_QueueTime, StartTime, Success);
+		pThreadData->Complete(Success);
+	}
+}
+
+void CReadWorker::UpdateConnections()
+{
+	const CLockScope LockScope(m_pShared->m_ReadLock);
+	while(m_vpReadConnections.size() < m_pShared->m_vpReadServers.size())
+		m_vpReadConnections.push_back(m_pShared->m_vpReadServers[m_vpReadConnections.size()]->CreateConnection());
+}
+
+void CReadWorker::Print(IConsole *pConsole)
+{
+	for(auto &pReadConnection : m_vpReadConnections)
+		pReadConnection->Print(pConsole, "Read");
+	if(m_vpReadConnections.empty())
+		pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "There are no read databases");
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "Read workers: %d, %d queries waiting", m_pShared->m_NumReadWorkers, m_pShared->m_NumReads.GetApproximateValue());
+	pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	m_pShared->PrintQueryStats(pConsole, false);
+}
+
+void CDbConnectionPool::StartReadWorkers()
+{
+	if(!m_vpReadWorkerThreads.empty() || m_Shutdown)
+		return;
+	m_pShared->m_NumReadWorkers = std::max(g_Config.m_SvSqlReadWorkers, 1);
+	for(int i = 0; i < m_pShared->m_NumReadWorkers; i++)
+	{
+		char aName[64];
+		str_format(aName, sizeof(aName), "database read worker %d", i);
+		m_vpReadWorkerThreads.push_back(thread_init(CReadWorker::Start, new CReadWorker(m_pShared, i, g_Config.m_DbgSql), aName));
+	}
+}
+
 /* static */
 bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pData, Write w)
 {
@@ -475,6 +759,59 @@ bool CDbConnectionPool::ExecSqlFunc(IDbConnection *pConnection, CSqlExecData *pD
 	return Success;
 }
 
+/* static */
+bool CDbConnectionPool::ExecSqlBatch(IDbConnection *pConnection, CSqlExecData *const *ppData, int NumData, Write w)
+{
+	if(pConnection == nullptr)
+	{
+		dbg_msg("sql", "No database given");
+		return false;
+	}
+	char aError[256] = "unknown error";
+	if(!pConnection->Connect(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed connecting to db: %s", aError);
+		return false;
+	}
+	if(!pConnection->BeginTransaction(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed starting transaction: %s", aError);
+		pConnection->Disconnect();
+		return false;
+	}
+	bool Success = true;
+	for(int i = 0; i < NumData && Success; i++)
+	{
+		dbg_assert(ppData[i]->m_Mode == CSqlExecData::WRITE_ACCESS, "only writes can be batched");
+		Success = ppData[i]->m_Ptr.m_pWriteFunc(pConnection, ppData[i]->m_pThreadData.get(), w, aError, sizeof(aError));
+		if(!Success)
+			dbg_msg("sql", "%s failed in transaction: %s", ppData[i]->m_pName, aError);
+	}
+	if(Success && !pConnection->CommitTransaction(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed committing transaction: %s", aError);
+		Success = false;
+	}
+	if(!Success && !pConnection->RollbackTransaction(aError, sizeof(aError)))
+	{
+		dbg_msg("sql", "failed rolling back transaction: %s", aError);
+	}
+	pConnection->Disconnect();
+	return Success;
+}
+
+/* static */
+void CDbConnectionPool::ExecSqlWrites(IDbConnection *pConnection, CSqlExecData *const *ppData, int NumData, Write w, bool *pSuccess)
+{
+	if(NumData > 1 && ExecSqlBatch(pConnection, ppData, NumData, w))
+	{
+		std::fill(pSuccess, pSuccess + NumData, true);
+		return;
+	}
+	for(int i = 0; i < NumData; i++)
+		pSuccess[i] = ExecSqlFunc(pConnection, ppData[i], w);
+}
+
 CDbConnectionPool::CDbConnectionPool()
 {
 	m_pShared = std::make_shared<CSharedData>();
@@ -489,4 +826,6 @@ CDbConnectionPool::~CDbConnectionPool()
 		thread_wait(m_pWorkerThread);
 	if(m_pBackupThread)
 		thread_wait(m_pBackupThread);
+	for(void *pThread : m_vpReadWorkerThreads)
+		thread_wait(pThread);
 }
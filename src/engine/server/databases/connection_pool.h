@@ -1,10 +1,14 @@
 #ifndef ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 #define ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
 
+#include <base/lock.h>
 #include <base/tl/threading.h>
 
 #include <atomic>
+#include <deque>
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 class IDbConnection;
@@ -77,11 +81,26 @@ public:
 		NUM_MODES,
 	};
 
+	// prints the servers and the statistics of the queries executed on them
 	void Print(IConsole *pConsole, Mode DatabaseMode);
 
+	// statistics of the write worker, printed with the write databases
+	struct CWriteStats
+	{
+		int m_MaxQueueDepth = 0;
+		// writes committed in transactions of more than one write
+		int64_t m_NumBatchedWrites = 0;
+		int64_t m_NumTransactions = 0;
+		int64_t m_NumFailedTransactions = 0;
+	};
+	CWriteStats WriteStats() const;
+
+	// READ servers are used by all read workers, each with its own connection
 	void RegisterSqliteDatabase(Mode DatabaseMode, const char aFilename[64]);
 	void RegisterMysqlDatabase(Mode DatabaseMode, const CMysqlConfig *pMysqlConfig);
 
+	// executed by one of the sv_sql_read_workers read workers, not ordered
+	// with other reads or the writes
 	void Execute(
 		FRead pFunc,
 		std::unique_ptr<const ISqlData> pSqlRequestData,
@@ -97,9 +116,18 @@ public:
 
 	friend class CWorker;
 	friend class CBackup;
+	friend class CReadWorker;
 
 private:
 	static bool ExecSqlFunc(IDbConnection *pConnection, struct CSqlExecData *pData, Write w);
+	// executes the writes in one transaction, which is rolled back if any of them fails
+	static bool ExecSqlBatch(IDbConnection *pConnection, struct CSqlExecData *const *ppData, int NumData, Write w);
+	// executes the writes in one transaction if possible, otherwise one by one
+	static void ExecSqlWrites(IDbConnection *pConnection, struct CSqlExecData *const *ppData, int NumData, Write w, bool *pSuccess);
+
+	// the read workers are started with the first read, after the config was executed
+	void StartReadWorkers();
+	void AddRead(std::unique_ptr<struct CSqlExecData> pData);
 
 	// Only the main thread accesses this variable. It points to the index,
 	// where the next query is added to the queue.
@@ -107,6 +135,17 @@ private:
 
 	bool m_Shutdown = false;
 
+	struct CQueryStats
+	{
+		int64_t m_NumQueries = 0;
+		int64_t m_NumFailed = 0;
+		// time in the queue
+		int64_t m_WaitSum = 0;
+		// time on the database
+		int64_t m_ExecuteSum = 0;
+		int64_t m_MaxLatency = 0;
+	};
+
 	struct CSharedData
 	{
 		// Used as signal that shutdown is in progress from main thread to
@@ -124,11 +163,38 @@ private:
 
 		// spsc queue with additional backup worker to look at queries first.
 		std::unique_ptr<struct CSqlExecData> m_aQueries[512];
+
+		// Returns whether the query at `JobNum` is a write which was already
+		// passed on to the thread waiting on `Semaphore`, so that thread can
+		// take it without blocking. Only that thread may call this.
+		bool IsQueuedWrite(CSemaphore &Semaphore, int JobNum);
+
+		// Reads don't go through the queue above, they are taken by any of
+		// the read workers. A nullptr tells one read worker to exit.
+		CLock m_ReadLock;
+		std::deque<std::unique_ptr<struct CSqlExecData>> m_vpReadQueries GUARDED_BY(m_ReadLock);
+		// the READ servers in the order they were registered, each read
+		// worker connects to them on its own
+		std::vector<std::unique_ptr<struct CSqlExecData>> m_vpReadServers GUARDED_BY(m_ReadLock);
+		CSemaphore m_NumReads;
+		// only set before the read workers are started
+		int m_NumReadWorkers = 0;
+
+		// statistics by the name of the query
+		CLock m_StatsLock;
+		std::map<std::string, CQueryStats> m_aQueryStats[2] GUARDED_BY(m_StatsLock);
+		void RecordQuery(bool Write, const char *pName, int64_t QueueTime, int64_t StartTime, bool Success) REQUIRES(!m_StatsLock);
+		void PrintQueryStats(IConsole *pConsole, bool Write) REQUIRES(!m_StatsLock);
+
+		// updated by the write worker
+		CLock m_WriteStatsLock;
+		CWriteStats m_WriteStats GUARDED_BY(m_WriteStatsLock);
 	};
 
 	std::shared_ptr<CSharedData> m_pShared;
 	void *m_pWorkerThread = nullptr;
 	void *m_pBackupThread = nullptr;
+	std::vector<void *> m_vpReadWorkerThreads;
 };
 
 #endif // ENGINE_SERVER_DATABASES_CONNECTION_POOL_H
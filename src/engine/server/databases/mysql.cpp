@@ -9,8 +9,10 @@
 
 #include <mysql.h>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
+#include <string>
 #include <vector>
 
 // MySQL >= 8.0.1 removed my_bool, 8.0.2 accidentally reintroduced it: https://bugs.mysql.com/bug.php?id=87337
@@ -83,6 +85,10 @@ public:
 	bool Connect(char *pError, int ErrorSize) override;
 	void Disconnect() override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 	bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize) override;
 
 	void BindString(int Idx, const char *pString) override;
@@ -112,11 +118,21 @@ private:
 		void operator()(MYSQL_STMT *pStmt) const;
 	};
 
+	struct CCachedStatement
+	{
+		std::string m_Query;
+		std::unique_ptr<MYSQL_STMT, CStmtDeleter> m_pStmt;
+		int64_t m_LastUse;
+	};
+
 	char m_aErrorDetail[128];
 	void StoreErrorMysql(const char *pContext);
 	void StoreErrorStmt(const char *pContext);
+	void StoreErrorStmt(MYSQL_STMT *pStmt, const char *pContext);
 	bool ConnectImpl();
-	bool PrepareAndExecuteStatement(const char *pStmt);
+	bool ExecuteQuery(const char *pQuery);
+	// the connection can't execute anything else while a result is pending
+	void FreeResult();
 
 	union UParameterExtra
 	{
@@ -129,7 +145,10 @@ private:
 	bool m_NewQuery = false;
 	bool m_HaveConnection = false;
 	MYSQL m_Mysql;
-	std::unique_ptr<MYSQL_STMT, CStmtDeleter> m_pStmt = nullptr;
+	// points into m_vCachedStatements
+	MYSQL_STMT *m_pStmt = nullptr;
+	std::vector<CCachedStatement> m_vCachedStatements;
+	int64_t m_NumStatementUses = 0;
 	std::vector<MYSQL_BIND> m_vStmtParameters;
 	std::vector<UParameterExtra> m_vStmtParameterExtras;
 
@@ -170,22 +189,31 @@ void CMysqlConnection::StoreErrorMysql(const char *pContext)
 
 void CMysqlConnection::StoreErrorStmt(const char *pContext)
 {
-	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:stmt:%d): %s", pContext, mysql_stmt_errno(m_pStmt.get()), mysql_stmt_error(m_pStmt.get()));
+	StoreErrorStmt(m_pStmt, pContext);
+}
+
+void CMysqlConnection::StoreErrorStmt(MYSQL_STMT *pStmt, const char *pContext)
+{
+	str_format(m_aErrorDetail, sizeof(m_aErrorDetail), "(%s:stmt:%d): %s", pContext, mysql_stmt_errno(pStmt), mysql_stmt_error(pStmt));
 }
 
-bool CMysqlConnection::PrepareAndExecuteStatement(const char *pStmt)
+bool CMysqlConnection::ExecuteQuery(const char *pQuery)
 {
-	if(mysql_stmt_prepare(m_pStmt.get(), pStmt, str_length(pStmt)))
+	if(mysql_real_query(&m_Mysql, pQuery, str_length(pQuery)))
 	{
-		StoreErrorStmt("prepare");
+		StoreErrorMysql("query");
 		return false;
 	}
-	if(mysql_stmt_execute(m_pStmt.get()))
+	return true;
+}
+
+void CMysqlConnection::FreeResult()
+{
+	if(m_pStmt && mysql_stmt_free_result(m_pStmt))
 	{
-		StoreErrorStmt("execute");
-		return false;
+		StoreErrorStmt("free_result");
+		dbg_msg("mysql", "can't free last result %s", m_aErrorDetail);
 	}
-	return true;
 }
 
 void CMysqlConnection::Print(IConsole *pConsole, const char *pMode)
@@ -220,11 +248,7 @@ bool CMysqlConnection::ConnectImpl()
 {
 	if(m_HaveConnection)
 	{
-		if(m_pStmt && mysql_stmt_free_result(m_pStmt.get()))
-		{
-			StoreErrorStmt("free_result");
-			dbg_msg("mysql", "can't free last result %s", m_aErrorDetail);
-		}
+		FreeResult();
 		if(!mysql_select_db(&m_Mysql, m_Config.m_aDatabase))
 		{
 			// Success.
@@ -237,7 +261,9 @@ bool CMysqlConnection::ConnectImpl()
 		mysql_init(&m_Mysql);
 	}
 
+	// statements belong to the previous connection
 	m_pStmt = nullptr;
+	m_vCachedStatements.clear();
 	unsigned int OptConnectTimeout = 60;
 	unsigned int OptReadTimeout = 60;
 	unsigned int OptWriteTimeout = 120;
@@ -259,10 +285,8 @@ bool CMysqlConnection::ConnectImpl()
 	}
 	m_HaveConnection = true;
 
-	m_pStmt = std::unique_ptr<MYSQL_STMT, CStmtDeleter>(mysql_stmt_init(&m_Mysql));
-
 	// Apparently MYSQL_SET_CHARSET_NAME is not enough
-	if(!PrepareAndExecuteStatement("SET CHARACTER SET utf8mb4"))
+	if(!ExecuteQuery("SET CHARACTER SET utf8mb4"))
 	{
 		return false;
 	}
@@ -272,7 +296,7 @@ bool CMysqlConnection::ConnectImpl()
 		char aCreateDatabase[1024];
 		// create database
 		str_format(aCreateDatabase, sizeof(aCreateDatabase), "CREATE DATABASE IF NOT EXISTS %s CHARACTER SET utf8mb4", m_Config.m_aDatabase);
-		if(!PrepareAndExecuteStatement(aCreateDatabase))
+		if(!ExecuteQuery(aCreateDatabase))
 		{
 			return false;
 		}
@@ -298,11 +322,11 @@ bool CMysqlConnection::ConnectImpl()
 		FormatCreateSaves(aCreateSaves, sizeof(aCreateSaves), /* Backup */ false);
 		FormatCreatePoints(aCreatePoints, sizeof(aCreatePoints));
 
-		if(!PrepareAndExecuteStatement(aCreateRace) ||
-			!PrepareAndExecuteStatement(aCreateTeamrace) ||
-			!PrepareAndExecuteStatement(aCreateMaps) ||
-			!PrepareAndExecuteStatement(aCreateSaves) ||
-			!PrepareAndExecuteStatement(aCreatePoints))
+		if(!ExecuteQuery(aCreateRace) ||
+			!ExecuteQuery(aCreateTeamrace) ||
+			!ExecuteQuery(aCreateMaps) ||
+			!ExecuteQuery(aCreateSaves) ||
+			!ExecuteQuery(aCreatePoints))
 		{
 			return false;
 		}
@@ -317,16 +341,72 @@ void CMysqlConnection::Disconnect()
 	m_InUse.store(false);
 }
 
-bool CMysqlConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+bool CMysqlConnection::BeginTransaction(char *pError, int ErrorSize)
 {
-	if(mysql_stmt_prepare(m_pStmt.get(), pStmt, str_length(pStmt)))
+	FreeResult();
+	if(!ExecuteQuery("START TRANSACTION"))
 	{
-		StoreErrorStmt("prepare");
 		str_copy(pError, m_aErrorDetail, ErrorSize);
 		return false;
 	}
+	return true;
+}
+
+bool CMysqlConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	FreeResult();
+	if(mysql_commit(&m_Mysql))
+	{
+		StoreErrorMysql("commit");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return false;
+	}
+	return true;
+}
+
+bool CMysqlConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	FreeResult();
+	if(mysql_rollback(&m_Mysql))
+	{
+		StoreErrorMysql("rollback");
+		str_copy(pError, m_aErrorDetail, ErrorSize);
+		return false;
+	}
+	return true;
+}
+
+bool CMysqlConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+{
+	FreeResult();
+	m_pStmt = nullptr;
+	m_NumStatementUses++;
+	auto It = std::find_if(m_vCachedStatements.begin(), m_vCachedStatements.end(), [&](const CCachedStatement &Statement) {
+		return Statement.m_Query == pStmt;
+	});
+	if(It == m_vCachedStatements.end())
+	{
+		std::unique_ptr<MYSQL_STMT, CStmtDeleter> pNewStmt(mysql_stmt_init(&m_Mysql));
+		if(mysql_stmt_prepare(pNewStmt.get(), pStmt, str_length(pStmt)))
+		{
+			StoreErrorStmt(pNewStmt.get(), "prepare");
+			str_copy(pError, m_aErrorDetail, ErrorSize);
+			return false;
+		}
+		if(m_vCachedStatements.size() >= MAX_CACHED_STATEMENTS)
+		{
+			auto Oldest = std::min_element(m_vCachedStatements.begin(), m_vCachedStatements.end(), [](const CCachedStatement &Left, const CCachedStatement &Right) {
+				return Left.m_LastUse < Right.m_LastUse;
+			});
+			m_vCachedStatements.erase(Oldest);
+		}
+		m_vCachedStatements.push_back({pStmt, std::move(pNewStmt), 0});
+		It = m_vCachedStatements.end() - 1;
+	}
+	It->m_LastUse = m_NumStatementUses;
+	m_pStmt = It->m_pStmt.get();
 	m_NewQuery = true;
-	unsigned NumParameters = mysql_stmt_param_count(m_pStmt.get());
+	unsigned NumParameters = mysql_stmt_param_count(m_pStmt);
 	m_vStmtParameters.resize(NumParameters);
 	m_vStmtParameterExtras.resize(NumParameters);
 	if(NumParameters)
@@ -444,20 +524,20 @@ bool CMysqlConnection::Step(bool *pEnd, char *pError, int ErrorSize)
 	if(m_NewQuery)
 	{
 		m_NewQuery = false;
-		if(mysql_stmt_bind_param(m_pStmt.get(), m_vStmtParameters.data()))
+		if(mysql_stmt_bind_param(m_pStmt, m_vStmtParameters.data()))
 		{
 			StoreErrorStmt("bind_param");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return false;
 		}
-		if(mysql_stmt_execute(m_pStmt.get()))
+		if(mysql_stmt_execute(m_pStmt))
 		{
 			StoreErrorStmt("execute");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return false;
 		}
 	}
-	int Result = mysql_stmt_fetch(m_pStmt.get());
+	int Result = mysql_stmt_fetch(m_pStmt);
 	if(Result == 1)
 	{
 		StoreErrorStmt("fetch");
@@ -475,19 +555,19 @@ bool CMysqlConnection::ExecuteUpdate(int *pNumUpdated, char *pError, int ErrorSi
 	if(m_NewQuery)
 	{
 		m_NewQuery = false;
-		if(mysql_stmt_bind_param(m_pStmt.get(), m_vStmtParameters.data()))
+		if(mysql_stmt_bind_param(m_pStmt, m_vStmtParameters.data()))
 		{
 			StoreErrorStmt("bind_param");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return false;
 		}
-		if(mysql_stmt_execute(m_pStmt.get()))
+		if(mysql_stmt_execute(m_pStmt))
 		{
 			StoreErrorStmt("execute");
 			str_copy(pError, m_aErrorDetail, ErrorSize);
 			return false;
 		}
-		*pNumUpdated = mysql_stmt_affected_rows(m_pStmt.get());
+		*pNumUpdated = mysql_stmt_affected_rows(m_pStmt);
 		return true;
 	}
 	str_copy(pError, "tried to execute update without query", ErrorSize);
@@ -508,7 +588,7 @@ bool CMysqlConnection::IsNull(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:null");
 		dbg_assert_failed("Error in IsNull: error fetching column %s", m_aErrorDetail);
@@ -531,7 +611,7 @@ float CMysqlConnection::GetFloat(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:float");
 		dbg_assert_failed("Error in GetFloat: error fetching column %s", m_aErrorDetail);
@@ -555,7 +635,7 @@ int CMysqlConnection::GetInt(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:int");
 		dbg_assert_failed("Error in GetInt: error fetching column %s", m_aErrorDetail);
@@ -579,7 +659,7 @@ int64_t CMysqlConnection::GetInt64(int Col)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = nullptr;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:int64");
 		dbg_assert_failed("Error in GetInt64: error fetching column %s", m_aErrorDetail);
@@ -610,7 +690,7 @@ void CMysqlConnection::GetString(int Col, char *pBuffer, int BufferSize)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = &Error;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:string");
 		dbg_assert_failed("Error in GetString: error fetching column %s", m_aErrorDetail);
@@ -635,7 +715,7 @@ int CMysqlConnection::GetBlob(int Col, unsigned char *pBuffer, int BufferSize)
 	Bind.is_null = &IsNull;
 	Bind.is_unsigned = false;
 	Bind.error = &Error;
-	if(mysql_stmt_fetch_column(m_pStmt.get(), &Bind, Col, 0))
+	if(mysql_stmt_fetch_column(m_pStmt, &Bind, Col, 0))
 	{
 		StoreErrorStmt("fetch_column:blob");
 		dbg_assert_failed("Error in GetBlob: error fetching column %s", m_aErrorDetail);
@@ -6,7 +6,11 @@
 
 #include <sqlite3.h>
 
+#include <algorithm>
 #include <atomic>
+#include <limits>
+#include <string>
+#include <vector>
 
 class CSqliteConnection : public IDbConnection
 {
@@ -31,6 +35,10 @@ public:
 	bool Connect(char *pError, int ErrorSize) override;
 	void Disconnect() override;
 
+	bool BeginTransaction(char *pError, int ErrorSize) override;
+	bool CommitTransaction(char *pError, int ErrorSize) override;
+	bool RollbackTransaction(char *pError, int ErrorSize) override;
+
 	bool PrepareStatement(const char *pStmt, char *pError, int ErrorSize) override;
 
 	void BindString(int Idx, const char *pString) override;
@@ -62,9 +70,21 @@ private:
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	bool m_Setup;
 
+	struct CCachedStatement
+	{
+		std::string m_Query;
+		sqlite3_stmt *m_pStmt;
+		int64_t m_LastUse;
+	};
+
 	sqlite3 *m_pDb;
+	// points into m_vCachedStatements
 	sqlite3_stmt *m_pStmt;
+	std::vector<CCachedStatement> m_vCachedStatements;
+	int64_t m_NumStatementUses = 0;
 	bool m_Done; // no more rows available for Step
+	// resets the current statement so it doesn't keep the database locked
+	void ResetStatement();
 	// returns false, if the query succeeded
 	bool Execute(const char *pQuery, char *pError, int ErrorSize);
 	// returns true on failure
@@ -90,8 +110,8 @@ CSqliteConnection::CSqliteConnection(const char *pFilename, bool Setup) :
 
 CSqliteConnection::~CSqliteConnection()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	for(const CCachedStatement &Statement : m_vCachedStatements)
+		sqlite3_finalize(Statement.m_pStmt);
 	sqlite3_close(m_pDb);
 	m_pDb = nullptr;
 }
@@ -143,8 +163,9 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 		return false;
 	}
 
-	// wait for database to unlock so we don't have to handle SQLITE_BUSY errors
-	sqlite3_busy_timeout(m_pDb, -1);
+	// wait for database to unlock so we don't have to handle SQLITE_BUSY errors,
+	// a timeout that isn't positive would disable waiting
+	sqlite3_busy_timeout(m_pDb, std::numeric_limits<int>::max());
 
 	if(m_Setup)
 	{
@@ -183,27 +204,71 @@ bool CSqliteConnection::ConnectImpl(char *pError, int ErrorSize)
 
 void CSqliteConnection::Disconnect()
 {
-	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
-	m_pStmt = nullptr;
+	ResetStatement();
 	m_InUse.store(false);
 }
 
-bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+bool CSqliteConnection::BeginTransaction(char *pError, int ErrorSize)
+{
+	// take the write lock right away, a deferred transaction can't wait for it when upgrading
+	return Execute("BEGIN IMMEDIATE", pError, ErrorSize);
+}
+
+bool CSqliteConnection::CommitTransaction(char *pError, int ErrorSize)
+{
+	ResetStatement();
+	return Execute("COMMIT", pError, ErrorSize);
+}
+
+bool CSqliteConnection::RollbackTransaction(char *pError, int ErrorSize)
+{
+	ResetStatement();
+	return Execute("ROLLBACK", pError, ErrorSize);
+}
+
+void CSqliteConnection::ResetStatement()
 {
 	if(m_pStmt != nullptr)
-		sqlite3_finalize(m_pStmt);
+	{
+		sqlite3_reset(m_pStmt);
+		sqlite3_clear_bindings(m_pStmt);
+	}
 	m_pStmt = nullptr;
-	int Result = sqlite3_prepare_v2(
-		m_pDb,
-		pStmt,
-		-1, // pStmt can be any length
-		&m_pStmt,
-		nullptr);
-	if(FormatError(Result, pError, ErrorSize))
+}
+
+bool CSqliteConnection::PrepareStatement(const char *pStmt, char *pError, int ErrorSize)
+{
+	ResetStatement();
+	m_NumStatementUses++;
+	auto It = std::find_if(m_vCachedStatements.begin(), m_vCachedStatements.end(), [&](const CCachedStatement &Statement) {
+		return Statement.m_Query == pStmt;
+	});
+	if(It == m_vCachedStatements.end())
 	{
-		return false;
+		sqlite3_stmt *pNewStmt = nullptr;
+		int Result = sqlite3_prepare_v2(
+			m_pDb,
+			pStmt,
+			-1, // pStmt can be any length
+			&pNewStmt,
+			nullptr);
+		if(FormatError(Result, pError, ErrorSize))
+		{
+			return false;
+		}
+		if(m_vCachedStatements.size() >= MAX_CACHED_STATEMENTS)
+		{
+			auto Oldest = std::min_element(m_vCachedStatements.begin(), m_vCachedStatements.end(), [](const CCachedStatement &Left, const CCachedStatement &Right) {
+				return Left.m_LastUse < Right.m_LastUse;
+			});
+			sqlite3_finalize(Oldest->m_pStmt);
+			m_vCachedStatements.erase(Oldest);
+		}
+		m_vCachedStatements.push_back({pStmt, pNewStmt, 0});
+		It = m_vCachedStatements.end() - 1;
 	}
+	It->m_LastUse = m_NumStatementUses;
+	m_pStmt = It->m_pStmt;
 	m_Done = false;
 	return true;
 }
@@ -0,0 +1,131 @@
+#include "map_preload.h"
+
+#include <base/log.h>
+
+#include <engine/shared/map.h>
+#include <engine/storage.h>
+
+#include <zlib.h>
+
+CMapFileData::~CMapFileData()
+{
+	Free();
+}
+
+CMapFileData &CMapFileData::operator=(CMapFileData &&Other)
+{
+	if(this != &Other)
+	{
+		Free();
+		m_pData = Other.m_pData;
+		m_Size = Other.m_Size;
+		m_Sha256 = Other.m_Sha256;
+		m_Crc = Other.m_Crc;
+		Other.m_pData = nullptr;
+		Other.m_Size = 0;
+	}
+	return *this;
+}
+
+void CMapFileData::Copy(const unsigned char *pData, unsigned Size, const SHA256_DIGEST &Sha256, unsigned Crc)
+{
+	Free();
+	m_pData = static_cast<unsigned char *>(malloc(Size));
+	mem_copy(m_pData, pData, Size);
+	m_Size = Size;
+	m_Sha256 = Sha256;
+	m_Crc = Crc;
+}
+
+bool CMapFileData::Load(IStorage *pStorage, const char *pFilename)
+{
+	void *pData;
+	unsigned Size;
+	if(!pStorage->ReadFile(pFilename, IStorage::TYPE_ALL, &pData, &Size))
+	{
+		return false;
+	}
+	if(Size == 0)
+	{
+		free(pData);
+		return false;
+	}
+
+	Free();
+	m_pData = static_cast<unsigned char *>(pData);
+	m_Size = Size;
+	m_Sha256 = sha256(m_pData, m_Size);
+	m_Crc = crc32(0, m_pData, m_Size);
+	return true;
+}
+
+void CMapFileData::Free()
+{
+	free(m_pData);
+	m_pData = nullptr;
+	m_Size = 0;
+}
+
+CMapPreload::CMapPreload(IEngine *pEngine, IStorage *pStorage, const char *pFilename, const char *pSixupFilename) :
+	m_pStorage(pStorage),
+	m_pMap(std::make_unique<CMap>(pEngine))
+{
+	str_copy(m_aFilename, pFilename);
+	str_copy(m_aSixupFilename, pSixupFilename != nullptr ? pSixupFilename : "");
+	Abortable(true);
+	SetPriority(PRIORITY_BACKGROUND);
+}
+
+CMapPreload::~CMapPreload() = default;
+
+void CMapPreload::Run()
+{
+	{
+		const std::unique_lock Lock(m_Mutex);
+		if(m_Cancelled)
+			return;
+		m_Started = true;
+	}
+	Load();
+	{
+		const std::unique_lock Lock(m_Mutex);
+		m_Finished = true;
+	}
+	m_FinishedCondition.notify_all();
+}
+
+bool CMapPreload::CancelOrWait()
+{
+	std::unique_lock Lock(m_Mutex);
+	if(!m_Started)
+	{
+		// still queued, possibly behind other background jobs
+		m_Cancelled = true;
+		Lock.unlock();
+		Abort();
+		return false;
+	}
+	m_FinishedCondition.wait(Lock, [this]() { return m_Finished; });
+	return true;
+}
+
+void CMapPreload::Load()
+{
+	const int64_t StartTime = time_get();
+	m_MapLoaded = m_pMap->Load(m_pStorage, m_aFilename);
+	if(!m_MapLoaded)
+	{
+		log_warn("server", "failed to preload map '%s'", m_aFilename);
+		return;
+	}
+	if(m_aSixupFilename[0] != '\0' && !m_SixupData.Load(m_pStorage, m_aSixupFilename))
+	{
+		log_warn("sixup", "failed to preload map '%s'", m_aSixupFilename);
+	}
+	log_debug("server", "preloaded map '%s' in %.2fms", m_aFilename, (time_get() - StartTime) * 1000.0 / time_freq());
+}
+
+IEngineMap *CMapPreload::Map()
+{
+	return m_MapLoaded ? m_pMap.get() : nullptr;
+}
@@ -0,0 +1,111 @@
+#ifndef ENGINE_SERVER_MAP_PRELOAD_H
+#define ENGINE_SERVER_MAP_PRELOAD_H
+
+#include <base/hash.h>
+#include <base/system.h>
+
+#include <engine/shared/jobs.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+class CMap;
+class IEngine;
+class IEngineMap;
+class IStorage;
+
+/**
+ * The content of a map file which is sent to clients. It is always a copy in memory,
+ * so replacing the file on disk cannot affect downloads which are in progress.
+ */
+class CMapFileData
+{
+	unsigned char *m_pData = nullptr;
+	unsigned m_Size = 0;
+	SHA256_DIGEST m_Sha256 = SHA256_ZEROED;
+	unsigned m_Crc = 0;
+
+public:
+	CMapFileData() = default;
+	~CMapFileData();
+
+	CMapFileData(const CMapFileData &Other) = delete;
+	CMapFileData &operator=(const CMapFileData &Other) = delete;
+	CMapFileData &operator=(CMapFileData &&Other);
+
+	/**
+	 * Copies the content of a file which was already loaded and hashed, e.g. by the map.
+	 */
+	void Copy(const unsigned char *pData, unsigned Size, const SHA256_DIGEST &Sha256, unsigned Crc);
+	/**
+	 * Reads the file into memory and hashes its content.
+	 *
+	 * @return `true` on success, otherwise the previous content is kept.
+	 */
+	[[nodiscard]] bool Load(IStorage *pStorage, const char *pFilename);
+	void Free();
+
+	bool IsLoaded() const { return m_pData != nullptr; }
+	const unsigned char *Data() const { return m_pData; }
+	unsigned Size() const { return m_Size; }
+	const SHA256_DIGEST &Sha256() const { return m_Sha256; }
+	unsigned Crc() const { return m_Crc; }
+};
+
+/**
+ * Loads the next map in the background, so changing to it does not stall the server.
+ */
+class CMapPreload : public IJob
+{
+	IStorage *m_pStorage;
+	char m_aFilename[IO_MAX_PATH_LENGTH];
+	char m_aSixupFilename[IO_MAX_PATH_LENGTH];
+
+	std::unique_ptr<CMap> m_pMap;
+	bool m_MapLoaded = false;
+	CMapFileData m_SixupData;
+
+	std::mutex m_Mutex;
+	// signaled when a started job has finished loading
+	std::condition_variable m_FinishedCondition;
+	bool m_Started = false;
+	bool m_Cancelled = false;
+	bool m_Finished = false;
+
+	void Run() override;
+	void Load();
+
+public:
+	/**
+	 * @param pEngine The engine which runs the jobs to decompress the map data.
+	 * @param pStorage The storage to load the files from.
+	 * @param pFilename The filename of the map.
+	 * @param pSixupFilename The filename of the 0.7 version of the map, or `nullptr` to not load it.
+	 */
+	CMapPreload(IEngine *pEngine, IStorage *pStorage, const char *pFilename, const char *pSixupFilename);
+	~CMapPreload() override;
+
+	const char *Filename() const { return m_aFilename; }
+	const char *SixupFilename() const { return m_aSixupFilename; }
+
+	/**
+	 * Cancels the job if it has not been started yet, otherwise blocks until it is finished.
+	 *
+	 * @return `true` if the job has finished, `false` if it was cancelled and the map
+	 * has to be loaded by the caller.
+	 */
+	bool CancelOrWait();
+
+	/**
+	 * The loaded map, or `nullptr` if it could not be loaded. Only valid once the job is done.
+	 */
+	IEngineMap *Map();
+	/**
+	 * The content of the 0.7 version of the map, not loaded if it was not requested or
+	 * could not be loaded. Only valid once the job is done.
+	 */
+	CMapFileData &SixupData() { return m_SixupData; }
+};
+
+#endif
@@ -88,6 +88,7 @@ class CRegister : public IRegister
 				m_pRegister(std::move(pRegister)),
 				m_pHttp(pHttp)
 			{
+				SetPriority(PRIORITY_BACKGROUND);
 			}
 			~CJob() override = default;
 		};
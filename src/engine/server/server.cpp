@@ -5,6 +5,7 @@
 
 #include "databases/connection.h"
 #include "databases/connection_pool.h"
+#include "map_preload.h"
 #include "register.h"
 
 #include <base/logger.h>
@@ -20,6 +21,7 @@
 #include <engine/shared/compression.h>
 #include <engine/shared/config.h>
 #include <engine/shared/console.h>
+#include <engine/shared/csv.h>
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
@@ -231,9 +233,9 @@ CServer::CServer()
 {
 	m_pConfig = &g_Config;
 	for(int i = 0; i < MAX_CLIENTS; i++)
-		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true);
-	m_aDemoRecorder[RECORDER_MANUAL] = CDemoRecorder(&m_SnapshotDelta, false);
-	m_aDemoRecorder[RECORDER_AUTO] = CDemoRecorder(&m_SnapshotDelta, false);
+		m_aDemoRecorder[i] = CDemoRecorder(&m_SnapshotDelta, true, &m_DemoRecordWriter);
+	m_aDemoRecorder[RECORDER_MANUAL] = CDemoRecorder(&m_SnapshotDelta, false, &m_DemoRecordWriter);
+	m_aDemoRecorder[RECORDER_AUTO] = CDemoRecorder(&m_SnapshotDelta, false, &m_DemoRecordWriter);
 
 	m_pGameServer = nullptr;
 
@@ -242,12 +244,6 @@ CServer::CServer()
 
 	m_aShutdownReason[0] = 0;
 
-	for(int i = 0; i < NUM_MAP_TYPES; i++)
-	{
-		m_apCurrentMapData[i] = nullptr;
-		m_aCurrentMapSize[i] = 0;
-	}
-
 	m_MapReload = false;
 	m_SameMapReload = false;
 	m_ReloadedWhenEmpty = false;
@@ -262,6 +258,13 @@ CServer::CServer()
 	m_ServerInfoNumRequests = 0;
 	m_ServerInfoNeedsUpdate = false;
 
+	// the engine sections are registered first so their indices match the enum
+	static const char *const s_apProfileSectionNames[NUM_PROFILE_SECTIONS] = {"loop", "network", "input", "game", "snapshot", "engine", "flush", "wait"};
+	for(const char *pName : s_apProfileSectionNames)
+		m_TickProfiler.AddSection(pName);
+	m_TickProfilerSummaryTime = std::chrono::nanoseconds(0);
+	m_aTickProfilerCsvFile[0] = '\0';
+
 #ifdef CONF_FAMILY_UNIX
 	m_ConnLoggingSocketCreated = false;
 #endif
@@ -276,11 +279,6 @@ CServer::CServer()
 
 CServer::~CServer()
 {
-	for(auto &pCurrentMapData : m_apCurrentMapData)
-	{
-		free(pCurrentMapData);
-	}
-
 	if(m_RunServer != UNINITIALIZED)
 	{
 		for(auto &Client : m_aClients)
@@ -1002,6 +1000,9 @@ void CServer::DoSnapshot()
 {
 	bool IsGlobalSnap = Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0;
 
+	// build the client independent part of the snapshots once
+	GameServer()->OnPreSnap();
+
 	if(m_aDemoRecorder[RECORDER_MANUAL].IsRecording() || m_aDemoRecorder[RECORDER_AUTO].IsRecording())
 	{
 		// create snapshot for demo recording
@@ -1019,6 +1020,22 @@ void CServer::DoSnapshot()
 			m_aDemoRecorder[RECORDER_AUTO].RecordSnapshot(Tick(), aData, SnapshotSize);
 	}
 
+	if(m_SnapshotWorkers.NumThreads() != Config()->m_SvSnapshotThreads)
+	{
+		m_SnapshotWorkers.Shutdown();
+		m_SnapshotWorkers.Init(Config()->m_SvSnapshotThreads);
+	}
+	if(m_vSnapshotTasks.empty())
+		m_vSnapshotTasks.resize(MAX_CLIENTS);
+	for(int Sixup = 0; Sixup < 2; Sixup++)
+	{
+		m_aClientSnapshotDeltas[Sixup].SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, Sixup);
+		m_aClientSnapshotDeltas[Sixup].SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, Sixup);
+	}
+	int NumSnapshotTasks = 0;
+	int aSnapshotCrcs[MAX_CLIENTS];
+	int aDeltaTicks[MAX_CLIENTS];
+
 	// create snapshots for all clients
 	for(int i = 0; i < MaxClients(); i++)
 	{
@@ -1055,7 +1072,7 @@ void CServer::DoSnapshot()
 				m_aDemoRecorder[i].RecordSnapshot(Tick(), aData, SnapshotSize);
 			}
 
-			int Crc = pData->Crc();
+			aSnapshotCrcs[i] = pData->Crc();
 
 			// remove old snapshots
 			// keep 3 seconds worth of snapshots
@@ -1078,59 +1095,76 @@ void CServer::DoSnapshot()
 						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
 				}
 			}
+			aDeltaTicks[i] = DeltaTick;
 
-			// create delta
+			// the demo recorders share these static sizes
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
 			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
 
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+			// the delta is created against the stored copy of the snapshot
+			CSnapshotWorkers::CTask &Task = m_vSnapshotTasks[NumSnapshotTasks++];
+			Task.m_ClientId = i;
+			Task.m_pFrom = pDeltashot;
+			m_aClients[i].m_Snapshots.Get(m_CurrentGameTick, nullptr, &Task.m_pTo, nullptr);
+			Task.m_pDelta = &m_aClientSnapshotDeltas[m_aClients[i].m_Sixup];
+		}
+	}
 
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+	// create and compress the deltas
+	m_SnapshotWorkers.Run(m_vSnapshotTasks.data(), NumSnapshotTasks);
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
-				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
+	// send them in client order
+	for(int t = 0; t < NumSnapshotTasks; t++)
+	{
+		const CSnapshotWorkers::CTask &Task = m_vSnapshotTasks[t];
+		const int i = Task.m_ClientId;
+		const int Crc = aSnapshotCrcs[i];
+		const int DeltaTick = aDeltaTicks[i];
 
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-				}
-			}
-			else
+		if(Task.m_CompressedSize)
+		{
+			// split it into packets
+			const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+
+			const int SnapshotSize = Task.m_CompressedSize;
+			int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+
+			for(int n = 0, Left = SnapshotSize; Left > 0; n++)
 			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
-				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				int Chunk = Left < MaxSize ? Left : MaxSize;
+				Left -= Chunk;
+
+				if(NumPackets == 1)
+				{
+					CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+					Msg.AddInt(m_CurrentGameTick);
+					Msg.AddInt(m_CurrentGameTick - DeltaTick);
+					Msg.AddInt(Crc);
+					Msg.AddInt(Chunk);
+					Msg.AddRaw(&Task.m_aCompressedData[n * MaxSize], Chunk);
+					SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				}
+				else
+				{
+					CMsgPacker Msg(NETMSG_SNAP, true);
+					Msg.AddInt(m_CurrentGameTick);
+					Msg.AddInt(m_CurrentGameTick - DeltaTick);
+					Msg.AddInt(NumPackets);
+					Msg.AddInt(n);
+					Msg.AddInt(Crc);
+					Msg.AddInt(Chunk);
+					Msg.AddRaw(&Task.m_aCompressedData[n * MaxSize], Chunk);
+					SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				}
 			}
 		}
+		else
+		{
+			CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+			Msg.AddInt(m_CurrentGameTick);
+			Msg.AddInt(m_CurrentGameTick - DeltaTick);
+			SendMsg(&Msg, MSGFLAG_FLUSH, i);
+		}
 	}
 
 	if(IsGlobalSnap)
@@ -1326,9 +1360,9 @@ void CServer::SendRconType(int ClientId, bool UsernameReq)
 void CServer::GetMapInfo(char *pMapName, int MapNameSize, int *pMapSize, SHA256_DIGEST *pMapSha256, int *pMapCrc)
 {
 	str_copy(pMapName, GetMapName(), MapNameSize);
-	*pMapSize = m_aCurrentMapSize[MAP_TYPE_SIX];
-	*pMapSha256 = m_aCurrentMapSha256[MAP_TYPE_SIX];
-	*pMapCrc = m_aCurrentMapCrc[MAP_TYPE_SIX];
+	*pMapSize = m_aCurrentMapData[MAP_TYPE_SIX].Size();
+	*pMapSha256 = m_aCurrentMapData[MAP_TYPE_SIX].Sha256();
+	*pMapCrc = m_aCurrentMapData[MAP_TYPE_SIX].Crc();
 }
 
 void CServer::SendCapabilities(int ClientId)
@@ -1345,9 +1379,9 @@ void CServer::SendMap(int ClientId)
 	{
 		CMsgPacker Msg(NETMSG_MAP_DETAILS, true);
 		Msg.AddString(GetMapName(), 0);
-		Msg.AddRaw(&m_aCurrentMapSha256[MapType].data, sizeof(m_aCurrentMapSha256[MapType].data));
-		Msg.AddInt(m_aCurrentMapCrc[MapType]);
-		Msg.AddInt(m_aCurrentMapSize[MapType]);
+		Msg.AddRaw(&m_aCurrentMapData[MapType].Sha256().data, sizeof(m_aCurrentMapData[MapType].Sha256().data));
+		Msg.AddInt(m_aCurrentMapData[MapType].Crc());
+		Msg.AddInt(m_aCurrentMapData[MapType].Size());
 		if(m_aMapDownloadUrl[0])
 		{
 			Msg.AddString(m_aMapDownloadUrl, 0);
@@ -1361,13 +1395,13 @@ void CServer::SendMap(int ClientId)
 	{
 		CMsgPacker Msg(NETMSG_MAP_CHANGE, true);
 		Msg.AddString(GetMapName(), 0);
-		Msg.AddInt(m_aCurrentMapCrc[MapType]);
-		Msg.AddInt(m_aCurrentMapSize[MapType]);
+		Msg.AddInt(m_aCurrentMapData[MapType].Crc());
+		Msg.AddInt(m_aCurrentMapData[MapType].Size());
 		if(MapType == MAP_TYPE_SIXUP)
 		{
 			Msg.AddInt(Config()->m_SvMapWindow);
 			Msg.AddInt(1024 - 128);
-			Msg.AddRaw(m_aCurrentMapSha256[MapType].data, sizeof(m_aCurrentMapSha256[MapType].data));
+			Msg.AddRaw(m_aCurrentMapData[MapType].Sha256().data, sizeof(m_aCurrentMapData[MapType].Sha256().data));
 		}
 		SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH, ClientId);
 	}
@@ -1383,12 +1417,12 @@ void CServer::SendMapData(int ClientId, int Chunk)
 	int Last = 0;
 
 	// drop faulty map data requests
-	if(Chunk < 0 || Offset > m_aCurrentMapSize[MapType])
+	if(Chunk < 0 || Offset > m_aCurrentMapData[MapType].Size())
 		return;
 
-	if(Offset + ChunkSize >= m_aCurrentMapSize[MapType])
+	if(Offset + ChunkSize >= m_aCurrentMapData[MapType].Size())
 	{
-		ChunkSize = m_aCurrentMapSize[MapType] - Offset;
+		ChunkSize = m_aCurrentMapData[MapType].Size() - Offset;
 		Last = 1;
 	}
 
@@ -1396,11 +1430,11 @@ void CServer::SendMapData(int ClientId, int Chunk)
 	if(MapType == MAP_TYPE_SIX)
 	{
 		Msg.AddInt(Last);
-		Msg.AddInt(m_aCurrentMapCrc[MAP_TYPE_SIX]);
+		Msg.AddInt(m_aCurrentMapData[MAP_TYPE_SIX].Crc());
 		Msg.AddInt(Chunk);
 		Msg.AddInt(ChunkSize);
 	}
-	Msg.AddRaw(&m_apCurrentMapData[MapType][Offset], ChunkSize);
+	Msg.AddRaw(&m_aCurrentMapData[MapType].Data()[Offset], ChunkSize);
 	SendMsg(&Msg, MSGFLAG_VITAL | MSGFLAG_FLUSH, ClientId);
 
 	if(Config()->m_Debug)
@@ -2244,8 +2278,8 @@ void CServer::CacheServerInfo(CCache *pCache, int Type, bool SendClients)
 
 	if(Type == SERVERINFO_EXTENDED)
 	{
-		ADD_INT(p, m_aCurrentMapCrc[MAP_TYPE_SIX]);
-		ADD_INT(p, m_aCurrentMapSize[MAP_TYPE_SIX]);
+		ADD_INT(p, m_aCurrentMapData[MAP_TYPE_SIX].Crc());
+		ADD_INT(p, m_aCurrentMapData[MAP_TYPE_SIX].Size());
 	}
 
 	// gametype
@@ -2606,7 +2640,7 @@ void CServer::UpdateRegisterServerInfo()
 	int MaxClients = maximum(m_NetServer.MaxClients() - g_Config.m_SvReservedSlots, ClientCount);
 	char aMapSha256[SHA256_MAXSTRSIZE];
 
-	sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIX], aMapSha256, sizeof(aMapSha256));
+	sha256_str(m_aCurrentMapData[MAP_TYPE_SIX].Sha256(), aMapSha256, sizeof(aMapSha256));
 
 	CJsonStringWriter JsonWriter;
 
@@ -2642,7 +2676,7 @@ void CServer::UpdateRegisterServerInfo()
 	JsonWriter.WriteAttribute("sha256");
 	JsonWriter.WriteStrValue(aMapSha256);
 	JsonWriter.WriteAttribute("size");
-	JsonWriter.WriteIntValue(m_aCurrentMapSize[MAP_TYPE_SIX]);
+	JsonWriter.WriteIntValue(m_aCurrentMapData[MAP_TYPE_SIX].Size());
 	if(m_aMapDownloadUrl[0])
 	{
 		JsonWriter.WriteAttribute("url");
@@ -2860,6 +2894,101 @@ void CServer::PumpNetwork(bool PacketWaiting)
 	m_Econ.Update();
 }
 
+void CServer::UpdateTickProfiler()
+{
+	if(m_TickProfiler.Enabled() != (Config()->m_SvTickProfiler != 0))
+	{
+		m_TickProfiler.SetEnabled(Config()->m_SvTickProfiler);
+		m_TickProfilerSummaryTime = time_get_nanoseconds();
+	}
+	if(!m_TickProfiler.Enabled())
+		return;
+
+	m_TickProfiler.EndFrame();
+	const std::chrono::nanoseconds Now = time_get_nanoseconds();
+	if(Now - m_TickProfilerSummaryTime < std::chrono::seconds(1))
+		return;
+	m_TickProfilerSummaryTime = Now;
+	m_TickProfiler.Summarize();
+
+	if(Config()->m_SvTickProfilerEcon)
+	{
+		char aBuf[256];
+		for(int Section = 0; Section < m_TickProfiler.NumSections(); Section++)
+		{
+			if(m_TickProfiler.Stats(Section).m_NumSamples == 0)
+				continue;
+			char aSection[192];
+			FormatTickProfileSection(Section, aSection, sizeof(aSection));
+			str_format(aBuf, sizeof(aBuf), "[tickprofile]: map=%s players=%d %s", GetMapName(), ClientCount(), aSection);
+			m_Econ.Send(-1, aBuf);
+		}
+	}
+	WriteTickProfileCsv();
+}
+
+void CServer::FormatTickProfileSection(int Section, char *pBuffer, int BufferSize) const
+{
+	const CTickProfiler::CStats &Stats = m_TickProfiler.Stats(Section);
+	str_format(pBuffer, BufferSize, "section=%s samples=%d p50=%dus p99=%dus max=%dus total=%dus",
+		m_TickProfiler.SectionName(Section), Stats.m_NumSamples,
+		(int)(Stats.m_P50Ns / 1000), (int)(Stats.m_P99Ns / 1000), (int)(Stats.m_MaxNs / 1000), (int)(Stats.m_TotalNs / 1000));
+}
+
+void CServer::WriteTickProfileCsv()
+{
+	if(str_comp(m_aTickProfilerCsvFile, Config()->m_SvTickProfilerCsv) != 0)
+	{
+		if(m_TickProfilerCsv)
+		{
+			io_close(m_TickProfilerCsv);
+			m_TickProfilerCsv = nullptr;
+		}
+		str_copy(m_aTickProfilerCsvFile, Config()->m_SvTickProfilerCsv);
+		if(m_aTickProfilerCsvFile[0] != '\0')
+		{
+			m_TickProfilerCsv = Storage()->OpenFile(m_aTickProfilerCsvFile, IOFLAG_APPEND, IStorage::TYPE_SAVE);
+			if(!m_TickProfilerCsv)
+			{
+				log_error("server", "failed to open tick profile file '%s'", m_aTickProfilerCsvFile);
+			}
+			else if(io_length(m_TickProfilerCsv) == 0)
+			{
+				static const char *const TICK_PROFILE_HEADER[] = {"timestamp", "map", "players", "frames", "section", "samples", "p50_us", "p99_us", "max_us", "total_us"};
+				CsvWrite(m_TickProfilerCsv, std::size(TICK_PROFILE_HEADER), TICK_PROFILE_HEADER);
+			}
+		}
+	}
+	if(!m_TickProfilerCsv)
+		return;
+
+	char aTimestamp[32];
+	char aPlayers[16];
+	char aFrames[16];
+	str_format(aTimestamp, sizeof(aTimestamp), "%" PRId64, time_timestamp());
+	str_format(aPlayers, sizeof(aPlayers), "%d", ClientCount());
+	str_format(aFrames, sizeof(aFrames), "%d", m_TickProfiler.NumFrames());
+	for(int Section = 0; Section < m_TickProfiler.NumSections(); Section++)
+	{
+		const CTickProfiler::CStats &Stats = m_TickProfiler.Stats(Section);
+		if(Stats.m_NumSamples == 0)
+			continue;
+		char aSamples[16];
+		char aP50[24];
+		char aP99[24];
+		char aMax[24];
+		char aTotal[24];
+		str_format(aSamples, sizeof(aSamples), "%d", Stats.m_NumSamples);
+		str_format(aP50, sizeof(aP50), "%" PRId64, Stats.m_P50Ns / 1000);
+		str_format(aP99, sizeof(aP99), "%" PRId64, Stats.m_P99Ns / 1000);
+		str_format(aMax, sizeof(aMax), "%" PRId64, Stats.m_MaxNs / 1000);
+		str_format(aTotal, sizeof(aTotal), "%" PRId64, Stats.m_TotalNs / 1000);
+		const char *apColumns[] = {aTimestamp, GetMapName(), aPlayers, aFrames, m_TickProfiler.SectionName(Section), aSamples, aP50, aP99, aMax, aTotal};
+		CsvWrite(m_TickProfilerCsv, std::size(apColumns), apColumns);
+	}
+	io_flush(m_TickProfilerCsv);
+}
+
 const char *CServer::GetMapName() const
 {
 	return m_pCurrentMapName;
@@ -2878,6 +3007,7 @@ void CServer::ReloadMap()
 
 int CServer::LoadMap(const char *pMapName)
 {
+	const bool SameMapReload = m_SameMapReload;
 	m_MapReload = false;
 	m_SameMapReload = false;
 
@@ -2892,7 +3022,25 @@ int CServer::LoadMap(const char *pMapName)
 	{
 		return 0;
 	}
-	if(!m_pMap->Load(aBuf))
+
+	// use the map that was loaded in the background, unless it is a different file or the file is reloaded on purpose
+	std::shared_ptr<CMapPreload> pPreload = std::move(m_pMapPreload);
+	if(pPreload && (SameMapReload || str_comp(pPreload->Filename(), aBuf) != 0))
+	{
+		pPreload->Abort();
+		pPreload = nullptr;
+	}
+	// waiting for a running job is still faster than loading the map again, a queued one is not started anymore
+	if(pPreload && !pPreload->CancelOrWait())
+	{
+		pPreload = nullptr;
+	}
+	if(pPreload && pPreload->Map() != nullptr)
+	{
+		m_pMap->Take(pPreload->Map());
+		log_debug("server", "using preloaded map '%s'", aBuf);
+	}
+	else if(!m_pMap->Load(aBuf))
 	{
 		return 0;
 	}
@@ -2900,26 +3048,31 @@ int CServer::LoadMap(const char *pMapName)
 	// reinit snapshot ids
 	m_IdPool.TimeoutIds();
 
-	// get the crc of the map
-	m_aCurrentMapSha256[MAP_TYPE_SIX] = m_pMap->Sha256();
-	m_aCurrentMapCrc[MAP_TYPE_SIX] = m_pMap->Crc();
+	// copy the map file for download instead of reading it again, it was hashed when loading the map.
+	// the map's data is not used directly, it must not change if the file is replaced during a download
+	const unsigned char *pMapData = m_pMap->MapData();
+	if(pMapData != nullptr)
+	{
+		m_aCurrentMapData[MAP_TYPE_SIX].Copy(pMapData, m_pMap->MapSize(), m_pMap->Sha256(), m_pMap->Crc());
+	}
+	else
+	{
+		m_aCurrentMapData[MAP_TYPE_SIX].Free();
+		if(!m_aCurrentMapData[MAP_TYPE_SIX].Load(Storage(), aBuf))
+		{
+			log_error("server", "failed to load map '%s' for download", aBuf);
+		}
+	}
+
 	char aBufMsg[256];
 	char aSha256[SHA256_MAXSTRSIZE];
-	sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIX], aSha256, sizeof(aSha256));
+	sha256_str(m_aCurrentMapData[MAP_TYPE_SIX].Sha256(), aSha256, sizeof(aSha256));
 	str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aBufMsg);
 
 	str_copy(m_aCurrentMap, pMapName);
 	m_pCurrentMapName = fs_filename(m_aCurrentMap);
 
-	// load complete map into memory for download
-	{
-		free(m_apCurrentMapData[MAP_TYPE_SIX]);
-		void *pData;
-		Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIX]);
-		m_apCurrentMapData[MAP_TYPE_SIX] = (unsigned char *)pData;
-	}
-
 	if(Config()->m_SvMapsBaseUrl[0])
 	{
 		char aEscaped[256];
@@ -2936,8 +3089,17 @@ int CServer::LoadMap(const char *pMapName)
 	if(Config()->m_SvSixup)
 	{
 		str_format(aBuf, sizeof(aBuf), "maps7/%s.map", pMapName);
-		void *pData;
-		if(!Storage()->ReadFile(aBuf, IStorage::TYPE_ALL, &pData, &m_aCurrentMapSize[MAP_TYPE_SIXUP]))
+		bool Loaded;
+		if(pPreload && pPreload->SixupData().IsLoaded() && str_comp(pPreload->SixupFilename(), aBuf) == 0)
+		{
+			m_aCurrentMapData[MAP_TYPE_SIXUP] = std::move(pPreload->SixupData());
+			Loaded = true;
+		}
+		else
+		{
+			Loaded = m_aCurrentMapData[MAP_TYPE_SIXUP].Load(Storage(), aBuf);
+		}
+		if(!Loaded)
 		{
 			Config()->m_SvSixup = 0;
 			if(m_pRegister)
@@ -2949,20 +3111,14 @@ int CServer::LoadMap(const char *pMapName)
 		}
 		else
 		{
-			free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
-			m_apCurrentMapData[MAP_TYPE_SIXUP] = (unsigned char *)pData;
-
-			m_aCurrentMapSha256[MAP_TYPE_SIXUP] = sha256(m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
-			m_aCurrentMapCrc[MAP_TYPE_SIXUP] = crc32(0, m_apCurrentMapData[MAP_TYPE_SIXUP], m_aCurrentMapSize[MAP_TYPE_SIXUP]);
-			sha256_str(m_aCurrentMapSha256[MAP_TYPE_SIXUP], aSha256, sizeof(aSha256));
+			sha256_str(m_aCurrentMapData[MAP_TYPE_SIXUP].Sha256(), aSha256, sizeof(aSha256));
 			str_format(aBufMsg, sizeof(aBufMsg), "%s sha256 is %s", aBuf, aSha256);
 			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "sixup", aBufMsg);
 		}
 	}
 	if(!Config()->m_SvSixup)
 	{
-		free(m_apCurrentMapData[MAP_TYPE_SIXUP]);
-		m_apCurrentMapData[MAP_TYPE_SIXUP] = nullptr;
+		m_aCurrentMapData[MAP_TYPE_SIXUP].Free();
 	}
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
@@ -2971,6 +3127,39 @@ int CServer::LoadMap(const char *pMapName)
 	return 1;
 }
 
+void CServer::PreloadMap(const char *pMapName)
+{
+	char aFilename[IO_MAX_PATH_LENGTH];
+	str_format(aFilename, sizeof(aFilename), "maps/%s.map", pMapName);
+	if(!str_valid_filename(fs_filename(aFilename)) || str_comp(pMapName, m_aCurrentMap) == 0)
+	{
+		return;
+	}
+	if(m_pMapPreload)
+	{
+		if(str_comp(m_pMapPreload->Filename(), aFilename) == 0)
+		{
+			return;
+		}
+		m_pMapPreload->Abort();
+	}
+
+	char aSixupFilename[IO_MAX_PATH_LENGTH];
+	str_format(aSixupFilename, sizeof(aSixupFilename), "maps7/%s.map", pMapName);
+	m_pMapPreload = std::make_shared<CMapPreload>(Engine(), Storage(), aFilename, Config()->m_SvSixup ? aSixupFilename : nullptr);
+	Engine()->AddJob(m_pMapPreload);
+}
+
+void CServer::CancelMapPreload()
+{
+	if(m_pMapPreload)
+	{
+		// a running job cannot be stopped, the job pool frees it once it is done
+		m_pMapPreload->Abort();
+		m_pMapPreload = nullptr;
+	}
+}
+
 void CServer::UpdateDebugDummies(bool ForceDisconnect)
 {
 	if(m_PreviousDebugDummies == g_Config.m_DbgDummies && !ForceDisconnect)
@@ -3101,6 +3290,8 @@ int CServer::Run()
 	if(Port == 0)
 		log_info("server", "using port %d", BindAddr.port);
 
+	m_NetServer.SetSendQueue(Config()->m_SvNetSendQueue);
+
 #if defined(CONF_UPNP)
 	m_UPnP.Open(BindAddr);
 #endif
@@ -3161,8 +3352,13 @@ int CServer::Run()
 		UpdateServerInfo();
 		while(m_RunServer < STOPPING)
 		{
+			const std::chrono::nanoseconds LoopStart = m_TickProfiler.Enabled() ? time_get_nanoseconds() : std::chrono::nanoseconds(0);
+
 			if(NonActive)
+			{
+				CTickProfileScope Profile(&m_TickProfiler, PROFILE_NETWORK);
 				PumpNetwork(PacketWaiting);
+			}
 
 			set_new_tick();
 
@@ -3248,6 +3444,7 @@ int CServer::Run()
 
 			while(LastTime > TickStartTime(m_CurrentGameTick + 1))
 			{
+				CTickProfileScope ProfileInput(&m_TickProfiler, PROFILE_INPUT);
 				GameServer()->OnPreTickTeehistorian();
 
 				UpdateDebugDummies(false);
@@ -3291,8 +3488,11 @@ int CServer::Run()
 					if(!ClientHadInput)
 						GameServer()->OnClientPredictedInput(c, nullptr);
 				}
+				ProfileInput.Stop();
 
+				CTickProfileScope ProfileGame(&m_TickProfiler, PROFILE_GAME);
 				GameServer()->OnTick();
+				ProfileGame.Stop();
 				if(ErrorShutdown())
 				{
 					break;
@@ -3302,7 +3502,11 @@ int CServer::Run()
 			// snap game
 			if(NewTicks)
 			{
+				CTickProfileScope ProfileSnapshot(&m_TickProfiler, PROFILE_SNAPSHOT);
 				DoSnapshot();
+				ProfileSnapshot.Stop();
+
+				CTickProfileScope ProfileEngine(&m_TickProfiler, PROFILE_ENGINE);
 
 				const int CommandSendingClientId = Tick() % MAX_CLIENTS;
 				UpdateClientRconCommands(CommandSendingClientId);
@@ -3379,7 +3583,10 @@ int CServer::Run()
 			}
 
 			if(!NonActive)
+			{
+				CTickProfileScope Profile(&m_TickProfiler, PROFILE_NETWORK);
 				PumpNetwork(PacketWaiting);
+			}
 
 			NonActive = true;
 			for(const auto &Client : m_aClients)
@@ -3409,6 +3616,16 @@ int CServer::Run()
 				m_ReloadedWhenEmpty = false;
 			}
 
+			// send everything queued during this iteration
+			{
+				CTickProfileScope Profile(&m_TickProfiler, PROFILE_FLUSH);
+				m_NetServer.FlushSendQueue();
+			}
+
+			if(m_TickProfiler.Enabled())
+				m_TickProfiler.Add(PROFILE_LOOP, time_get_nanoseconds() - LoopStart);
+			CTickProfileScope ProfileWait(&m_TickProfiler, PROFILE_WAIT);
+
 			// wait for incoming data
 			if(NonActive && Config()->m_SvShutdownWhenEmpty)
 			{
@@ -3427,6 +3644,9 @@ int CServer::Run()
 				const auto MicrosecondsToWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(TickStartTime(m_CurrentGameTick + 1) - LastTime)) + 1us;
 				PacketWaiting = MicrosecondsToWait > 0us ? net_socket_read_wait(m_NetServer.Socket(), MicrosecondsToWait) : true;
 			}
+			ProfileWait.Stop();
+			UpdateTickProfiler();
+
 			if(IsInterrupted())
 			{
 				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "interrupted");
@@ -3450,12 +3670,21 @@ int CServer::Run()
 			m_NetServer.Drop(i, pDisconnectReason);
 	}
 
+	if(m_TickProfilerCsv)
+	{
+		io_close(m_TickProfilerCsv);
+		m_TickProfilerCsv = nullptr;
+	}
+
 	m_pRegister->OnShutdown();
 	m_Econ.Shutdown();
 	m_Fifo.Shutdown();
+	m_SnapshotWorkers.Shutdown();
 	Engine()->ShutdownJobs();
+	m_pMapPreload = nullptr;
 
 	GameServer()->OnShutdown(nullptr);
+	m_aCurrentMapData[MAP_TYPE_SIX].Free();
 	m_pMap->Unload();
 	DbPool()->OnShutdown();
 
@@ -3815,14 +4044,15 @@ void CServer::DemoRecorder_HandleAutoStart()
 			aFilename,
 			GameServer()->NetVersion(),
 			GetMapName(),
-			m_aCurrentMapSha256[MAP_TYPE_SIX],
-			m_aCurrentMapCrc[MAP_TYPE_SIX],
+			m_aCurrentMapData[MAP_TYPE_SIX].Sha256(),
+			m_aCurrentMapData[MAP_TYPE_SIX].Crc(),
 			"server",
-			m_aCurrentMapSize[MAP_TYPE_SIX],
-			m_apCurrentMapData[MAP_TYPE_SIX],
+			m_aCurrentMapData[MAP_TYPE_SIX].Size(),
+			m_aCurrentMapData[MAP_TYPE_SIX].Data(),
+			nullptr,
 			nullptr,
 			nullptr,
-			nullptr);
+			Config()->m_SvDemoIndex >= 2);
 
 		if(Config()->m_SvAutoDemoMax)
 		{
@@ -3855,14 +4085,15 @@ void CServer::StartRecord(int ClientId)
 			aFilename,
 			GameServer()->NetVersion(),
 			GetMapName(),
-			m_aCurrentMapSha256[MAP_TYPE_SIX],
-			m_aCurrentMapCrc[MAP_TYPE_SIX],
+			m_aCurrentMapData[MAP_TYPE_SIX].Sha256(),
+			m_aCurrentMapData[MAP_TYPE_SIX].Crc(),
 			"server",
-			m_aCurrentMapSize[MAP_TYPE_SIX],
-			m_apCurrentMapData[MAP_TYPE_SIX],
+			m_aCurrentMapData[MAP_TYPE_SIX].Size(),
+			m_aCurrentMapData[MAP_TYPE_SIX].Data(),
 			nullptr,
 			nullptr,
-			nullptr);
+			nullptr,
+			Config()->m_SvDemoIndex >= 2);
 	}
 }
 
@@ -3917,14 +4148,15 @@ void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 		aFilename,
 		pServer->GameServer()->NetVersion(),
 		pServer->GetMapName(),
-		pServer->m_aCurrentMapSha256[MAP_TYPE_SIX],
-		pServer->m_aCurrentMapCrc[MAP_TYPE_SIX],
+		pServer->m_aCurrentMapData[MAP_TYPE_SIX].Sha256(),
+		pServer->m_aCurrentMapData[MAP_TYPE_SIX].Crc(),
 		"server",
-		pServer->m_aCurrentMapSize[MAP_TYPE_SIX],
-		pServer->m_apCurrentMapData[MAP_TYPE_SIX],
+		pServer->m_aCurrentMapData[MAP_TYPE_SIX].Size(),
+		pServer->m_aCurrentMapData[MAP_TYPE_SIX].Data(),
+		nullptr,
 		nullptr,
 		nullptr,
-		nullptr);
+		pServer->Config()->m_SvDemoIndex >= 1);
 }
 
 void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
@@ -3937,6 +4169,31 @@ void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->ReloadMap();
 }
 
+void CServer::ConTickProfile(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = (CServer *)pUser;
+	const CTickProfiler &Profiler = pThis->m_TickProfiler;
+	if(!Profiler.Enabled())
+	{
+		log_info("server", "tick profiler is disabled, enable it with sv_tick_profiler 1");
+		return;
+	}
+	if(Profiler.NumFrames() == 0)
+	{
+		log_info("server", "no tick profile yet, try again in a second");
+		return;
+	}
+	log_info("server", "tick profile of the last second: map=%s players=%d frames=%d", pThis->GetMapName(), pThis->ClientCount(), Profiler.NumFrames());
+	for(int Section = 0; Section < Profiler.NumSections(); Section++)
+	{
+		if(Profiler.Stats(Section).m_NumSamples == 0)
+			continue;
+		char aBuf[192];
+		pThis->FormatTickProfileSection(Section, aBuf, sizeof(aBuf));
+		log_info("server", "%s", aBuf);
+	}
+}
+
 void CServer::ConLogout(IConsole::IResult *pResult, void *pUser)
 {
 	CServer *pServer = (CServer *)pUser;
@@ -4260,7 +4517,7 @@ void CServer::ConchainSixupUpdate(IConsole::IResult *pResult, void *pUserData, I
 	pfnCallback(pResult, pCallbackUserData);
 	CServer *pThis = static_cast<CServer *>(pUserData);
 	if(pResult->NumArguments() >= 1 && pThis->m_aCurrentMap[0] != '\0')
-		pThis->m_MapReload |= (pThis->m_apCurrentMapData[MAP_TYPE_SIXUP] != nullptr) != (pResult->GetInteger(0) != 0);
+		pThis->m_MapReload |= pThis->m_aCurrentMapData[MAP_TYPE_SIXUP].IsLoaded() != (pResult->GetInteger(0) != 0);
 }
 
 void CServer::ConchainRegisterCommunityTokenRedact(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
@@ -4373,6 +4630,7 @@ void CServer::RegisterCommands()
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
+	Console()->Register("tick_profile", "", CFGFLAG_SERVER, ConTickProfile, this, "Show how long the phases of the server loop took during the last second (needs sv_tick_profiler 1)");
 
 	Console()->Register("add_sqlserver", "s['r'|'w'] s[Database] s[Prefix] s[User] s[Password] s[IP] i[Port] ?i[SetUpDatabase ?]", CFGFLAG_SERVER | CFGFLAG_NONTEEHISTORIC, ConAddSqlServer, this, "add a sqlserver");
 	Console()->Register("dump_sqlservers", "s['r'|'w']", CFGFLAG_SERVER, ConDumpSqlServers, this, "dumps all sqlservers readservers = r, writeservers = w");
@@ -4441,6 +4699,8 @@ void *CServer::SnapNewItem(int Type, int Id, int Size)
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
+	for(auto &ClientSnapshotDelta : m_aClientSnapshotDeltas)
+		ClientSnapshotDelta.SetStaticsize(ItemType, Size);
 }
 
 CServer *CreateServer() { return new CServer(); }
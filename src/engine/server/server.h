@@ -5,8 +5,10 @@
 
 #include "antibot.h"
 #include "authmanager.h"
+#include "map_preload.h"
 #include "name_ban.h"
 #include "snap_id_pool.h"
+#include "snapshot_workers.h"
 
 #include <base/hash.h>
 
@@ -20,6 +22,7 @@
 #include <engine/shared/network.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
+#include <engine/shared/tick_profiler.h>
 #include <engine/shared/uuid_manager.h>
 
 #include <memory>
@@ -214,6 +217,12 @@ public:
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
+
+	// the snapshot deltas for the clients are created in parallel,
+	// with static sizes for 0.6 and 0.7 clients respectively
+	CSnapshotDelta m_aClientSnapshotDeltas[2];
+	CSnapshotWorkers m_SnapshotWorkers;
+	std::vector<CSnapshotWorkers::CTask> m_vSnapshotTasks;
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
@@ -221,6 +230,23 @@ public:
 	CServerBan m_ServerBan;
 	CHttp m_Http;
 
+	enum
+	{
+		PROFILE_LOOP = 0,
+		PROFILE_NETWORK,
+		PROFILE_INPUT,
+		PROFILE_GAME,
+		PROFILE_SNAPSHOT,
+		PROFILE_ENGINE,
+		PROFILE_FLUSH,
+		PROFILE_WAIT,
+		NUM_PROFILE_SECTIONS
+	};
+	CTickProfiler m_TickProfiler;
+	std::chrono::nanoseconds m_TickProfilerSummaryTime;
+	IOHANDLE m_TickProfilerCsv = nullptr;
+	char m_aTickProfilerCsvFile[128];
+
 	IEngineMap *m_pMap;
 
 	int64_t m_GameStartTime;
@@ -259,12 +285,11 @@ public:
 
 	char m_aCurrentMap[IO_MAX_PATH_LENGTH];
 	const char *m_pCurrentMapName;
-	SHA256_DIGEST m_aCurrentMapSha256[NUM_MAP_TYPES];
-	unsigned m_aCurrentMapCrc[NUM_MAP_TYPES];
-	unsigned char *m_apCurrentMapData[NUM_MAP_TYPES];
-	unsigned int m_aCurrentMapSize[NUM_MAP_TYPES];
+	CMapFileData m_aCurrentMapData[NUM_MAP_TYPES];
+	std::shared_ptr<CMapPreload> m_pMapPreload;
 	char m_aMapDownloadUrl[256];
 
+	CDemoRecordWriter m_DemoRecordWriter;
 	CDemoRecorder m_aDemoRecorder[NUM_RECORDERS];
 	CAuthManager m_AuthManager;
 
@@ -414,9 +439,16 @@ public:
 
 	void PumpNetwork(bool PacketWaiting);
 
+	void UpdateTickProfiler();
+	void FormatTickProfileSection(int Section, char *pBuffer, int BufferSize) const;
+	void WriteTickProfileCsv();
+	CTickProfiler *TickProfiler() override { return &m_TickProfiler; }
+
 	void ChangeMap(const char *pMap) override;
 	const char *GetMapName() const override;
 	void ReloadMap() override;
+	void PreloadMap(const char *pMapName) override;
+	void CancelMapPreload() override;
 	int LoadMap(const char *pMapName);
 
 	void SaveDemo(int ClientId, float Time) override;
@@ -433,6 +465,7 @@ public:
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
+	static void ConTickProfile(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
 	static void ConShowIps(IConsole::IResult *pResult, void *pUser);
 	static void ConHideAuthStatus(IConsole::IResult *pResult, void *pUser);
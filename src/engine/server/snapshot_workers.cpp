@@ -0,0 +1,96 @@
+#include "snapshot_workers.h"
+
+#include <base/math.h>
+
+#include <engine/shared/compression.h>
+
+CSnapshotWorkers::~CSnapshotWorkers()
+{
+	Shutdown();
+}
+
+void CSnapshotWorkers::Init(int NumThreads)
+{
+	dbg_assert(m_vpThreads.empty(), "Snapshot workers already running");
+	if(NumThreads <= 0)
+		return;
+
+	m_Shutdown = false;
+	sphore_init(&m_StartSemaphore);
+	sphore_init(&m_DoneSemaphore);
+
+	char aName[16]; // unix kernel length limit
+	m_vpThreads.reserve(NumThreads);
+	for(int i = 0; i < NumThreads; i++)
+	{
+		str_format(aName, sizeof(aName), "snapshot W%d", i);
+		m_vpThreads.push_back(thread_init(WorkerThread, this, aName));
+	}
+}
+
+void CSnapshotWorkers::Shutdown()
+{
+	if(m_vpThreads.empty())
+		return;
+
+	m_Shutdown = true;
+	for(size_t i = 0; i < m_vpThreads.size(); i++)
+		sphore_signal(&m_StartSemaphore);
+	for(void *pThread : m_vpThreads)
+		thread_wait(pThread);
+	m_vpThreads.clear();
+
+	sphore_destroy(&m_StartSemaphore);
+	sphore_destroy(&m_DoneSemaphore);
+}
+
+void CSnapshotWorkers::Run(CTask *pTasks, int NumTasks)
+{
+	m_pTasks = pTasks;
+	m_NumTasks = NumTasks;
+	m_NextTask = 0;
+
+	// only wake up as many workers as there are tasks for them
+	const int NumWorkers = minimum<int>(m_vpThreads.size(), NumTasks - 1);
+	for(int i = 0; i < NumWorkers; i++)
+		sphore_signal(&m_StartSemaphore);
+
+	ProcessTasks();
+
+	for(int i = 0; i < NumWorkers; i++)
+		sphore_wait(&m_DoneSemaphore);
+}
+
+void CSnapshotWorkers::WorkerThread(void *pUser)
+{
+	CSnapshotWorkers *pThis = static_cast<CSnapshotWorkers *>(pUser);
+	while(true)
+	{
+		sphore_wait(&pThis->m_StartSemaphore);
+		if(pThis->m_Shutdown)
+			break;
+		pThis->ProcessTasks();
+		sphore_signal(&pThis->m_DoneSemaphore);
+	}
+}
+
+void CSnapshotWorkers::ProcessTasks()
+{
+	while(true)
+	{
+		const int Task = m_NextTask.fetch_add(1);
+		if(Task >= m_NumTasks)
+			break;
+		ProcessTask(&m_pTasks[Task]);
+	}
+}
+
+void CSnapshotWorkers::ProcessTask(CTask *pTask)
+{
+	char aDeltaData[CSnapshot::MAX_SIZE];
+	const int DeltaSize = pTask->m_pDelta->CreateDelta(pTask->m_pFrom, pTask->m_pTo, aDeltaData);
+	if(DeltaSize)
+		pTask->m_CompressedSize = CVariableInt::Compress(aDeltaData, DeltaSize, pTask->m_aCompressedData, sizeof(pTask->m_aCompressedData));
+	else
+		pTask->m_CompressedSize = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef ENGINE_SERVER_SNAPSHOT_WORKERS_H
+#define ENGINE_SERVER_SNAPSHOT_WORKERS_H
+
+#include <base/system.h>
+
+#include <engine/shared/snapshot.h>
+
+#include <atomic>
+#include <vector>
+
+/**
+ * A fixed team of threads which create and compress the snapshot deltas
+ * for all clients in parallel. The calling thread takes part in the work,
+ * so the tasks are still processed if there are no worker threads.
+ */
+class CSnapshotWorkers
+{
+public:
+	class CTask
+	{
+	public:
+		// input, the snapshots must not change until the task is done
+		int m_ClientId;
+		const CSnapshot *m_pFrom;
+		const CSnapshot *m_pTo;
+		const CSnapshotDelta *m_pDelta;
+
+		// output, size is 0 if there is no difference between the snapshots
+		int m_CompressedSize;
+		char m_aCompressedData[CSnapshot::MAX_SIZE];
+	};
+
+	CSnapshotWorkers() = default;
+	~CSnapshotWorkers();
+
+	CSnapshotWorkers(const CSnapshotWorkers &Other) = delete;
+	CSnapshotWorkers &operator=(const CSnapshotWorkers &Other) = delete;
+
+	void Init(int NumThreads);
+	void Shutdown();
+	int NumThreads() const { return m_vpThreads.size(); }
+
+	/**
+	 * Processes the tasks and returns once all of them are done.
+	 *
+	 * @remark Must always be called from the same thread.
+	 */
+	void Run(CTask *pTasks, int NumTasks);
+
+private:
+	std::vector<void *> m_vpThreads;
+	SEMAPHORE m_StartSemaphore;
+	SEMAPHORE m_DoneSemaphore;
+	std::atomic<bool> m_Shutdown = false;
+
+	CTask *m_pTasks = nullptr;
+	int m_NumTasks = 0;
+	std::atomic<int> m_NextTask = 0;
+
+	static void WorkerThread(void *pUser);
+	void ProcessTasks();
+	static void ProcessTask(CTask *pTask);
+};
+
+#endif
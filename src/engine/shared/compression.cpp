@@ -1,6 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include "compression.h"
+#include "simd.h"
 
 #include <base/system.h>
 
@@ -65,6 +66,232 @@ const unsigned char *CVariableInt::Unpack(const unsigned char *pSrc, int *pInOut
 	return pSrc;
 }
 
+// The vectorized kernels only handle runs of ints that are packed into a
+// single byte, which is the common case for snapshot deltas. They return the
+// number of ints handled, everything else goes through Pack and Unpack.
+// A single byte holds the sign bit and 6 bits of data, i.e. -64 to 63.
+
+#if defined(CONF_SIMD_X86)
+static int CountTrailingZeros(unsigned Mask)
+{
+#if defined(_MSC_VER)
+	unsigned long Index;
+	_BitScanForward(&Index, Mask);
+	return Index;
+#else
+	return __builtin_ctz(Mask);
+#endif
+}
+
+static __m128i PackSingleByteSse2(__m128i Value)
+{
+	const __m128i Sign = _mm_srai_epi32(Value, 31);
+	return _mm_or_si128(_mm_xor_si128(Value, Sign), _mm_and_si128(Sign, _mm_set1_epi32(0x40)));
+}
+
+static __m128i UnpackSingleByteSse2(__m128i Byte)
+{
+	const __m128i Sign = _mm_srai_epi32(_mm_slli_epi32(Byte, 25), 31);
+	return _mm_xor_si128(_mm_and_si128(Byte, _mm_set1_epi32(0x3F)), Sign);
+}
+
+static __m128i FitsSingleByteSse2(__m128i Value)
+{
+	const __m128i Outside = _mm_and_si128(_mm_add_epi32(Value, _mm_set1_epi32(64)), _mm_set1_epi32(~0x7F));
+	return _mm_cmpeq_epi32(Outside, _mm_setzero_si128());
+}
+
+static int PackSingleBytesSse2(const int *pSrc, int SrcSize, unsigned char *pDst, int DstSize)
+{
+	int i = 0;
+	for(; i + 16 <= SrcSize && i + 16 <= DstSize; i += 16)
+	{
+		const __m128i A = _mm_loadu_si128((const __m128i *)(pSrc + i));
+		const __m128i B = _mm_loadu_si128((const __m128i *)(pSrc + i + 4));
+		const __m128i C = _mm_loadu_si128((const __m128i *)(pSrc + i + 8));
+		const __m128i D = _mm_loadu_si128((const __m128i *)(pSrc + i + 12));
+		const __m128i AB = _mm_packs_epi32(PackSingleByteSse2(A), PackSingleByteSse2(B));
+		const __m128i CD = _mm_packs_epi32(PackSingleByteSse2(C), PackSingleByteSse2(D));
+		_mm_storeu_si128((__m128i *)(pDst + i), _mm_packus_epi16(AB, CD));
+		// the bytes up to the first int that does not fit are valid
+		const __m128i FitsAB = _mm_packs_epi32(FitsSingleByteSse2(A), FitsSingleByteSse2(B));
+		const __m128i FitsCD = _mm_packs_epi32(FitsSingleByteSse2(C), FitsSingleByteSse2(D));
+		const unsigned Outside = ~_mm_movemask_epi8(_mm_packs_epi16(FitsAB, FitsCD)) & 0xFFFF;
+		if(Outside)
+			return i + CountTrailingZeros(Outside);
+	}
+	return i;
+}
+
+static int UnpackSingleBytesSse2(const unsigned char *pSrc, int SrcSize, int *pDst, int DstSize)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	int i = 0;
+	for(; i + 16 <= SrcSize && i + 16 <= DstSize; i += 16)
+	{
+		const __m128i Bytes = _mm_loadu_si128((const __m128i *)(pSrc + i));
+		const unsigned Extended = _mm_movemask_epi8(Bytes);
+		const __m128i Lo = _mm_unpacklo_epi8(Bytes, Zero);
+		const __m128i Hi = _mm_unpackhi_epi8(Bytes, Zero);
+		_mm_storeu_si128((__m128i *)(pDst + i), UnpackSingleByteSse2(_mm_unpacklo_epi16(Lo, Zero)));
+		_mm_storeu_si128((__m128i *)(pDst + i + 4), UnpackSingleByteSse2(_mm_unpackhi_epi16(Lo, Zero)));
+		_mm_storeu_si128((__m128i *)(pDst + i + 8), UnpackSingleByteSse2(_mm_unpacklo_epi16(Hi, Zero)));
+		_mm_storeu_si128((__m128i *)(pDst + i + 12), UnpackSingleByteSse2(_mm_unpackhi_epi16(Hi, Zero)));
+		// the ints up to the first extended byte are valid
+		if(Extended)
+			return i + CountTrailingZeros(Extended);
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2 static __m256i PackSingleByteAvx2(__m256i Value)
+{
+	const __m256i Sign = _mm256_srai_epi32(Value, 31);
+	return _mm256_or_si256(_mm256_xor_si256(Value, Sign), _mm256_and_si256(Sign, _mm256_set1_epi32(0x40)));
+}
+
+SIMD_TARGET_AVX2 static __m256i UnpackSingleByteAvx2(__m256i Byte)
+{
+	const __m256i Sign = _mm256_srai_epi32(_mm256_slli_epi32(Byte, 25), 31);
+	return _mm256_xor_si256(_mm256_and_si256(Byte, _mm256_set1_epi32(0x3F)), Sign);
+}
+
+SIMD_TARGET_AVX2 static __m256i FitsSingleByteAvx2(__m256i Value)
+{
+	const __m256i Outside = _mm256_and_si256(_mm256_add_epi32(Value, _mm256_set1_epi32(64)), _mm256_set1_epi32(~0x7F));
+	return _mm256_cmpeq_epi32(Outside, _mm256_setzero_si256());
+}
+
+SIMD_TARGET_AVX2 static int PackSingleBytesAvx2(const int *pSrc, int SrcSize, unsigned char *pDst, int DstSize)
+{
+	// the packs work within the 128 bit lanes, restore the order afterwards
+	const __m256i Order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int i = 0;
+	for(; i + 32 <= SrcSize && i + 32 <= DstSize; i += 32)
+	{
+		const __m256i A = _mm256_loadu_si256((const __m256i *)(pSrc + i));
+		const __m256i B = _mm256_loadu_si256((const __m256i *)(pSrc + i + 8));
+		const __m256i C = _mm256_loadu_si256((const __m256i *)(pSrc + i + 16));
+		const __m256i D = _mm256_loadu_si256((const __m256i *)(pSrc + i + 24));
+		const __m256i AB = _mm256_packs_epi32(PackSingleByteAvx2(A), PackSingleByteAvx2(B));
+		const __m256i CD = _mm256_packs_epi32(PackSingleByteAvx2(C), PackSingleByteAvx2(D));
+		_mm256_storeu_si256((__m256i *)(pDst + i), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(AB, CD), Order));
+		const __m256i FitsAB = _mm256_packs_epi32(FitsSingleByteAvx2(A), FitsSingleByteAvx2(B));
+		const __m256i FitsCD = _mm256_packs_epi32(FitsSingleByteAvx2(C), FitsSingleByteAvx2(D));
+		const unsigned Outside = ~(unsigned)_mm256_movemask_epi8(_mm256_permutevar8x32_epi32(_mm256_packs_epi16(FitsAB, FitsCD), Order));
+		if(Outside)
+			return i + CountTrailingZeros(Outside);
+	}
+	return i + PackSingleBytesSse2(pSrc + i, SrcSize - i, pDst + i, DstSize - i);
+}
+
+SIMD_TARGET_AVX2 static int UnpackSingleBytesAvx2(const unsigned char *pSrc, int SrcSize, int *pDst, int DstSize)
+{
+	int i = 0;
+	for(; i + 32 <= SrcSize && i + 32 <= DstSize; i += 32)
+	{
+		const unsigned Extended = _mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(pSrc + i)));
+		for(int j = 0; j < 32; j += 8)
+			_mm256_storeu_si256((__m256i *)(pDst + i + j), UnpackSingleByteAvx2(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(pSrc + i + j)))));
+		if(Extended)
+			return i + CountTrailingZeros(Extended);
+	}
+	return i + UnpackSingleBytesSse2(pSrc + i, SrcSize - i, pDst + i, DstSize - i);
+}
+#elif defined(CONF_SIMD_NEON)
+static int8x8_t PackSingleByteNeon(int32x4_t Lo, int32x4_t Hi)
+{
+	const int32x4_t SignLo = vshrq_n_s32(Lo, 31);
+	const int32x4_t SignHi = vshrq_n_s32(Hi, 31);
+	Lo = vorrq_s32(veorq_s32(Lo, SignLo), vandq_s32(SignLo, vdupq_n_s32(0x40)));
+	Hi = vorrq_s32(veorq_s32(Hi, SignHi), vandq_s32(SignHi, vdupq_n_s32(0x40)));
+	return vmovn_s16(vcombine_s16(vmovn_s32(Lo), vmovn_s32(Hi)));
+}
+
+static int32x4_t UnpackSingleByteNeon(uint16x4_t Byte)
+{
+	const int32x4_t Value = vreinterpretq_s32_u32(vmovl_u16(Byte));
+	const int32x4_t Sign = vshrq_n_s32(vshlq_n_s32(Value, 25), 31);
+	return veorq_s32(vandq_s32(Value, vdupq_n_s32(0x3F)), Sign);
+}
+
+static int16x4_t FitsSingleByteNeon(int32x4_t Value)
+{
+	const uint32x4_t Fits = vcleq_u32(vreinterpretq_u32_s32(vaddq_s32(Value, vdupq_n_s32(64))), vdupq_n_u32(0x7F));
+	return vmovn_s32(vreinterpretq_s32_u32(Fits));
+}
+
+static int PackSingleBytesNeon(const int *pSrc, int SrcSize, unsigned char *pDst, int DstSize)
+{
+	int i = 0;
+	for(; i + 16 <= SrcSize && i + 16 <= DstSize; i += 16)
+	{
+		const int32x4_t A = vld1q_s32(pSrc + i);
+		const int32x4_t B = vld1q_s32(pSrc + i + 4);
+		const int32x4_t C = vld1q_s32(pSrc + i + 8);
+		const int32x4_t D = vld1q_s32(pSrc + i + 12);
+		vst1q_s8((int8_t *)(pDst + i), vcombine_s8(PackSingleByteNeon(A, B), PackSingleByteNeon(C, D)));
+		// 4 bits per int, set for ints that do not fit
+		const int8x8_t FitsLo = vmovn_s16(vcombine_s16(FitsSingleByteNeon(A), FitsSingleByteNeon(B)));
+		const int8x8_t FitsHi = vmovn_s16(vcombine_s16(FitsSingleByteNeon(C), FitsSingleByteNeon(D)));
+		const uint8x16_t Outside = vmvnq_u8(vreinterpretq_u8_s8(vcombine_s8(FitsLo, FitsHi)));
+		const uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Outside), 4)), 0);
+		if(Mask)
+			return i + __builtin_ctzll(Mask) / 4;
+	}
+	return i;
+}
+
+static int UnpackSingleBytesNeon(const unsigned char *pSrc, int SrcSize, int *pDst, int DstSize)
+{
+	int i = 0;
+	for(; i + 16 <= SrcSize && i + 16 <= DstSize; i += 16)
+	{
+		const uint8x16_t Bytes = vld1q_u8(pSrc + i);
+		const uint16x8_t Lo = vmovl_u8(vget_low_u8(Bytes));
+		const uint16x8_t Hi = vmovl_u8(vget_high_u8(Bytes));
+		vst1q_s32(pDst + i, UnpackSingleByteNeon(vget_low_u16(Lo)));
+		vst1q_s32(pDst + i + 4, UnpackSingleByteNeon(vget_high_u16(Lo)));
+		vst1q_s32(pDst + i + 8, UnpackSingleByteNeon(vget_low_u16(Hi)));
+		vst1q_s32(pDst + i + 12, UnpackSingleByteNeon(vget_high_u16(Hi)));
+		// 4 bits per byte, set for extended bytes
+		const uint8x16_t Extended = vcgeq_u8(Bytes, vdupq_n_u8(0x80));
+		const uint64_t Mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Extended), 4)), 0);
+		if(Mask)
+			return i + __builtin_ctzll(Mask) / 4;
+	}
+	return i;
+}
+#endif
+
+static int PackSingleBytes(const int *pSrc, int SrcSize, unsigned char *pDst, int DstSize)
+{
+	switch(CSimd::Level())
+	{
+#if defined(CONF_SIMD_X86)
+	case CSimd::LEVEL_AVX2: return PackSingleBytesAvx2(pSrc, SrcSize, pDst, DstSize);
+	case CSimd::LEVEL_SSE2: return PackSingleBytesSse2(pSrc, SrcSize, pDst, DstSize);
+#elif defined(CONF_SIMD_NEON)
+	case CSimd::LEVEL_NEON: return PackSingleBytesNeon(pSrc, SrcSize, pDst, DstSize);
+#endif
+	default: return 0;
+	}
+}
+
+static int UnpackSingleBytes(const unsigned char *pSrc, int SrcSize, int *pDst, int DstSize)
+{
+	switch(CSimd::Level())
+	{
+#if defined(CONF_SIMD_X86)
+	case CSimd::LEVEL_AVX2: return UnpackSingleBytesAvx2(pSrc, SrcSize, pDst, DstSize);
+	case CSimd::LEVEL_SSE2: return UnpackSingleBytesSse2(pSrc, SrcSize, pDst, DstSize);
+#elif defined(CONF_SIMD_NEON)
+	case CSimd::LEVEL_NEON: return UnpackSingleBytesNeon(pSrc, SrcSize, pDst, DstSize);
+#endif
+	default: return 0;
+	}
+}
+
 long CVariableInt::Decompress(const void *pSrc, int SrcSize, void *pDst, int DstSize)
 {
 	dbg_assert(DstSize % sizeof(int) == 0, "invalid bounds");
@@ -75,6 +302,12 @@ long CVariableInt::Decompress(const void *pSrc, int SrcSize, void *pDst, int Dst
 	const int *pIntDstEnd = pIntDst + DstSize / sizeof(int); // NOLINT(bugprone-sizeof-expression)
 	while(pCharSrc < pCharSrcEnd)
 	{
+		const int NumUnpacked = UnpackSingleBytes(pCharSrc, pCharSrcEnd - pCharSrc, pIntDst, pIntDstEnd - pIntDst);
+		pCharSrc += NumUnpacked;
+		pIntDst += NumUnpacked;
+		if(pCharSrc >= pCharSrcEnd)
+			break;
+
 		if(pIntDst >= pIntDstEnd)
 			return -1;
 		pCharSrc = CVariableInt::Unpack(pCharSrc, pIntDst, pCharSrcEnd - pCharSrc);
@@ -95,6 +328,13 @@ long CVariableInt::Compress(const void *pSrc, int SrcSize, void *pDst, int DstSi
 	SrcSize /= sizeof(int);
 	while(SrcSize)
 	{
+		const int NumPacked = PackSingleBytes(pIntSrc, SrcSize, pCharDst, pCharDstEnd - pCharDst);
+		pIntSrc += NumPacked;
+		pCharDst += NumPacked;
+		SrcSize -= NumPacked;
+		if(!SrcSize)
+			break;
+
 		pCharDst = CVariableInt::Pack(pCharDst, *pIntSrc, pCharDstEnd - pCharDst);
 		if(!pCharDst)
 			return -1;
@@ -25,16 +25,19 @@
 CConsole::CResult::CResult(int ClientId) :
 	IResult(ClientId)
 {
-	mem_zero(m_aStringStorage, sizeof(m_aStringStorage));
+	// only the used part of the storage and arguments is ever read, so they are not cleared here,
+	// as results are created for every executed command
+	m_aStringStorage[0] = '\0';
+	m_StorageLength = 1;
 	m_pArgsStart = nullptr;
 	m_pCommand = nullptr;
-	std::fill(std::begin(m_apArgs), std::end(m_apArgs), nullptr);
 }
 
 CConsole::CResult::CResult(const CResult &Other) :
 	IResult(Other)
 {
 	mem_copy(m_aStringStorage, Other.m_aStringStorage, sizeof(m_aStringStorage));
+	m_StorageLength = Other.m_StorageLength;
 	m_pArgsStart = m_aStringStorage + (Other.m_pArgsStart - Other.m_aStringStorage);
 	m_pCommand = m_aStringStorage + (Other.m_pCommand - Other.m_aStringStorage);
 	for(unsigned i = 0; i < Other.m_NumArgs; ++i)
@@ -162,7 +165,7 @@ int CConsole::ParseStart(CResult *pResult, const char *pString, int Length)
 	if(Length < Len)
 		Len = Length;
 
-	str_copy(pResult->m_aStringStorage, pString, Len);
+	pResult->m_StorageLength = str_copy(pResult->m_aStringStorage, pString, Len) + 1;
 	pStr = pResult->m_aStringStorage;
 
 	// get command
@@ -430,6 +433,38 @@ void CConsole::InitChecksum(CChecksumData *pData) const
 	}
 }
 
+// returns the end of the command at the start of the string, and the start of the next command or nullptr
+static const char *FindPartEnd(const char *pStr, bool InterpretSemicolons, const char **ppNextPart)
+{
+	const char *pEnd = pStr;
+	int InString = 0;
+	*ppNextPart = nullptr;
+
+	while(*pEnd)
+	{
+		if(*pEnd == '"')
+			InString ^= 1;
+		else if(*pEnd == '\\') // escape sequences
+		{
+			if(pEnd[1] == '"')
+				pEnd++;
+		}
+		else if(!InString && InterpretSemicolons)
+		{
+			if(*pEnd == ';') // command separator
+			{
+				*ppNextPart = pEnd + 1;
+				break;
+			}
+			else if(*pEnd == '#') // comment, no need to do anything more
+				break;
+		}
+
+		pEnd++;
+	}
+	return pEnd;
+}
+
 bool CConsole::LineIsValid(const char *pStr)
 {
 	if(!pStr || *pStr == 0)
@@ -438,32 +473,8 @@ bool CConsole::LineIsValid(const char *pStr)
 	do
 	{
 		CResult Result(IConsole::CLIENT_ID_UNSPECIFIED);
-		const char *pEnd = pStr;
-		const char *pNextPart = nullptr;
-		int InString = 0;
-
-		while(*pEnd)
-		{
-			if(*pEnd == '"')
-				InString ^= 1;
-			else if(*pEnd == '\\') // escape sequences
-			{
-				if(pEnd[1] == '"')
-					pEnd++;
-			}
-			else if(!InString)
-			{
-				if(*pEnd == ';') // command separator
-				{
-					pNextPart = pEnd + 1;
-					break;
-				}
-				else if(*pEnd == '#') // comment, no need to do anything more
-					break;
-			}
-
-			pEnd++;
-		}
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pStr, true, &pNextPart);
 
 		if(ParseStart(&Result, pStr, (pEnd - pStr) + 1) != 0)
 			return false;
@@ -478,6 +489,28 @@ bool CConsole::LineIsValid(const char *pStr)
 	return true;
 }
 
+void CConsole::ParseLine(const char *pStr, FParsedCommandCallback pfnCallback, void *pUser)
+{
+	const char *pWithoutPrefix = str_startswith(pStr, "mc;");
+	if(pWithoutPrefix)
+		pStr = pWithoutPrefix;
+	while(pStr && *pStr)
+	{
+		CResult Result(IConsole::CLIENT_ID_UNSPECIFIED);
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pStr, true, &pNextPart);
+
+		if(ParseStart(&Result, pStr, (pEnd - pStr) + 1) != 0)
+			return;
+
+		CCommand *pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+		if(pCommand && ParseArgs(&Result, pCommand->m_pParams) == PARSEARGS_OK)
+			pfnCallback(pCommand, &Result, pUser);
+
+		pStr = pNextPart;
+	}
+}
+
 void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bool InterpretSemicolons)
 {
 	const char *pWithoutPrefix = str_startswith(pStr, "mc;");
@@ -489,32 +522,8 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bo
 	while(pStr && *pStr)
 	{
 		CResult Result(ClientId);
-		const char *pEnd = pStr;
-		const char *pNextPart = nullptr;
-		int InString = 0;
-
-		while(*pEnd)
-		{
-			if(*pEnd == '"')
-				InString ^= 1;
-			else if(*pEnd == '\\') // escape sequences
-			{
-				if(pEnd[1] == '"')
-					pEnd++;
-			}
-			else if(!InString && InterpretSemicolons)
-			{
-				if(*pEnd == ';') // command separator
-				{
-					pNextPart = pEnd + 1;
-					break;
-				}
-				else if(*pEnd == '#') // comment, no need to do anything more
-					break;
-			}
-
-			pEnd++;
-		}
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pStr, InterpretSemicolons, &pNextPart);
 
 		if(ParseStart(&Result, pStr, (pEnd - pStr) + 1) != 0)
 			return;
@@ -529,46 +538,56 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bo
 			return;
 		}
 
-		CCommand *pCommand;
-		if(ClientId == IConsole::CLIENT_ID_GAME)
-			pCommand = FindCommand(Result.m_pCommand, m_FlagMask | CFGFLAG_GAME);
-		else
-			pCommand = FindCommand(Result.m_pCommand, m_FlagMask);
+		CCommand *pCommand = FindCommand(Result.m_pCommand, ClientId == IConsole::CLIENT_ID_GAME ? m_FlagMask | CFGFLAG_GAME : m_FlagMask);
+		if(!ExecuteCommand(Stroke, &Result, pCommand, pStr, ClientId, nullptr))
+			return;
+
+		pStr = pNextPart;
+	}
+}
 
-		if(pCommand)
+bool CConsole::ExecuteCommand(int Stroke, CResult *pResult, CCommand *pCommand, const char *pStr, int ClientId, CParsedArgs *pParsed)
+{
+	if(pCommand)
+	{
+		if(ClientId == IConsole::CLIENT_ID_GAME && !(pCommand->m_Flags & CFGFLAG_GAME))
 		{
-			if(ClientId == IConsole::CLIENT_ID_GAME && !(pCommand->m_Flags & CFGFLAG_GAME))
+			if(Stroke)
 			{
-				if(Stroke)
-				{
-					char aBuf[CMDLINE_LENGTH + 64];
-					str_format(aBuf, sizeof(aBuf), "Command '%s' cannot be executed from a map.", Result.m_pCommand);
-					Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
-				}
+				char aBuf[CMDLINE_LENGTH + 64];
+				str_format(aBuf, sizeof(aBuf), "Command '%s' cannot be executed from a map.", pResult->m_pCommand);
+				Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
 			}
-			else if(ClientId == IConsole::CLIENT_ID_NO_GAME && pCommand->m_Flags & CFGFLAG_GAME)
+		}
+		else if(ClientId == IConsole::CLIENT_ID_NO_GAME && pCommand->m_Flags & CFGFLAG_GAME)
+		{
+			if(Stroke)
 			{
-				if(Stroke)
-				{
-					char aBuf[CMDLINE_LENGTH + 64];
-					str_format(aBuf, sizeof(aBuf), "Command '%s' cannot be executed from a non-map config file.", Result.m_pCommand);
-					Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
-					str_format(aBuf, sizeof(aBuf), "Hint: Put the command in '%s.cfg' instead of '%s.map.cfg' ", g_Config.m_SvMap, g_Config.m_SvMap);
-					Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
-				}
+				char aBuf[CMDLINE_LENGTH + 64];
+				str_format(aBuf, sizeof(aBuf), "Command '%s' cannot be executed from a non-map config file.", pResult->m_pCommand);
+				Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
+				str_format(aBuf, sizeof(aBuf), "Hint: Put the command in '%s.cfg' instead of '%s.map.cfg' ", g_Config.m_SvMap, g_Config.m_SvMap);
+				Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
 			}
-			else if(CanUseCommand(Result.m_ClientId, pCommand))
+		}
+		else if(CanUseCommand(pResult->m_ClientId, pCommand))
+		{
+			const bool IsStrokeCommand = pResult->m_pCommand[0] == '+';
+			if(Stroke || IsStrokeCommand)
 			{
-				int IsStrokeCommand = 0;
-				if(Result.m_pCommand[0] == '+')
+				int Error;
+				if(pParsed != nullptr && pParsed->m_Valid)
 				{
-					// insert the stroke direction token
-					Result.AddArgument(m_apStrokeStr[Stroke]);
-					IsStrokeCommand = 1;
+					Error = pParsed->m_Error;
 				}
-
-				if(Stroke || IsStrokeCommand)
+				else
 				{
+					if(IsStrokeCommand)
+					{
+						// insert the stroke direction token
+						pResult->AddArgument(m_apStrokeStr[Stroke]);
+					}
+
 					bool IsColor = false;
 					{
 						FCommandCallback pfnCallback = pCommand->m_pfnCallback;
@@ -577,81 +596,86 @@ void CConsole::ExecuteLineStroked(int Stroke, const char *pStr, int ClientId, bo
 						IsColor = pfnCallback == &SColorConfigVariable::CommandCallback;
 					}
 
-					if(int Error = ParseArgs(&Result, pCommand->m_pParams, IsColor))
+					Error = ParseArgs(pResult, pCommand->m_pParams, IsColor);
+					if(pParsed != nullptr)
 					{
-						char aBuf[CMDLINE_LENGTH + 64];
-						if(Error == PARSEARGS_INVALID_INTEGER)
-							str_format(aBuf, sizeof(aBuf), "%s is not a valid integer.", Result.GetString(Result.NumArguments() - 1));
-						else if(Error == PARSEARGS_INVALID_COLOR)
-							str_format(aBuf, sizeof(aBuf), "%s is not a valid color.", Result.GetString(Result.NumArguments() - 1));
-						else if(Error == PARSEARGS_INVALID_FLOAT)
-							str_format(aBuf, sizeof(aBuf), "%s is not a valid decimal number.", Result.GetString(Result.NumArguments() - 1));
-						else
-							str_format(aBuf, sizeof(aBuf), "Invalid arguments. Usage: %s %s", pCommand->m_pName, pCommand->m_pParams);
-						Print(OUTPUT_LEVEL_STANDARD, "chatresp", aBuf);
-					}
-					else if(m_StoreCommands && pCommand->m_Flags & CFGFLAG_STORE)
-					{
-						m_vExecutionQueue.emplace_back(pCommand, Result);
+						pParsed->Store(*pResult, Error);
 					}
+				}
+
+				if(Error)
+				{
+					char aBuf[CMDLINE_LENGTH + 64];
+					if(Error == PARSEARGS_INVALID_INTEGER)
+						str_format(aBuf, sizeof(aBuf), "%s is not a valid integer.", pResult->GetString(pResult->NumArguments() - 1));
+					else if(Error == PARSEARGS_INVALID_COLOR)
+						str_format(aBuf, sizeof(aBuf), "%s is not a valid color.", pResult->GetString(pResult->NumArguments() - 1));
+					else if(Error == PARSEARGS_INVALID_FLOAT)
+						str_format(aBuf, sizeof(aBuf), "%s is not a valid decimal number.", pResult->GetString(pResult->NumArguments() - 1));
 					else
+						str_format(aBuf, sizeof(aBuf), "Invalid arguments. Usage: %s %s", pCommand->m_pName, pCommand->m_pParams);
+					Print(OUTPUT_LEVEL_STANDARD, "chatresp", aBuf);
+				}
+				else if(m_StoreCommands && pCommand->m_Flags & CFGFLAG_STORE)
+				{
+					m_vExecutionQueue.emplace_back(pCommand, *pResult);
+				}
+				else
+				{
+					if(pCommand->m_Flags & CMDFLAG_TEST && !g_Config.m_SvTestingCommands)
 					{
-						if(pCommand->m_Flags & CMDFLAG_TEST && !g_Config.m_SvTestingCommands)
-						{
-							Print(OUTPUT_LEVEL_STANDARD, "console", "Test commands aren't allowed, enable them with 'sv_test_cmds 1' in your initial config.");
-							return;
-						}
+						Print(OUTPUT_LEVEL_STANDARD, "console", "Test commands aren't allowed, enable them with 'sv_test_cmds 1' in your initial config.");
+						return false;
+					}
 
-						if(m_pfnTeeHistorianCommandCallback && !(pCommand->m_Flags & CFGFLAG_NONTEEHISTORIC))
-						{
-							m_pfnTeeHistorianCommandCallback(ClientId, m_FlagMask, pCommand->m_pName, &Result, m_pTeeHistorianCommandUserdata);
-						}
+					if(m_pfnTeeHistorianCommandCallback && !(pCommand->m_Flags & CFGFLAG_NONTEEHISTORIC))
+					{
+						m_pfnTeeHistorianCommandCallback(ClientId, m_FlagMask, pCommand->m_pName, pResult, m_pTeeHistorianCommandUserdata);
+					}
 
-						if(Result.GetVictim() == CResult::VICTIM_ME)
-							Result.SetVictim(ClientId);
+					if(pResult->GetVictim() == CResult::VICTIM_ME)
+						pResult->SetVictim(ClientId);
 
-						if(Result.HasVictim() && Result.GetVictim() == CResult::VICTIM_ALL)
-						{
-							for(int i = 0; i < MAX_CLIENTS; i++)
-							{
-								Result.SetVictim(i);
-								pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
-							}
-						}
-						else
+					if(pResult->HasVictim() && pResult->GetVictim() == CResult::VICTIM_ALL)
+					{
+						for(int i = 0; i < MAX_CLIENTS; i++)
 						{
-							pCommand->m_pfnCallback(&Result, pCommand->m_pUserData);
+							pResult->SetVictim(i);
+							pCommand->m_pfnCallback(pResult, pCommand->m_pUserData);
 						}
-
-						if(pCommand->m_Flags & CMDFLAG_TEST)
-							m_Cheated = true;
 					}
+					else
+					{
+						pCommand->m_pfnCallback(pResult, pCommand->m_pUserData);
+					}
+
+					if(pCommand->m_Flags & CMDFLAG_TEST)
+						m_Cheated = true;
 				}
 			}
-			else if(Stroke)
-			{
-				char aBuf[CMDLINE_LENGTH + 32];
-				str_format(aBuf, sizeof(aBuf), "Access for command %s denied.", Result.m_pCommand);
-				Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
-			}
 		}
 		else if(Stroke)
 		{
-			// Pass the original string to the unknown command callback instead of the parsed command, as the latter
-			// ends at the first whitespace, which breaks for unknown commands (filenames) containing spaces.
-			if(!m_pfnUnknownCommandCallback(pStr, m_pUnknownCommandUserdata))
-			{
-				char aBuf[CMDLINE_LENGTH + 32];
-				if(m_FlagMask & CFGFLAG_CHAT)
-					str_format(aBuf, sizeof(aBuf), "No such command: %s. Use /cmdlist for a list of all commands.", Result.m_pCommand);
-				else
-					str_format(aBuf, sizeof(aBuf), "No such command: %s.", Result.m_pCommand);
-				Print(OUTPUT_LEVEL_STANDARD, "chatresp", aBuf);
-			}
+			char aBuf[CMDLINE_LENGTH + 32];
+			str_format(aBuf, sizeof(aBuf), "Access for command %s denied.", pResult->m_pCommand);
+			Print(OUTPUT_LEVEL_STANDARD, "console", aBuf);
 		}
-
-		pStr = pNextPart;
 	}
+	else if(Stroke)
+	{
+		// Pass the original string to the unknown command callback instead of the parsed command, as the latter
+		// ends at the first whitespace, which breaks for unknown commands (filenames) containing spaces.
+		if(!m_pfnUnknownCommandCallback(pStr, m_pUnknownCommandUserdata))
+		{
+			char aBuf[CMDLINE_LENGTH + 32];
+			if(m_FlagMask & CFGFLAG_CHAT)
+				str_format(aBuf, sizeof(aBuf), "No such command: %s. Use /cmdlist for a list of all commands.", pResult->m_pCommand);
+			else
+				str_format(aBuf, sizeof(aBuf), "No such command: %s.", pResult->m_pCommand);
+			Print(OUTPUT_LEVEL_STANDARD, "chatresp", aBuf);
+		}
+	}
+	return true;
 }
 
 bool CConsole::CanUseCommand(int ClientId, const IConsole::ICommandInfo *pCommand) const
@@ -679,9 +703,47 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
+unsigned CConsole::CommandNameHash(const char *pName)
+{
+	// FNV-1a of the lowercase name, as command names are case-insensitive
+	unsigned Hash = 2166136261u;
+	for(; *pName; pName++)
+	{
+		const char Char = *pName >= 'A' && *pName <= 'Z' ? *pName - 'A' + 'a' : *pName;
+		Hash = (Hash ^ (unsigned char)Char) * 16777619u;
+	}
+	return Hash;
+}
+
+void CConsole::IndexCommand(CCommand *pCommand)
+{
+	// keep the order of the sorted list, which puts new commands before the ones with the same name
+	std::vector<CCommand *> &vpCommands = m_CommandIndex[CommandNameHash(pCommand->m_pName)];
+	auto It = std::find_if(vpCommands.begin(), vpCommands.end(), [&](const CCommand *pOther) {
+		return str_comp(pCommand->m_pName, pOther->m_pName) <= 0;
+	});
+	vpCommands.insert(It, pCommand);
+	m_CommandsGeneration++;
+}
+
+void CConsole::UnindexCommand(CCommand *pCommand)
+{
+	auto It = m_CommandIndex.find(CommandNameHash(pCommand->m_pName));
+	dbg_assert(It != m_CommandIndex.end(), "command not indexed: %s", pCommand->m_pName);
+	std::vector<CCommand *> &vpCommands = It->second;
+	vpCommands.erase(std::remove(vpCommands.begin(), vpCommands.end(), pCommand), vpCommands.end());
+	if(vpCommands.empty())
+		m_CommandIndex.erase(It);
+	m_CommandsGeneration++;
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto It = m_CommandIndex.find(CommandNameHash(pName));
+	if(It == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : It->second)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -707,6 +769,107 @@ void CConsole::ExecuteLineFlag(const char *pStr, int FlagMask, int ClientId, boo
 	m_FlagMask = Temp;
 }
 
+void CConsole::CParsedArgs::Store(const CResult &Result, int Error)
+{
+	m_vStorage.assign(Result.m_aStringStorage, Result.m_aStringStorage + Result.m_StorageLength);
+	m_CommandOffset = Result.m_pCommand - Result.m_aStringStorage;
+	m_vArgOffsets.clear();
+	for(int i = 0; i < Result.NumArguments(); i++)
+	{
+		const char *pArg = Result.m_apArgs[i];
+		const bool InStorage = pArg >= Result.m_aStringStorage && pArg < Result.m_aStringStorage + Result.m_StorageLength;
+		m_vArgOffsets.push_back(InStorage ? pArg - Result.m_aStringStorage : -1);
+	}
+	m_Victim = Result.m_Victim;
+	m_Error = Error;
+	m_Valid = true;
+}
+
+void CConsole::CParsedArgs::Restore(CResult *pResult, const char *pStrokeStr) const
+{
+	mem_copy(pResult->m_aStringStorage, m_vStorage.data(), m_vStorage.size());
+	pResult->m_StorageLength = m_vStorage.size();
+	pResult->m_pCommand = pResult->m_aStringStorage + m_CommandOffset;
+	// all arguments have been parsed already
+	pResult->m_pArgsStart = pResult->m_aStringStorage + m_vStorage.size() - 1;
+	for(int Offset : m_vArgOffsets)
+		pResult->AddArgument(Offset < 0 ? pStrokeStr : pResult->m_aStringStorage + Offset);
+	pResult->m_Victim = m_Victim;
+}
+
+std::unique_ptr<IConsole::ICompiledLine> CConsole::CompileLine(const char *pStr, bool InterpretSemicolons)
+{
+	std::unique_ptr<CCompiledLine> pLine = std::make_unique<CCompiledLine>();
+	pLine->m_Line = pStr;
+	const char *pLineStart = pLine->m_Line.c_str();
+
+	const char *pPart = pLineStart;
+	const char *pWithoutPrefix = str_startswith(pPart, "mc;");
+	if(pWithoutPrefix)
+	{
+		InterpretSemicolons = true;
+		pPart = pWithoutPrefix;
+	}
+	while(pPart && *pPart)
+	{
+		const char *pNextPart;
+		const char *pEnd = FindPartEnd(pPart, InterpretSemicolons, &pNextPart);
+
+		// the name of the command like in ParseStart, parts without a command are skipped
+		CCompiledLine::CPart Part;
+		Part.m_Start = pPart - pLineStart;
+		Part.m_Length = (pEnd - pPart) + 1;
+		const char *pName = str_skip_whitespaces_const(pPart);
+		const char *pNameEnd = str_skip_to_whitespace_const(pName);
+		const char *pLimit = std::min(pEnd, pPart + CONSOLE_MAX_STR_LENGTH);
+		if(pName < pLimit)
+		{
+			Part.m_Name.assign(pName, std::min(pNameEnd, pLimit));
+			Part.m_IsStrokeCommand = Part.m_Name[0] == '+';
+			pLine->m_vParts.push_back(std::move(Part));
+		}
+
+		pPart = pNextPart;
+	}
+	return pLine;
+}
+
+void CConsole::ExecuteCompiledLine(ICompiledLine *pLine, int ClientId)
+{
+	ExecuteCompiledLineStroked(1, pLine, ClientId); // press it
+	ExecuteCompiledLineStroked(0, pLine, ClientId); // then release it
+}
+
+void CConsole::ExecuteCompiledLineStroked(int Stroke, ICompiledLine *pLine, int ClientId)
+{
+	CCompiledLine *pCompiledLine = static_cast<CCompiledLine *>(pLine);
+	const int FlagMask = ClientId == IConsole::CLIENT_ID_GAME ? m_FlagMask | CFGFLAG_GAME : m_FlagMask;
+	for(CCompiledLine::CPart &Part : pCompiledLine->m_vParts)
+	{
+		// releasing does nothing for commands which are not stroke commands
+		if(!Stroke && !Part.m_IsStrokeCommand)
+			continue;
+
+		if(Part.m_Generation != m_CommandsGeneration || Part.m_FlagMask != FlagMask)
+		{
+			Part.m_pCommand = FindCommand(Part.m_Name.c_str(), FlagMask);
+			Part.m_FlagMask = FlagMask;
+			Part.m_Generation = m_CommandsGeneration;
+			Part.m_ParsedArgs.m_Valid = false;
+		}
+
+		const char *pStr = pCompiledLine->m_Line.c_str() + Part.m_Start;
+		CResult Result(ClientId);
+		if(Part.m_ParsedArgs.m_Valid)
+			Part.m_ParsedArgs.Restore(&Result, m_apStrokeStr[Stroke]);
+		else
+			ParseStart(&Result, pStr, Part.m_Length);
+
+		if(!ExecuteCommand(Stroke, &Result, Part.m_pCommand, pStr, ClientId, &Part.m_ParsedArgs))
+			return;
+	}
+}
+
 bool CConsole::ExecuteFile(const char *pFilename, int ClientId, bool LogFailure, int StorageType)
 {
 	int Count = 0;
@@ -737,9 +900,30 @@ bool CConsole::ExecuteFile(const char *pFilename, int ClientId, bool LogFailure,
 		str_format(aBuf, sizeof(aBuf), "executing '%s'", pFilename);
 		Print(IConsole::OUTPUT_LEVEL_STANDARD, "console", aBuf);
 
+		std::vector<const char *> vpLines;
+		std::string Content;
 		while(const char *pLine = LineReader.Get())
 		{
-			ExecuteLine(pLine, ClientId);
+			vpLines.push_back(pLine);
+			Content.append(pLine);
+			Content.push_back('\n');
+		}
+
+		// files like the configs of maps are executed repeatedly, so their lines are only compiled once.
+		// the cache is only cleared by files which are not executed by other files, which could still be using it.
+		if(pPrev == nullptr && m_ExecFileCache.size() >= MAX_EXEC_FILE_CACHE)
+			m_ExecFileCache.clear();
+		CExecFileCache &Cache = m_ExecFileCache[{pFilename, StorageType}];
+		if(Cache.m_Content != Content)
+		{
+			Cache.m_Content = std::move(Content);
+			Cache.m_vpLines.clear();
+			for(const char *pLine : vpLines)
+				Cache.m_vpLines.push_back(CompileLine(pLine));
+		}
+		for(const auto &pLine : Cache.m_vpLines)
+		{
+			ExecuteCompiledLine(pLine.get(), ClientId);
 		}
 
 		Success = true;
@@ -869,6 +1053,7 @@ CConsole::CConsole(int FlagMask)
 	m_apStrokeStr[0] = "0";
 	m_apStrokeStr[1] = "1";
 	m_pFirstCommand = nullptr;
+	m_CommandsGeneration = 1;
 	m_pFirstExec = nullptr;
 	m_pfnTeeHistorianCommandCallback = nullptr;
 	m_pTeeHistorianCommandUserdata = nullptr;
@@ -946,10 +1131,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 {
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
-		if(m_pFirstCommand && m_pFirstCommand->Next())
-			pCommand->SetNext(m_pFirstCommand);
-		else
-			pCommand->SetNext(nullptr);
+		pCommand->SetNext(m_pFirstCommand);
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -964,6 +1146,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+	IndexCommand(pCommand);
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -988,6 +1171,8 @@ void CConsole::Register(const char *pName, const char *pParams,
 
 	if(DoAdd)
 		AddCommandSorted(pCommand);
+	else
+		m_CommandsGeneration++;
 
 	if(pCommand->m_Flags & CFGFLAG_CHAT)
 		pCommand->SetAccessLevel(EAccessLevel::USER);
@@ -1054,6 +1239,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		UnindexCommand(pRemoved);
 		pRemoved->SetNext(m_pRecycleList);
 		m_pRecycleList = pRemoved;
 	}
@@ -1077,6 +1263,17 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(auto It = m_CommandIndex.begin(); It != m_CommandIndex.end();)
+	{
+		std::vector<CCommand *> &vpCommands = It->second;
+		vpCommands.erase(std::remove_if(vpCommands.begin(), vpCommands.end(), [](const CCommand *pCommand) { return pCommand->m_Temp; }), vpCommands.end());
+		if(vpCommands.empty())
+			It = m_CommandIndex.erase(It);
+		else
+			++It;
+	}
+	m_CommandsGeneration++;
+
 	m_TempCommands.Reset();
 	m_pRecycleList = nullptr;
 }
@@ -1110,6 +1307,7 @@ void CConsole::Chain(const char *pName, FChainCommandCallback pfnChainFunc, void
 	// chain
 	pCommand->m_pfnCallback = Con_Chain;
 	pCommand->m_pUserData = pChainInfo;
+	m_CommandsGeneration++;
 }
 
 void CConsole::StoreCommands(bool Store)
@@ -1127,7 +1325,11 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::ICommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto It = m_CommandIndex.find(CommandNameHash(pName));
+	if(It == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : It->second)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
 		{
@@ -8,7 +8,10 @@
 #include <engine/console.h>
 #include <engine/storage.h>
 
+#include <map>
 #include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class CConsole : public IConsole
@@ -52,6 +55,14 @@ class CConsole : public IConsole
 	bool m_StoreCommands;
 	const char *m_apStrokeStr[2];
 	CCommand *m_pFirstCommand;
+	// commands by the hash of their lowercase name, in the same order as in the list
+	std::unordered_map<unsigned, std::vector<CCommand *>> m_CommandIndex;
+	// changes whenever commands are added, removed or changed, so compiled lines look them up again
+	unsigned m_CommandsGeneration;
+
+	static unsigned CommandNameHash(const char *pName);
+	void IndexCommand(CCommand *pCommand);
+	void UnindexCommand(CCommand *pCommand);
 
 	class CExecFile
 	{
@@ -90,13 +101,15 @@ class CConsole : public IConsole
 	enum
 	{
 		CONSOLE_MAX_STR_LENGTH = 8192,
-		MAX_PARTS = (CONSOLE_MAX_STR_LENGTH + 1) / 2
+		MAX_PARTS = (CONSOLE_MAX_STR_LENGTH + 1) / 2,
+		MAX_EXEC_FILE_CACHE = 64,
 	};
 
 	class CResult : public IResult
 	{
 	public:
 		char m_aStringStorage[CONSOLE_MAX_STR_LENGTH + 1];
+		int m_StorageLength;
 		char *m_pArgsStart;
 
 		const char *m_pCommand;
@@ -104,6 +117,7 @@ class CConsole : public IConsole
 
 		CResult(int ClientId);
 		CResult(const CResult &Other);
+		CResult &operator=(const CResult &Other) = delete;
 
 		void AddArgument(const char *pArg);
 		void RemoveArgument(unsigned Index) override;
@@ -132,6 +146,22 @@ class CConsole : public IConsole
 
 	int ParseStart(CResult *pResult, const char *pString, int Length);
 
+	// the result of parsing the arguments of a command, which can be restored instead of parsing them again
+	class CParsedArgs
+	{
+	public:
+		bool m_Valid = false;
+		int m_Error;
+		int m_Victim;
+		int m_CommandOffset;
+		std::vector<char> m_vStorage;
+		// offsets into the storage, negative for the stroke argument which is not part of it
+		std::vector<int> m_vArgOffsets;
+
+		void Store(const CResult &Result, int Error);
+		void Restore(CResult *pResult, const char *pStrokeStr) const;
+	};
+
 	enum
 	{
 		PARSEARGS_OK = 0,
@@ -162,6 +192,48 @@ class CConsole : public IConsole
 	};
 	std::vector<CExecutionQueueEntry> m_vExecutionQueue;
 
+	class CCompiledLine : public ICompiledLine
+	{
+	public:
+		class CPart
+		{
+		public:
+			// offset of the part in the line, the rest of the line is passed to the unknown command callback
+			int m_Start;
+			int m_Length;
+			std::string m_Name;
+			bool m_IsStrokeCommand;
+
+			// the command and its arguments, valid for the flag mask and commands generation
+			CCommand *m_pCommand = nullptr;
+			int m_FlagMask = 0;
+			unsigned m_Generation = 0;
+			CParsedArgs m_ParsedArgs;
+		};
+
+		std::string m_Line;
+		std::vector<CPart> m_vParts;
+
+		const char *Line() const override { return m_Line.c_str(); }
+	};
+
+	class CExecFileCache
+	{
+	public:
+		std::string m_Content;
+		std::vector<std::unique_ptr<ICompiledLine>> m_vpLines;
+	};
+	std::map<std::pair<std::string, int>, CExecFileCache> m_ExecFileCache;
+
+	/**
+	 * Executes a command whose name has been parsed into the result.
+	 *
+	 * @param pParsed Cache for the parsed arguments. If it is valid, the result already contains them.
+	 *
+	 * @return `false` if the rest of the line must not be executed.
+	 */
+	bool ExecuteCommand(int Stroke, CResult *pResult, CCommand *pCommand, const char *pStr, int ClientId, CParsedArgs *pParsed);
+
 	void AddCommandSorted(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
@@ -186,9 +258,13 @@ public:
 	void StoreCommands(bool Store) override;
 
 	bool LineIsValid(const char *pStr) override;
+	void ParseLine(const char *pStr, FParsedCommandCallback pfnCallback, void *pUser) override;
 	void ExecuteLine(const char *pStr, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) override;
 	void ExecuteLineFlag(const char *pStr, int FlagMask, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED, bool InterpretSemicolons = true) override;
 	bool ExecuteFile(const char *pFilename, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED, bool LogFailure = false, int StorageType = IStorage::TYPE_ALL) override;
+	std::unique_ptr<ICompiledLine> CompileLine(const char *pStr, bool InterpretSemicolons = true) override;
+	void ExecuteCompiledLine(ICompiledLine *pLine, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED) override;
+	void ExecuteCompiledLineStroked(int Stroke, ICompiledLine *pLine, int ClientId = IConsole::CLIENT_ID_UNSPECIFIED) override;
 
 	void Print(int Level, const char *pFrom, const char *pStr, ColorRGBA PrintColor = gs_ConsoleDefaultColor) const override;
 	void SetTeeHistorianCommandCallback(FTeeHistorianCommandCallback pfnCallback, void *pUser) override;
@@ -10,12 +10,17 @@
 #include <base/math.h>
 #include <base/system.h>
 
+#include <engine/engine.h>
 #include <engine/storage.h>
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <limits>
+#include <thread>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
@@ -36,6 +41,12 @@ static inline void SwapEndianInPlace(T *pObj)
 	SwapEndianInPlace(pObj, sizeof(T));
 }
 
+#if defined(CONF_ARCH_ENDIAN_BIG)
+static constexpr bool NEEDS_ENDIAN_SWAP = true;
+#else
+static constexpr bool NEEDS_ENDIAN_SWAP = false;
+#endif
+
 static inline int SwapEndianInt(int Number)
 {
 	SwapEndianInPlace(&Number);
@@ -129,6 +140,10 @@ class CDatafile
 {
 public:
 	IOHANDLE m_File;
+	// the whole file if it could be read into memory, otherwise data is read from the file
+	char *m_pFileBuffer;
+	// set once the buffer is shared with others, data must not be modified in place anymore
+	bool m_FileBufferShared;
 	unsigned m_FileSize;
 	SHA256_DIGEST m_Sha256;
 	unsigned m_Crc;
@@ -139,6 +154,20 @@ public:
 	int *m_pDataSizes;
 	char *m_pData;
 
+	bool IsInFileBuffer(const void *pData) const
+	{
+		return m_pFileBuffer != nullptr && pData >= m_pFileBuffer && pData < m_pFileBuffer + m_FileSize;
+	}
+
+	void FreeData(int Index) const
+	{
+		if(!IsInFileBuffer(m_ppDataPtrs[Index]))
+		{
+			free(m_ppDataPtrs[Index]);
+		}
+		m_ppDataPtrs[Index] = nullptr;
+	}
+
 	int GetFileDataSize(int Index) const
 	{
 		dbg_assert(Index >= 0 && Index < m_Header.m_NumRawData, "Invalid Index: %d", Index);
@@ -200,6 +229,7 @@ public:
 		}
 
 		const unsigned DataSize = GetFileDataSize(Index);
+		const char *pFileData = m_pFileBuffer != nullptr ? m_pFileBuffer + m_DataStartOffset + m_Info.m_pDataOffsets[Index] : nullptr;
 		if(m_Info.m_pDataSizes != nullptr)
 		{
 			// v4 has compressed data
@@ -213,27 +243,32 @@ public:
 				return nullptr;
 			}
 
-			// read the compressed data
-			void *pCompressedData = malloc(DataSize);
-			if(pCompressedData == nullptr)
-			{
-				log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
-			}
-			unsigned ActualDataSize = 0;
-			if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
-			{
-				ActualDataSize = io_read(m_File, pCompressedData, DataSize);
-			}
-			if(DataSize != ActualDataSize)
+			// read the compressed data, unless it can be decompressed directly from the file buffer
+			void *pCompressedData = nullptr;
+			if(pFileData == nullptr)
 			{
-				log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
-				free(pCompressedData);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
+				pCompressedData = malloc(DataSize);
+				if(pCompressedData == nullptr)
+				{
+					log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
+				unsigned ActualDataSize = 0;
+				if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
+				{
+					ActualDataSize = io_read(m_File, pCompressedData, DataSize);
+				}
+				if(DataSize != ActualDataSize)
+				{
+					log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
+					free(pCompressedData);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
+				pFileData = static_cast<const char *>(pCompressedData);
 			}
 
 			// decompress the data
@@ -246,7 +281,7 @@ public:
 				return nullptr;
 			}
 			unsigned long UncompressedSize = OriginalUncompressedSize;
-			const int Result = uncompress(static_cast<Bytef *>(m_ppDataPtrs[Index]), &UncompressedSize, static_cast<Bytef *>(pCompressedData), DataSize);
+			const int Result = uncompress(static_cast<Bytef *>(m_ppDataPtrs[Index]), &UncompressedSize, reinterpret_cast<const Bytef *>(pFileData), DataSize);
 			free(pCompressedData);
 			if(Result != Z_OK || UncompressedSize != OriginalUncompressedSize)
 			{
@@ -258,6 +293,14 @@ public:
 			}
 			m_pDataSizes[Index] = OriginalUncompressedSize;
 		}
+		else if(pFileData != nullptr && !m_FileBufferShared && (uintptr_t)pFileData % sizeof(int) == 0 && !(Swap && NEEDS_ENDIAN_SWAP))
+		{
+			// the buffer is owned by the reader, so the data can be used and even modified in place
+			log_trace("datafile", "using data in place. index=%d size=%d", Index, DataSize);
+			m_ppDataPtrs[Index] = const_cast<char *>(pFileData);
+			m_pDataSizes[Index] = DataSize;
+			return m_ppDataPtrs[Index];
+		}
 		else
 		{
 			log_trace("datafile", "loading data. index=%d size=%d", Index, DataSize);
@@ -269,7 +312,12 @@ public:
 				return nullptr;
 			}
 			unsigned ActualDataSize = 0;
-			if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
+			if(pFileData != nullptr)
+			{
+				mem_copy(m_ppDataPtrs[Index], pFileData, DataSize);
+				ActualDataSize = DataSize;
+			}
+			else if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
 			{
 				ActualDataSize = io_read(m_File, m_ppDataPtrs[Index], DataSize);
 			}
@@ -455,6 +503,23 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
+	// read the whole file into memory if possible, otherwise the data is read from the file
+	// when it is needed. the file is not mapped, so replacing or truncating it while it is
+	// open cannot affect the loaded data.
+	const int64_t Length = io_length(File);
+	char *pFileBuffer = Length > 0 ? static_cast<char *>(malloc(Length)) : nullptr;
+	if(pFileBuffer != nullptr && (int64_t)io_read(File, pFileBuffer, Length) != Length)
+	{
+		log_warn("datafile", "could not read file into memory, reading it piecewise instead");
+		free(pFileBuffer);
+		pFileBuffer = nullptr;
+		io_seek(File, 0, IOSEEK_START);
+	}
+	const auto &&CloseFile = [&]() {
+		free(pFileBuffer);
+		io_close(File);
+	};
+
 	// determine size and hashes of the file and store them
 	int64_t FileSize = 0;
 	unsigned Crc = 0;
@@ -462,30 +527,52 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	{
 		SHA256_CTX Sha256Ctxt;
 		sha256_init(&Sha256Ctxt);
-		unsigned char aBuffer[64 * 1024];
-		while(true)
-		{
-			const unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
-			if(Bytes == 0)
-				break;
+		const auto &&Hash = [&](const void *pData, unsigned Bytes) {
 			FileSize += Bytes;
-			Crc = crc32(Crc, aBuffer, Bytes);
-			sha256_update(&Sha256Ctxt, aBuffer, Bytes);
+			Crc = crc32(Crc, static_cast<const Bytef *>(pData), Bytes);
+			sha256_update(&Sha256Ctxt, pData, Bytes);
+		};
+		if(pFileBuffer != nullptr)
+		{
+			constexpr int64_t CHUNK_SIZE = 1024 * 1024;
+			for(int64_t Offset = 0; Offset < Length; Offset += CHUNK_SIZE)
+			{
+				Hash(pFileBuffer + Offset, minimum(CHUNK_SIZE, Length - Offset));
+			}
 		}
-		Sha256 = sha256_finish(&Sha256Ctxt);
-		if(io_seek(File, 0, IOSEEK_START) != 0)
+		else
 		{
-			io_close(File);
-			log_error("datafile", "could not seek to start after calculating hashes");
-			return false;
+			unsigned char aBuffer[64 * 1024];
+			while(true)
+			{
+				const unsigned Bytes = io_read(File, aBuffer, sizeof(aBuffer));
+				if(Bytes == 0)
+					break;
+				Hash(aBuffer, Bytes);
+			}
 		}
+		Sha256 = sha256_finish(&Sha256Ctxt);
 	}
 
+	// reads from the file buffer or the file
+	const auto &&ReadFile = [&](void *pDest, int64_t Offset, int64_t Size) {
+		if(pFileBuffer != nullptr)
+		{
+			if(Offset + Size > FileSize)
+			{
+				return false;
+			}
+			mem_copy(pDest, pFileBuffer + Offset, Size);
+			return true;
+		}
+		return io_seek(File, Offset, IOSEEK_START) == 0 && (int64_t)io_read(File, pDest, Size) == Size;
+	};
+
 	// read header
 	CDatafileHeader Header;
-	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header))
+	if(!ReadFile(&Header, 0, sizeof(Header)))
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "could not read file header. file truncated or not a datafile.");
 		return false;
 	}
@@ -494,7 +581,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if((Header.m_aId[0] != 'A' || Header.m_aId[1] != 'T' || Header.m_aId[2] != 'A' || Header.m_aId[3] != 'D') &&
 		(Header.m_aId[0] != 'D' || Header.m_aId[1] != 'A' || Header.m_aId[2] != 'T' || Header.m_aId[3] != 'A'))
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "wrong header magic. magic=%x%x%x%x", Header.m_aId[0], Header.m_aId[1], Header.m_aId[2], Header.m_aId[3]);
 		return false;
 	}
@@ -504,7 +591,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	// check header version
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "unsupported header version. version=%d", Header.m_Version);
 		return false;
 	}
@@ -518,7 +605,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Header.m_ItemSize % sizeof(int) != 0 ||
 		Header.m_DataSize < 0)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header information. num_types=%d num_items=%d num_data=%d item_size=%d data_size=%d",
 			Header.m_NumItemTypes, Header.m_NumItems, Header.m_NumRawData, Header.m_ItemSize, Header.m_DataSize);
 		return false;
@@ -544,7 +631,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if((int64_t)sizeof(Header) + Size + (int64_t)Header.m_DataSize != FileSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header data size or truncated file. data_size=%d file_size=%" PRId64, Header.m_DataSize, FileSize);
 		return false;
 	}
@@ -559,7 +646,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header size or truncated file. size=%" PRId64 " actual=%" PRId64, HeaderFileSize, FileSize);
 			return false;
 		}
@@ -576,7 +663,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header swaplen or truncated file. swaplen=%" PRId64 " actual=%" PRId64, HeaderSwaplen, FileSizeSwaplen);
 			return false;
 		}
@@ -589,7 +676,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(int); // add space for data sizes
 	if(AllocSize > MaxAllocSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "file too large. alloc_size=%" PRId64 " max=%" PRId64, AllocSize, MaxAllocSize);
 		return false;
 	}
@@ -597,7 +684,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	CDatafile *pTmpDataFile = static_cast<CDatafile *>(malloc(AllocSize));
 	if(pTmpDataFile == nullptr)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "out of memory. could not allocate memory for datafile. alloc_size=%" PRId64, AllocSize);
 		return false;
 	}
@@ -607,6 +694,8 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	pTmpDataFile->m_pDataSizes = (int *)(pTmpDataFile->m_ppDataPtrs + Header.m_NumRawData);
 	pTmpDataFile->m_pData = (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
 	pTmpDataFile->m_File = File;
+	pTmpDataFile->m_pFileBuffer = pFileBuffer;
+	pTmpDataFile->m_FileBufferShared = false;
 	pTmpDataFile->m_FileSize = FileSize;
 	pTmpDataFile->m_Sha256 = Sha256;
 	pTmpDataFile->m_Crc = Crc;
@@ -615,13 +704,13 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	mem_zero(pTmpDataFile->m_ppDataPtrs, Header.m_NumRawData * sizeof(void *));
 	mem_zero(pTmpDataFile->m_pDataSizes, Header.m_NumRawData * sizeof(int));
 
-	// read types, offsets, sizes and item data
-	const unsigned ReadSize = io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
-	if((int64_t)ReadSize != Size)
+	// read types, offsets, sizes and item data. they are copied even if the file is in memory,
+	// so they cannot change after being validated.
+	if(!ReadFile(pTmpDataFile->m_pData, sizeof(CDatafileHeader), Size))
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
-		log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64 " got=%d", Size, ReadSize);
+		log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64, Size);
 		return false;
 	}
 
@@ -647,7 +736,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if(!pTmpDataFile->Validate())
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
 		return false;
 	}
@@ -667,9 +756,10 @@ void CDataFileReader::Close()
 
 	for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
 	{
-		free(m_pDataFile->m_ppDataPtrs[i]);
+		m_pDataFile->FreeData(i);
 	}
 
+	free(m_pDataFile->m_pFileBuffer);
 	io_close(m_pDataFile->m_File);
 	free(m_pDataFile);
 	m_pDataFile = nullptr;
@@ -687,6 +777,38 @@ IOHANDLE CDataFileReader::File() const
 	return m_pDataFile->m_File;
 }
 
+const unsigned char *CDataFileReader::FileData()
+{
+	dbg_assert(m_pDataFile != nullptr, "File not open");
+
+	if(m_pDataFile->m_pFileBuffer == nullptr)
+	{
+		return nullptr;
+	}
+
+	// data that is used in place may be modified by its users, so copy it before sharing the buffer
+	if(!m_pDataFile->m_FileBufferShared)
+	{
+		for(int i = 0; i < m_pDataFile->m_Header.m_NumRawData; i++)
+		{
+			if(!m_pDataFile->IsInFileBuffer(m_pDataFile->m_ppDataPtrs[i]))
+			{
+				continue;
+			}
+			void *pCopy = malloc(m_pDataFile->m_pDataSizes[i]);
+			if(pCopy == nullptr)
+			{
+				log_error("datafile", "out of memory. could not copy data used in place. index=%d size=%d", i, m_pDataFile->m_pDataSizes[i]);
+				return nullptr;
+			}
+			mem_copy(pCopy, m_pDataFile->m_ppDataPtrs[i], m_pDataFile->m_pDataSizes[i]);
+			m_pDataFile->m_ppDataPtrs[i] = pCopy;
+		}
+		m_pDataFile->m_FileBufferShared = true;
+	}
+	return reinterpret_cast<const unsigned char *>(m_pDataFile->m_pFileBuffer);
+}
+
 int CDataFileReader::GetDataSize(int Index) const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
@@ -736,7 +858,7 @@ void CDataFileReader::ReplaceData(int Index, char *pData, size_t Size)
 	dbg_assert(m_pDataFile != nullptr, "File not open");
 	dbg_assert(Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData, "Index invalid: %d", Index);
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_ppDataPtrs[Index] = pData;
 	m_pDataFile->m_pDataSizes[Index] = Size;
 }
@@ -748,11 +870,54 @@ void CDataFileReader::UnloadData(int Index)
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
 		return;
 
-	free(m_pDataFile->m_ppDataPtrs[Index]);
-	m_pDataFile->m_ppDataPtrs[Index] = nullptr;
+	m_pDataFile->FreeData(Index);
 	m_pDataFile->m_pDataSizes[Index] = 0;
 }
 
+void CDataFileReader::LoadData(IEngine *pEngine, const std::vector<int> &vIndices)
+{
+	dbg_assert(m_pDataFile != nullptr, "File not open");
+
+	// every data must only be loaded once, as loading it on multiple threads at the same time is not safe
+	std::vector<int> vLoad;
+	for(int Index : vIndices)
+	{
+		if(Index >= 0 && Index < m_pDataFile->m_Header.m_NumRawData && m_pDataFile->m_ppDataPtrs[Index] == nullptr && m_pDataFile->m_pDataSizes[Index] >= 0)
+		{
+			vLoad.push_back(Index);
+		}
+	}
+	std::sort(vLoad.begin(), vLoad.end());
+	vLoad.erase(std::unique(vLoad.begin(), vLoad.end()), vLoad.end());
+	if(vLoad.empty())
+	{
+		return;
+	}
+
+	// start with the largest data, so it is not left for the end when the other threads are idle
+	std::stable_sort(vLoad.begin(), vLoad.end(), [&](int Index1, int Index2) {
+		return m_pDataFile->GetFileDataSize(Index1) > m_pDataFile->GetFileDataSize(Index2);
+	});
+
+	// only the file buffer can be read by multiple threads at the same time, not the file
+	if(pEngine != nullptr && m_pDataFile->m_pFileBuffer != nullptr)
+	{
+		pEngine->ParallelFor(0, vLoad.size(), 1, [&](int Begin, int End) {
+			for(int i = Begin; i < End; i++)
+			{
+				m_pDataFile->GetData(vLoad[i], false);
+			}
+		});
+	}
+	else
+	{
+		for(int Index : vLoad)
+		{
+			m_pDataFile->GetData(Index, false);
+		}
+	}
+}
+
 int CDataFileReader::NumData() const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
@@ -1104,21 +1269,49 @@ static int CompressionLevelToZlib(CDataFileWriter::ECompressionLevel Compression
 	}
 }
 
-void CDataFileWriter::Finish()
+void CDataFileWriter::Finish(int MaxThreads)
 {
 	dbg_assert((bool)m_File, "File not open");
+	dbg_assert(MaxThreads >= 0, "Invalid MaxThreads: %d", MaxThreads);
 
 	// Compress data. This takes the majority of the time when saving a datafile,
 	// so it's delayed until the end so it can be off-loaded to another thread.
-	for(CDataInfo &DataInfo : m_vDatas)
+	// Every data is compressed on its own, so they can be compressed in parallel
+	// and the result does not depend on which thread compressed which data.
+	const std::chrono::nanoseconds CompressStart = time_get_nanoseconds();
+	std::vector<int> vCompressOrder(m_vDatas.size());
+	for(size_t i = 0; i < m_vDatas.size(); i++)
+	{
+		vCompressOrder[i] = i;
+	}
+	// start with the largest data, so it is not left for the end when the other threads are idle
+	std::stable_sort(vCompressOrder.begin(), vCompressOrder.end(), [&](int Index1, int Index2) {
+		return m_vDatas[Index1].m_UncompressedSize > m_vDatas[Index2].m_UncompressedSize;
+	});
+	std::atomic<size_t> NextCompress = 0;
+	const auto &&CompressData = [&]() {
+		for(size_t Next = NextCompress.fetch_add(1); Next < vCompressOrder.size(); Next = NextCompress.fetch_add(1))
+		{
+			CDataInfo &DataInfo = m_vDatas[vCompressOrder[Next]];
+			unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
+			DataInfo.m_pCompressedData = malloc(CompressedSize);
+			const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
+			DataInfo.m_CompressedSize = CompressedSize;
+			free(DataInfo.m_pUncompressedData);
+			DataInfo.m_pUncompressedData = nullptr;
+			dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+		}
+	};
+	const size_t NumThreads = std::clamp<size_t>(MaxThreads > 0 ? MaxThreads : std::thread::hardware_concurrency(), 1, maximum<size_t>(m_vDatas.size(), 1));
+	std::vector<std::thread> vThreads;
+	for(size_t i = 1; i < NumThreads; i++)
 	{
-		unsigned long CompressedSize = compressBound(DataInfo.m_UncompressedSize);
-		DataInfo.m_pCompressedData = malloc(CompressedSize);
-		const int Result = compress2(static_cast<Bytef *>(DataInfo.m_pCompressedData), &CompressedSize, static_cast<Bytef *>(DataInfo.m_pUncompressedData), DataInfo.m_UncompressedSize, CompressionLevelToZlib(DataInfo.m_CompressionLevel));
-		DataInfo.m_CompressedSize = CompressedSize;
-		free(DataInfo.m_pUncompressedData);
-		DataInfo.m_pUncompressedData = nullptr;
-		dbg_assert(Result == Z_OK, "datafile zlib compression failed with error %d", Result);
+		vThreads.emplace_back(CompressData);
+	}
+	CompressData();
+	for(std::thread &Thread : vThreads)
+	{
+		Thread.join();
 	}
 
 	// Calculate total size of items
@@ -1131,10 +1324,14 @@ void CDataFileWriter::Finish()
 
 	// Calculate total size of data
 	int64_t DataSize = 0;
+	int64_t UncompressedDataSize = 0;
 	for(const CDataInfo &DataInfo : m_vDatas)
 	{
 		DataSize += DataInfo.m_CompressedSize;
+		UncompressedDataSize += DataInfo.m_UncompressedSize;
 	}
+	log_debug("datafile", "compressed data. num=%d threads=%d uncompressed=%" PRId64 " compressed=%" PRId64 " time=%.2fms",
+		(int)m_vDatas.size(), (int)NumThreads, UncompressedDataSize, DataSize, (time_get_nanoseconds() - CompressStart).count() / 1000000.0);
 
 	// Calculate complete file size
 	const int64_t TypesSize = m_ItemTypes.size() * sizeof(CDatafileItemType);
@@ -35,6 +35,15 @@ public:
 	void Close();
 	bool IsOpen() const;
 	IOHANDLE File() const;
+	/**
+	 * Returns the content of the whole file, if it was read into memory.
+	 *
+	 * @return The content of the file with @link MapSize @endlink bytes, or `nullptr` if it is not in memory.
+	 *
+	 * @remark The content stays valid until the file is closed. Data which was used in place is copied,
+	 *         so changes to data returned by @link GetData @endlink afterwards do not change the content.
+	 */
+	const unsigned char *FileData();
 
 	int GetDataSize(int Index) const;
 	void *GetData(int Index);
@@ -42,6 +51,16 @@ public:
 	const char *GetDataString(int Index);
 	void ReplaceData(int Index, char *pData, size_t Size); // memory for data must have been allocated with malloc
 	void UnloadData(int Index);
+	/**
+	 * Loads data in parallel using the jobs of the engine and waits until it has been loaded.
+	 * Loading data with @link GetData @endlink afterwards does not need to decompress it anymore.
+	 *
+	 * @param pEngine The engine which runs the jobs, or `nullptr` to load the data on this thread only.
+	 * @param vIndices The indices of the data to load. Invalid indices and data which is already loaded are skipped.
+	 *
+	 * @remark The data is loaded like with @link GetData @endlink, i.e. not swapped.
+	 */
+	void LoadData(class IEngine *pEngine, const std::vector<int> &vIndices);
 	int NumData() const;
 
 	int GetItemSize(int Index) const;
@@ -130,7 +149,15 @@ public:
 	int AddData(size_t Size, const void *pData, ECompressionLevel CompressionLevel = COMPRESSION_DEFAULT);
 	int AddDataSwapped(size_t Size, const void *pData);
 	int AddDataString(const char *pStr);
-	void Finish();
+	/**
+	 * Compresses the data and writes the file.
+	 *
+	 * @param MaxThreads Maximum number of threads which compress data at the same time,
+	 * `0` to use as many as there are hardware threads.
+	 *
+	 * @remark The file is identical regardless of the number of threads.
+	 */
+	void Finish(int MaxThreads = 0);
 };
 
 #endif
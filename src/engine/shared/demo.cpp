@@ -17,6 +17,8 @@
 #include "network.h"
 #include "snapshot.h"
 
+#include <algorithm>
+
 const CUuid SHA256_EXTENSION =
 	{{0x6b, 0xe6, 0xda, 0x4a, 0xce, 0xbd, 0x38, 0x0c,
 		0x9b, 0x5b, 0x12, 0x89, 0xc8, 0x42, 0xd7, 0x80}};
@@ -30,6 +32,59 @@ static const unsigned char gs_VersionTickCompression = 5; // demo files with thi
 static constexpr ColorRGBA gs_DemoPrintColor{0.75f, 0.7f, 0.7f, 1.0f};
 static constexpr LOG_COLOR DEMO_PRINT_COLOR = {191, 178, 178};
 
+/*
+	Keyframe index
+
+	Written next to the demo, so old demos and players are not affected. It
+	starts with the compressed snapshots, followed by the keyframe and
+	snapshot tables and the footer, all values are stored big endian.
+*/
+static const unsigned char gs_aIndexMarker[8] = {'T', 'W', 'D', 'E', 'M', 'O', 'I', 'X'};
+static const unsigned gs_IndexVersion = 1;
+
+class CDemoIndexFooter
+{
+public:
+	unsigned char m_aMarker[8];
+	unsigned char m_aVersion[4];
+	// the index only belongs to the demo with this size and timestamp
+	unsigned char m_aDemoSize[8];
+	char m_aTimestamp[20];
+	unsigned char m_aFirstTick[4];
+	unsigned char m_aLastTick[4];
+	unsigned char m_aNumKeyFrames[4];
+	unsigned char m_aNumSnapshots[4];
+	unsigned char m_aTablesOffset[8];
+};
+
+class CDemoIndexKeyFrameEntry
+{
+public:
+	unsigned char m_aFilepos[8];
+	unsigned char m_aTick[4];
+};
+
+class CDemoIndexSnapshotEntry
+{
+public:
+	unsigned char m_aFilepos[8];
+	unsigned char m_aTick[4];
+	unsigned char m_aPreviousTick[4];
+	unsigned char m_aDataOffset[8];
+	unsigned char m_aDataSize[4];
+};
+
+static void Int64ToBytesBe(unsigned char *pBytes, int64_t Value)
+{
+	uint_to_bytes_be(pBytes, (uint64_t)Value >> 32);
+	uint_to_bytes_be(pBytes + 4, (uint64_t)Value & 0xffffffff);
+}
+
+static int64_t BytesBeToInt64(const unsigned char *pBytes)
+{
+	return (int64_t)(((uint64_t)bytes_be_to_uint(pBytes) << 32) | bytes_be_to_uint(pBytes + 4));
+}
+
 bool CDemoHeader::Valid() const
 {
 	// Check marker and ensure that strings are zero-terminated and valid UTF-8.
@@ -40,8 +95,9 @@ bool CDemoHeader::Valid() const
 	       mem_has_null(m_aTimestamp, sizeof(m_aTimestamp)) && str_utf8_check(m_aTimestamp);
 }
 
-CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData)
+CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData, CDemoRecordWriter *pWriter)
 {
+	m_pWriter = pWriter;
 	m_File = nullptr;
 	m_aCurrentFilename[0] = '\0';
 	m_pfnFilter = nullptr;
@@ -57,7 +113,7 @@ CDemoRecorder::~CDemoRecorder()
 }
 
 // Record
-int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned Crc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser)
+int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetVersion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned Crc, const char *pType, unsigned MapSize, const unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser, bool WriteIndex)
 {
 	dbg_assert(m_File == 0, "Demo recorder already recording");
 
@@ -202,6 +258,20 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_LastTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_LastSnapshotDataSize = 0;
+
+	// recording works without the index, an index of an earlier demo with the same name is replaced
+	m_IndexFile = nullptr;
+	if(WriteIndex)
+	{
+		char aIndexFilename[IO_MAX_PATH_LENGTH];
+		IndexFilename(pFilename, aIndexFilename, sizeof(aIndexFilename));
+		m_IndexFile = pStorage->OpenFile(aIndexFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	}
+	m_vIndexKeyFrames.clear();
+	m_vIndexSnapshots.clear();
+	m_LastIndexSnapshot = -1;
+	str_copy(m_aTimestamp, Header.m_aTimestamp);
 
 	if(m_pConsole)
 	{
@@ -216,6 +286,9 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 	m_File = DemoFile;
 	str_copy(m_aCurrentFilename, pFilename);
 
+	if(m_pWriter)
+		m_pWriter->Register(this);
+
 	return 0;
 }
 
@@ -247,8 +320,17 @@ enum
 	CHUNKTYPE_DELTA = 3,
 };
 
+// items queued for the writer which are not compressed chunks: the tick markers
+// and the entries of the index, which need the file position they are written at
+static constexpr int CHUNKTYPE_RAW = -1;
+static constexpr int CHUNKTYPE_INDEX_KEYFRAME = -2;
+static constexpr int CHUNKTYPE_INDEX_SNAPSHOT = -3;
+
 void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 {
+	if(Keyframe && m_IndexFile)
+		Enqueue(CHUNKTYPE_INDEX_KEYFRAME, &Tick, sizeof(Tick));
+
 	if(m_LastTickMarker == -1 || Tick - m_LastTickMarker > CHUNKMASK_TICK || Keyframe)
 	{
 		unsigned char aChunk[sizeof(int32_t) + 1];
@@ -258,13 +340,13 @@ void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 		if(Keyframe)
 			aChunk[0] |= CHUNKTICKFLAG_KEYFRAME;
 
-		io_write(m_File, aChunk, sizeof(aChunk));
+		WriteRaw(aChunk, sizeof(aChunk));
 	}
 	else
 	{
 		unsigned char aChunk[1];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | CHUNKTICKFLAG_TICK_COMPRESSED | (Tick - m_LastTickMarker);
-		io_write(m_File, aChunk, sizeof(aChunk));
+		WriteRaw(aChunk, sizeof(aChunk));
 	}
 
 	m_LastTickMarker = Tick;
@@ -272,14 +354,9 @@ void CDemoRecorder::WriteTickMarker(int Tick, bool Keyframe)
 		m_FirstTick = Tick;
 }
 
-void CDemoRecorder::Write(int Type, const void *pData, int Size)
+// compresses the data of a chunk, returns the compressed size or -1 on error
+static int CompressChunkData(const void *pData, int Size, void *pOutput, int OutputSize)
 {
-	if(!m_File)
-		return;
-
-	if(Size > 64 * 1024)
-		return;
-
 	/* pad the data with 0 so we get an alignment of 4,
 	else the compression won't work and miss some bytes */
 	char aBuffer[64 * 1024];
@@ -289,9 +366,48 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		aBuffer2[Size++] = 0;
 	Size = CVariableInt::Compress(aBuffer2, Size, aBuffer, sizeof(aBuffer)); // buffer2 -> buffer
 	if(Size < 0)
+		return -1;
+
+	return CNetBase::Compress(aBuffer, Size, pOutput, OutputSize); // buffer -> output
+}
+
+void CDemoRecorder::WriteChunk(int Type, const void *pData, int Size)
+{
+	if(Type == CHUNKTYPE_RAW)
+	{
+		io_write(m_File, pData, Size);
+		return;
+	}
+	else if(Type == CHUNKTYPE_INDEX_KEYFRAME)
+	{
+		CDemoIndexKeyFrame KeyFrame;
+		KeyFrame.m_Filepos = io_tell(m_File);
+		mem_copy(&KeyFrame.m_Tick, pData, sizeof(KeyFrame.m_Tick));
+		m_vIndexKeyFrames.push_back(KeyFrame);
+		return;
+	}
+	else if(Type == CHUNKTYPE_INDEX_SNAPSHOT)
+	{
+		int aTicks[2];
+		mem_copy(aTicks, pData, sizeof(aTicks));
+		unsigned char aCompressed[64 * 1024];
+		const int CompressedSize = CompressChunkData((const unsigned char *)pData + sizeof(aTicks), Size - sizeof(aTicks), aCompressed, sizeof(aCompressed));
+		if(CompressedSize < 0)
+			return;
+
+		CDemoIndexSnapshot Snapshot;
+		Snapshot.m_Filepos = io_tell(m_File);
+		Snapshot.m_Tick = aTicks[0];
+		Snapshot.m_PreviousTick = aTicks[1];
+		Snapshot.m_DataOffset = io_tell(m_IndexFile);
+		Snapshot.m_DataSize = CompressedSize;
+		if(io_write(m_IndexFile, aCompressed, CompressedSize) == (unsigned)CompressedSize)
+			m_vIndexSnapshots.push_back(Snapshot);
 		return;
+	}
 
-	Size = CNetBase::Compress(aBuffer, Size, aBuffer2, sizeof(aBuffer2)); // buffer -> buffer2
+	unsigned char aBuffer[64 * 1024];
+	Size = CompressChunkData(pData, Size, aBuffer, sizeof(aBuffer));
 	if(Size < 0)
 		return;
 
@@ -319,7 +435,43 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		}
 	}
 
-	io_write(m_File, aBuffer2, Size);
+	io_write(m_File, aBuffer, Size);
+}
+
+void CDemoRecorder::Enqueue(int Type, const void *pData, int Size)
+{
+	if(m_pQueue)
+		m_pWriter->Queue(this, Type, pData, Size);
+	else
+		WriteChunk(Type, pData, Size);
+}
+
+void CDemoRecorder::WriteRaw(const void *pData, int Size)
+{
+	Enqueue(CHUNKTYPE_RAW, pData, Size);
+}
+
+void CDemoRecorder::Write(int Type, const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+
+	if(Size > 64 * 1024)
+		return;
+
+	Enqueue(Type, pData, Size);
+}
+
+void CDemoRecorder::WriteIndexSnapshot(int Tick)
+{
+	// the snapshot the next delta is based on, playback can continue from the
+	// tick marker of the given tick with it
+	unsigned char aData[2 * sizeof(int) + CSnapshot::MAX_SIZE];
+	const int aTicks[2] = {Tick, m_LastTickMarker};
+	mem_copy(aData, aTicks, sizeof(aTicks));
+	mem_copy(aData + sizeof(aTicks), m_aLastSnapshotData, m_LastSnapshotDataSize);
+	Enqueue(CHUNKTYPE_INDEX_SNAPSHOT, aData, sizeof(aTicks) + m_LastSnapshotDataSize);
+	m_LastIndexSnapshot = Tick;
 }
 
 void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
@@ -333,10 +485,15 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 		Write(CHUNKTYPE_SNAPSHOT, pData, Size);
 
 		m_LastKeyFrame = Tick;
+		m_LastIndexSnapshot = Tick;
 		mem_copy(m_aLastSnapshotData, pData, Size);
+		m_LastSnapshotDataSize = Size;
 	}
 	else
 	{
+		if(m_IndexFile && Tick - m_LastIndexSnapshot >= INDEX_SNAPSHOT_INTERVAL)
+			WriteIndexSnapshot(Tick);
+
 		// write tickmarker
 		WriteTickMarker(Tick, false);
 
@@ -350,6 +507,7 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 			// record delta
 			Write(CHUNKTYPE_DELTA, aDeltaData, DeltaSize);
 			mem_copy(m_aLastSnapshotData, pData, Size);
+			m_LastSnapshotDataSize = Size;
 		}
 	}
 }
@@ -371,6 +529,10 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 	if(!m_File)
 		return -1;
 
+	// the header is rewritten below, so all chunks have to be written first
+	if(m_pQueue)
+		m_pWriter->Unregister(this);
+
 	if(Mode == IDemoRecorder::EStopMode::KEEP_FILE)
 	{
 		// add the demo length to the header
@@ -390,13 +552,28 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 			uint_to_bytes_be(aMarker, m_aTimelineMarkers[i]);
 			io_write(m_File, aMarker, sizeof(aMarker));
 		}
+
+		if(m_IndexFile)
+			FinishIndex();
 	}
 
 	io_close(m_File);
 	m_File = nullptr;
 
+	// the index follows the demo
+	const bool HasIndex = m_IndexFile != nullptr;
+	char aIndexFilename[IO_MAX_PATH_LENGTH];
+	IndexFilename(m_aCurrentFilename, aIndexFilename, sizeof(aIndexFilename));
+	if(HasIndex)
+	{
+		io_close(m_IndexFile);
+		m_IndexFile = nullptr;
+	}
+
 	if(Mode == IDemoRecorder::EStopMode::REMOVE_FILE)
 	{
+		if(HasIndex)
+			m_pStorage->RemoveFile(aIndexFilename, IStorage::TYPE_SAVE);
 		if(!m_pStorage->RemoveFile(m_aCurrentFilename, IStorage::TYPE_SAVE))
 		{
 			if(m_pConsole)
@@ -410,6 +587,12 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 	}
 	else if(pTargetFilename[0] != '\0')
 	{
+		if(HasIndex)
+		{
+			char aTargetIndexFilename[IO_MAX_PATH_LENGTH];
+			IndexFilename(pTargetFilename, aTargetIndexFilename, sizeof(aTargetIndexFilename));
+			m_pStorage->RenameFile(aIndexFilename, aTargetIndexFilename, IStorage::TYPE_SAVE);
+		}
 		if(!m_pStorage->RenameFile(m_aCurrentFilename, pTargetFilename, IStorage::TYPE_SAVE))
 		{
 			if(m_pConsole)
@@ -432,6 +615,48 @@ int CDemoRecorder::Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilena
 	return 0;
 }
 
+void CDemoRecorder::FinishIndex()
+{
+	const int64_t TablesOffset = io_tell(m_IndexFile);
+	std::vector<unsigned char> vTables(m_vIndexKeyFrames.size() * sizeof(CDemoIndexKeyFrameEntry) + m_vIndexSnapshots.size() * sizeof(CDemoIndexSnapshotEntry));
+	CDemoIndexKeyFrameEntry *pKeyFrameEntry = (CDemoIndexKeyFrameEntry *)vTables.data();
+	for(const CDemoIndexKeyFrame &KeyFrame : m_vIndexKeyFrames)
+	{
+		Int64ToBytesBe(pKeyFrameEntry->m_aFilepos, KeyFrame.m_Filepos);
+		uint_to_bytes_be(pKeyFrameEntry->m_aTick, KeyFrame.m_Tick);
+		pKeyFrameEntry++;
+	}
+	CDemoIndexSnapshotEntry *pSnapshotEntry = (CDemoIndexSnapshotEntry *)pKeyFrameEntry;
+	for(const CDemoIndexSnapshot &Snapshot : m_vIndexSnapshots)
+	{
+		Int64ToBytesBe(pSnapshotEntry->m_aFilepos, Snapshot.m_Filepos);
+		uint_to_bytes_be(pSnapshotEntry->m_aTick, Snapshot.m_Tick);
+		uint_to_bytes_be(pSnapshotEntry->m_aPreviousTick, Snapshot.m_PreviousTick);
+		Int64ToBytesBe(pSnapshotEntry->m_aDataOffset, Snapshot.m_DataOffset);
+		uint_to_bytes_be(pSnapshotEntry->m_aDataSize, Snapshot.m_DataSize);
+		pSnapshotEntry++;
+	}
+
+	CDemoIndexFooter Footer;
+	mem_copy(Footer.m_aMarker, gs_aIndexMarker, sizeof(Footer.m_aMarker));
+	uint_to_bytes_be(Footer.m_aVersion, gs_IndexVersion);
+	Int64ToBytesBe(Footer.m_aDemoSize, io_length(m_File));
+	mem_copy(Footer.m_aTimestamp, m_aTimestamp, sizeof(Footer.m_aTimestamp));
+	uint_to_bytes_be(Footer.m_aFirstTick, m_FirstTick);
+	uint_to_bytes_be(Footer.m_aLastTick, m_LastTickMarker);
+	uint_to_bytes_be(Footer.m_aNumKeyFrames, m_vIndexKeyFrames.size());
+	uint_to_bytes_be(Footer.m_aNumSnapshots, m_vIndexSnapshots.size());
+	Int64ToBytesBe(Footer.m_aTablesOffset, TablesOffset);
+
+	io_write(m_IndexFile, vTables.data(), vTables.size());
+	io_write(m_IndexFile, &Footer, sizeof(Footer));
+}
+
+void CDemoRecorder::IndexFilename(const char *pDemoFilename, char *pBuffer, size_t BufferSize)
+{
+	str_format(pBuffer, BufferSize, "%s.idx", pDemoFilename);
+}
+
 void CDemoRecorder::AddDemoMarker()
 {
 	if(m_LastTickMarker < 0)
@@ -473,6 +698,107 @@ void CDemoRecorder::AddDemoMarker(int Tick)
 	}
 }
 
+class CQueuedChunk
+{
+public:
+	int m_Type;
+	int m_Size;
+};
+
+CDemoRecordWriter::~CDemoRecordWriter()
+{
+	if(!m_pThread)
+		return;
+
+	{
+		std::unique_lock Lock(m_Mutex);
+		dbg_assert(m_vpRecorders.empty(), "Demo recorders were not stopped");
+		m_Shutdown = true;
+	}
+	m_QueuedCondition.notify_one();
+	thread_wait(m_pThread);
+}
+
+void CDemoRecordWriter::Register(CDemoRecorder *pRecorder)
+{
+	std::unique_lock Lock(m_Mutex);
+	if(!m_pThread)
+		m_pThread = thread_init(ThreadMain, this, "demo writer");
+	pRecorder->m_pQueue = new CDynamicRingBuffer<unsigned char>(QUEUE_SIZE);
+	pRecorder->m_NumQueued = 0;
+	m_vpRecorders.push_back(pRecorder);
+}
+
+void CDemoRecordWriter::Unregister(CDemoRecorder *pRecorder)
+{
+	std::unique_lock Lock(m_Mutex);
+	m_WrittenCondition.wait(Lock, [pRecorder]() { return pRecorder->m_NumQueued == 0; });
+	m_vpRecorders.erase(std::find(m_vpRecorders.begin(), m_vpRecorders.end(), pRecorder));
+	delete pRecorder->m_pQueue;
+	pRecorder->m_pQueue = nullptr;
+}
+
+void CDemoRecordWriter::Queue(CDemoRecorder *pRecorder, int Type, const void *pData, int Size)
+{
+	std::unique_lock Lock(m_Mutex);
+	unsigned char *pItem;
+	while(!(pItem = pRecorder->m_pQueue->Allocate(sizeof(CQueuedChunk) + Size)))
+		m_WrittenCondition.wait(Lock);
+
+	CQueuedChunk Chunk;
+	Chunk.m_Type = Type;
+	Chunk.m_Size = Size;
+	mem_copy(pItem, &Chunk, sizeof(Chunk));
+	mem_copy(pItem + sizeof(Chunk), pData, Size);
+	pRecorder->m_NumQueued++;
+	Lock.unlock();
+	m_QueuedCondition.notify_one();
+}
+
+void CDemoRecordWriter::ThreadMain(void *pUser)
+{
+	static_cast<CDemoRecordWriter *>(pUser)->Run();
+}
+
+bool CDemoRecordWriter::HasQueuedChunks() const
+{
+	return std::any_of(m_vpRecorders.begin(), m_vpRecorders.end(), [](const CDemoRecorder *pRecorder) {
+		return pRecorder->m_NumQueued > 0;
+	});
+}
+
+void CDemoRecordWriter::Run()
+{
+	std::unique_lock Lock(m_Mutex);
+	while(true)
+	{
+		m_QueuedCondition.wait(Lock, [this]() { return m_Shutdown || HasQueuedChunks(); });
+		if(m_Shutdown && !HasQueuedChunks())
+			break;
+
+		// take turns between the recorders. the recorders cannot be unregistered while they
+		// have queued chunks, and the producers only add new items to the queues, so the
+		// first item can be processed without holding the lock.
+		for(size_t i = 0; i < m_vpRecorders.size(); i++)
+		{
+			CDemoRecorder *pRecorder = m_vpRecorders[i];
+			unsigned char *pItem = pRecorder->m_pQueue->First();
+			if(!pItem)
+				continue;
+
+			Lock.unlock();
+			CQueuedChunk Chunk;
+			mem_copy(&Chunk, pItem, sizeof(Chunk));
+			pRecorder->WriteChunk(Chunk.m_Type, pItem + sizeof(Chunk), Chunk.m_Size);
+			Lock.lock();
+
+			pRecorder->m_pQueue->PopFirst();
+			pRecorder->m_NumQueued--;
+			m_WrittenCondition.notify_all();
+		}
+	}
+}
+
 CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta, bool UseVideo, TUpdateIntraTimesFunc &&UpdateIntraTimesFunc)
 {
 	Construct(pSnapshotDelta, UseVideo);
@@ -493,6 +819,7 @@ CDemoPlayer::~CDemoPlayer()
 void CDemoPlayer::Construct(class CSnapshotDelta *pSnapshotDelta, bool UseVideo)
 {
 	m_File = nullptr;
+	m_IndexFile = nullptr;
 	m_SpeedIndex = DEMO_SPEED_INDEX_DEFAULT;
 
 	m_pSnapshotDelta = pSnapshotDelta;
@@ -651,6 +978,121 @@ CDemoPlayer::EScanFileResult CDemoPlayer::ScanFile()
 	return ResetToStartPosition(m_vKeyFrames.empty() ? EScanFileResult::ERROR_UNRECOVERABLE : EScanFileResult::SUCCESS);
 }
 
+bool CDemoPlayer::LoadIndex(IStorage *pStorage, int StorageType)
+{
+	char aIndexFilename[IO_MAX_PATH_LENGTH];
+	CDemoRecorder::IndexFilename(m_aFilename, aIndexFilename, sizeof(aIndexFilename));
+	IOHANDLE IndexFile = pStorage->OpenFile(aIndexFilename, IOFLAG_READ, StorageType);
+	if(!IndexFile)
+		return false;
+
+	const auto &Fail = [&]() {
+		io_close(IndexFile);
+		return false;
+	};
+
+	// io_length seeks back to the start of the file
+	const int64_t ChunksPos = io_tell(m_File);
+	const int64_t DemoSize = io_length(m_File);
+	if(ChunksPos < 0 || DemoSize < 0 || io_seek(m_File, ChunksPos, IOSEEK_START) != 0)
+		return Fail();
+
+	// the index is only used if it was written for this demo
+	CDemoIndexFooter Footer;
+	const int64_t IndexSize = io_length(IndexFile);
+	if(IndexSize < (int64_t)sizeof(Footer) ||
+		io_seek(IndexFile, IndexSize - sizeof(Footer), IOSEEK_START) != 0 ||
+		io_read(IndexFile, &Footer, sizeof(Footer)) != sizeof(Footer) ||
+		mem_comp(Footer.m_aMarker, gs_aIndexMarker, sizeof(gs_aIndexMarker)) != 0 ||
+		bytes_be_to_uint(Footer.m_aVersion) != gs_IndexVersion ||
+		BytesBeToInt64(Footer.m_aDemoSize) != DemoSize ||
+		mem_comp(Footer.m_aTimestamp, m_Info.m_Header.m_aTimestamp, sizeof(Footer.m_aTimestamp)) != 0)
+		return Fail();
+
+	const int FirstTick = bytes_be_to_uint(Footer.m_aFirstTick);
+	const int LastTick = bytes_be_to_uint(Footer.m_aLastTick);
+	const int64_t NumKeyFrames = bytes_be_to_uint(Footer.m_aNumKeyFrames);
+	const int64_t NumSnapshots = bytes_be_to_uint(Footer.m_aNumSnapshots);
+	const int64_t TablesOffset = BytesBeToInt64(Footer.m_aTablesOffset);
+	const int64_t TablesSize = NumKeyFrames * sizeof(CDemoIndexKeyFrameEntry) + NumSnapshots * sizeof(CDemoIndexSnapshotEntry);
+	if(FirstTick < MIN_TICK || LastTick < FirstTick || LastTick >= MAX_TICK || NumKeyFrames == 0 ||
+		TablesOffset < 0 || TablesOffset + TablesSize + (int64_t)sizeof(Footer) != IndexSize)
+		return Fail();
+
+	std::vector<unsigned char> vTables(TablesSize);
+	if(io_seek(IndexFile, TablesOffset, IOSEEK_START) != 0 ||
+		io_read(IndexFile, vTables.data(), vTables.size()) != vTables.size())
+		return Fail();
+
+	const auto &ValidPosition = [&](int64_t Filepos, int Tick) {
+		return Filepos >= ChunksPos && Filepos < DemoSize && Tick >= FirstTick && Tick <= LastTick;
+	};
+
+	std::vector<CKeyFrame> vKeyFrames;
+	vKeyFrames.reserve(NumKeyFrames);
+	const CDemoIndexKeyFrameEntry *pKeyFrameEntry = (const CDemoIndexKeyFrameEntry *)vTables.data();
+	for(int64_t i = 0; i < NumKeyFrames; i++, pKeyFrameEntry++)
+	{
+		const int64_t Filepos = BytesBeToInt64(pKeyFrameEntry->m_aFilepos);
+		const int Tick = bytes_be_to_uint(pKeyFrameEntry->m_aTick);
+		if(!ValidPosition(Filepos, Tick) || (!vKeyFrames.empty() && Tick <= vKeyFrames.back().m_Tick))
+			return Fail();
+		vKeyFrames.emplace_back(Filepos, Tick);
+	}
+
+	std::vector<CDemoIndexSnapshot> vSnapshots;
+	vSnapshots.reserve(NumSnapshots);
+	const CDemoIndexSnapshotEntry *pSnapshotEntry = (const CDemoIndexSnapshotEntry *)pKeyFrameEntry;
+	for(int64_t i = 0; i < NumSnapshots; i++, pSnapshotEntry++)
+	{
+		CDemoIndexSnapshot Snapshot;
+		Snapshot.m_Filepos = BytesBeToInt64(pSnapshotEntry->m_aFilepos);
+		Snapshot.m_Tick = bytes_be_to_uint(pSnapshotEntry->m_aTick);
+		Snapshot.m_PreviousTick = bytes_be_to_uint(pSnapshotEntry->m_aPreviousTick);
+		Snapshot.m_DataOffset = BytesBeToInt64(pSnapshotEntry->m_aDataOffset);
+		Snapshot.m_DataSize = bytes_be_to_uint(pSnapshotEntry->m_aDataSize);
+		if(!ValidPosition(Snapshot.m_Filepos, Snapshot.m_Tick) ||
+			Snapshot.m_PreviousTick < FirstTick || Snapshot.m_PreviousTick >= Snapshot.m_Tick ||
+			(!vSnapshots.empty() && Snapshot.m_Tick <= vSnapshots.back().m_Tick) ||
+			Snapshot.m_DataSize <= 0 || Snapshot.m_DataSize > (int)sizeof(m_aCompressedSnapshotData) ||
+			Snapshot.m_DataOffset < 0 || Snapshot.m_DataOffset + Snapshot.m_DataSize > TablesOffset)
+			return Fail();
+		vSnapshots.push_back(Snapshot);
+	}
+
+	m_IndexFile = IndexFile;
+	m_vKeyFrames = std::move(vKeyFrames);
+	m_vIndexSnapshots = std::move(vSnapshots);
+	m_Info.m_Info.m_FirstTick = FirstTick;
+	m_Info.m_Info.m_LastTick = LastTick;
+	return true;
+}
+
+bool CDemoPlayer::SeekIndexSnapshot(const CDemoIndexSnapshot &Snapshot)
+{
+	if(io_seek(m_IndexFile, Snapshot.m_DataOffset, IOSEEK_START) != 0 ||
+		io_read(m_IndexFile, m_aCompressedSnapshotData, Snapshot.m_DataSize) != (unsigned)Snapshot.m_DataSize)
+		return false;
+
+	int DataSize = CNetBase::Decompress(m_aCompressedSnapshotData, Snapshot.m_DataSize, m_aDecompressedSnapshotData, sizeof(m_aDecompressedSnapshotData));
+	if(DataSize < 0)
+		return false;
+	DataSize = CVariableInt::Decompress(m_aDecompressedSnapshotData, DataSize, m_aChunkData, sizeof(m_aChunkData));
+	if(DataSize < 0 || !((CSnapshot *)m_aChunkData)->IsValid(DataSize))
+		return false;
+
+	if(io_seek(m_File, Snapshot.m_Filepos, IOSEEK_START) != 0)
+		return false;
+
+	// continue as if the tick before the snapshot's tick marker was just played
+	mem_copy(m_aLastSnapshotData, m_aChunkData, DataSize);
+	m_LastSnapshotDataSize = DataSize;
+	m_Info.m_NextTick = Snapshot.m_PreviousTick;
+	m_Info.m_Info.m_CurrentTick = -1;
+	m_Info.m_PreviousTick = -1;
+	return true;
+}
+
 void CDemoPlayer::DoTick()
 {
 	// update ticks
@@ -864,8 +1306,8 @@ int CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole, const
 		}
 	}
 
-	// Scan the file for interesting points
-	if(ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
+	// Use the index if there is a valid one, otherwise scan the file for interesting points
+	if(!LoadIndex(pStorage, StorageType) && ScanFile() == EScanFileResult::ERROR_UNRECOVERABLE)
 	{
 		Stop("Error scanning demo file");
 		return -1;
@@ -1053,16 +1495,24 @@ int CDemoPlayer::SetPos(int WantedTick)
 	while(KeyFrame > 0 && m_vKeyFrames[KeyFrame].m_Tick > KeyFrameWantedTick)
 		KeyFrame--;
 
-	// seek to the correct key frame
-	if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+	// a snapshot of the index may be closer to the wanted tick than the key frame
+	const auto NextSnapshot = std::upper_bound(m_vIndexSnapshots.begin(), m_vIndexSnapshots.end(), KeyFrameWantedTick, [](int Tick, const CDemoIndexSnapshot &Snapshot) {
+		return Tick < Snapshot.m_Tick;
+	});
+	const bool UseSnapshot = NextSnapshot != m_vIndexSnapshots.begin() && std::prev(NextSnapshot)->m_Tick > m_vKeyFrames[KeyFrame].m_Tick;
+	if(!UseSnapshot || !SeekIndexSnapshot(*std::prev(NextSnapshot)))
 	{
-		Stop("Error seeking keyframe position");
-		return -1;
-	}
+		// seek to the correct key frame
+		if(io_seek(m_File, m_vKeyFrames[KeyFrame].m_Filepos, IOSEEK_START) != 0)
+		{
+			Stop("Error seeking keyframe position");
+			return -1;
+		}
 
-	m_Info.m_NextTick = -1;
-	m_Info.m_Info.m_CurrentTick = -1;
-	m_Info.m_PreviousTick = -1;
+		m_Info.m_NextTick = -1;
+		m_Info.m_Info.m_CurrentTick = -1;
+		m_Info.m_PreviousTick = -1;
+	}
 
 	// playback everything until we hit our tick
 	while(m_Info.m_NextTick < WantedTick)
@@ -1251,6 +1701,12 @@ void CDemoPlayer::Stop(const char *pErrorMessage)
 	io_close(m_File);
 	m_File = nullptr;
 	m_vKeyFrames.clear();
+	if(m_IndexFile)
+	{
+		io_close(m_IndexFile);
+		m_IndexFile = nullptr;
+	}
+	m_vIndexSnapshots.clear();
 	str_copy(m_aFilename, "");
 	str_copy(m_aErrorMessage, pErrorMessage);
 }
@@ -1407,7 +1863,7 @@ bool CDemoEditor::Slice(const char *pDemo, const char *pDst, int StartTick, int
 
 	CDemoRecorder DemoRecorder(m_pSnapshotDelta);
 	unsigned char *pMapData = DemoPlayer.GetMapData(m_pStorage);
-	const int Result = DemoRecorder.Start(m_pStorage, m_pConsole, pDst, pInfo->m_Header.m_aNetversion, pMapInfo->m_aName, Sha256, pMapInfo->m_Crc, pInfo->m_Header.m_aType, pMapInfo->m_Size, pMapData, nullptr, pfnFilter, pUser) == -1;
+	const int Result = DemoRecorder.Start(m_pStorage, m_pConsole, pDst, pInfo->m_Header.m_aNetversion, pMapInfo->m_aName, Sha256, pMapInfo->m_Crc, pInfo->m_Header.m_aType, pMapInfo->m_Size, pMapData, nullptr, pfnFilter, pUser, g_Config.m_ClDemoIndex >= 1) == -1;
 	free(pMapData);
 	if(Result != 0)
 	{
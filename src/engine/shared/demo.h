@@ -3,6 +3,7 @@
 #ifndef ENGINE_SHARED_DEMO_H
 #define ENGINE_SHARED_DEMO_H
 
+#include "ringbuffer.h"
 #include "snapshot.h"
 
 #include <base/hash.h>
@@ -10,13 +11,86 @@
 #include <engine/demo.h>
 #include <engine/shared/protocol.h>
 
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <vector>
 
 typedef std::function<void()> TUpdateIntraTimesFunc;
 
+class CDemoRecorder;
+
+/**
+ * Keyframe of a demo, the tick marker of the keyframe starts at the file position.
+ */
+class CDemoIndexKeyFrame
+{
+public:
+	int64_t m_Filepos;
+	int m_Tick;
+};
+
+/**
+ * Full snapshot stored in the index of a demo. Playback can continue from the
+ * tick marker at the file position with this snapshot as the previous one.
+ */
+class CDemoIndexSnapshot
+{
+public:
+	int64_t m_Filepos;
+	int m_Tick;
+	// tick before the tick marker, compressed tick markers are relative to it
+	int m_PreviousTick;
+	// compressed snapshot within the index file
+	int64_t m_DataOffset;
+	int m_DataSize;
+};
+
+/**
+ * Compresses and writes the chunks of demo recorders on a shared background
+ * thread, so recording does not delay the thread producing the snapshots.
+ * Every recorder using the writer has its own bounded queue, recording only
+ * blocks if the queue of the recorder is full.
+ */
+class CDemoRecordWriter
+{
+public:
+	CDemoRecordWriter() = default;
+	~CDemoRecordWriter();
+
+	CDemoRecordWriter(const CDemoRecordWriter &Other) = delete;
+	CDemoRecordWriter &operator=(const CDemoRecordWriter &Other) = delete;
+
+private:
+	friend CDemoRecorder;
+
+	enum
+	{
+		QUEUE_SIZE = 256 * 1024,
+	};
+
+	std::mutex m_Mutex;
+	// signaled when chunks were queued or the writer shuts down
+	std::condition_variable m_QueuedCondition;
+	// signaled when queued chunks have been written
+	std::condition_variable m_WrittenCondition;
+	std::vector<CDemoRecorder *> m_vpRecorders;
+	bool m_Shutdown = false;
+	void *m_pThread = nullptr;
+
+	void Register(CDemoRecorder *pRecorder);
+	void Unregister(CDemoRecorder *pRecorder);
+	void Queue(CDemoRecorder *pRecorder, int Type, const void *pData, int Size);
+
+	static void ThreadMain(void *pUser);
+	void Run();
+	bool HasQueuedChunks() const;
+};
+
 class CDemoRecorder : public IDemoRecorder
 {
+	friend CDemoRecordWriter;
+
 	class IConsole *m_pConsole;
 	class IStorage *m_pStorage;
 
@@ -27,8 +101,17 @@ class CDemoRecorder : public IDemoRecorder
 	int m_FirstTick;
 
 	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
+	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
 
+	// keyframe index, see CDemoPlayer. the entries are added by the thread writing
+	// the chunks, the index is completed when the recording is stopped.
+	IOHANDLE m_IndexFile = nullptr;
+	std::vector<CDemoIndexKeyFrame> m_vIndexKeyFrames;
+	std::vector<CDemoIndexSnapshot> m_vIndexSnapshots;
+	int m_LastIndexSnapshot;
+	char m_aTimestamp[20];
+
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
 
@@ -37,15 +120,35 @@ class CDemoRecorder : public IDemoRecorder
 	DEMOFUNC_FILTER m_pfnFilter;
 	void *m_pUser;
 
+	// only used while recording with a writer, the queue is protected by the writer's mutex
+	CDemoRecordWriter *m_pWriter = nullptr;
+	CDynamicRingBuffer<unsigned char> *m_pQueue = nullptr;
+	int m_NumQueued = 0;
+
 	void WriteTickMarker(int Tick, bool Keyframe);
+	void WriteRaw(const void *pData, int Size);
 	void Write(int Type, const void *pData, int Size);
+	void WriteIndexSnapshot(int Tick);
+	void Enqueue(int Type, const void *pData, int Size);
+	void WriteChunk(int Type, const void *pData, int Size);
+	void FinishIndex();
 
 public:
-	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false);
+	/**
+	 * @param pWriter Writes the demo in the background if set, must outlive the recorder.
+	 */
+	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta, bool NoMapData = false, CDemoRecordWriter *pWriter = nullptr);
 	CDemoRecorder() = default;
 	~CDemoRecorder() override;
 
-	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, unsigned MapSize, unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser);
+	// ticks between the full snapshots in the index, seeking with the index replays fewer ticks than this.
+	// keyframes are recorded every 5 seconds, so the index stores two snapshots between them.
+	static constexpr int INDEX_SNAPSHOT_INTERVAL = SERVER_TICK_SPEED * 2;
+
+	/**
+	 * @param WriteIndex Whether to write the keyframe index to `<pFilename>.idx` for faster seeking.
+	 */
+	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, const SHA256_DIGEST &Sha256, unsigned MapCrc, const char *pType, unsigned MapSize, const unsigned char *pMapData, IOHANDLE MapFile, DEMOFUNC_FILTER pfnFilter, void *pUser, bool WriteIndex = false);
 	int Stop(IDemoRecorder::EStopMode Mode, const char *pTargetFilename = "") override;
 
 	void AddDemoMarker();
@@ -58,6 +161,11 @@ public:
 	const char *CurrentFilename() const override { return m_aCurrentFilename; }
 
 	int Length() const override { return (m_LastTickMarker - m_FirstTick) / SERVER_TICK_SPEED; }
+
+	/**
+	 * The keyframe index of a demo is stored next to it in a file with this name.
+	 */
+	static void IndexFilename(const char *pDemoFilename, char *pBuffer, size_t BufferSize);
 };
 
 class CDemoPlayer : public IDemoPlayer
@@ -119,6 +227,9 @@ private:
 	char m_aFilename[IO_MAX_PATH_LENGTH];
 	char m_aErrorMessage[256];
 	std::vector<CKeyFrame> m_vKeyFrames;
+	// only set if the demo has a valid index
+	IOHANDLE m_IndexFile;
+	std::vector<CDemoIndexSnapshot> m_vIndexSnapshots;
 	CMapInfo m_MapInfo;
 	int m_SpeedIndex;
 
@@ -156,6 +267,8 @@ private:
 		ERROR_UNRECOVERABLE,
 	};
 	EScanFileResult ScanFile();
+	bool LoadIndex(class IStorage *pStorage, int StorageType);
+	bool SeekIndexSnapshot(const CDemoIndexSnapshot &Snapshot);
 	void UpdateTimes();
 
 	int64_t Time();
@@ -101,6 +101,16 @@ public:
 		m_JobPool.Add(std::move(pJob));
 	}
 
+	void AddJobAfter(std::shared_ptr<IJob> pJob, const std::vector<std::shared_ptr<IJob>> &vpDependencies) override
+	{
+		m_JobPool.AddAfter(std::move(pJob), vpDependencies);
+	}
+
+	void ParallelFor(int Begin, int End, int Grain, const std::function<void(int Begin, int End)> &Function) override
+	{
+		m_JobPool.ParallelFor(Begin, End, Grain, Function);
+	}
+
 	void ShutdownJobs() override
 	{
 		m_JobPool.Shutdown();
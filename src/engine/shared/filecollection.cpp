@@ -5,6 +5,7 @@
 
 #include <base/math.h>
 
+#include <engine/shared/demo.h>
 #include <engine/storage.h>
 
 #include <algorithm>
@@ -41,6 +42,14 @@ void CFileCollection::Init(IStorage *pStorage, const char *pPath, const char *pF
 		}
 
 		m_pStorage->RemoveFile(aBuf, IStorage::TYPE_SAVE);
+		if(str_comp(m_aFileExt, ".demo") == 0)
+		{
+			// demos may have a keyframe index next to them
+			char aIndexFilename[IO_MAX_PATH_LENGTH];
+			CDemoRecorder::IndexFilename(aBuf, aIndexFilename, sizeof(aIndexFilename));
+			if(m_pStorage->FileExists(aIndexFilename, IStorage::TYPE_SAVE))
+				m_pStorage->RemoveFile(aIndexFilename, IStorage::TYPE_SAVE);
+		}
 		FilesDeleted++;
 	}
 }
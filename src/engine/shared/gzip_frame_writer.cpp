@@ -0,0 +1,179 @@
+#include "gzip_frame_writer.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+// gzip member header with the "TH" subfield in the extra field and trailer, see RFC 1952
+static constexpr int EXTRA_SIZE = 4 + 12;
+static constexpr int HEADER_SIZE = 10 + 2 + EXTRA_SIZE;
+static constexpr int TRAILER_SIZE = 8;
+
+static void WriteLittleEndian(unsigned char *pBytes, uint64_t Value, int Size)
+{
+	for(int i = 0; i < Size; i++)
+		pBytes[i] = (Value >> (8 * i)) & 0xff;
+}
+
+CGzipFrameWriter::CGzipFrameWriter(IOHANDLE File, int Level, int FrameSize) :
+	m_File(File),
+	m_Level(Level),
+	m_FrameSize(std::clamp(FrameSize, 1, (int)BUFFER_SIZE / 2))
+{
+	m_vBuffer.resize(BUFFER_SIZE);
+	m_pThread = thread_init(ThreadMain, this, "gzip writer");
+}
+
+CGzipFrameWriter::~CGzipFrameWriter()
+{
+	Close();
+}
+
+void CGzipFrameWriter::Write(const void *pData, int Size)
+{
+	const unsigned char *pBytes = static_cast<const unsigned char *>(pData);
+	while(Size > 0)
+	{
+		const uint64_t WritePos = m_WritePos.load(std::memory_order_relaxed);
+		const uint64_t Free = BUFFER_SIZE - (WritePos - m_ReadPos.load(std::memory_order_acquire));
+		if(Free == 0)
+		{
+			// the disk is slower than the data comes in
+			WakeUpWriter();
+			std::unique_lock Lock(m_Mutex);
+			m_SpaceCondition.wait(Lock, [&]() { return m_ReadPos.load(std::memory_order_acquire) + BUFFER_SIZE != WritePos; });
+			continue;
+		}
+
+		const int Part = std::min<uint64_t>(Size, Free);
+		const int Offset = WritePos % BUFFER_SIZE;
+		const int Contiguous = std::min(Part, (int)BUFFER_SIZE - Offset);
+		mem_copy(&m_vBuffer[Offset], pBytes, Contiguous);
+		mem_copy(&m_vBuffer[0], pBytes + Contiguous, Part - Contiguous);
+		m_WritePos.store(WritePos + Part, std::memory_order_release);
+		pBytes += Part;
+		Size -= Part;
+	}
+
+	if(m_WritePos.load(std::memory_order_relaxed) - m_NotifyPos >= (uint64_t)m_FrameSize)
+		WakeUpWriter();
+}
+
+void CGzipFrameWriter::WakeUpWriter()
+{
+	m_NotifyPos = m_WritePos.load(std::memory_order_relaxed);
+	{
+		// the writer checks the positions while holding the lock, so it
+		// either sees the new position or is already waiting
+		const std::unique_lock Lock(m_Mutex);
+	}
+	m_DataCondition.notify_one();
+}
+
+void CGzipFrameWriter::Close()
+{
+	if(!m_File)
+		return;
+
+	m_Closing.store(true);
+	WakeUpWriter();
+	thread_wait(m_pThread);
+	m_pThread = nullptr;
+
+	io_close(m_File);
+	m_File = nullptr;
+}
+
+void CGzipFrameWriter::ThreadMain(void *pUser)
+{
+	static_cast<CGzipFrameWriter *>(pUser)->Run();
+}
+
+void CGzipFrameWriter::Run()
+{
+	z_stream Stream = {};
+	// raw deflate, the gzip header and trailer are added manually
+	const bool Initialized = deflateInit2(&Stream, m_Level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+	if(!Initialized)
+		m_Error.store(true, std::memory_order_relaxed);
+
+	std::vector<unsigned char> vFrame(m_FrameSize);
+	std::vector<unsigned char> vMember(Initialized ? HEADER_SIZE + deflateBound(&Stream, m_FrameSize) + TRAILER_SIZE : 0);
+	uint64_t StreamOffset = 0;
+	while(true)
+	{
+		const uint64_t ReadPos = m_ReadPos.load(std::memory_order_relaxed);
+		{
+			std::unique_lock Lock(m_Mutex);
+			m_DataCondition.wait_for(Lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [&]() {
+				return m_Closing.load() || m_WritePos.load(std::memory_order_acquire) - ReadPos >= (uint64_t)m_FrameSize;
+			});
+		}
+
+		// check for closing first, all data is queued before
+		const bool Closing = m_Closing.load();
+		const uint64_t Available = m_WritePos.load(std::memory_order_acquire) - ReadPos;
+		if(Available == 0)
+		{
+			if(Closing)
+				break;
+			continue;
+		}
+
+		const int Size = std::min<uint64_t>(Available, m_FrameSize);
+		const int Offset = ReadPos % BUFFER_SIZE;
+		const int Contiguous = std::min(Size, (int)BUFFER_SIZE - Offset);
+		mem_copy(vFrame.data(), &m_vBuffer[Offset], Contiguous);
+		mem_copy(vFrame.data() + Contiguous, &m_vBuffer[0], Size - Contiguous);
+		m_ReadPos.store(ReadPos + Size, std::memory_order_release);
+		{
+			const std::unique_lock Lock(m_Mutex);
+		}
+		m_SpaceCondition.notify_one();
+
+		if(!Initialized)
+			continue;
+
+		// every frame is compressed on its own, so it can be decompressed without the previous ones
+		deflateReset(&Stream);
+		Stream.next_in = vFrame.data();
+		Stream.avail_in = Size;
+		Stream.next_out = vMember.data() + HEADER_SIZE;
+		Stream.avail_out = vMember.size() - HEADER_SIZE - TRAILER_SIZE;
+		if(deflate(&Stream, Z_FINISH) != Z_STREAM_END)
+		{
+			m_Error.store(true, std::memory_order_relaxed);
+			continue;
+		}
+		const int MemberSize = HEADER_SIZE + Stream.total_out + TRAILER_SIZE;
+
+		unsigned char *pHeader = vMember.data();
+		pHeader[0] = 0x1f; // magic
+		pHeader[1] = 0x8b;
+		pHeader[2] = 8; // deflate
+		pHeader[3] = 4; // FEXTRA
+		WriteLittleEndian(pHeader + 4, 0, 4); // no modification time
+		pHeader[8] = 0; // no extra flags
+		pHeader[9] = 255; // unknown operating system
+		WriteLittleEndian(pHeader + 10, EXTRA_SIZE, 2);
+		pHeader[12] = 'T';
+		pHeader[13] = 'H';
+		WriteLittleEndian(pHeader + 14, EXTRA_SIZE - 4, 2);
+		WriteLittleEndian(pHeader + 16, MemberSize, 4);
+		WriteLittleEndian(pHeader + 20, StreamOffset, 8);
+
+		unsigned char *pTrailer = vMember.data() + MemberSize - TRAILER_SIZE;
+		WriteLittleEndian(pTrailer, crc32(0, vFrame.data(), Size), 4);
+		WriteLittleEndian(pTrailer + 4, Size, 4);
+
+		io_write(m_File, vMember.data(), MemberSize);
+		io_flush(m_File);
+		if(io_error(m_File))
+			m_Error.store(true, std::memory_order_relaxed);
+		StreamOffset += Size;
+	}
+
+	if(Initialized)
+		deflateEnd(&Stream);
+}
@@ -0,0 +1,89 @@
+#ifndef ENGINE_SHARED_GZIP_FRAME_WRITER_H
+#define ENGINE_SHARED_GZIP_FRAME_WRITER_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Compresses a stream on a background thread and writes it to a file.
+ *
+ * The stream is split into frames which are compressed independently, each
+ * frame is a complete gzip member, so the file can be read with any gzip
+ * decoder. The extra field of every member contains the subfield "TH" with
+ * the size of the member (4 bytes) followed by the offset of its data in the
+ * uncompressed stream (8 bytes), both little endian. This allows readers to
+ * skip from member to member, to seek without decompressing everything before
+ * and to resynchronize after a damaged member.
+ *
+ * A frame is written once @link FrameSize @endlink bytes are queued, and at
+ * least once a second while there is data, so little is lost on a crash.
+ *
+ * The data is passed to the thread through a lock-free ring buffer, writing
+ * only blocks if the buffer is full.
+ */
+class CGzipFrameWriter
+{
+public:
+	enum
+	{
+		DEFAULT_FRAME_SIZE = 256 * 1024,
+		BUFFER_SIZE = 4 * 1024 * 1024,
+		FLUSH_INTERVAL_MS = 1000,
+	};
+
+	/**
+	 * Takes ownership of the file.
+	 *
+	 * @param Level The zlib compression level.
+	 */
+	CGzipFrameWriter(IOHANDLE File, int Level, int FrameSize = DEFAULT_FRAME_SIZE);
+	~CGzipFrameWriter();
+
+	CGzipFrameWriter(const CGzipFrameWriter &Other) = delete;
+	CGzipFrameWriter &operator=(const CGzipFrameWriter &Other) = delete;
+
+	/**
+	 * Queues data for writing.
+	 *
+	 * @remark Must always be called from the same thread.
+	 */
+	void Write(const void *pData, int Size);
+	/**
+	 * Writes the remaining data and closes the file.
+	 */
+	void Close();
+	/**
+	 * @return Whether compressing or writing failed.
+	 */
+	bool Error() const { return m_Error.load(std::memory_order_relaxed); }
+
+private:
+	IOHANDLE m_File;
+	int m_Level;
+	int m_FrameSize;
+	void *m_pThread = nullptr;
+
+	std::vector<unsigned char> m_vBuffer;
+	// total number of bytes written to and read from the buffer
+	std::atomic<uint64_t> m_WritePos = 0;
+	std::atomic<uint64_t> m_ReadPos = 0;
+	uint64_t m_NotifyPos = 0;
+	std::atomic<bool> m_Closing = false;
+	std::atomic<bool> m_Error = false;
+
+	// only used to sleep and wake up, the buffer is accessed without it
+	std::mutex m_Mutex;
+	std::condition_variable m_DataCondition;
+	std::condition_variable m_SpaceCondition;
+
+	static void ThreadMain(void *pUser);
+	void Run();
+	void WakeUpWriter();
+};
+
+#endif
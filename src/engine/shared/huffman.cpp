@@ -92,114 +92,121 @@ void CHuffman::ConstructTree(const unsigned *pFrequencies)
 	Setbits_r(m_pStartNode, 0, 0);
 }
 
-void CHuffman::Init(const unsigned *pFrequencies)
+void CHuffman::BuildDecodeLut()
 {
-	// make sure to cleanout every thing
-	mem_zero(m_aNodes, sizeof(m_aNodes));
-	mem_zero(m_apDecodeLut, sizeof(m_apDecodeLut));
-	m_pStartNode = nullptr;
-	m_NumNodes = 0;
-
-	// construct the tree
-	ConstructTree(pFrequencies);
-
-	// build decode LUT
 	for(int i = 0; i < HUFFMAN_LUTSIZE; i++)
 	{
+		CDecodeEntry &Entry = m_aDecodeLut[i];
+		mem_zero(&Entry, sizeof(Entry));
+
+		// decode as many complete symbols as fit into the lookup bits
+		const CNode *pNode = m_pStartNode;
 		unsigned Bits = i;
-		int k;
-		CNode *pNode = m_pStartNode;
-		for(k = 0; k < HUFFMAN_LUTBITS; k++)
+		for(int k = 1; k <= HUFFMAN_LUTBITS; k++)
 		{
 			pNode = &m_aNodes[pNode->m_aLeaves[Bits & 1]];
 			Bits >>= 1;
 
-			if(!pNode)
-				break;
+			if(!pNode->m_NumBits)
+				continue;
 
-			if(pNode->m_NumBits)
+			// the eof symbol always ends an entry, the decoder handles it separately
+			if(pNode == &m_aNodes[HUFFMAN_EOF_SYMBOL])
 			{
-				m_apDecodeLut[i] = pNode;
+				if(Entry.m_NumSymbols == 0)
+				{
+					Entry.m_Node = HUFFMAN_EOF_SYMBOL;
+					Entry.m_NumBits = k;
+				}
 				break;
 			}
+
+			Entry.m_aSymbols[Entry.m_NumSymbols++] = pNode->m_Symbol;
+			Entry.m_NumBits = k;
+			if(Entry.m_NumSymbols == HUFFMAN_LUTMAXSYMBOLS)
+				break;
+			pNode = m_pStartNode;
 		}
 
-		if(k == HUFFMAN_LUTBITS)
-			m_apDecodeLut[i] = pNode;
+		// the first code is longer than the lookup, continue the tree walk from where we stopped
+		if(Entry.m_NumSymbols == 0 && Entry.m_NumBits == 0)
+		{
+			Entry.m_Node = pNode - m_aNodes;
+			Entry.m_NumBits = HUFFMAN_LUTBITS;
+		}
 	}
 }
 
+void CHuffman::Init(const unsigned *pFrequencies)
+{
+	// make sure to cleanout every thing
+	mem_zero(m_aNodes, sizeof(m_aNodes));
+	mem_zero(m_aDecodeLut, sizeof(m_aDecodeLut));
+	m_pStartNode = nullptr;
+	m_NumNodes = 0;
+
+	// construct the tree
+	ConstructTree(pFrequencies);
+	for(int i = 0; i < HUFFMAN_MAX_SYMBOLS; i++)
+		dbg_assert(m_aNodes[i].m_NumBits <= HUFFMAN_MAX_CODEBITS, "huffman code too long");
+
+	// build decode LUT
+	BuildDecodeLut();
+}
+
 //***************************************************************
 int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
 {
-	// this macro loads a symbol for a byte into bits and bitcount
-#define HUFFMAN_MACRO_LOADSYMBOL(Sym) \
-	do \
-	{ \
-		Bits |= m_aNodes[Sym].m_Bits << Bitcount; \
-		Bitcount += m_aNodes[Sym].m_NumBits; \
-	} while(0)
-
-	// this macro writes the symbol stored in bits and bitcount to the dst pointer
-#define HUFFMAN_MACRO_WRITE() \
-	do \
-	{ \
-		while(Bitcount >= 8) \
-		{ \
-			*pDst++ = (unsigned char)(Bits & 0xff); \
-			if(pDst == pDstEnd) \
-				return -1; \
-			Bits >>= 8; \
-			Bitcount -= 8; \
-		} \
-	} while(0)
-
 	// setup buffer pointers
 	const unsigned char *pSrc = (const unsigned char *)pInput;
 	const unsigned char *pSrcEnd = pSrc + InputSize;
 	unsigned char *pDst = (unsigned char *)pOutput;
 	unsigned char *pDstEnd = pDst + OutputSize;
 
-	// symbol variables
-	unsigned Bits = 0;
+	// symbols are collected in a 64 bit accumulator and written out 32 bits at a time,
+	// the trailing partial byte always needs room after them
+	uint64_t Bits = 0;
 	unsigned Bitcount = 0;
 
-	// make sure that we have data that we want to compress
-	if(InputSize)
+	while(pSrc != pSrcEnd)
 	{
-		// {A} load the first symbol
-		int Symbol = *pSrc++;
+		const CNode &Node = m_aNodes[*pSrc++];
+		Bits |= (uint64_t)Node.m_Bits << Bitcount;
+		Bitcount += Node.m_NumBits;
 
-		while(pSrc != pSrcEnd)
+		if(Bitcount >= 32)
 		{
-			// {B} load the symbol
-			HUFFMAN_MACRO_LOADSYMBOL(Symbol);
-
-			// {C} fetch next symbol, this is done here because it will reduce dependency in the code
-			Symbol = *pSrc++;
-
-			// {B} write the symbol loaded at
-			HUFFMAN_MACRO_WRITE();
+			if(pDstEnd - pDst <= 4)
+				return -1;
+			pDst[0] = (unsigned char)Bits;
+			pDst[1] = (unsigned char)(Bits >> 8);
+			pDst[2] = (unsigned char)(Bits >> 16);
+			pDst[3] = (unsigned char)(Bits >> 24);
+			pDst += 4;
+			Bits >>= 32;
+			Bitcount -= 32;
 		}
-
-		// write the last symbol loaded from {C} or {A} in the case of only 1 byte input buffer
-		HUFFMAN_MACRO_LOADSYMBOL(Symbol);
-		HUFFMAN_MACRO_WRITE();
 	}
 
 	// write EOF symbol
-	HUFFMAN_MACRO_LOADSYMBOL(HUFFMAN_EOF_SYMBOL);
-	HUFFMAN_MACRO_WRITE();
+	Bits |= (uint64_t)m_aNodes[HUFFMAN_EOF_SYMBOL].m_Bits << Bitcount;
+	Bitcount += m_aNodes[HUFFMAN_EOF_SYMBOL].m_NumBits;
+	while(Bitcount >= 8)
+	{
+		if(pDstEnd - pDst <= 1)
+			return -1;
+		*pDst++ = (unsigned char)Bits;
+		Bits >>= 8;
+		Bitcount -= 8;
+	}
 
 	// write out the last bits
-	*pDst++ = Bits;
+	if(pDst == pDstEnd)
+		return -1;
+	*pDst++ = (unsigned char)Bits;
 
 	// return the size of the output
 	return (int)(pDst - (const unsigned char *)pOutput);
-
-	// remove macros
-#undef HUFFMAN_MACRO_LOADSYMBOL
-#undef HUFFMAN_MACRO_WRITE
 }
 
 //***************************************************************
@@ -207,66 +214,92 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 {
 	// setup buffer pointers
 	unsigned char *pDst = (unsigned char *)pOutput;
-	unsigned char *pSrc = (unsigned char *)pInput;
+	const unsigned char *pSrc = (const unsigned char *)pInput;
 	unsigned char *pDstEnd = pDst + OutputSize;
-	unsigned char *pSrcEnd = pSrc + InputSize;
+	const unsigned char *pSrcEnd = pSrc + InputSize;
 
-	unsigned Bits = 0;
+	// Bitcount only counts bits that came from the input, everything above is zero
+	uint64_t Bits = 0;
 	unsigned Bitcount = 0;
 
 	const CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
 
 	while(true)
 	{
-		// {A} try to load a node now, this will reduce dependency at location {D}
-		const CNode *pNode = nullptr;
-		if(Bitcount >= HUFFMAN_LUTBITS)
-			pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
-
-		// {B} fill with new bits
-		while(Bitcount < 24 && pSrc != pSrcEnd)
+		// {A} fill with new bits, whole words while possible
+		if(Bitcount < HUFFMAN_MAX_CODEBITS)
 		{
-			Bits |= (*pSrc++) << Bitcount;
-			Bitcount += 8;
+			if(pSrcEnd - pSrc >= 8)
+			{
+				uint64_t Word = 0;
+				for(int i = 7; i >= 0; i--)
+					Word = (Word << 8) | pSrc[i];
+				Bits |= Word << Bitcount;
+				pSrc += (63 - Bitcount) >> 3;
+				Bitcount |= 56;
+			}
+			else
+			{
+				while(Bitcount <= 56 && pSrc != pSrcEnd)
+				{
+					Bits |= (uint64_t)(*pSrc++) << Bitcount;
+					Bitcount += 8;
+				}
+			}
 		}
 
-		// {C} load symbol now if we didn't that earlier at location {A}
-		if(!pNode)
-			pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
+		// {B} resolve a run of symbols through the lut. close to the end of the input
+		// the lut could read past the last bit, so the tree is walked from the start instead
+		const CNode *pNode = m_pStartNode;
+		if(Bitcount >= HUFFMAN_LUTBITS)
+		{
+			const CDecodeEntry &Entry = m_aDecodeLut[Bits & HUFFMAN_LUTMASK];
+			Bits >>= Entry.m_NumBits;
+			Bitcount -= Entry.m_NumBits;
 
-		if(!pNode)
-			return -1;
+			if(Entry.m_NumSymbols)
+			{
+				// copy the whole entry when there is room, so the copy has a fixed size
+				if(pDstEnd - pDst >= HUFFMAN_LUTMAXSYMBOLS)
+				{
+					for(int i = 0; i < HUFFMAN_LUTMAXSYMBOLS; i++)
+						pDst[i] = Entry.m_aSymbols[i];
+				}
+				else if(pDstEnd - pDst >= Entry.m_NumSymbols)
+				{
+					for(int i = 0; i < Entry.m_NumSymbols; i++)
+						pDst[i] = Entry.m_aSymbols[i];
+				}
+				else
+					return -1;
+				pDst += Entry.m_NumSymbols;
+				continue;
+			}
 
-		// {D} check if we hit a symbol already
-		if(pNode->m_NumBits)
-		{
-			// remove the bits for that symbol
-			Bits >>= pNode->m_NumBits;
-			Bitcount -= pNode->m_NumBits;
+			pNode = &m_aNodes[Entry.m_Node];
 		}
-		else
-		{
-			// remove the bits that the lut checked up for us
-			Bits >>= HUFFMAN_LUTBITS;
-			Bitcount -= HUFFMAN_LUTBITS;
 
-			// walk the tree bit by bit
-			while(true)
+		// {C} walk the tree bit by bit for long codes
+		if(Bitcount >= HUFFMAN_MAX_CODEBITS)
+		{
+			while(!pNode->m_NumBits)
 			{
-				// traverse tree
 				pNode = &m_aNodes[pNode->m_aLeaves[Bits & 1]];
-
-				// remove bit
-				Bitcount--;
 				Bits >>= 1;
-
-				// check if we hit a symbol
-				if(pNode->m_NumBits)
-					break;
-
+				Bitcount--;
+			}
+		}
+		else
+		{
+			while(!pNode->m_NumBits)
+			{
 				// no more bits, decoding error
 				if(Bitcount == 0)
 					return -1;
+
+				pNode = &m_aNodes[pNode->m_aLeaves[Bits & 1]];
+				Bits >>= 1;
+				Bitcount--;
 			}
 		}
 
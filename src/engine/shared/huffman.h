@@ -12,9 +12,13 @@ class CHuffman
 		HUFFMAN_MAX_SYMBOLS = HUFFMAN_EOF_SYMBOL + 1,
 		HUFFMAN_MAX_NODES = HUFFMAN_MAX_SYMBOLS * 2 - 1,
 
-		HUFFMAN_LUTBITS = 10,
+		HUFFMAN_LUTBITS = 11,
 		HUFFMAN_LUTSIZE = (1 << HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1),
+		HUFFMAN_LUTMAXSYMBOLS = 6,
+
+		// the encoder and the tree walk keep codes in 32 bit words
+		HUFFMAN_MAX_CODEBITS = 32
 	};
 
 	struct CNode
@@ -30,15 +34,29 @@ class CHuffman
 		unsigned char m_Symbol;
 	};
 
+	// a decode lut entry resolves every complete byte symbol within the lookup bits at once.
+	// if no symbol fits (long code or the eof symbol), it holds the node reached after m_NumBits instead.
+	struct CDecodeEntry
+	{
+		union
+		{
+			unsigned char m_aSymbols[HUFFMAN_LUTMAXSYMBOLS];
+			unsigned short m_Node;
+		};
+		unsigned char m_NumSymbols;
+		unsigned char m_NumBits;
+	};
+
 	static const unsigned ms_aFreqTable[HUFFMAN_MAX_SYMBOLS];
 
 	CNode m_aNodes[HUFFMAN_MAX_NODES];
-	CNode *m_apDecodeLut[HUFFMAN_LUTSIZE];
+	CDecodeEntry m_aDecodeLut[HUFFMAN_LUTSIZE];
 	CNode *m_pStartNode;
 	int m_NumNodes;
 
 	void Setbits_r(CNode *pNode, int Bits, unsigned Depth);
 	void ConstructTree(const unsigned *pFrequencies);
+	void BuildDecodeLut();
 
 public:
 	/*
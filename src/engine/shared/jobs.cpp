@@ -5,9 +5,11 @@
 #include <algorithm>
 
 IJob::IJob() :
-	m_pNext(nullptr),
 	m_State(STATE_QUEUED),
-	m_Abortable(false)
+	m_Abortable(false),
+	m_Priority(PRIORITY_INTERACTIVE),
+	m_ContinuationsReleased(false),
+	m_NumPendingDependencies(0)
 {
 }
 
@@ -43,9 +45,26 @@ bool IJob::IsAbortable() const
 	return m_Abortable;
 }
 
+void IJob::SetPriority(EJobPriority Priority)
+{
+	dbg_assert(Priority >= 0 && Priority < NUM_PRIORITIES, "Invalid job priority: %d", static_cast<int>(Priority));
+	m_Priority = Priority;
+}
+
+IJob::EJobPriority IJob::Priority() const
+{
+	return m_Priority;
+}
+
+// the worker thread which is running on the current thread, to queue jobs added from jobs for the same worker
+static thread_local const void *gs_pCurrentWorkerPool = nullptr;
+static thread_local int gs_CurrentWorkerIndex = -1;
+
 CJobPool::CJobPool()
 {
 	m_Shutdown = true;
+	m_NumQueued = 0;
+	m_NextWorker = 0;
 }
 
 CJobPool::~CJobPool()
@@ -58,70 +77,116 @@ CJobPool::~CJobPool()
 
 void CJobPool::WorkerThread(void *pUser)
 {
-	static_cast<CJobPool *>(pUser)->RunLoop();
+	CWorker *pWorker = static_cast<CWorker *>(pUser);
+	gs_pCurrentWorkerPool = pWorker->m_pPool;
+	gs_CurrentWorkerIndex = pWorker->m_Index;
+	pWorker->m_pPool->RunLoop(pWorker);
 }
 
-void CJobPool::RunLoop()
+void CJobPool::RunLoop(CWorker *pWorker)
 {
 	while(true)
 	{
 		// wait for job to become available
 		sphore_wait(&m_Semaphore);
 
-		// fetch job from queue
-		std::shared_ptr<IJob> pJob = nullptr;
+		// The semaphore is signaled once for every queued job, but another worker
+		// may have taken the job which was queued for this signal while this
+		// worker was looking at the other queues, so look again until the queues
+		// are actually empty.
+		std::shared_ptr<IJob> pJob = TakeJob(pWorker->m_Index);
+		while(!pJob && m_NumQueued > 0)
 		{
-			const CLockScope LockScope(m_Lock);
-			if(m_pFirstJob)
-			{
-				pJob = m_pFirstJob;
-				m_pFirstJob = m_pFirstJob->m_pNext;
-				// allow remaining objects in list to destruct, even when current object stays alive
-				pJob->m_pNext = nullptr;
-				if(!m_pFirstJob)
-					m_pLastJob = nullptr;
-			}
+			thread_yield();
+			pJob = TakeJob(pWorker->m_Index);
 		}
 
 		if(pJob)
 		{
-			IJob::EJobState OldStateQueued = IJob::STATE_QUEUED;
-			if(!pJob->m_State.compare_exchange_strong(OldStateQueued, IJob::STATE_RUNNING))
-			{
-				if(OldStateQueued == IJob::STATE_ABORTED)
-				{
-					// job was aborted before it was started
-					pJob->m_State = IJob::STATE_ABORTED;
-					continue;
-				}
-				dbg_assert_failed("Job state invalid. Job was reused or uninitialized.");
-			}
+			RunJob(pJob);
+		}
+		else if(m_Shutdown)
+		{
+			// shut down worker thread when pool is shutting down and no more jobs are left
+			break;
+		}
+	}
+}
 
-			// remember running jobs so we can abort them
-			{
-				const CLockScope LockScope(m_LockRunning);
-				m_RunningJobs.push_back(pJob);
-			}
-			pJob->Run();
+std::shared_ptr<IJob> CJobPool::TakeJob(int WorkerIndex)
+{
+	const int NumWorkers = m_vpWorkers.size();
+	for(int Priority = 0; Priority < IJob::NUM_PRIORITIES; Priority++)
+	{
+		// take from own queue first, then steal from the other workers
+		for(int i = 0; i < NumWorkers; i++)
+		{
+			CWorker *pWorker = m_vpWorkers[(WorkerIndex + i) % NumWorkers].get();
+			const CLockScope LockScope(pWorker->m_Lock);
+			std::deque<std::shared_ptr<IJob>> &Queue = pWorker->m_aQueues[Priority];
+			if(!Queue.empty())
 			{
-				const CLockScope LockScope(m_LockRunning);
-				m_RunningJobs.erase(std::find(m_RunningJobs.begin(), m_RunningJobs.end(), pJob));
+				std::shared_ptr<IJob> pJob = std::move(Queue.front());
+				Queue.pop_front();
+				m_NumQueued--;
+				return pJob;
 			}
+		}
+	}
+	return nullptr;
+}
 
-			// do not change state to done if job was not completed successfully
-			IJob::EJobState OldStateRunning = IJob::STATE_RUNNING;
-			if(!pJob->m_State.compare_exchange_strong(OldStateRunning, IJob::STATE_DONE))
-			{
-				if(OldStateRunning != IJob::STATE_ABORTED)
-				{
-					dbg_assert_failed("Job state invalid, must be either running or aborted");
-				}
-			}
+void CJobPool::RunJob(const std::shared_ptr<IJob> &pJob)
+{
+	IJob::EJobState OldStateQueued = IJob::STATE_QUEUED;
+	if(!pJob->m_State.compare_exchange_strong(OldStateQueued, IJob::STATE_RUNNING))
+	{
+		if(OldStateQueued == IJob::STATE_ABORTED)
+		{
+			// job was aborted before it was started
+			pJob->m_State = IJob::STATE_ABORTED;
+			ReleaseContinuations(pJob.get());
+			return;
 		}
-		else if(m_Shutdown)
+		dbg_assert_failed("Job state invalid. Job was reused or uninitialized.");
+	}
+
+	// remember running jobs so we can abort them
+	{
+		const CLockScope LockScope(m_LockRunning);
+		m_RunningJobs.push_back(pJob);
+	}
+	pJob->Run();
+	{
+		const CLockScope LockScope(m_LockRunning);
+		m_RunningJobs.erase(std::find(m_RunningJobs.begin(), m_RunningJobs.end(), pJob));
+	}
+
+	// do not change state to done if job was not completed successfully
+	IJob::EJobState OldStateRunning = IJob::STATE_RUNNING;
+	if(!pJob->m_State.compare_exchange_strong(OldStateRunning, IJob::STATE_DONE))
+	{
+		if(OldStateRunning != IJob::STATE_ABORTED)
 		{
-			// shut down worker thread when pool is shutting down and no more jobs are left
-			break;
+			dbg_assert_failed("Job state invalid, must be either running or aborted");
+		}
+	}
+	ReleaseContinuations(pJob.get());
+}
+
+void CJobPool::ReleaseContinuations(IJob *pJob)
+{
+	std::vector<std::shared_ptr<IJob>> vpContinuations;
+	{
+		const CLockScope LockScope(pJob->m_LockContinuations);
+		pJob->m_ContinuationsReleased = true;
+		std::swap(vpContinuations, pJob->m_vpContinuations);
+	}
+	for(std::shared_ptr<IJob> &pContinuation : vpContinuations)
+	{
+		if(--pContinuation->m_NumPendingDependencies == 0)
+		{
+			Add(std::move(pContinuation));
 		}
 	}
 }
@@ -129,20 +194,29 @@ void CJobPool::RunLoop()
 void CJobPool::Init(int NumThreads)
 {
 	dbg_assert(m_Shutdown, "Job pool already running");
-	m_Shutdown = false;
+	dbg_assert(NumThreads > 0, "Invalid number of worker threads: %d", NumThreads);
 
-	const CLockScope LockScope(m_Lock);
 	sphore_init(&m_Semaphore);
-	m_pFirstJob = nullptr;
-	m_pLastJob = nullptr;
+	m_NumQueued = 0;
+	m_NextWorker = 0;
+
+	m_vpWorkers.reserve(NumThreads);
+	for(int i = 0; i < NumThreads; i++)
+	{
+		std::unique_ptr<CWorker> pWorker = std::make_unique<CWorker>();
+		pWorker->m_pPool = this;
+		pWorker->m_Index = i;
+		pWorker->m_pThread = nullptr;
+		m_vpWorkers.push_back(std::move(pWorker));
+	}
+	m_Shutdown = false;
 
 	// start worker threads
 	char aName[16]; // unix kernel length limit
-	m_vpThreads.reserve(NumThreads);
-	for(int i = 0; i < NumThreads; i++)
+	for(const std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
 	{
-		str_format(aName, sizeof(aName), "CJobPool W%d", i);
-		m_vpThreads.push_back(thread_init(WorkerThread, this, aName));
+		str_format(aName, sizeof(aName), "CJobPool W%d", pWorker->m_Index);
+		pWorker->m_pThread = thread_init(WorkerThread, pWorker.get(), aName);
 	}
 }
 
@@ -151,35 +225,34 @@ void CJobPool::Shutdown()
 	dbg_assert(!m_Shutdown, "Job pool already shut down");
 	m_Shutdown = true;
 
-	// abort queued jobs
+	// abort queued jobs, only abortable jobs are removed from the queues
+	std::vector<std::shared_ptr<IJob>> vpAborted;
+	for(const std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
 	{
-		const CLockScope LockScope(m_Lock);
-		std::shared_ptr<IJob> pJob = m_pFirstJob;
-		std::shared_ptr<IJob> pPrev = nullptr;
-		while(pJob != nullptr)
+		const CLockScope LockScope(pWorker->m_Lock);
+		for(std::deque<std::shared_ptr<IJob>> &Queue : pWorker->m_aQueues)
 		{
-			std::shared_ptr<IJob> pNext = pJob->m_pNext;
-			if(pJob->Abort())
+			for(auto It = Queue.begin(); It != Queue.end();)
 			{
-				// only remove abortable jobs from queue
-				pJob->m_pNext = nullptr;
-				if(pPrev)
+				if((*It)->Abort())
 				{
-					pPrev->m_pNext = pNext;
+					vpAborted.push_back(std::move(*It));
+					It = Queue.erase(It);
+					m_NumQueued--;
 				}
 				else
 				{
-					m_pFirstJob = pNext;
+					++It;
 				}
 			}
-			else
-			{
-				pPrev = pJob;
-			}
-			pJob = pNext;
 		}
-		m_pLastJob = pPrev;
 	}
+	// continuations of aborted jobs are aborted as well, as no jobs are accepted anymore
+	for(const std::shared_ptr<IJob> &pJob : vpAborted)
+	{
+		ReleaseContinuations(pJob.get());
+	}
+	vpAborted.clear();
 
 	// abort running jobs
 	{
@@ -191,18 +264,18 @@ void CJobPool::Shutdown()
 	}
 
 	// wake up all worker threads
-	for(size_t i = 0; i < m_vpThreads.size(); i++)
+	for(size_t i = 0; i < m_vpWorkers.size(); i++)
 	{
 		sphore_signal(&m_Semaphore);
 	}
 
 	// wait for all worker threads to finish
-	for(void *pThread : m_vpThreads)
+	for(const std::unique_ptr<CWorker> &pWorker : m_vpWorkers)
 	{
-		thread_wait(pThread);
+		thread_wait(pWorker->m_pThread);
 	}
 
-	m_vpThreads.clear();
+	m_vpWorkers.clear();
 	sphore_destroy(&m_Semaphore);
 }
 
@@ -210,21 +283,155 @@ void CJobPool::Add(std::shared_ptr<IJob> pJob)
 {
 	if(m_Shutdown)
 	{
-		// no jobs are accepted when the job pool is already shutting down
+		// no jobs are accepted when the job pool is already shutting down,
+		// its continuations are released so they are aborted as well
 		pJob->Abort();
+		ReleaseContinuations(pJob.get());
 		return;
 	}
 
-	// add job to queue
+	// add job to the queue of the current worker, or distribute it between the workers
+	int WorkerIndex;
+	if(gs_pCurrentWorkerPool == this)
+	{
+		WorkerIndex = gs_CurrentWorkerIndex;
+	}
+	else
+	{
+		WorkerIndex = m_NextWorker.fetch_add(1) % m_vpWorkers.size();
+	}
 	{
-		const CLockScope LockScope(m_Lock);
-		if(m_pLastJob)
-			m_pLastJob->m_pNext = pJob;
-		m_pLastJob = std::move(pJob);
-		if(!m_pFirstJob)
-			m_pFirstJob = m_pLastJob;
+		CWorker *pWorker = m_vpWorkers[WorkerIndex].get();
+		const CLockScope LockScope(pWorker->m_Lock);
+		pWorker->m_aQueues[pJob->Priority()].push_back(std::move(pJob));
+		m_NumQueued++;
 	}
 
 	// signal a worker thread that a job is available
 	sphore_signal(&m_Semaphore);
 }
+
+void CJobPool::AddAfter(std::shared_ptr<IJob> pJob, const std::vector<std::shared_ptr<IJob>> &vpDependencies)
+{
+	// hold back one dependency until the job was added to all dependencies,
+	// so it is not started while it is still being added
+	pJob->m_NumPendingDependencies = vpDependencies.size() + 1;
+	int NumDone = 1;
+	for(const std::shared_ptr<IJob> &pDependency : vpDependencies)
+	{
+		const CLockScope LockScope(pDependency->m_LockContinuations);
+		if(pDependency->m_ContinuationsReleased)
+		{
+			NumDone++;
+		}
+		else
+		{
+			pDependency->m_vpContinuations.push_back(pJob);
+		}
+	}
+	if(pJob->m_NumPendingDependencies.fetch_sub(NumDone) == NumDone)
+	{
+		Add(std::move(pJob));
+	}
+}
+
+// distributes the chunks of a range between the calling thread and the jobs
+class CJobPool::CParallelFor
+{
+	const std::function<void(int Begin, int End)> &m_Function;
+	const int m_Begin;
+	const int m_End;
+	const int m_Grain;
+	const int m_NumChunks;
+	std::atomic<int> m_NextChunk;
+	std::atomic<int> m_NumChunksDone;
+	SEMAPHORE m_DoneSemaphore;
+
+public:
+	CParallelFor(int Begin, int End, int Grain, const std::function<void(int Begin, int End)> &Function) :
+		m_Function(Function),
+		m_Begin(Begin),
+		m_End(End),
+		m_Grain(Grain),
+		m_NumChunks((End - Begin + Grain - 1) / Grain),
+		m_NextChunk(0),
+		m_NumChunksDone(0)
+	{
+		sphore_init(&m_DoneSemaphore);
+	}
+
+	~CParallelFor()
+	{
+		sphore_destroy(&m_DoneSemaphore);
+	}
+
+	int NumChunks() const { return m_NumChunks; }
+
+	// returns false once all chunks are being processed, the function is not accessed anymore then
+	bool RunNext()
+	{
+		const int Chunk = m_NextChunk.fetch_add(1);
+		if(Chunk >= m_NumChunks)
+		{
+			return false;
+		}
+		const int Begin = m_Begin + Chunk * m_Grain;
+		m_Function(Begin, std::min(Begin + m_Grain, m_End));
+		if(m_NumChunksDone.fetch_add(1) + 1 == m_NumChunks)
+		{
+			sphore_signal(&m_DoneSemaphore);
+		}
+		return true;
+	}
+
+	void Wait()
+	{
+		sphore_wait(&m_DoneSemaphore);
+	}
+};
+
+class CJobPool::CParallelForJob : public IJob
+{
+	std::shared_ptr<CParallelFor> m_pParallelFor;
+
+	void Run() override
+	{
+		while(m_pParallelFor->RunNext())
+		{
+		}
+	}
+
+public:
+	CParallelForJob(std::shared_ptr<CParallelFor> pParallelFor, EJobPriority Priority) :
+		m_pParallelFor(std::move(pParallelFor))
+	{
+		// the calling thread processes all chunks on its own if the jobs are not started
+		Abortable(true);
+		SetPriority(Priority);
+	}
+};
+
+void CJobPool::ParallelFor(int Begin, int End, int Grain, const std::function<void(int Begin, int End)> &Function, IJob::EJobPriority Priority)
+{
+	dbg_assert(Grain > 0, "Invalid grain: %d", Grain);
+	if(Begin >= End)
+	{
+		return;
+	}
+
+	const auto pParallelFor = std::make_shared<CParallelFor>(Begin, End, Grain, Function);
+	if(!m_Shutdown)
+	{
+		const int NumJobs = std::min<int>(pParallelFor->NumChunks() - 1, m_vpWorkers.size());
+		for(int i = 0; i < NumJobs; i++)
+		{
+			Add(std::make_shared<CParallelForJob>(pParallelFor, Priority));
+		}
+	}
+
+	// process chunks on this thread as well instead of only waiting for the jobs
+	while(pParallelFor->RunNext())
+	{
+	}
+	pParallelFor->Wait();
+}
@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -50,10 +51,35 @@ public:
 		STATE_ABORTED,
 	};
 
+	/**
+	 * The priority of a job in the job pool. Queued jobs with a higher priority
+	 * are always started before jobs with a lower priority.
+	 */
+	enum EJobPriority
+	{
+		/**
+		 * Job that someone is waiting for, e.g. loading assets that are shown soon.
+		 */
+		PRIORITY_INTERACTIVE = 0,
+
+		/**
+		 * Job whose result is not needed immediately, e.g. saving files or downloading
+		 * optional resources.
+		 */
+		PRIORITY_BACKGROUND,
+
+		NUM_PRIORITIES,
+	};
+
 private:
-	std::shared_ptr<IJob> m_pNext;
 	std::atomic<EJobState> m_State;
 	std::atomic<bool> m_Abortable;
+	EJobPriority m_Priority;
+
+	CLock m_LockContinuations;
+	std::vector<std::shared_ptr<IJob>> m_vpContinuations GUARDED_BY(m_LockContinuations);
+	bool m_ContinuationsReleased GUARDED_BY(m_LockContinuations);
+	std::atomic<int> m_NumPendingDependencies;
 
 protected:
 	/**
@@ -117,28 +143,65 @@ public:
 	 * @return `true` if the job can be aborted, `false` otherwise.
 	 */
 	bool IsAbortable() const;
+
+	/**
+	 * Sets the priority of this job.
+	 *
+	 * @remark Must be called before the job is added to a job pool.
+	 *
+	 * @see EJobPriority
+	 */
+	void SetPriority(EJobPriority Priority);
+
+	/**
+	 * Returns the priority of the job. Jobs have @link PRIORITY_INTERACTIVE @endlink
+	 * priority by default.
+	 *
+	 * @return Priority of the job.
+	 */
+	EJobPriority Priority() const;
 };
 
 /**
  * A job pool which runs jobs in one or more worker threads.
  *
+ * Every worker thread has its own queues. Jobs which are added from a worker
+ * thread are queued for that worker, other jobs are distributed between all
+ * workers. Idle workers steal jobs from the other workers.
+ *
  * @see IJob
  */
 class CJobPool
 {
-	std::vector<void *> m_vpThreads;
+	class CWorker
+	{
+	public:
+		CJobPool *m_pPool;
+		int m_Index;
+		void *m_pThread;
+
+		CLock m_Lock;
+		std::deque<std::shared_ptr<IJob>> m_aQueues[IJob::NUM_PRIORITIES] GUARDED_BY(m_Lock);
+	};
+
+	class CParallelFor;
+	class CParallelForJob;
+
+	std::vector<std::unique_ptr<CWorker>> m_vpWorkers;
 	std::atomic<bool> m_Shutdown;
 
-	CLock m_Lock;
 	SEMAPHORE m_Semaphore;
-	std::shared_ptr<IJob> m_pFirstJob GUARDED_BY(m_Lock);
-	std::shared_ptr<IJob> m_pLastJob GUARDED_BY(m_Lock);
+	std::atomic<int> m_NumQueued;
+	std::atomic<unsigned> m_NextWorker;
 
 	CLock m_LockRunning;
 	std::deque<std::shared_ptr<IJob>> m_RunningJobs GUARDED_BY(m_LockRunning);
 
 	static void WorkerThread(void *pUser) NO_THREAD_SAFETY_ANALYSIS;
-	void RunLoop() NO_THREAD_SAFETY_ANALYSIS;
+	void RunLoop(CWorker *pWorker) NO_THREAD_SAFETY_ANALYSIS;
+	std::shared_ptr<IJob> TakeJob(int WorkerIndex);
+	void RunJob(const std::shared_ptr<IJob> &pJob) REQUIRES(!m_LockRunning);
+	void ReleaseContinuations(IJob *pJob);
 
 public:
 	CJobPool();
@@ -151,7 +214,7 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Init(int NumThreads) REQUIRES(!m_Lock);
+	void Init(int NumThreads);
 
 	/**
 	 * Shuts down the job pool. Aborts all abortable jobs. Then waits for all
@@ -159,7 +222,7 @@ public:
 	 *
 	 * @remark Must be called on the main thread.
 	 */
-	void Shutdown() REQUIRES(!m_Lock) REQUIRES(!m_LockRunning);
+	void Shutdown() REQUIRES(!m_LockRunning);
 
 	/**
 	 * Adds a job to the queue of the job pool.
@@ -168,7 +231,36 @@ public:
 	 *
 	 * @remark If the job pool is already shutting down, no additional jobs
 	 * will be enqueue anymore. Abortable jobs will immediately be aborted.
+	 * Jobs added after the job with @link AddAfter @endlink are added as well,
+	 * so they are aborted too.
+	 */
+	void Add(std::shared_ptr<IJob> pJob);
+
+	/**
+	 * Adds a job to the queue of the job pool once all given jobs are done,
+	 * i.e. completed or aborted. The job is still added if one of the jobs
+	 * it depends on was aborted, so it should check their state if necessary.
+	 *
+	 * @param pJob The job to enqueue.
+	 * @param vpDependencies The jobs which must be done before the job is started.
+	 * They must be added to a job pool as well, otherwise the job is never started.
+	 *
+	 * @see Add
+	 */
+	void AddAfter(std::shared_ptr<IJob> pJob, const std::vector<std::shared_ptr<IJob>> &vpDependencies);
+
+	/**
+	 * Calls a function for all chunks of a range in parallel and waits until all
+	 * calls returned. The calling thread processes chunks as well, so this may
+	 * also be used from within jobs.
+	 *
+	 * @param Begin The first index of the range.
+	 * @param End The index after the last index of the range.
+	 * @param Grain The maximum number of indices in a chunk.
+	 * @param Function The function which is called with the begin and end of a chunk.
+	 * It is called from multiple threads at the same time.
+	 * @param Priority The priority of the jobs which help the calling thread.
 	 */
-	void Add(std::shared_ptr<IJob> pJob) REQUIRES(!m_Lock);
+	void ParallelFor(int Begin, int End, int Grain, const std::function<void(int Begin, int End)> &Function, IJob::EJobPriority Priority = IJob::PRIORITY_INTERACTIVE);
 };
 #endif
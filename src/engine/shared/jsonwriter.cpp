@@ -5,6 +5,9 @@
 
 #include <base/system.h>
 
+#include <cmath>
+#include <cstdlib>
+
 static char EscapeJsonChar(char c)
 {
 	switch(c)
@@ -86,6 +89,29 @@ void CJsonWriter::WriteIntValue(int Value)
 	CompleteDataType();
 }
 
+void CJsonWriter::WriteDoubleValue(double Value)
+{
+	dbg_assert(CanWriteDatatype(), "Cannot write value here");
+	WriteIndent(false);
+	if(std::isfinite(Value))
+	{
+		char aBuf[32];
+		for(int Precision = 1; Precision <= 17; Precision++)
+		{
+			str_format(aBuf, sizeof(aBuf), "%.*g", Precision, Value);
+			if(std::strtod(aBuf, nullptr) == Value)
+				break;
+		}
+		WriteInternal(aBuf);
+	}
+	else
+	{
+		// JSON has no infinity or NaN
+		WriteInternal("null");
+	}
+	CompleteDataType();
+}
+
 void CJsonWriter::WriteBoolValue(bool Value)
 {
 	dbg_assert(CanWriteDatatype(), "Cannot write value here");
@@ -75,6 +75,8 @@ public:
 	// - As root value (only once).
 	void WriteStrValue(const char *pValue);
 	void WriteIntValue(int Value);
+	// Writes the shortest number that reads back as `Value`, or null if it is not finite.
+	void WriteDoubleValue(double Value);
 	void WriteBoolValue(bool Value);
 	void WriteNullValue();
 };
@@ -8,7 +8,12 @@
 
 #include <game/mapitems.h>
 
-CMap::CMap() = default;
+#include <cstddef>
+
+CMap::CMap(IEngine *pEngine) :
+	m_pEngine(pEngine)
+{
+}
 
 int CMap::GetDataSize(int Index) const
 {
@@ -35,6 +40,11 @@ void CMap::UnloadData(int Index)
 	m_DataFile.UnloadData(Index);
 }
 
+void CMap::LoadData(const std::vector<int> &vIndices)
+{
+	m_DataFile.LoadData(m_pEngine, vIndices);
+}
+
 int CMap::NumData() const
 {
 	return m_DataFile.NumData();
@@ -75,7 +85,11 @@ bool CMap::Load(const char *pMapName)
 	IStorage *pStorage = Kernel()->RequestInterface<IStorage>();
 	if(!pStorage)
 		return false;
+	return Load(pStorage, pMapName);
+}
 
+bool CMap::Load(IStorage *pStorage, const char *pMapName)
+{
 	// Ensure current datafile is not left in an inconsistent state if loading fails,
 	// by loading the new datafile separately first.
 	CDataFileReader NewDataFile;
@@ -91,10 +105,35 @@ bool CMap::Load(const char *pMapName)
 		return false;
 	}
 
-	// Replace compressed tile layers with uncompressed ones
 	int GroupsStart, GroupsNum, LayersStart, LayersNum;
 	NewDataFile.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
 	NewDataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
+
+	// Decompress the data of all tile layers in parallel, it is needed by both server and client
+	std::vector<int> vTileData;
+	constexpr int DATA_FIELD = offsetof(CMapItemLayerTilemap, m_Data) / sizeof(int);
+	constexpr int TELE_FIELD = offsetof(CMapItemLayerTilemap, m_Tele) / sizeof(int);
+	for(int l = 0; l < LayersNum; l++)
+	{
+		const int *pFields = static_cast<const int *>(NewDataFile.GetItem(LayersStart + l));
+		const int NumFields = NewDataFile.GetItemSize(LayersStart + l) / sizeof(int);
+		const CMapItemLayerTilemap *pTilemap = reinterpret_cast<const CMapItemLayerTilemap *>(pFields);
+		if(NumFields <= DATA_FIELD || pTilemap->m_Layer.m_Type != LAYERTYPE_TILES)
+			continue;
+
+		vTileData.push_back(pTilemap->m_Data);
+		// Same as in CLayers::Init, old versions store the data of the special layers starting at the data field
+		const int aSpecialFlags[] = {TILESLAYERFLAG_TELE, TILESLAYERFLAG_SPEEDUP, TILESLAYERFLAG_FRONT, TILESLAYERFLAG_SWITCH, TILESLAYERFLAG_TUNE};
+		for(int i = 0; i < (int)std::size(aSpecialFlags); i++)
+		{
+			const int Field = (pTilemap->m_Version <= 2 ? DATA_FIELD : TELE_FIELD) + i;
+			if((pTilemap->m_Flags & aSpecialFlags[i]) && Field < NumFields)
+				vTileData.push_back(pFields[Field]);
+		}
+	}
+	NewDataFile.LoadData(m_pEngine, vTileData);
+
+	// Replace compressed tile layers with uncompressed ones
 	for(int g = 0; g < GroupsNum; g++)
 	{
 		const CMapItemGroup *pGroup = static_cast<CMapItemGroup *>(NewDataFile.GetItem(GroupsStart + g));
@@ -130,6 +169,13 @@ bool CMap::Load(const char *pMapName)
 	return true;
 }
 
+void CMap::Take(IEngineMap *pOther)
+{
+	CMap *pOtherMap = static_cast<CMap *>(pOther);
+	m_DataFile.Close();
+	m_DataFile = std::move(pOtherMap->m_DataFile);
+}
+
 void CMap::Unload()
 {
 	m_DataFile.Close();
@@ -160,6 +206,11 @@ int CMap::MapSize() const
 	return m_DataFile.MapSize();
 }
 
+const unsigned char *CMap::MapData()
+{
+	return m_DataFile.FileData();
+}
+
 void CMap::ExtractTiles(CTile *pDest, size_t DestSize, const CTile *pSrc, size_t SrcSize)
 {
 	size_t DestIndex = 0;
@@ -176,4 +227,4 @@ void CMap::ExtractTiles(CTile *pDest, size_t DestSize, const CTile *pSrc, size_t
 	}
 }
 
-extern IEngineMap *CreateEngineMap() { return new CMap; }
+extern IEngineMap *CreateEngineMap(IEngine *pEngine) { return new CMap(pEngine); }
@@ -12,9 +12,11 @@
 class CMap : public IEngineMap
 {
 	CDataFileReader m_DataFile;
+	// runs the jobs to load data in parallel, optional
+	class IEngine *m_pEngine;
 
 public:
-	CMap();
+	CMap(class IEngine *pEngine = nullptr);
 
 	CDataFileReader *GetReader() { return &m_DataFile; }
 
@@ -23,6 +25,7 @@ public:
 	void *GetDataSwapped(int Index) override;
 	const char *GetDataString(int Index) override;
 	void UnloadData(int Index) override;
+	void LoadData(const std::vector<int> &vIndices) override;
 	int NumData() const override;
 
 	int GetItemSize(int Index) override;
@@ -33,6 +36,8 @@ public:
 	int NumItems() const override;
 
 	[[nodiscard]] bool Load(const char *pMapName) override;
+	[[nodiscard]] bool Load(class IStorage *pStorage, const char *pMapName);
+	void Take(IEngineMap *pOther) override;
 	void Unload() override;
 	bool IsLoaded() const override;
 	IOHANDLE File() const override;
@@ -40,6 +45,7 @@ public:
 	SHA256_DIGEST Sha256() const override;
 	unsigned Crc() const override;
 	int MapSize() const override;
+	const unsigned char *MapData() override;
 
 	static void ExtractTiles(class CTile *pDest, size_t DestSize, const class CTile *pSrc, size_t SrcSize);
 };
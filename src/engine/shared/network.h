@@ -460,6 +460,10 @@ public:
 	int Send(CNetChunk *pChunk);
 	void Update();
 
+	// queue the outgoing packets and send them in batches
+	void SetSendQueue(bool Enabled) { net_udp_set_send_queue(m_Socket, Enabled); }
+	void FlushSendQueue() { net_udp_flush(m_Socket); }
+
 	//
 	void Drop(int ClientId, const char *pReason);
 
@@ -0,0 +1,80 @@
+#include "simd.h"
+
+#if defined(CONF_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static CSimd::ELevel DetectLevel()
+{
+#if defined(CONF_SIMD_X86)
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return CSimd::LEVEL_AVX2;
+#elif defined(_MSC_VER)
+	int aInfo[4];
+	__cpuid(aInfo, 0);
+	if(aInfo[0] >= 7)
+	{
+		__cpuid(aInfo, 1);
+		// the os must save the ymm registers
+		const bool OsXsave = (aInfo[2] & (1 << 27)) != 0;
+		if(OsXsave && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(aInfo, 7, 0);
+			if(aInfo[1] & (1 << 5))
+				return CSimd::LEVEL_AVX2;
+		}
+	}
+#endif
+	return CSimd::LEVEL_SSE2;
+#elif defined(CONF_SIMD_NEON)
+	return CSimd::LEVEL_NEON;
+#else
+	return CSimd::LEVEL_SCALAR;
+#endif
+}
+
+CSimd::ELevel CSimd::ms_Level = DetectLevel();
+
+CSimd::ELevel CSimd::SupportedLevel()
+{
+	static const ELevel s_Level = DetectLevel();
+	return s_Level;
+}
+
+bool CSimd::IsSupported(ELevel Level)
+{
+	const ELevel Supported = SupportedLevel();
+	switch(Level)
+	{
+	case LEVEL_SCALAR:
+		return true;
+	case LEVEL_SSE2:
+		return Supported == LEVEL_SSE2 || Supported == LEVEL_AVX2;
+	case LEVEL_AVX2:
+	case LEVEL_NEON:
+		return Supported == Level;
+	}
+	return false;
+}
+
+bool CSimd::SetLevel(ELevel Level)
+{
+	if(!IsSupported(Level))
+		return false;
+	ms_Level = Level;
+	return true;
+}
+
+const char *CSimd::LevelName(ELevel Level)
+{
+	switch(Level)
+	{
+	case LEVEL_SCALAR: return "scalar";
+	case LEVEL_SSE2: return "sse2";
+	case LEVEL_AVX2: return "avx2";
+	case LEVEL_NEON: return "neon";
+	}
+	return "unknown";
+}
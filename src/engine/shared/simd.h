@@ -0,0 +1,49 @@
+#ifndef ENGINE_SHARED_SIMD_H
+#define ENGINE_SHARED_SIMD_H
+
+#include <base/detect.h>
+
+// SSE2 is part of the amd64 baseline, AVX2 is detected at runtime
+#if defined(CONF_ARCH_AMD64)
+#define CONF_SIMD_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+// NEON is part of the arm64 baseline
+#elif defined(CONF_ARCH_ARM64) && defined(__ARM_NEON)
+#define CONF_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Selects the instruction set used by the vectorized kernels of the
+// snapshot delta and variable int packing. All levels produce exactly the
+// same output as the scalar reference implementation.
+class CSimd
+{
+public:
+	enum ELevel
+	{
+		LEVEL_SCALAR = 0,
+		LEVEL_SSE2,
+		LEVEL_AVX2,
+		LEVEL_NEON,
+	};
+
+	// highest level supported by the compiler and cpu
+	static ELevel SupportedLevel();
+	// level currently used by the kernels, defaults to the supported level
+	static ELevel Level() { return ms_Level; }
+	// returns false if the level is not supported, e.g. to compare the
+	// kernels against the scalar implementation in tests and benchmarks
+	static bool SetLevel(ELevel Level);
+	static bool IsSupported(ELevel Level);
+	static const char *LevelName(ELevel Level);
+
+private:
+	static ELevel ms_Level;
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include "snapshot.h"
 
 #include "compression.h"
+#include "simd.h"
 #include "uuid_manager.h"
 
 #include <base/math.h>
@@ -11,8 +12,10 @@
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
+#include <new>
 
 // CSnapshot
 
@@ -36,6 +39,12 @@ int CSnapshot::GetItemType(int Index) const
 	return GetExternalItemType(InternalType);
 }
 
+int CSnapshot::GetItemType(int Index, const CSnapshotKeyIndex &KeyIndex) const
+{
+	int InternalType = GetItem(Index)->Type();
+	return KeyIndex.GetExternalItemType(InternalType);
+}
+
 int CSnapshot::GetExternalItemType(int InternalType) const
 {
 	if(InternalType < OFFSET_UUID_TYPE)
@@ -58,7 +67,7 @@ int CSnapshot::GetExternalItemType(int InternalType) const
 
 int CSnapshot::GetItemIndex(int Key) const
 {
-	// TODO: OPT: this should not be a linear search. very bad
+	// use CSnapshotKeyIndex for repeated lookups in the same snapshot
 	for(int i = 0; i < m_NumItems; i++)
 	{
 		if(GetItem(i)->Key() == Key)
@@ -105,6 +114,23 @@ const void *CSnapshot::FindItem(int Type, int Id) const
 	return Index < 0 ? nullptr : GetItem(Index)->Data();
 }
 
+const void *CSnapshot::FindItem(int Type, int Id, const CSnapshotKeyIndex &KeyIndex) const
+{
+	int InternalType = Type;
+	if(Type >= OFFSET_UUID)
+	{
+		InternalType = KeyIndex.GetInternalItemType(Type);
+		if(InternalType == -1)
+		{
+			return nullptr;
+		}
+	}
+	const int Key = (InternalType << 16) | Id;
+	int Index = KeyIndex.GetItemIndex(Key);
+	// items might have been invalidated after the index was built
+	return Index < 0 || GetItem(Index)->Key() != Key ? nullptr : GetItem(Index)->Data();
+}
+
 unsigned CSnapshot::Crc() const
 {
 	unsigned int Crc = 0;
@@ -160,6 +186,92 @@ bool CSnapshot::IsValid(size_t ActualSize) const
 	return true;
 }
 
+// CSnapshotKeyIndex
+
+void CSnapshotKeyIndex::Build(const CSnapshot *pSnapshot)
+{
+	// sort by key and then by index, so duplicate keys resolve to the
+	// first item like the linear search in CSnapshot::GetItemIndex
+	uint64_t aEntries[CSnapshot::MAX_ITEMS];
+	m_NumItems = pSnapshot->NumItems();
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		aEntries[i] = ((uint64_t)(unsigned)pSnapshot->GetItem(i)->Key() << 32) | (unsigned)i;
+	}
+	std::sort(aEntries, aEntries + m_NumItems);
+	for(int i = 0; i < m_NumItems; i++)
+	{
+		m_aKeys[i] = (int)(aEntries[i] >> 32);
+		m_aIndices[i] = (short)(aEntries[i] & 0xffff);
+	}
+
+	m_NumExtendedItemTypes = 0;
+	for(int i = 0; i < m_NumItems && m_NumExtendedItemTypes < MAX_EXTENDED_ITEM_TYPES; i++)
+	{
+		const CSnapshotItem *pItem = pSnapshot->GetItem(i);
+		if(pItem->Type() != 0 || pItem->Id() < CSnapshot::OFFSET_UUID_TYPE) // NETOBJTYPE_EX
+			continue;
+		const int ExternalType = pSnapshot->GetExternalItemType(pItem->Id());
+		if(ExternalType == pItem->Id())
+			continue;
+		m_aExtendedInternalTypes[m_NumExtendedItemTypes] = pItem->Id();
+		m_aExtendedExternalTypes[m_NumExtendedItemTypes] = ExternalType;
+		m_NumExtendedItemTypes++;
+	}
+}
+
+void CSnapshotKeyIndex::Clear()
+{
+	m_NumItems = 0;
+	m_NumExtendedItemTypes = 0;
+}
+
+int CSnapshotKeyIndex::GetItemIndex(int Key) const
+{
+	const unsigned UnsignedKey = Key;
+	int Low = 0;
+	int High = m_NumItems;
+	while(Low < High)
+	{
+		const int Mid = Low + (High - Low) / 2;
+		if((unsigned)m_aKeys[Mid] < UnsignedKey)
+			Low = Mid + 1;
+		else
+			High = Mid;
+	}
+	if(Low < m_NumItems && m_aKeys[Low] == Key)
+		return m_aIndices[Low];
+	return -1;
+}
+
+int CSnapshotKeyIndex::GetExternalItemType(int InternalType) const
+{
+	if(InternalType < CSnapshot::OFFSET_UUID_TYPE)
+	{
+		return InternalType;
+	}
+	for(int i = 0; i < m_NumExtendedItemTypes; i++)
+	{
+		if(m_aExtendedInternalTypes[i] == InternalType)
+			return m_aExtendedExternalTypes[i];
+	}
+	return InternalType;
+}
+
+int CSnapshotKeyIndex::GetInternalItemType(int ExternalType) const
+{
+	if(ExternalType < OFFSET_UUID)
+	{
+		return ExternalType;
+	}
+	for(int i = 0; i < m_NumExtendedItemTypes; i++)
+	{
+		if(m_aExtendedExternalTypes[i] == ExternalType)
+			return m_aExtendedInternalTypes[i];
+	}
+	return -1;
+}
+
 // CSnapshotDelta
 
 enum
@@ -214,7 +326,7 @@ static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
 	return -1;
 }
 
-int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
+static int DiffItemScalar(const int *pPast, const int *pCurrent, int *pOut, int Size)
 {
 	int Needed = 0;
 	while(Size)
@@ -231,7 +343,7 @@ int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, i
 	return Needed;
 }
 
-void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
+static void UndiffItemScalar(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
 {
 	while(Size)
 	{
@@ -254,6 +366,174 @@ void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, i
 	}
 }
 
+// The vectorized data rate counts the bytes CVariableInt::Pack would need by
+// comparing the magnitude against the largest value of 1 to 4 packed bytes.
+
+#if defined(CONF_SIMD_X86)
+static int HorizontalOrSse2(__m128i Value)
+{
+	Value = _mm_or_si128(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(1, 0, 3, 2)));
+	Value = _mm_or_si128(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(Value);
+}
+
+static int HorizontalAddSse2(__m128i Value)
+{
+	Value = _mm_add_epi32(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(1, 0, 3, 2)));
+	Value = _mm_add_epi32(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(Value);
+}
+
+static __m128i PackedBitsSse2(__m128i Diff)
+{
+	const __m128i Value = _mm_xor_si128(Diff, _mm_srai_epi32(Diff, 31));
+	__m128i Bytes = _mm_set1_epi32(1);
+	Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32(0x3F)));
+	Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32(0x1FFF)));
+	Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32(0xFFFFF)));
+	Bytes = _mm_sub_epi32(Bytes, _mm_cmpgt_epi32(Value, _mm_set1_epi32(0x7FFFFFF)));
+	// unchanged ints only count as one bit
+	const __m128i Unchanged = _mm_cmpeq_epi32(Diff, _mm_setzero_si128());
+	return _mm_or_si128(_mm_andnot_si128(Unchanged, _mm_slli_epi32(Bytes, 3)), _mm_and_si128(Unchanged, _mm_set1_epi32(1)));
+}
+
+static int DiffItemSse2(const int *pPast, const int *pCurrent, int *pOut, int Size)
+{
+	__m128i Needed = _mm_setzero_si128();
+	int i = 0;
+	for(; i + 4 <= Size; i += 4)
+	{
+		const __m128i Diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(pCurrent + i)), _mm_loadu_si128((const __m128i *)(pPast + i)));
+		_mm_storeu_si128((__m128i *)(pOut + i), Diff);
+		Needed = _mm_or_si128(Needed, Diff);
+	}
+	return HorizontalOrSse2(Needed) | DiffItemScalar(pPast + i, pCurrent + i, pOut + i, Size - i);
+}
+
+static void UndiffItemSse2(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
+{
+	__m128i Bits = _mm_setzero_si128();
+	int i = 0;
+	for(; i + 4 <= Size; i += 4)
+	{
+		const __m128i Diff = _mm_loadu_si128((const __m128i *)(pDiff + i));
+		_mm_storeu_si128((__m128i *)(pOut + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(pPast + i)), Diff));
+		Bits = _mm_add_epi32(Bits, PackedBitsSse2(Diff));
+	}
+	*pDataRate += (unsigned)HorizontalAddSse2(Bits);
+	UndiffItemScalar(pPast + i, pDiff + i, pOut + i, Size - i, pDataRate);
+}
+
+SIMD_TARGET_AVX2 static __m256i PackedBitsAvx2(__m256i Diff)
+{
+	const __m256i Value = _mm256_xor_si256(Diff, _mm256_srai_epi32(Diff, 31));
+	__m256i Bytes = _mm256_set1_epi32(1);
+	Bytes = _mm256_sub_epi32(Bytes, _mm256_cmpgt_epi32(Value, _mm256_set1_epi32(0x3F)));
+	Bytes = _mm256_sub_epi32(Bytes, _mm256_cmpgt_epi32(Value, _mm256_set1_epi32(0x1FFF)));
+	Bytes = _mm256_sub_epi32(Bytes, _mm256_cmpgt_epi32(Value, _mm256_set1_epi32(0xFFFFF)));
+	Bytes = _mm256_sub_epi32(Bytes, _mm256_cmpgt_epi32(Value, _mm256_set1_epi32(0x7FFFFFF)));
+	const __m256i Unchanged = _mm256_cmpeq_epi32(Diff, _mm256_setzero_si256());
+	return _mm256_blendv_epi8(_mm256_slli_epi32(Bytes, 3), _mm256_set1_epi32(1), Unchanged);
+}
+
+SIMD_TARGET_AVX2 static int DiffItemAvx2(const int *pPast, const int *pCurrent, int *pOut, int Size)
+{
+	__m256i Needed = _mm256_setzero_si256();
+	int i = 0;
+	for(; i + 8 <= Size; i += 8)
+	{
+		const __m256i Diff = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(pCurrent + i)), _mm256_loadu_si256((const __m256i *)(pPast + i)));
+		_mm256_storeu_si256((__m256i *)(pOut + i), Diff);
+		Needed = _mm256_or_si256(Needed, Diff);
+	}
+	const __m128i Needed128 = _mm_or_si128(_mm256_castsi256_si128(Needed), _mm256_extracti128_si256(Needed, 1));
+	return HorizontalOrSse2(Needed128) | DiffItemSse2(pPast + i, pCurrent + i, pOut + i, Size - i);
+}
+
+SIMD_TARGET_AVX2 static void UndiffItemAvx2(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
+{
+	__m256i Bits = _mm256_setzero_si256();
+	int i = 0;
+	for(; i + 8 <= Size; i += 8)
+	{
+		const __m256i Diff = _mm256_loadu_si256((const __m256i *)(pDiff + i));
+		_mm256_storeu_si256((__m256i *)(pOut + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(pPast + i)), Diff));
+		Bits = _mm256_add_epi32(Bits, PackedBitsAvx2(Diff));
+	}
+	const __m128i Bits128 = _mm_add_epi32(_mm256_castsi256_si128(Bits), _mm256_extracti128_si256(Bits, 1));
+	*pDataRate += (unsigned)HorizontalAddSse2(Bits128);
+	UndiffItemSse2(pPast + i, pDiff + i, pOut + i, Size - i, pDataRate);
+}
+#elif defined(CONF_SIMD_NEON)
+static int32x4_t PackedBitsNeon(int32x4_t Diff)
+{
+	const int32x4_t Value = veorq_s32(Diff, vshrq_n_s32(Diff, 31));
+	int32x4_t Bytes = vdupq_n_s32(1);
+	Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32(0x3F))));
+	Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32(0x1FFF))));
+	Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32(0xFFFFF))));
+	Bytes = vsubq_s32(Bytes, vreinterpretq_s32_u32(vcgtq_s32(Value, vdupq_n_s32(0x7FFFFFF))));
+	const uint32x4_t Unchanged = vceqq_s32(Diff, vdupq_n_s32(0));
+	return vbslq_s32(Unchanged, vdupq_n_s32(1), vshlq_n_s32(Bytes, 3));
+}
+
+static int DiffItemNeon(const int *pPast, const int *pCurrent, int *pOut, int Size)
+{
+	int32x4_t Needed = vdupq_n_s32(0);
+	int i = 0;
+	for(; i + 4 <= Size; i += 4)
+	{
+		const int32x4_t Diff = vsubq_s32(vld1q_s32(pCurrent + i), vld1q_s32(pPast + i));
+		vst1q_s32(pOut + i, Diff);
+		Needed = vorrq_s32(Needed, Diff);
+	}
+	const int32x2_t Needed64 = vorr_s32(vget_low_s32(Needed), vget_high_s32(Needed));
+	return (vget_lane_s32(Needed64, 0) | vget_lane_s32(Needed64, 1)) | DiffItemScalar(pPast + i, pCurrent + i, pOut + i, Size - i);
+}
+
+static void UndiffItemNeon(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
+{
+	int32x4_t Bits = vdupq_n_s32(0);
+	int i = 0;
+	for(; i + 4 <= Size; i += 4)
+	{
+		const int32x4_t Diff = vld1q_s32(pDiff + i);
+		vst1q_s32(pOut + i, vaddq_s32(vld1q_s32(pPast + i), Diff));
+		Bits = vaddq_s32(Bits, PackedBitsNeon(Diff));
+	}
+	*pDataRate += (unsigned)vaddvq_s32(Bits);
+	UndiffItemScalar(pPast + i, pDiff + i, pOut + i, Size - i, pDataRate);
+}
+#endif
+
+int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
+{
+	switch(CSimd::Level())
+	{
+#if defined(CONF_SIMD_X86)
+	case CSimd::LEVEL_AVX2: return DiffItemAvx2(pPast, pCurrent, pOut, Size);
+	case CSimd::LEVEL_SSE2: return DiffItemSse2(pPast, pCurrent, pOut, Size);
+#elif defined(CONF_SIMD_NEON)
+	case CSimd::LEVEL_NEON: return DiffItemNeon(pPast, pCurrent, pOut, Size);
+#endif
+	default: return DiffItemScalar(pPast, pCurrent, pOut, Size);
+	}
+}
+
+void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
+{
+	switch(CSimd::Level())
+	{
+#if defined(CONF_SIMD_X86)
+	case CSimd::LEVEL_AVX2: UndiffItemAvx2(pPast, pDiff, pOut, Size, pDataRate); break;
+	case CSimd::LEVEL_SSE2: UndiffItemSse2(pPast, pDiff, pOut, Size, pDataRate); break;
+#elif defined(CONF_SIMD_NEON)
+	case CSimd::LEVEL_NEON: UndiffItemNeon(pPast, pDiff, pOut, Size, pDataRate); break;
+#endif
+	default: UndiffItemScalar(pPast, pDiff, pOut, Size, pDataRate); break;
+	}
+}
+
 CSnapshotDelta::CSnapshotDelta()
 {
 	std::fill(std::begin(m_aItemSizes), std::end(m_aItemSizes), 0);
@@ -292,7 +572,7 @@ const CSnapshotDelta::CData *CSnapshotDelta::EmptyDelta() const
 }
 
 // TODO: OPT: this should be made much faster
-int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData)
+int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData) const
 {
 	CData *pDelta = (CData *)pDstData;
 	int *pData = (int *)pDelta->m_aData;
@@ -524,9 +804,16 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 	if(pData > pEnd)
 		return -101;
 
+	CSnapshotKeyIndex FromIndex;
+	FromIndex.Build(pFrom);
+
+	// index of the copied item in the builder for every item of pFrom
+	int aBuilderIndices[CSnapshot::MAX_ITEMS];
+
 	// copy all non deleted stuff
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
+		aBuilderIndices[i] = -1;
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
 		const int ItemSize = pFrom->GetItemSize(i);
 		bool Keep = true;
@@ -541,6 +828,7 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 
 		if(Keep)
 		{
+			aBuilderIndices[i] = Builder.NumItems();
 			void *pObj = Builder.NewItem(pFromItem->Type(), pFromItem->Id(), ItemSize);
 			if(!pObj)
 				return -301;
@@ -581,20 +869,24 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 			return -205;
 
 		const int Key = (Type << 16) | Id;
+		const int FromItemIndex = FromIndex.GetItemIndex(Key);
 
 		// create the item if needed
-		int *pNewData = Builder.GetItemData(Key);
+		int *pNewData;
+		if(FromItemIndex != -1 && aBuilderIndices[FromItemIndex] != -1)
+			pNewData = Builder.GetItemDataByIndex(aBuilderIndices[FromItemIndex]);
+		else
+			pNewData = Builder.GetItemData(Key);
 		if(!pNewData)
 			pNewData = (int *)Builder.NewItem(Type, Id, ItemSize);
 
 		if(!pNewData)
 			return -302;
 
-		const int FromIndex = pFrom->GetItemIndex(Key);
-		if(FromIndex != -1)
+		if(FromItemIndex != -1)
 		{
 			// we got an update so we need to apply the diff
-			UndiffItem(pFrom->GetItem(FromIndex)->Data(), pData, pNewData, ItemSize / sizeof(int32_t), &m_aSnapshotDataRate[Type]);
+			UndiffItem(pFrom->GetItem(FromItemIndex)->Data(), pData, pNewData, ItemSize / sizeof(int32_t), &m_aSnapshotDataRate[Type]);
 		}
 		else // no previous, just copy the pData
 		{
@@ -612,10 +904,115 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 
 // CSnapshotStorage
 
+static constexpr int StorageAlign(size_t Size)
+{
+	return (Size + 7) & ~(size_t)7;
+}
+
+CSnapshotStorage::~CSnapshotStorage()
+{
+	PurgeAll();
+}
+
 void CSnapshotStorage::Init()
 {
 	m_pFirst = nullptr;
 	m_pLast = nullptr;
+	m_ArenaHead = 0;
+	m_ArenaTail = 0;
+	m_NumArenaHolders = 0;
+	m_ArenaWrapped = false;
+	std::fill(std::begin(m_apTickLookup), std::end(m_apTickLookup), nullptr);
+	m_TicksIncreasing = true;
+}
+
+void *CSnapshotStorage::AllocateBlock(int Size, int *pArenaOffset)
+{
+	*pArenaOffset = -1;
+	if(Size > MAX_ARENA_SIZE)
+		return malloc(Size);
+
+	// once a block did not fit, the arena is left to drain so it can grow
+	if(m_ArenaFull && m_NumArenaHolders > 0)
+		return malloc(Size);
+
+	int Offset = -1;
+	if(m_NumArenaHolders == 0)
+	{
+		// the arena can only be replaced while no holder is in it
+		int NewSize = m_ArenaSize == 0 ? MIN_ARENA_SIZE : m_ArenaSize;
+		if(m_ArenaFull)
+			NewSize *= 2;
+		while(NewSize < Size)
+			NewSize *= 2;
+		NewSize = minimum<int>(NewSize, MAX_ARENA_SIZE);
+		if(NewSize != m_ArenaSize)
+		{
+			m_pArena.reset(new char[NewSize]);
+			m_ArenaSize = NewSize;
+		}
+		m_ArenaFull = false;
+		m_ArenaHead = 0;
+		m_ArenaTail = 0;
+		m_ArenaWrapped = false;
+		Offset = 0;
+	}
+	else if(!m_ArenaWrapped)
+	{
+		if(m_ArenaHead + Size <= m_ArenaSize)
+			Offset = m_ArenaHead;
+		else if(Size <= m_ArenaTail)
+		{
+			Offset = 0;
+			m_ArenaWrapped = true;
+		}
+	}
+	else if(m_ArenaHead + Size <= m_ArenaTail)
+		Offset = m_ArenaHead;
+
+	// the arena is full, fall back to the heap
+	if(Offset == -1)
+	{
+		m_ArenaFull = true;
+		return malloc(Size);
+	}
+
+	m_ArenaHead = Offset + Size;
+	m_NumArenaHolders++;
+	*pArenaOffset = Offset;
+	return m_pArena.get() + Offset;
+}
+
+void CSnapshotStorage::FreeHolder(CHolder *pHolder)
+{
+	CHolder *&pLookup = m_apTickLookup[pHolder->m_Tick & (TICK_LOOKUP_SIZE - 1)];
+	if(pLookup == pHolder)
+		pLookup = nullptr;
+
+	if(pHolder->m_ArenaOffset == -1)
+	{
+		free(pHolder);
+		return;
+	}
+
+	// holders are freed in the order they were added, so the tail moves
+	// to the next holder in the arena
+	m_NumArenaHolders--;
+	CHolder *pNextArenaHolder = pHolder->m_pNext;
+	while(pNextArenaHolder && pNextArenaHolder->m_ArenaOffset == -1)
+		pNextArenaHolder = pNextArenaHolder->m_pNext;
+	if(!pNextArenaHolder || m_NumArenaHolders == 0)
+	{
+		m_ArenaHead = 0;
+		m_ArenaTail = 0;
+		m_ArenaWrapped = false;
+	}
+	else
+	{
+		if(pNextArenaHolder->m_ArenaOffset < pHolder->m_ArenaOffset)
+			m_ArenaWrapped = false;
+		m_ArenaTail = pNextArenaHolder->m_ArenaOffset;
+	}
 }
 
 void CSnapshotStorage::PurgeAll()
@@ -623,12 +1020,11 @@ void CSnapshotStorage::PurgeAll()
 	while(m_pFirst)
 	{
 		CHolder *pNext = m_pFirst->m_pNext;
-		free(m_pFirst->m_pSnap);
-		free(m_pFirst->m_pAltSnap);
-		free(m_pFirst);
+		FreeHolder(m_pFirst);
 		m_pFirst = pNext;
 	}
 	m_pLast = nullptr;
+	m_TicksIncreasing = true;
 }
 
 void CSnapshotStorage::PurgeUntil(int Tick)
@@ -640,9 +1036,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 		CHolder *pNext = pHolder->m_pNext;
 		if(pHolder->m_Tick >= Tick)
 			return; // no more to remove
-		free(pHolder->m_pSnap);
-		free(pHolder->m_pAltSnap);
-		free(pHolder);
+		FreeHolder(pHolder);
 
 		// did we come to the end of the list?
 		if(!pNext)
@@ -656,6 +1050,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 	// no more snapshots in storage
 	m_pFirst = nullptr;
 	m_pLast = nullptr;
+	m_TicksIncreasing = true;
 }
 
 void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData)
@@ -663,26 +1058,49 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	dbg_assert(DataSize <= (size_t)CSnapshot::MAX_SIZE, "Snapshot data size invalid");
 	dbg_assert(AltDataSize <= (size_t)CSnapshot::MAX_SIZE, "Alt snapshot data size invalid");
 
-	CHolder *pHolder = static_cast<CHolder *>(malloc(sizeof(CHolder)));
+	// the holder, the snapshots and the key index of the alternative
+	// snapshot are placed in one block
+	const int HolderSize = StorageAlign(sizeof(CHolder));
+	const int SnapSize = StorageAlign(DataSize);
+	const int AltSnapSize = StorageAlign(AltDataSize);
+	const int IndexSize = AltDataSize ? StorageAlign(sizeof(CSnapshotKeyIndex)) : 0;
+	const int BlockSize = HolderSize + SnapSize + AltSnapSize + IndexSize;
+
+	int ArenaOffset;
+	char *pBlock = static_cast<char *>(AllocateBlock(BlockSize, &ArenaOffset));
+
+	CHolder *pHolder = reinterpret_cast<CHolder *>(pBlock);
 	pHolder->m_Tick = Tick;
 	pHolder->m_Tagtime = Tagtime;
+	pHolder->m_ArenaOffset = ArenaOffset;
 
-	pHolder->m_pSnap = static_cast<CSnapshot *>(malloc(DataSize));
+	pHolder->m_pSnap = reinterpret_cast<CSnapshot *>(pBlock + HolderSize);
 	mem_copy(pHolder->m_pSnap, pData, DataSize);
 	pHolder->m_SnapSize = DataSize;
 
 	if(AltDataSize) // create alternative if wanted
 	{
-		pHolder->m_pAltSnap = static_cast<CSnapshot *>(malloc(AltDataSize));
+		pHolder->m_pAltSnap = reinterpret_cast<CSnapshot *>(pBlock + HolderSize + SnapSize);
 		mem_copy(pHolder->m_pAltSnap, pAltData, AltDataSize);
 		pHolder->m_AltSnapSize = AltDataSize;
+
+		// the alternative snapshot is the one items are looked up in
+		pHolder->m_pAltSnapIndex = new(pBlock + HolderSize + SnapSize + AltSnapSize) CSnapshotKeyIndex();
+		pHolder->m_pAltSnapIndex->Build(pHolder->m_pAltSnap);
 	}
 	else
 	{
 		pHolder->m_pAltSnap = nullptr;
 		pHolder->m_AltSnapSize = 0;
+		pHolder->m_pAltSnapIndex = nullptr;
 	}
 
+	if(m_pLast && Tick <= m_pLast->m_Tick)
+		m_TicksIncreasing = false;
+	CHolder *&pLookup = m_apTickLookup[Tick & (TICK_LOOKUP_SIZE - 1)];
+	if(!pLookup || pLookup->m_Tick != Tick)
+		pLookup = pHolder;
+
 	// link
 	pHolder->m_pNext = nullptr;
 	pHolder->m_pPrev = m_pLast;
@@ -695,25 +1113,31 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 
 int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const
 {
-	CHolder *pHolder = m_pFirst;
-
-	while(pHolder)
+	CHolder *pHolder = nullptr;
+	if(m_TicksIncreasing && (!m_pFirst || m_pLast->m_Tick - m_pFirst->m_Tick < TICK_LOOKUP_SIZE))
 	{
-		if(pHolder->m_Tick == Tick)
-		{
-			if(pTagtime)
-				*pTagtime = pHolder->m_Tagtime;
-			if(ppData)
-				*ppData = pHolder->m_pSnap;
-			if(ppAltData)
-				*ppAltData = pHolder->m_pAltSnap;
-			return pHolder->m_SnapSize;
-		}
-
-		pHolder = pHolder->m_pNext;
+		// every stored tick has its own lookup slot
+		CHolder *pLookup = m_apTickLookup[Tick & (TICK_LOOKUP_SIZE - 1)];
+		if(pLookup && pLookup->m_Tick == Tick)
+			pHolder = pLookup;
+	}
+	else
+	{
+		pHolder = m_pFirst;
+		while(pHolder && pHolder->m_Tick != Tick)
+			pHolder = pHolder->m_pNext;
 	}
 
-	return -1;
+	if(!pHolder)
+		return -1;
+
+	if(pTagtime)
+		*pTagtime = pHolder->m_Tagtime;
+	if(ppData)
+		*ppData = pHolder->m_pSnap;
+	if(ppAltData)
+		*ppAltData = pHolder->m_pAltSnap;
+	return pHolder->m_SnapSize;
 }
 
 // CSnapshotBuilder
@@ -739,6 +1163,11 @@ CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 	return (CSnapshotItem *)&(m_aData[m_aOffsets[Index]]);
 }
 
+int *CSnapshotBuilder::GetItemDataByIndex(int Index)
+{
+	return GetItem(Index)->Data();
+}
+
 int *CSnapshotBuilder::GetItemData(int Key)
 {
 	for(int i = 0; i < m_NumItems; i++)
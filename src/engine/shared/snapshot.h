@@ -8,6 +8,9 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+
+class CSnapshotKeyIndex;
 
 // CSnapshot
 
@@ -59,8 +62,10 @@ public:
 	int GetItemIndex(int Key) const;
 	void InvalidateItem(int Index);
 	int GetItemType(int Index) const;
+	int GetItemType(int Index, const CSnapshotKeyIndex &KeyIndex) const;
 	int GetExternalItemType(int InternalType) const;
 	const void *FindItem(int Type, int Id) const;
+	const void *FindItem(int Type, int Id, const CSnapshotKeyIndex &KeyIndex) const;
 
 	unsigned Crc() const;
 	// Prints the raw snapshot data showing item and int boundaries.
@@ -72,6 +77,35 @@ public:
 	static const CSnapshot *EmptySnapshot() { return &ms_EmptySnapshot; }
 };
 
+// CSnapshotKeyIndex
+
+// Sorted key index of a snapshot for O(log n) item lookups, plus a cache
+// of the extended item types (UUIDs) registered in the snapshot.
+// Must be rebuilt whenever the indexed snapshot changes.
+class CSnapshotKeyIndex
+{
+	enum
+	{
+		MAX_EXTENDED_ITEM_TYPES = 64,
+	};
+
+	int m_aKeys[CSnapshot::MAX_ITEMS];
+	short m_aIndices[CSnapshot::MAX_ITEMS];
+	int m_NumItems = 0;
+
+	int m_aExtendedInternalTypes[MAX_EXTENDED_ITEM_TYPES];
+	int m_aExtendedExternalTypes[MAX_EXTENDED_ITEM_TYPES];
+	int m_NumExtendedItemTypes = 0;
+
+public:
+	void Build(const CSnapshot *pSnapshot);
+	void Clear();
+
+	int GetItemIndex(int Key) const;
+	int GetExternalItemType(int InternalType) const;
+	int GetInternalItemType(int ExternalType) const;
+};
+
 // CSnapshotDelta
 
 class CSnapshotDelta
@@ -97,10 +131,11 @@ private:
 	uint64_t m_aSnapshotDataUpdates[CSnapshot::MAX_TYPE + 1];
 	CData m_Empty;
 
-	static void UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate);
-
 public:
+	// vectorized according to CSimd::Level()
 	static int DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size);
+	static void UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate);
+
 	CSnapshotDelta();
 	CSnapshotDelta(const CSnapshotDelta &Old);
 	uint64_t GetDataRate(int Index) const { return m_aSnapshotDataRate[Index]; }
@@ -108,13 +143,18 @@ public:
 	void SetStaticsize(int ItemType, size_t Size);
 	void SetStaticsize7(int ItemType, size_t Size);
 	const CData *EmptyDelta() const;
-	int CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData);
+	int CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData) const;
 	int UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const void *pSrcData, int DataSize, bool Sixup);
 	int DebugDumpDelta(const void *pSrcData, int DataSize);
 };
 
 // CSnapshotStorage
 
+// Stores the snapshots of the last ticks in order. The holders and their
+// snapshot data are placed together in a ring arena, which is consumed in the
+// same order as the snapshots are added. Snapshots that do not fit into the
+// arena are allocated on the heap, and the arena grows the next time it is
+// empty, so it is sized by the snapshots that are actually stored.
 class CSnapshotStorage
 {
 public:
@@ -132,18 +172,57 @@ public:
 
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+
+		// only set if there is an alternative snapshot
+		CSnapshotKeyIndex *m_pAltSnapIndex;
+
+		// offset of the holder in the arena, -1 if it is on the heap
+		int m_ArenaOffset;
 	};
 
 	CHolder *m_pFirst;
 	CHolder *m_pLast;
 
 	CSnapshotStorage() { Init(); }
-	~CSnapshotStorage() { PurgeAll(); }
+	~CSnapshotStorage();
+	CSnapshotStorage(const CSnapshotStorage &) = delete;
+	CSnapshotStorage &operator=(const CSnapshotStorage &) = delete;
 	void Init();
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData);
 	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const;
+	int ArenaSize() const { return m_ArenaSize; }
+
+	enum
+	{
+		MIN_ARENA_SIZE = 64 * 1024,
+		MAX_ARENA_SIZE = 1024 * 1024,
+	};
+
+private:
+	enum
+	{
+		// must be a power of two
+		TICK_LOOKUP_SIZE = 256,
+	};
+
+	std::unique_ptr<char[]> m_pArena;
+	int m_ArenaSize = 0;
+	// set when a block did not fit into the arena since it was last empty
+	bool m_ArenaFull = false;
+	int m_ArenaHead;
+	int m_ArenaTail;
+	int m_NumArenaHolders;
+	bool m_ArenaWrapped;
+
+	// holders by tick modulo TICK_LOOKUP_SIZE, complete as long as the
+	// stored ticks are increasing and span less than TICK_LOOKUP_SIZE
+	CHolder *m_apTickLookup[TICK_LOOKUP_SIZE];
+	bool m_TicksIncreasing;
+
+	void *AllocateBlock(int Size, int *pArenaOffset);
+	void FreeHolder(CHolder *pHolder);
 };
 
 class CSnapshotBuilder
@@ -178,6 +257,8 @@ public:
 
 	CSnapshotItem *GetItem(int Index);
 	int *GetItemData(int Key);
+	int *GetItemDataByIndex(int Index);
+	int NumItems() const { return m_NumItems; }
 
 	int Finish(void *pSnapdata);
 };
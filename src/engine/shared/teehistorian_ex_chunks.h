@@ -26,3 +26,5 @@ UUID(TEEHISTORIAN_ANTIBOT, "teehistorian-antibot@ddnet.org")
 UUID(TEEHISTORIAN_PLAYER_NAME, "teehistorian-player-name@ddnet.org")
 UUID(TEEHISTORIAN_PLAYER_FINISH, "teehistorian-player-finish@ddnet.org")
 UUID(TEEHISTORIAN_TEAM_FINISH, "teehistorian-team-finish@ddnet.org")
+UUID(TEEHISTORIAN_SAVE_SUCCESS_BINARY, "teehistorian-save-success-binary@ddnet.org")
+UUID(TEEHISTORIAN_LOAD_SUCCESS_BINARY, "teehistorian-load-success-binary@ddnet.org")
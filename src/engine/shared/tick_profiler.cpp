@@ -0,0 +1,80 @@
+#include "tick_profiler.h"
+
+#include <algorithm>
+
+int CTickProfiler::AddSection(const char *pName)
+{
+	for(int i = 0; i < m_NumSections; i++)
+	{
+		if(str_comp(m_aSections[i].m_aName, pName) == 0)
+			return i;
+	}
+	if(m_NumSections == MAX_SECTIONS)
+		return -1;
+	str_copy(m_aSections[m_NumSections].m_aName, pName);
+	return m_NumSections++;
+}
+
+void CTickProfiler::SetEnabled(bool Enabled)
+{
+	m_Enabled = Enabled;
+	m_NumFrames = 0;
+	m_NumSummaryFrames = 0;
+	for(int i = 0; i < m_NumSections; i++)
+	{
+		CSection &Section = m_aSections[i];
+		Section.m_FrameNs = 0;
+		Section.m_FrameActive = false;
+		Section.m_vSamples.clear();
+		Section.m_Stats = CStats();
+	}
+}
+
+void CTickProfiler::EndFrame()
+{
+	if(!m_Enabled)
+		return;
+	m_NumFrames++;
+	for(int i = 0; i < m_NumSections; i++)
+	{
+		CSection &Section = m_aSections[i];
+		if(!Section.m_FrameActive)
+			continue;
+		Section.m_vSamples.push_back(Section.m_FrameNs);
+		Section.m_FrameNs = 0;
+		Section.m_FrameActive = false;
+	}
+}
+
+static int64_t Percentile(std::vector<int64_t> &vSamples, int Percent)
+{
+	// nearest rank, the samples are partially reordered
+	const size_t Rank = (vSamples.size() * Percent + 99) / 100;
+	const auto Nth = vSamples.begin() + (Rank > 0 ? Rank - 1 : 0);
+	std::nth_element(vSamples.begin(), Nth, vSamples.end());
+	return *Nth;
+}
+
+void CTickProfiler::Summarize()
+{
+	m_NumSummaryFrames = m_NumFrames;
+	m_NumFrames = 0;
+	for(int i = 0; i < m_NumSections; i++)
+	{
+		CSection &Section = m_aSections[i];
+		CStats Stats;
+		Stats.m_NumSamples = Section.m_vSamples.size();
+		if(Stats.m_NumSamples > 0)
+		{
+			for(int64_t Sample : Section.m_vSamples)
+			{
+				Stats.m_TotalNs += Sample;
+				Stats.m_MaxNs = std::max(Stats.m_MaxNs, Sample);
+			}
+			Stats.m_P99Ns = Percentile(Section.m_vSamples, 99);
+			Stats.m_P50Ns = Percentile(Section.m_vSamples, 50);
+		}
+		Section.m_Stats = Stats;
+		Section.m_vSamples.clear();
+	}
+}
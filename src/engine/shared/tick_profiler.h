@@ -0,0 +1,127 @@
+#ifndef ENGINE_SHARED_TICK_PROFILER_H
+#define ENGINE_SHARED_TICK_PROFILER_H
+
+#include <base/system.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Measures how long the sections of the server loop take.
+ *
+ * Durations added to a section are summed up per loop iteration ("frame").
+ * Every frame in which a section ran becomes one sample of that section,
+ * and @link Summarize @endlink condenses the samples collected since the
+ * previous summary into percentiles. Sections may be nested, e.g. the
+ * per-entity-type sections of the game world are part of the game tick.
+ */
+class CTickProfiler
+{
+public:
+	enum
+	{
+		MAX_SECTIONS = 32,
+	};
+
+	class CStats
+	{
+	public:
+		int m_NumSamples = 0;
+		int64_t m_TotalNs = 0;
+		int64_t m_P50Ns = 0;
+		int64_t m_P99Ns = 0;
+		int64_t m_MaxNs = 0;
+	};
+
+	/**
+	 * Registers a section, returns the existing index if a section of the
+	 * same name has been registered before or -1 if there are too many.
+	 */
+	int AddSection(const char *pName);
+	int NumSections() const { return m_NumSections; }
+	const char *SectionName(int Section) const { return m_aSections[Section].m_aName; }
+
+	bool Enabled() const { return m_Enabled; }
+	/**
+	 * Enables or disables the profiler, discarding all samples and summaries.
+	 */
+	void SetEnabled(bool Enabled);
+
+	void Add(int Section, std::chrono::nanoseconds Duration)
+	{
+		if(Section < 0)
+			return;
+		m_aSections[Section].m_FrameNs += Duration.count();
+		m_aSections[Section].m_FrameActive = true;
+	}
+
+	void EndFrame();
+
+	/**
+	 * Computes the statistics of the samples since the previous summary and
+	 * starts collecting new samples.
+	 */
+	void Summarize();
+	/**
+	 * @return The statistics of the last summary.
+	 */
+	const CStats &Stats(int Section) const { return m_aSections[Section].m_Stats; }
+	/**
+	 * @return The number of frames in the last summary.
+	 */
+	int NumFrames() const { return m_NumSummaryFrames; }
+
+private:
+	class CSection
+	{
+	public:
+		char m_aName[32];
+		int64_t m_FrameNs = 0;
+		bool m_FrameActive = false;
+		std::vector<int64_t> m_vSamples;
+		CStats m_Stats;
+	};
+
+	CSection m_aSections[MAX_SECTIONS];
+	int m_NumSections = 0;
+	bool m_Enabled = false;
+	int m_NumFrames = 0;
+	int m_NumSummaryFrames = 0;
+};
+
+/**
+ * Adds the lifetime of the scope, or the time until @link Stop @endlink is
+ * called, to a section if the profiler is enabled.
+ */
+class CTickProfileScope
+{
+	CTickProfiler *m_pProfiler;
+	int m_Section;
+	std::chrono::nanoseconds m_Start;
+
+public:
+	CTickProfileScope(CTickProfiler *pProfiler, int Section) :
+		m_pProfiler(pProfiler != nullptr && pProfiler->Enabled() ? pProfiler : nullptr),
+		m_Section(Section),
+		m_Start(m_pProfiler != nullptr ? time_get_nanoseconds() : std::chrono::nanoseconds(0))
+	{
+	}
+
+	~CTickProfileScope()
+	{
+		Stop();
+	}
+
+	void Stop()
+	{
+		if(m_pProfiler != nullptr)
+			m_pProfiler->Add(m_Section, time_get_nanoseconds() - m_Start);
+		m_pProfiler = nullptr;
+	}
+
+	CTickProfileScope(const CTickProfileScope &) = delete;
+	CTickProfileScope &operator=(const CTickProfileScope &) = delete;
+};
+
+#endif
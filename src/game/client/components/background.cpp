@@ -30,7 +30,7 @@ CBackground::~CBackground()
 
 CBackgroundEngineMap *CBackground::CreateBGMap()
 {
-	return new CBackgroundEngineMap;
+	return new CBackgroundEngineMap(Engine());
 }
 
 void CBackground::OnInit()
@@ -16,6 +16,8 @@ class CMapImages;
 class CBackgroundEngineMap : public CMap
 {
 	MACRO_INTERFACE("background_enginemap")
+public:
+	using CMap::CMap;
 };
 
 class CBackground : public CMapLayers
@@ -51,6 +51,7 @@ void CBinds::Bind(int KeyId, const char *pStr, bool FreeOnly, int ModifierCombin
 
 	free(m_aapKeyBindings[ModifierCombination][KeyId]);
 	m_aapKeyBindings[ModifierCombination][KeyId] = nullptr;
+	m_aapCompiledKeyBindings[ModifierCombination][KeyId] = nullptr;
 
 	char aBindName[128];
 	GetKeyBindName(KeyId, ModifierCombination, aBindName, sizeof(aBindName));
@@ -138,7 +139,7 @@ bool CBinds::OnInput(const IInput::CEvent &Event)
 						m_MouseOnAction = true;
 					}
 				}
-				Console()->ExecuteLineStroked(1, pBind);
+				ExecuteBind(CBindSlot(Event.m_Key, Mask), 1);
 				m_vActiveBinds.emplace_back(Event.m_Key, Mask);
 			};
 
@@ -161,7 +162,7 @@ bool CBinds::OnInput(const IInput::CEvent &Event)
 			// Have to check for nullptr again because the previous execute can unbind itself
 			if(m_aapKeyBindings[ActiveBind->m_ModifierMask][ActiveBind->m_Key])
 			{
-				Console()->ExecuteLineStroked(1, m_aapKeyBindings[ActiveBind->m_ModifierMask][ActiveBind->m_Key]);
+				ExecuteBind(*ActiveBind, 1);
 			}
 			Handled = true;
 		}
@@ -183,7 +184,7 @@ bool CBinds::OnInput(const IInput::CEvent &Event)
 			{
 				return;
 			}
-			Console()->ExecuteLineStroked(0, m_aapKeyBindings[Bind.m_ModifierMask][Bind.m_Key]);
+			ExecuteBind(Bind, 0);
 		};
 
 		// Release active bind that uses this primary key
@@ -217,6 +218,18 @@ bool CBinds::OnInput(const IInput::CEvent &Event)
 	return Handled;
 }
 
+void CBinds::ExecuteBind(const CBindSlot &BindSlot, int Stroke)
+{
+	std::shared_ptr<IConsole::ICompiledLine> &pCompiledBind = m_aapCompiledKeyBindings[BindSlot.m_ModifierMask][BindSlot.m_Key];
+	if(!pCompiledBind)
+	{
+		pCompiledBind = Console()->CompileLine(m_aapKeyBindings[BindSlot.m_ModifierMask][BindSlot.m_Key]);
+	}
+	// keep the line alive while it is executed, as it may change the bind itself
+	const std::shared_ptr<IConsole::ICompiledLine> pLine = pCompiledBind;
+	Console()->ExecuteCompiledLineStroked(Stroke, pLine.get());
+}
+
 void CBinds::UnbindAll()
 {
 	for(auto &apKeyBinding : m_aapKeyBindings)
@@ -227,6 +240,13 @@ void CBinds::UnbindAll()
 			pKeyBinding = nullptr;
 		}
 	}
+	for(auto &apCompiledKeyBinding : m_aapCompiledKeyBindings)
+	{
+		for(auto &pCompiledKeyBinding : apCompiledKeyBinding)
+		{
+			pCompiledKeyBinding = nullptr;
+		}
+	}
 }
 
 const char *CBinds::Get(int KeyId, int ModifierCombination) const
@@ -8,6 +8,7 @@
 
 #include <game/client/component.h>
 
+#include <memory>
 #include <vector>
 
 class IConfigManager;
@@ -55,6 +56,8 @@ class CBinds : public CComponent
 	// free buffer after use
 	char *GetKeyBindCommand(int ModifierCombination, int Key) const;
 
+	void ExecuteBind(const CBindSlot &BindSlot, int Stroke);
+
 public:
 	CBinds();
 	~CBinds() override;
@@ -92,6 +95,8 @@ public:
 
 private:
 	char *m_aapKeyBindings[KeyModifier::COMBINATION_COUNT][KEY_LAST];
+	// compiled when the bind is first executed, so its commands are not looked up and parsed every time
+	std::shared_ptr<IConsole::ICompiledLine> m_aapCompiledKeyBindings[KeyModifier::COMBINATION_COUNT][KEY_LAST];
 	std::vector<CBindSlot> m_vActiveBinds;
 };
 #endif
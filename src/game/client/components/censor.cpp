@@ -178,6 +178,7 @@ CCensor::CCensorListDownloadJob::CCensorListDownloadJob(CCensor *pCensor, const
 	str_copy(m_aSaveFilePath, pSaveFilePath);
 	m_vLoadedWords = std::nullopt;
 	Abortable(true);
+	SetPriority(PRIORITY_BACKGROUND);
 }
 
 bool CCensor::CCensorListDownloadJob::Abort()
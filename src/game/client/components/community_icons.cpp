@@ -33,6 +33,7 @@ CCommunityIcons::CCommunityIconLoadJob::CCommunityIconLoadJob(CCommunityIcons *p
 	CAbstractCommunityIconJob(pCommunityIcons, pCommunityId, StorageType)
 {
 	Abortable(true);
+	SetPriority(PRIORITY_BACKGROUND);
 }
 
 CCommunityIcons::CCommunityIconLoadJob::~CCommunityIconLoadJob()
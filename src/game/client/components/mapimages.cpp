@@ -97,6 +97,18 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 
 	const int TextureLoadFlag = Graphics()->Uses2DTextureArrays() ? IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE : IGraphics::TEXLOAD_TO_3D_TEXTURE;
 
+	// decompress the embedded images in parallel, they are uploaded one by one below
+	std::vector<int> vImageData;
+	for(int i = 0; i < m_Count; i++)
+	{
+		const CMapItemImage_v2 *pImg = static_cast<const CMapItemImage_v2 *>(pMap->GetItem(Start + i));
+		if(aTextureUsedByTileOrQuadLayerFlag[i] != 0 && !pImg->m_External)
+		{
+			vImageData.push_back(pImg->m_ImageData);
+		}
+	}
+	pMap->LoadData(vImageData);
+
 	// load new textures
 	bool ShowWarning = false;
 	for(int i = 0; i < m_Count; i++)
@@ -69,7 +69,7 @@ CMenuBackground::CMenuBackground() :
 
 CBackgroundEngineMap *CMenuBackground::CreateBGMap()
 {
-	return new CMenuMap;
+	return new CMenuMap(Engine());
 }
 
 void CMenuBackground::OnInterfacesInit(CGameClient *pClient)
@@ -12,6 +12,8 @@
 class CMenuMap : public CBackgroundEngineMap
 {
 	MACRO_INTERFACE("menu_enginemap")
+public:
+	using CBackgroundEngineMap::CBackgroundEngineMap;
 };
 
 // themes
@@ -19,6 +19,7 @@
 #include <engine/keys.h>
 #include <engine/serverbrowser.h>
 #include <engine/shared/config.h>
+#include <engine/shared/demo.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
 
@@ -1557,6 +1558,15 @@ void CMenus::RenderPopupFullscreen(CUIRect Screen)
 			}
 			else if(Storage()->RenameFile(aBufOld, aBufNew, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
 			{
+				if(!m_vpFilteredDemos[m_DemolistSelectedIndex]->m_IsDir)
+				{
+					char aIndexOld[IO_MAX_PATH_LENGTH];
+					char aIndexNew[IO_MAX_PATH_LENGTH];
+					CDemoRecorder::IndexFilename(aBufOld, aIndexOld, sizeof(aIndexOld));
+					CDemoRecorder::IndexFilename(aBufNew, aIndexNew, sizeof(aIndexNew));
+					if(Storage()->FileExists(aIndexOld, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
+						Storage()->RenameFile(aIndexOld, aIndexNew, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType);
+				}
 				str_copy(m_aCurrentDemoSelectionName, m_DemoRenameInput.GetString());
 				if(!m_vpFilteredDemos[m_DemolistSelectedIndex]->m_IsDir)
 					fs_split_file_extension(m_DemoRenameInput.GetString(), m_aCurrentDemoSelectionName, sizeof(m_aCurrentDemoSelectionName));
@@ -12,6 +12,7 @@
 #include <engine/demo.h>
 #include <engine/graphics.h>
 #include <engine/keys.h>
+#include <engine/shared/demo.h>
 #include <engine/shared/localization.h>
 #include <engine/storage.h>
 #include <engine/textrender.h>
@@ -1670,6 +1671,10 @@ void CMenus::PopupConfirmDeleteDemo()
 	str_format(aBuf, sizeof(aBuf), "%s/%s", m_aCurrentDemoFolder, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_aFilename);
 	if(Storage()->RemoveFile(aBuf, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
 	{
+		char aIndexFilename[IO_MAX_PATH_LENGTH];
+		CDemoRecorder::IndexFilename(aBuf, aIndexFilename, sizeof(aIndexFilename));
+		if(Storage()->FileExists(aIndexFilename, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType))
+			Storage()->RemoveFile(aIndexFilename, m_vpFilteredDemos[m_DemolistSelectedIndex]->m_StorageType);
 		DemolistPopulate();
 		DemolistOnUpdate(false);
 	}
@@ -15,8 +15,10 @@ class CEntity
 
 private:
 	friend CGameWorld; // entity list handling
+	friend CEntityGrid<CEntity>;
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	CEntityGrid<CEntity>::CItem m_GridItem;
 
 protected:
 	CGameWorld *m_pGameWorld;
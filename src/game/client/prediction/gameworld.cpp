@@ -71,13 +71,43 @@ CEntity *CGameWorld::FindLast(int Type)
 	return pLast;
 }
 
+void CGameWorld::SyncGrid()
+{
+	for(auto *pEnt : m_apFirstEntityTypes)
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			m_aGrids[pEnt->m_ObjType].Update(pEnt, pEnt->m_Pos, pEnt->m_ProximityRadius);
+	m_GridDirty = false;
+}
+
+void CGameWorld::EndTraverseEntity()
+{
+	if(m_pTraverseEntity)
+		m_aGrids[m_pTraverseEntity->m_ObjType].Update(m_pTraverseEntity, m_pTraverseEntity->m_Pos, m_pTraverseEntity->m_ProximityRadius);
+	m_pTraverseEntity = nullptr;
+}
+
+const std::vector<CEntity *> &CGameWorld::QueryEntities(int Type, vec2 Min, vec2 Max)
+{
+	if(m_GridDirty)
+		SyncGrid();
+
+	CEntity *pTraverseEntity = m_pTraverseEntity && m_pTraverseEntity->m_ObjType == Type ? m_pTraverseEntity : nullptr;
+	if(!m_aGrids[Type].Query(Min, Max, pTraverseEntity, m_vpQueryEntities))
+	{
+		// the area is too large for the grid to help, fall back to the whole list
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			m_vpQueryEntities.push_back(pEnt);
+	}
+	return m_vpQueryEntities;
+}
+
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+	for(CEntity *pEnt : QueryEntities(Type, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius)))
 	{
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
@@ -123,6 +153,9 @@ void CGameWorld::InsertEntity(CEntity *pEnt, bool Last)
 		pEnt->m_pNextTypeEntity = nullptr;
 	}
 
+	// the grid returns entities in list order
+	m_aGrids[pEnt->m_ObjType].Insert(pEnt, pEnt->m_Pos, pEnt->m_ProximityRadius, Last ? m_LastGridOrder-- : m_FirstGridOrder++);
+
 	if(pEnt->m_ObjType == ENTTYPE_CHARACTER)
 	{
 		auto *pChar = (CCharacter *)pEnt;
@@ -153,6 +186,9 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	// keep list traversing valid
 	if(m_pNextTraverseEntity == pEnt)
 		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+	if(m_pTraverseEntity == pEnt)
+		m_pTraverseEntity = nullptr;
+	m_aGrids[pEnt->m_ObjType].Remove(pEnt);
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
@@ -198,6 +234,10 @@ void CGameWorld::RemoveEntities()
 
 void CGameWorld::Tick()
 {
+	// pick up positions changed from snapshots
+	if(m_GridDirty)
+		SyncGrid();
+
 	// update all objects
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 	{
@@ -209,7 +249,9 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTraverseEntity = pEnt;
 				((CCharacter *)pEnt)->PreTick();
+				EndTraverseEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
@@ -218,7 +260,9 @@ void CGameWorld::Tick()
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			m_pTraverseEntity = pEnt;
 			pEnt->Tick();
+			EndTraverseEntity();
 			pEnt = m_pNextTraverseEntity;
 		}
 	}
@@ -227,7 +271,9 @@ void CGameWorld::Tick()
 		for(; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			m_pTraverseEntity = pEnt;
 			pEnt->TickDeferred();
+			EndTraverseEntity();
 			pEnt->m_SnapTicks++;
 			pEnt = m_pNextTraverseEntity;
 		}
@@ -264,11 +310,14 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 
 CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Type, vec2 &NewPos, const CEntity *pNotThis, int CollideWith, const CEntity *pThisOnly)
 {
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
+	const vec2 Extent = vec2(Radius, Radius);
+	for(CEntity *pEntity : QueryEntities(Type, vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - Extent, vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + Extent))
 	{
 		if(pEntity == pNotThis)
 			continue;
@@ -302,9 +351,10 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
+	const vec2 Extent = vec2(Radius, Radius);
+	for(CEntity *pEnt : QueryEntities(ENTTYPE_CHARACTER, vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - Extent, vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + Extent))
 	{
+		CCharacter *pChr = (CCharacter *)pEnt;
 		if(pChr == pNotThis)
 			continue;
 
@@ -390,6 +440,7 @@ void CGameWorld::NetObjBegin(CTeamsCore Teams, int LocalClientId)
 {
 	m_Teams = Teams;
 	m_LocalClientId = LocalClientId;
+	m_GridDirty = true;
 
 	for(int i = 0; i < NUM_ENTTYPES; i++)
 		for(CEntity *pEnt = FindFirst(i); pEnt; pEnt = pEnt->TypeNext())
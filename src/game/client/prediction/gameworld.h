@@ -3,6 +3,7 @@
 #ifndef GAME_CLIENT_PREDICTION_GAMEWORLD_H
 #define GAME_CLIENT_PREDICTION_GAMEWORLD_H
 
+#include <game/entity_grid.h>
 #include <game/gamecore.h>
 #include <game/teamscore.h>
 
@@ -114,9 +115,22 @@ public:
 private:
 	void RemoveEntities();
 
+	void SyncGrid();
+	void EndTraverseEntity();
+	const std::vector<CEntity *> &QueryEntities(int Type, vec2 Min, vec2 Max);
+
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// kept up to date during Tick like on the server. snapshots assign positions directly, so
+	// NetObjBegin marks the grids dirty and they are synchronized before the next query or tick.
+	CEntityGrid<CEntity> m_aGrids[NUM_ENTTYPES];
+	bool m_GridDirty = false;
+	CEntity *m_pTraverseEntity = nullptr;
+	int64_t m_FirstGridOrder = 0;
+	int64_t m_LastGridOrder = -1;
+	std::vector<CEntity *> m_vpQueryEntities;
+
 	CCharacter *m_apCharacters[MAX_CLIENTS];
 
 	CCollision *m_pCollision;
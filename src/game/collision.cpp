@@ -36,6 +36,69 @@ vec2 ClampVel(int MoveRestriction, vec2 Vel)
 	return Vel;
 }
 
+// The positions the line intersection functions check: `mix(Pos0, Pos1, i / Divisor)` for i in [0, Num).
+// All checks only depend on the tile a position rounds to, so after the first position on a tile
+// was checked the remaining ones can be skipped. Visiting the tiles in order this way gives the
+// same result as checking every position, as positions move monotonically along both axes.
+class CLineSamples
+{
+	vec2 m_Pos0;
+	vec2 m_Pos1;
+	float m_Divisor;
+	int m_Num;
+
+	// tile lookups clamp to the map, so negative positions only need to share a tile key with each other
+	static int TileKey(float Value) { return round_to_int(Value) >> 5; }
+
+	int NextTileOnAxis(int i, int Axis, int Key) const
+	{
+		const float Delta = m_Pos1[Axis] - m_Pos0[Axis];
+		if(Delta == 0.0f)
+			return m_Num;
+
+		// estimate where the rounded position leaves the tile, then correct with the exact positions
+		const float Boundary = Delta > 0.0f ? (Key + 1) * 32 - 0.5f : Key * 32 - 0.5f;
+		const float Estimate = std::ceil((Boundary - m_Pos0[Axis]) / Delta * m_Divisor);
+		int Next;
+		if(!(Estimate < m_Num))
+			Next = m_Num;
+		else if(!(Estimate > i + 1))
+			Next = i + 1;
+		else
+			Next = (int)Estimate;
+
+		while(Next > i + 1 && TileKey(At(Next - 1)[Axis]) != Key)
+			Next--;
+		while(Next < m_Num && TileKey(At(Next)[Axis]) == Key)
+			Next++;
+		return Next;
+	}
+
+public:
+	CLineSamples(vec2 Pos0, vec2 Pos1, float Divisor, int Num) :
+		m_Pos0(Pos0), m_Pos1(Pos1), m_Divisor(Divisor), m_Num(Num)
+	{
+	}
+
+	int Num() const { return m_Num; }
+
+	vec2 At(int i) const
+	{
+		float a = i / m_Divisor;
+		return mix(m_Pos0, m_Pos1, a);
+	}
+
+	// the position before sample i, which is reported as the position before a collision
+	vec2 Before(int i) const { return i == 0 ? m_Pos0 : At(i - 1); }
+
+	// first sample after i on a different tile, Num() if there is none
+	int NextTile(int i) const
+	{
+		const vec2 Pos = At(i);
+		return minimum(NextTileOnAxis(i, 0, TileKey(Pos.x)), NextTileOnAxis(i, 1, TileKey(Pos.y)));
+	}
+};
+
 CCollision::CCollision()
 {
 	m_pDoor = nullptr;
@@ -330,11 +393,10 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	const CLineSamples Samples(Pos0, Pos1, End, End + 1);
+	for(int i = 0; i < Samples.Num(); i = Samples.NextTile(i))
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Samples.At(i);
 		// Temporary position for checking collision
 		int ix = round_to_int(Pos.x);
 		int iy = round_to_int(Pos.y);
@@ -344,11 +406,9 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			return GetCollisionAt(ix, iy);
 		}
-
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -361,13 +421,12 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
+	const CLineSamples Samples(Pos0, Pos1, End, End + 1);
 	int dx = 0, dy = 0; // Offset for checking the "through" tile
 	ThroughOffset(Pos0, Pos1, &dx, &dy);
-	for(int i = 0; i <= End; i++)
+	for(int i = 0; i < Samples.Num(); i = Samples.NextTile(i))
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Samples.At(i);
 		// Temporary position for checking collision
 		int ix = round_to_int(Pos.x);
 		int iy = round_to_int(Pos.y);
@@ -385,7 +444,7 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			return TILE_TELEINHOOK;
 		}
 
@@ -404,11 +463,9 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			return Hit;
 		}
-
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -421,11 +478,10 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	const CLineSamples Samples(Pos0, Pos1, End, End + 1);
+	for(int i = 0; i < Samples.Num(); i = Samples.NextTile(i))
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Samples.At(i);
 		// Temporary position for checking collision
 		int ix = round_to_int(Pos.x);
 		int iy = round_to_int(Pos.y);
@@ -443,7 +499,7 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			return TILE_TELEINWEAPON;
 		}
 
@@ -452,11 +508,9 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			return GetCollisionAt(ix, iy);
 		}
-
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1140,13 +1194,12 @@ void ThroughOffset(vec2 Pos0, vec2 Pos1, int *pOffsetX, int *pOffsetY)
 int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	const CLineSamples Samples(Pos0, Pos1, Distance, DistanceRounded);
+	for(int i = 0; i < Samples.Num(); i = Samples.NextTile(i))
 	{
-		float a = i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Samples.At(i);
 		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, m_Width - 1);
 		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, m_Height - 1);
 		if(GetIndex(Nx, Ny) == TILE_SOLID || GetIndex(Nx, Ny) == TILE_NOHOOK || GetIndex(Nx, Ny) == TILE_NOLASER || GetFrontIndex(Nx, Ny) == TILE_NOLASER)
@@ -1154,13 +1207,12 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			if(GetFrontIndex(Nx, Ny) == TILE_NOLASER)
 				return GetFrontCollisionAt(Pos.x, Pos.y);
 			else
 				return GetCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1172,25 +1224,23 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	const CLineSamples Samples(Pos0, Pos1, Distance, DistanceRounded);
+	for(int i = 0; i < Samples.Num(); i = Samples.NextTile(i))
 	{
-		float a = (float)i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Samples.At(i);
 		if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)) || IsFrontNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
 		{
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
 				return GetCollisionAt(Pos.x, Pos.y);
 			else
 				return GetFrontCollisionAt(Pos.x, Pos.y);
 		}
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1202,19 +1252,18 @@ int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	const CLineSamples Samples(Pos0, Pos1, Distance, DistanceRounded);
+	for(int i = 0; i < Samples.Num(); i = Samples.NextTile(i))
 	{
-		float a = (float)i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
+		vec2 Pos = Samples.At(i);
 		if(IsSolid(round_to_int(Pos.x), round_to_int(Pos.y)) || (!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y))))
 		{
 			if(pOutCollision)
 				*pOutCollision = Pos;
 			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
+				*pOutBeforeCollision = Samples.Before(i);
 			if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y)))
 				return -1;
 			else if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)))
@@ -1222,7 +1271,6 @@ int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pO
 			else
 				return GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y));
 		}
-		Last = Pos;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -0,0 +1,174 @@
+#ifndef GAME_ENTITY_GRID_H
+#define GAME_ENTITY_GRID_H
+
+#include <base/vmath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Uniform grid over entity positions, hashed into a fixed number of buckets so it
+// does not depend on the map size. Each entity embeds a CItem named m_GridItem.
+// The grid only knows the position an entity had at its last Insert/Update, the
+// owner is responsible for updating entities after they moved.
+template<typename TEntity>
+class CEntityGrid
+{
+public:
+	enum
+	{
+		CELL_SIZE = 256,
+		NUM_BUCKETS = 256,
+		// keeps cell coordinates in int range for far away or invalid positions
+		MAX_CELL = 1 << 20,
+	};
+
+	class CItem
+	{
+		friend CEntityGrid;
+
+		TEntity *m_pPrev = nullptr;
+		TEntity *m_pNext = nullptr;
+		int m_Bucket = -1;
+		int m_CellX = 0;
+		int m_CellY = 0;
+		// entities are returned sorted by descending order
+		int64_t m_Order = 0;
+
+	public:
+		CItem() = default;
+		// copied entities are not part of the grid until they are inserted themselves
+		CItem(const CItem &Other) {}
+		CItem &operator=(const CItem &Other) { return *this; }
+
+		bool Inserted() const { return m_Bucket != -1; }
+	};
+
+	CEntityGrid()
+	{
+		std::fill(std::begin(m_apBuckets), std::end(m_apBuckets), nullptr);
+	}
+
+	int Num() const { return m_Num; }
+
+	void Insert(TEntity *pEnt, vec2 Pos, float Radius, int64_t Order)
+	{
+		CItem &Item = pEnt->m_GridItem;
+		Item.m_Order = Order;
+		Item.m_CellX = Cell(Pos.x);
+		Item.m_CellY = Cell(Pos.y);
+		Link(pEnt);
+		m_MaxRadius = std::max(m_MaxRadius, Radius);
+		m_Num++;
+	}
+
+	void Remove(TEntity *pEnt)
+	{
+		if(!pEnt->m_GridItem.Inserted())
+			return;
+		Unlink(pEnt);
+		m_Num--;
+	}
+
+	void Update(TEntity *pEnt, vec2 Pos, float Radius)
+	{
+		CItem &Item = pEnt->m_GridItem;
+		if(!Item.Inserted())
+			return;
+		m_MaxRadius = std::max(m_MaxRadius, Radius);
+		const int CellX = Cell(Pos.x);
+		const int CellY = Cell(Pos.y);
+		if(CellX == Item.m_CellX && CellY == Item.m_CellY)
+			return;
+		Unlink(pEnt);
+		Item.m_CellX = CellX;
+		Item.m_CellY = CellY;
+		Link(pEnt);
+	}
+
+	// Collects all entities that were last seen within the box grown by the largest
+	// entity radius, plus pAlways if set, sorted by descending order. Returns false
+	// without collecting anything if the box covers more cells than there are entities.
+	bool Query(vec2 Min, vec2 Max, TEntity *pAlways, std::vector<TEntity *> &vpEntities) const
+	{
+		vpEntities.clear();
+		const float Padding = m_MaxRadius + 1.0f;
+		const int MinX = Cell(Min.x - Padding);
+		const int MinY = Cell(Min.y - Padding);
+		const int MaxX = Cell(Max.x + Padding);
+		const int MaxY = Cell(Max.y + Padding);
+		if(MaxX < MinX || MaxY < MinY)
+			return true;
+		if((int64_t)(MaxX - MinX + 1) * (MaxY - MinY + 1) > m_Num)
+			return false;
+
+		for(int y = MinY; y <= MaxY; y++)
+		{
+			for(int x = MinX; x <= MaxX; x++)
+			{
+				// buckets are shared by several cells, so check the cell as well to not add entities twice
+				for(TEntity *pEnt = m_apBuckets[Bucket(x, y)]; pEnt; pEnt = pEnt->m_GridItem.m_pNext)
+				{
+					if(pEnt->m_GridItem.m_CellX == x && pEnt->m_GridItem.m_CellY == y && pEnt != pAlways)
+						vpEntities.push_back(pEnt);
+				}
+			}
+		}
+		if(pAlways && pAlways->m_GridItem.Inserted())
+			vpEntities.push_back(pAlways);
+
+		std::sort(vpEntities.begin(), vpEntities.end(), [](const TEntity *pA, const TEntity *pB) {
+			return pA->m_GridItem.m_Order > pB->m_GridItem.m_Order;
+		});
+		return true;
+	}
+
+private:
+	TEntity *m_apBuckets[NUM_BUCKETS];
+	float m_MaxRadius = 0.0f;
+	int m_Num = 0;
+
+	static int Cell(float Value)
+	{
+		float Cell = std::floor(Value / CELL_SIZE);
+		// written so that NaN ends up in a valid cell too
+		if(!(Cell > -MAX_CELL))
+			Cell = -MAX_CELL;
+		if(!(Cell < MAX_CELL))
+			Cell = MAX_CELL;
+		return (int)Cell;
+	}
+
+	static int Bucket(int CellX, int CellY)
+	{
+		return (int)(((unsigned)CellX * 73856093u) ^ ((unsigned)CellY * 19349663u)) & (NUM_BUCKETS - 1);
+	}
+
+	void Link(TEntity *pEnt)
+	{
+		CItem &Item = pEnt->m_GridItem;
+		Item.m_Bucket = Bucket(Item.m_CellX, Item.m_CellY);
+		Item.m_pPrev = nullptr;
+		Item.m_pNext = m_apBuckets[Item.m_Bucket];
+		if(Item.m_pNext)
+			Item.m_pNext->m_GridItem.m_pPrev = pEnt;
+		m_apBuckets[Item.m_Bucket] = pEnt;
+	}
+
+	void Unlink(TEntity *pEnt)
+	{
+		CItem &Item = pEnt->m_GridItem;
+		if(Item.m_pPrev)
+			Item.m_pPrev->m_GridItem.m_pNext = Item.m_pNext;
+		else
+			m_apBuckets[Item.m_Bucket] = Item.m_pNext;
+		if(Item.m_pNext)
+			Item.m_pNext->m_GridItem.m_pPrev = Item.m_pPrev;
+		Item.m_pPrev = nullptr;
+		Item.m_pNext = nullptr;
+		Item.m_Bucket = -1;
+	}
+};
+
+#endif
@@ -1590,6 +1590,7 @@ void CGameContext::ConShowOthers(IConsole::IResult *pResult, void *pUserData)
 			pPlayer->m_ShowOthers = pResult->GetInteger(0);
 		else
 			pPlayer->m_ShowOthers = !pPlayer->m_ShowOthers;
+		pSelf->m_pController->Teams().InvalidateTeamMasks();
 	}
 	else
 		pSelf->Console()->Print(
@@ -1640,6 +1641,7 @@ void CGameContext::ConSpecTeam(IConsole::IResult *pResult, void *pUserData)
 		pPlayer->m_SpecTeam = pResult->GetInteger(0);
 	else
 		pPlayer->m_SpecTeam = !pPlayer->m_SpecTeam;
+	pSelf->m_pController->Teams().InvalidateTeamMasks();
 }
 
 void CGameContext::ConSayTime(IConsole::IResult *pResult, void *pUserData)
@@ -35,6 +35,10 @@ CCharacter::CCharacter(CGameWorld *pWorld, CNetObj_PlayerInput LastInput) :
 	m_TriggeredEvents7 = 0;
 	m_StrongWeakId = 0;
 
+	mem_zero(&m_SnapCore, sizeof(m_SnapCore));
+	m_SnapEmote = EMOTE_NORMAL;
+	mem_zero(&m_SnapDDNetCharacter, sizeof(m_SnapDDNetCharacter));
+
 	m_Input = LastInput;
 	// never initialize both to zero
 	m_Input.m_TargetX = 0;
@@ -174,6 +178,7 @@ void CCharacter::SetSolo(bool Solo)
 {
 	m_Core.m_Solo = Solo;
 	Teams()->m_Core.SetSolo(m_pPlayer->GetCid(), Solo);
+	Teams()->InvalidateTeamMasks();
 }
 
 void CCharacter::SetSuper(bool Super)
@@ -1070,21 +1075,8 @@ void CCharacter::CancelSwapRequests()
 void CCharacter::SnapCharacter(int SnappingClient, int Id)
 {
 	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
-	CCharacterCore *pCore;
 	int Weapon = m_Core.m_ActiveWeapon, AmmoCount = 0,
 	    Health = 0, Armor = 0;
-	int Emote = DetermineEyeEmote();
-	int Tick;
-	if(!m_ReckoningTick || GameServer()->m_World.m_Paused)
-	{
-		Tick = 0;
-		pCore = &m_Core;
-	}
-	else
-	{
-		Tick = m_ReckoningTick;
-		pCore = &m_SendCore;
-	}
 
 	// use ninja graphic for old clients if player is frozen
 	if(m_Core.m_DeepFrozen || m_FreezeTime > 0 || m_Core.m_LiveFrozen)
@@ -1140,10 +1132,8 @@ void CCharacter::SnapCharacter(int SnappingClient, int Id)
 		if(!pCharacter)
 			return;
 
-		pCore->Write(pCharacter);
-
-		pCharacter->m_Tick = Tick;
-		pCharacter->m_Emote = Emote;
+		*static_cast<CNetObj_CharacterCore *>(pCharacter) = m_SnapCore;
+		pCharacter->m_Emote = m_SnapEmote;
 
 		if(pCharacter->m_HookedPlayer != -1)
 		{
@@ -1165,7 +1155,7 @@ void CCharacter::SnapCharacter(int SnappingClient, int Id)
 		if(!pCharacter)
 			return;
 
-		pCore->Write(reinterpret_cast<CNetObj_CharacterCore *>(static_cast<protocol7::CNetObj_CharacterCore *>(pCharacter)));
+		*reinterpret_cast<CNetObj_CharacterCore *>(static_cast<protocol7::CNetObj_CharacterCore *>(pCharacter)) = m_SnapCore;
 		if(pCharacter->m_Angle > (int)(pi * 256.0f))
 		{
 			pCharacter->m_Angle -= (int)(2.0f * pi * 256.0f);
@@ -1175,8 +1165,7 @@ void CCharacter::SnapCharacter(int SnappingClient, int Id)
 		// will consider invalid. https://github.com/ddnet/ddnet/issues/3915
 		pCharacter->m_HookTick = maximum(0, pCharacter->m_HookTick);
 
-		pCharacter->m_Tick = Tick;
-		pCharacter->m_Emote = Emote;
+		pCharacter->m_Emote = m_SnapEmote;
 		pCharacter->m_AttackTick = m_AttackTick;
 		pCharacter->m_Direction = m_Input.m_Direction;
 		pCharacter->m_Weapon = Weapon;
@@ -1243,29 +1232,28 @@ bool CCharacter::IsSnappingCharacterInView(int SnappingClientId)
 	return true;
 }
 
-void CCharacter::Snap(int SnappingClient)
+void CCharacter::PreSnap()
 {
-	int Id = m_pPlayer->GetCid();
-
-	if(!Server()->Translate(Id, SnappingClient))
-		return;
-
-	if(!CanSnapCharacter(SnappingClient))
+	// the same character and DDNet character data is sent to every client,
+	// only the fields depending on the snapping client are set in Snap
+	const CCharacterCore *pCore;
+	int Tick;
+	if(!m_ReckoningTick || GameServer()->m_World.m_Paused)
 	{
-		return;
+		Tick = 0;
+		pCore = &m_Core;
 	}
+	else
+	{
+		Tick = m_ReckoningTick;
+		pCore = &m_SendCore;
+	}
+	pCore->Write(&m_SnapCore);
+	m_SnapCore.m_Tick = Tick;
+	m_SnapEmote = DetermineEyeEmote();
 
-	// always snap the snapping client, even if it is not in view
-	if(!IsSnappingCharacterInView(SnappingClient) && Id != SnappingClient)
-		return;
-
-	SnapCharacter(SnappingClient, Id);
-
-	CNetObj_DDNetCharacter *pDDNetCharacter = Server()->SnapNewItem<CNetObj_DDNetCharacter>(Id);
-	if(!pDDNetCharacter)
-		return;
-
-	pDDNetCharacter->m_Flags = 0;
+	CNetObj_DDNetCharacter *pDDNetCharacter = &m_SnapDDNetCharacter;
+	mem_zero(pDDNetCharacter, sizeof(*pDDNetCharacter));
 	if(m_Core.m_Solo)
 		pDDNetCharacter->m_Flags |= CHARACTERFLAG_SOLO;
 	if(m_Core.m_Super)
@@ -1339,10 +1327,35 @@ void CCharacter::Snap(int SnappingClient)
 	pDDNetCharacter->m_TargetX = m_Core.m_Input.m_TargetX;
 	pDDNetCharacter->m_TargetY = m_Core.m_Input.m_TargetY;
 
-	// -1 is the default value, SnapNewItem zeroes the object, so it would incorrectly become 0
+	// -1 is the default value, zeroing the object would incorrectly make it 0
 	pDDNetCharacter->m_TuneZoneOverride = -1;
 }
 
+void CCharacter::Snap(int SnappingClient)
+{
+	int Id = m_pPlayer->GetCid();
+
+	if(!Server()->Translate(Id, SnappingClient))
+		return;
+
+	if(!CanSnapCharacter(SnappingClient))
+	{
+		return;
+	}
+
+	// always snap the snapping client, even if it is not in view
+	if(!IsSnappingCharacterInView(SnappingClient) && Id != SnappingClient)
+		return;
+
+	SnapCharacter(SnappingClient, Id);
+
+	CNetObj_DDNetCharacter *pDDNetCharacter = Server()->SnapNewItem<CNetObj_DDNetCharacter>(Id);
+	if(!pDDNetCharacter)
+		return;
+
+	*pDDNetCharacter = m_SnapDDNetCharacter;
+}
+
 void CCharacter::PostGlobalSnap()
 {
 	m_TriggeredEvents7 = 0;
@@ -40,6 +40,7 @@ public:
 	void Tick() override;
 	void TickDeferred() override;
 	void TickPaused() override;
+	void PreSnap() override;
 	void Snap(int SnappingClient) override;
 	void SwapClients(int Client1, int Client2) override;
 
@@ -167,6 +168,11 @@ private:
 	CCharacterCore m_SendCore; // core that we should send
 	CCharacterCore m_ReckoningCore; // the dead reckoning core
 
+	// snapshot data shared by all snapping clients, filled in PreSnap
+	CNetObj_CharacterCore m_SnapCore;
+	int m_SnapEmote;
+	CNetObj_DDNetCharacter m_SnapDDNetCharacter;
+
 	// DDRace
 
 	void SnapCharacter(int SnappingClient, int Id);
@@ -77,11 +77,6 @@ void CDraggerBeam::Tick()
 	}
 }
 
-void CDraggerBeam::SetPos(vec2 Pos)
-{
-	m_Pos = Pos;
-}
-
 void CDraggerBeam::Reset()
 {
 	m_MarkedForDestroy = true;
@@ -273,6 +273,18 @@ void CLaser::TickPaused()
 	++m_EvalTick;
 }
 
+void CLaser::PreSnap()
+{
+	CCharacter *pOwnerChar = nullptr;
+	m_SnapTeamMask = CClientMask().set();
+
+	if(m_Owner >= 0)
+		pOwnerChar = GameServer()->GetPlayerChar(m_Owner);
+
+	if(pOwnerChar && pOwnerChar->IsAlive())
+		m_SnapTeamMask = pOwnerChar->TeamMask();
+}
+
 void CLaser::Snap(int SnappingClient)
 {
 	if(NetworkClipped(SnappingClient) && NetworkClipped(SnappingClient, m_From))
@@ -283,16 +295,7 @@ void CLaser::Snap(int SnappingClient)
 	if(!pOwnerChar)
 		return;
 
-	pOwnerChar = nullptr;
-	CClientMask TeamMask = CClientMask().set();
-
-	if(m_Owner >= 0)
-		pOwnerChar = GameServer()->GetPlayerChar(m_Owner);
-
-	if(pOwnerChar && pOwnerChar->IsAlive())
-		TeamMask = pOwnerChar->TeamMask();
-
-	if(SnappingClient != SERVER_DEMO_CLIENT && !TeamMask.test(SnappingClient))
+	if(SnappingClient != SERVER_DEMO_CLIENT && !m_SnapTeamMask.test(SnappingClient))
 		return;
 
 	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
@@ -13,6 +13,7 @@ public:
 	void Reset() override;
 	void Tick() override;
 	void TickPaused() override;
+	void PreSnap() override;
 	void Snap(int SnappingClient) override;
 	void SwapClients(int Client1, int Client2) override;
 
@@ -32,6 +33,7 @@ private:
 	int m_EvalTick;
 	int m_Owner;
 	CClientMask m_TeamMask;
+	CClientMask m_SnapTeamMask; // shared by all snapping clients, filled in PreSnap
 	bool m_ZeroEnergyBounceInLastTick;
 
 	// DDRace
@@ -278,11 +278,24 @@ void CProjectile::FillInfo(CNetObj_Projectile *pProj)
 	pProj->m_Type = m_Type;
 }
 
-void CProjectile::Snap(int SnappingClient)
+void CProjectile::PreSnap()
 {
 	float Ct = (Server()->Tick() - m_StartTick) / (float)Server()->TickSpeed();
+	m_SnapPos = GetPos(Ct);
+
+	CCharacter *pOwnerChar = nullptr;
+	m_SnapTeamMask = CClientMask().set();
+
+	if(m_Owner >= 0)
+		pOwnerChar = GameServer()->GetPlayerChar(m_Owner);
 
-	if(NetworkClipped(SnappingClient, GetPos(Ct)))
+	if(pOwnerChar && pOwnerChar->IsAlive())
+		m_SnapTeamMask = pOwnerChar->TeamMask();
+}
+
+void CProjectile::Snap(int SnappingClient)
+{
+	if(NetworkClipped(SnappingClient, m_SnapPos))
 		return;
 
 	int SnappingClientVersion = GameServer()->GetClientVersion(SnappingClient);
@@ -294,16 +307,7 @@ void CProjectile::Snap(int SnappingClient)
 			return;
 	}
 
-	CCharacter *pOwnerChar = nullptr;
-	CClientMask TeamMask = CClientMask().set();
-
-	if(m_Owner >= 0)
-		pOwnerChar = GameServer()->GetPlayerChar(m_Owner);
-
-	if(pOwnerChar && pOwnerChar->IsAlive())
-		TeamMask = pOwnerChar->TeamMask();
-
-	if(SnappingClient != SERVER_DEMO_CLIENT && m_Owner != -1 && !TeamMask.test(SnappingClient))
+	if(SnappingClient != SERVER_DEMO_CLIENT && m_Owner != -1 && !m_SnapTeamMask.test(SnappingClient))
 		return;
 
 	CNetObj_DDRaceProjectile DDRaceProjectile;
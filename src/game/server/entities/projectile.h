@@ -28,6 +28,7 @@ public:
 	void Reset() override;
 	void Tick() override;
 	void TickPaused() override;
+	void PreSnap() override;
 	void Snap(int SnappingClient) override;
 	void SwapClients(int Client1, int Client2) override;
 
@@ -50,6 +51,10 @@ private:
 	bool m_IsSolo;
 	vec2 m_InitDir;
 
+	// shared by all snapping clients, filled in PreSnap
+	vec2 m_SnapPos;
+	CClientMask m_SnapTeamMask;
+
 public:
 	void SetBouncing(int Value);
 	bool FillExtraInfoLegacy(CNetObj_DDRaceProjectile *pProj);
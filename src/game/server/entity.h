@@ -23,8 +23,10 @@ class CEntity
 
 private:
 	friend CGameWorld; // entity list handling
+	friend CEntityGrid<CEntity>;
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	CEntityGrid<CEntity>::CItem m_GridItem;
 
 	/* Identity */
 	CGameWorld *m_pGameWorld;
@@ -78,6 +80,14 @@ public: // TODO: Maybe make protected
 
 	/* Other functions */
 
+	/*
+		Function: SetPos
+			Moves the entity and updates its cell in the world's
+			grid. Use this instead of assigning m_Pos when moving
+			an entity from outside of its own callbacks.
+	*/
+	void SetPos(vec2 Pos);
+
 	/*
 		Function: Destroy
 			Destroys the entity.
@@ -110,6 +120,14 @@ public: // TODO: Maybe make protected
 	*/
 	virtual void TickPaused() {}
 
+	/*
+		Function: PreSnap
+			Called once per snapshot tick before Snap is called for
+			the individual clients. Data which does not depend on the
+			snapping client should be computed here and reused by Snap.
+	*/
+	virtual void PreSnap() {}
+
 	/*
 		Function: Snap
 			Called when a new snapshot is being generated for a specific
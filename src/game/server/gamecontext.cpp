@@ -21,6 +21,7 @@
 #include <engine/server/server.h>
 #include <engine/shared/config.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/gzip_frame_writer.h>
 #include <engine/shared/json.h>
 #include <engine/shared/linereader.h>
 #include <engine/shared/memheap.h>
@@ -125,6 +126,7 @@ CGameContext::CGameContext(bool Resetting) :
 
 	m_aDeleteTempfile[0] = 0;
 	m_TeeHistorianActive = false;
+	m_pTeeHistorianCompressedFile = nullptr;
 }
 
 CGameContext::~CGameContext()
@@ -173,7 +175,10 @@ void CGameContext::Clear()
 void CGameContext::TeeHistorianWrite(const void *pData, int DataSize, void *pUser)
 {
 	CGameContext *pSelf = (CGameContext *)pUser;
-	aio_write(pSelf->m_pTeeHistorianFile, pData, DataSize);
+	if(pSelf->m_pTeeHistorianCompressedFile)
+		pSelf->m_pTeeHistorianCompressedFile->Write(pData, DataSize);
+	else
+		aio_write(pSelf->m_pTeeHistorianFile, pData, DataSize);
 }
 
 void CGameContext::CommandCallback(int ClientId, int FlagMask, const char *pCmd, IConsole::IResult *pResult, void *pUser)
@@ -855,11 +860,25 @@ void CGameContext::StartVote(const char *pDesc, const char *pCommand, const char
 	str_copy(m_aVoteReason, pReason, sizeof(m_aVoteReason));
 	SendVoteSet(-1);
 	m_VoteUpdate = true;
+
+	// load the map of map votes in the background, so changing to it does not stall the server
+	Console()->ParseLine(pCommand, PreloadVoteMap, this);
+}
+
+void CGameContext::PreloadVoteMap(const IConsole::ICommandInfo *pCommand, IConsole::IResult *pResult, void *pUserData)
+{
+	if(pResult->NumArguments() == 0 || (str_comp(pCommand->Name(), "change_map") != 0 && str_comp(pCommand->Name(), "sv_map") != 0))
+		return;
+	// the last map command of the vote wins, like when it is executed
+	static_cast<CGameContext *>(pUserData)->Server()->PreloadMap(pResult->GetString(0));
 }
 
 void CGameContext::EndVote()
 {
 	m_VoteCloseTime = 0;
+	// the map of a map vote is only needed if the vote passed
+	if(m_VoteEnforce != VOTE_ENFORCE_YES && m_VoteEnforce != VOTE_ENFORCE_YES_ADMIN)
+		Server()->CancelMapPreload();
 	SendVoteSet(-1);
 }
 
@@ -1073,11 +1092,22 @@ void CGameContext::OnTick()
 
 	if(m_TeeHistorianActive)
 	{
-		int Error = aio_error(m_pTeeHistorianFile);
-		if(Error)
+		if(m_pTeeHistorianCompressedFile)
+		{
+			if(m_pTeeHistorianCompressedFile->Error())
+			{
+				dbg_msg("teehistorian", "error compressing or writing to file");
+				Server()->SetErrorShutdown("teehistorian io error");
+			}
+		}
+		else
 		{
-			dbg_msg("teehistorian", "error writing to file, err=%d", Error);
-			Server()->SetErrorShutdown("teehistorian io error");
+			int Error = aio_error(m_pTeeHistorianFile);
+			if(Error)
+			{
+				dbg_msg("teehistorian", "error writing to file, err=%d", Error);
+				Server()->SetErrorShutdown("teehistorian io error");
+			}
 		}
 
 		if(!m_TeeHistorian.Starting())
@@ -1661,6 +1691,7 @@ void CGameContext::OnClientEnter(int ClientId)
 				SendChatTarget(ClientId, "You can see other players. To disable this use DDNet client and type /showothers");
 
 			m_apPlayers[ClientId]->m_ShowOthers = g_Config.m_SvShowOthersDefault;
+			m_pController->Teams().InvalidateTeamMasks();
 		}
 	}
 	m_VoteUpdate = true;
@@ -1815,6 +1846,7 @@ void CGameContext::OnClientDrop(int ClientId, const char *pReason)
 	m_pController->OnPlayerDisconnect(m_apPlayers[ClientId], pReason);
 	delete m_apPlayers[ClientId];
 	m_apPlayers[ClientId] = nullptr;
+	m_pController->Teams().InvalidateTeamMasks();
 
 	delete m_apSavedTeams[ClientId];
 	m_apSavedTeams[ClientId] = nullptr;
@@ -2700,6 +2732,7 @@ void CGameContext::OnShowOthersLegacyNetMessage(const CNetMsg_Cl_ShowOthersLegac
 	{
 		CPlayer *pPlayer = m_apPlayers[ClientId];
 		pPlayer->m_ShowOthers = pMsg->m_Show;
+		m_pController->Teams().InvalidateTeamMasks();
 	}
 }
 
@@ -2709,6 +2742,7 @@ void CGameContext::OnShowOthersNetMessage(const CNetMsg_Cl_ShowOthers *pMsg, int
 	{
 		CPlayer *pPlayer = m_apPlayers[ClientId];
 		pPlayer->m_ShowOthers = pMsg->m_Show;
+		m_pController->Teams().InvalidateTeamMasks();
 	}
 }
 
@@ -4200,8 +4234,9 @@ void CGameContext::OnInit(const void *pPersistentData)
 		char aGameUuid[UUID_MAXSTRSIZE];
 		FormatUuid(m_GameUuid, aGameUuid, sizeof(aGameUuid));
 
+		const bool Compressed = g_Config.m_SvTeeHistorianCompression > 0;
 		char aFilename[IO_MAX_PATH_LENGTH];
-		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian", aGameUuid);
+		str_format(aFilename, sizeof(aFilename), "teehistorian/%s.teehistorian%s", aGameUuid, Compressed ? ".gz" : "");
 
 		IOHANDLE THFile = Storage()->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 		if(!THFile)
@@ -4214,7 +4249,16 @@ void CGameContext::OnInit(const void *pPersistentData)
 		{
 			dbg_msg("teehistorian", "recording to '%s'", aFilename);
 		}
-		m_pTeeHistorianFile = aio_new(THFile);
+		if(Compressed)
+		{
+			m_pTeeHistorianFile = nullptr;
+			m_pTeeHistorianCompressedFile = new CGzipFrameWriter(THFile, g_Config.m_SvTeeHistorianCompression);
+		}
+		else
+		{
+			m_pTeeHistorianFile = aio_new(THFile);
+			m_pTeeHistorianCompressedFile = nullptr;
+		}
 
 		char aVersion[128];
 		if(GIT_SHORTREV_HASH)
@@ -4380,6 +4424,7 @@ CPlayer *CGameContext::CreatePlayer(int ClientId, int StartTeam, bool Afk, int L
 	m_apPlayers[ClientId]->SetInitialAfk(Afk);
 	m_apPlayers[ClientId]->m_LastWhisperTo = LastWhisperTo;
 	m_NextUniqueClientId += 1;
+	m_pController->Teams().InvalidateTeamMasks();
 	return m_apPlayers[ClientId];
 }
 
@@ -4533,15 +4578,29 @@ void CGameContext::OnShutdown(void *pPersistentData)
 	if(m_TeeHistorianActive)
 	{
 		m_TeeHistorian.Finish();
-		aio_close(m_pTeeHistorianFile);
-		aio_wait(m_pTeeHistorianFile);
-		int Error = aio_error(m_pTeeHistorianFile);
-		if(Error)
+		if(m_pTeeHistorianCompressedFile)
+		{
+			m_pTeeHistorianCompressedFile->Close();
+			if(m_pTeeHistorianCompressedFile->Error())
+			{
+				dbg_msg("teehistorian", "error closing file");
+				Server()->SetErrorShutdown("teehistorian close error");
+			}
+			delete m_pTeeHistorianCompressedFile;
+			m_pTeeHistorianCompressedFile = nullptr;
+		}
+		else
 		{
-			dbg_msg("teehistorian", "error closing file, err=%d", Error);
-			Server()->SetErrorShutdown("teehistorian close error");
+			aio_close(m_pTeeHistorianFile);
+			aio_wait(m_pTeeHistorianFile);
+			int Error = aio_error(m_pTeeHistorianFile);
+			if(Error)
+			{
+				dbg_msg("teehistorian", "error closing file, err=%d", Error);
+				Server()->SetErrorShutdown("teehistorian close error");
+			}
+			aio_free(m_pTeeHistorianFile);
 		}
-		aio_free(m_pTeeHistorianFile);
 	}
 
 	// Stop any demos being recorded.
@@ -4592,6 +4651,11 @@ void CGameContext::LoadMapSettings()
 	Console()->ExecuteFile(aBuf, IConsole::CLIENT_ID_NO_GAME);
 }
 
+void CGameContext::OnPreSnap()
+{
+	m_World.PreSnap();
+}
+
 void CGameContext::OnSnap(int ClientId, bool GlobalSnap)
 {
 	// sixup should only snap during global snap
@@ -120,7 +120,9 @@ class CGameContext : public IGameServer
 
 	bool m_TeeHistorianActive;
 	CTeeHistorian m_TeeHistorian;
+	// one of them is used, depending on whether the file is compressed
 	ASYNCIO *m_pTeeHistorianFile;
+	class CGzipFrameWriter *m_pTeeHistorianCompressedFile;
 	CUuid m_GameUuid;
 	CMapBugs m_MapBugs;
 	CPrng m_Prng;
@@ -229,6 +231,7 @@ public:
 
 	// voting
 	void StartVote(const char *pDesc, const char *pCommand, const char *pReason, const char *pSixupDesc);
+	static void PreloadVoteMap(const IConsole::ICommandInfo *pCommand, IConsole::IResult *pResult, void *pUserData);
 	void EndVote();
 	void SendVoteSet(int ClientId);
 	void SendVoteStatus(int ClientId, int Total, int Yes, int No);
@@ -324,6 +327,7 @@ public:
 	void OnShutdown(void *pPersistentData) override;
 
 	void OnTick() override;
+	void OnPreSnap() override;
 	void OnSnap(int ClientId, bool GlobalSnap) override;
 	void OnPostGlobalSnap() override;
 
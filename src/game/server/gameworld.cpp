@@ -9,6 +9,7 @@
 #include "gamecontroller.h"
 
 #include <engine/shared/config.h>
+#include <engine/shared/tick_profiler.h>
 
 #include <game/collision.h>
 
@@ -28,6 +29,8 @@ CGameWorld::CGameWorld()
 	m_ResetRequested = false;
 	for(auto &pFirstEntityType : m_apFirstEntityTypes)
 		pFirstEntityType = nullptr;
+	for(int &ProfileSection : m_aProfileSections)
+		ProfileSection = -1;
 }
 
 CGameWorld::~CGameWorld()
@@ -43,6 +46,10 @@ void CGameWorld::SetGameServer(CGameContext *pGameServer)
 	m_pGameServer = pGameServer;
 	m_pConfig = m_pGameServer->Config();
 	m_pServer = m_pGameServer->Server();
+
+	static const char *const s_apProfileSectionNames[NUM_ENTTYPES] = {"world.projectile", "world.laser", "world.pickup", "world.flag", "world.character"};
+	for(int i = 0; i < NUM_ENTTYPES; i++)
+		m_aProfileSections[i] = m_pServer->TickProfiler()->AddSection(s_apProfileSectionNames[i]);
 }
 
 void CGameWorld::Init(CCollision *pCollision, CTuningParams *pTuningList)
@@ -56,13 +63,44 @@ CEntity *CGameWorld::FindFirst(int Type)
 	return Type < 0 || Type >= NUM_ENTTYPES ? nullptr : m_apFirstEntityTypes[Type];
 }
 
+void CGameWorld::UpdateEntityGrid(CEntity *pEnt)
+{
+	m_aGrids[pEnt->m_ObjType].Update(pEnt, pEnt->m_Pos, pEnt->m_ProximityRadius);
+}
+
+void CGameWorld::SyncGrid()
+{
+	for(auto *pEnt : m_apFirstEntityTypes)
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			UpdateEntityGrid(pEnt);
+}
+
+void CGameWorld::EndTraverseEntity()
+{
+	if(m_pTraverseEntity)
+		UpdateEntityGrid(m_pTraverseEntity);
+	m_pTraverseEntity = nullptr;
+}
+
+const std::vector<CEntity *> &CGameWorld::QueryEntities(int Type, vec2 Min, vec2 Max)
+{
+	CEntity *pTraverseEntity = m_pTraverseEntity && m_pTraverseEntity->m_ObjType == Type ? m_pTraverseEntity : nullptr;
+	if(!m_aGrids[Type].Query(Min, Max, pTraverseEntity, m_vpQueryEntities))
+	{
+		// the area is too large for the grid to help, fall back to the whole list
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			m_vpQueryEntities.push_back(pEnt);
+	}
+	return m_vpQueryEntities;
+}
+
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
 		return 0;
 
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+	for(CEntity *pEnt : QueryEntities(Type, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius)))
 	{
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
@@ -90,6 +128,9 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = nullptr;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+
+	// later insertions come first in the list
+	m_aGrids[pEnt->m_ObjType].Insert(pEnt, pEnt->m_Pos, pEnt->m_ProximityRadius, m_NextGridOrder++);
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
@@ -109,12 +150,26 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	// keep list traversing valid
 	if(m_pNextTraverseEntity == pEnt)
 		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+	if(m_pTraverseEntity == pEnt)
+		m_pTraverseEntity = nullptr;
+	m_aGrids[pEnt->m_ObjType].Remove(pEnt);
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
 }
 
 //
+void CGameWorld::PreSnap()
+{
+	for(auto *pEnt : m_apFirstEntityTypes)
+		for(; pEnt;)
+		{
+			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+			pEnt->PreSnap();
+			pEnt = m_pNextTraverseEntity;
+		}
+}
+
 void CGameWorld::Snap(int SnappingClient)
 {
 	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
@@ -205,11 +260,16 @@ void CGameWorld::Tick()
 	if(m_ResetRequested)
 		Reset();
 
+	// pick up positions assigned directly instead of through CEntity::SetPos
+	SyncGrid();
+
 	if(!m_Paused)
 	{
 		// update all objects
 		for(int i = 0; i < NUM_ENTTYPES; i++)
 		{
+			CTickProfileScope Profile(Server()->TickProfiler(), m_aProfileSections[i]);
+
 			// It's important to call PreTick() and Tick() after each other.
 			// If we call PreTick() before, and Tick() after other entities have been processed, it causes physics changes such as a stronger shotgun or grenade.
 			if(g_Config.m_SvNoWeakHook && i == ENTTYPE_CHARACTER)
@@ -218,7 +278,9 @@ void CGameWorld::Tick()
 				for(; pEnt;)
 				{
 					m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+					m_pTraverseEntity = pEnt;
 					((CCharacter *)pEnt)->PreTick();
+					EndTraverseEntity();
 					pEnt = m_pNextTraverseEntity;
 				}
 			}
@@ -227,29 +289,41 @@ void CGameWorld::Tick()
 			for(; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTraverseEntity = pEnt;
 				pEnt->Tick();
+				EndTraverseEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
 		}
 
-		for(auto *pEnt : m_apFirstEntityTypes)
-			for(; pEnt;)
+		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			CTickProfileScope Profile(Server()->TickProfiler(), m_aProfileSections[i]);
+			for(auto *pEnt = m_apFirstEntityTypes[i]; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTraverseEntity = pEnt;
 				pEnt->TickDeferred();
+				EndTraverseEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
+		}
 	}
 	else
 	{
 		// update all objects
-		for(auto *pEnt : m_apFirstEntityTypes)
-			for(; pEnt;)
+		for(int i = 0; i < NUM_ENTTYPES; i++)
+		{
+			CTickProfileScope Profile(Server()->TickProfiler(), m_aProfileSections[i]);
+			for(auto *pEnt = m_apFirstEntityTypes[i]; pEnt;)
 			{
 				m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
+				m_pTraverseEntity = pEnt;
 				pEnt->TickPaused();
+				EndTraverseEntity();
 				pEnt = m_pNextTraverseEntity;
 			}
+		}
 	}
 
 	RemoveEntities();
@@ -297,11 +371,14 @@ CCharacter *CGameWorld::IntersectCharacter(vec2 Pos0, vec2 Pos1, float Radius, v
 
 CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Type, vec2 &NewPos, const CEntity *pNotThis, int CollideWith, const CEntity *pThisOnly)
 {
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return nullptr;
+
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
+	const vec2 Extent = vec2(Radius, Radius);
+	for(CEntity *pEntity : QueryEntities(Type, vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - Extent, vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + Extent))
 	{
 		if(pEntity == pNotThis)
 			continue;
@@ -338,9 +415,9 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 	float ClosestRange = Radius * 2;
 	CCharacter *pClosest = nullptr;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
+	for(CEntity *pEnt : QueryEntities(ENTTYPE_CHARACTER, Pos - vec2(Radius, Radius), Pos + vec2(Radius, Radius)))
 	{
+		CCharacter *p = (CCharacter *)pEnt;
 		if(p == pNotThis)
 			continue;
 
@@ -361,9 +438,10 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
+	const vec2 Extent = vec2(Radius, Radius);
+	for(CEntity *pEnt : QueryEntities(ENTTYPE_CHARACTER, vec2(minimum(Pos0.x, Pos1.x), minimum(Pos0.y, Pos1.y)) - Extent, vec2(maximum(Pos0.x, Pos1.x), maximum(Pos0.y, Pos1.y)) + Extent))
 	{
+		CCharacter *pChr = (CCharacter *)pEnt;
 		if(pChr == pNotThis)
 			continue;
 
@@ -5,6 +5,7 @@
 
 #include "save.h"
 
+#include <game/entity_grid.h>
 #include <game/gamecore.h>
 
 #include <vector>
@@ -35,9 +36,24 @@ private:
 	void Reset();
 	void RemoveEntities();
 
+	void SyncGrid();
+	void EndTraverseEntity();
+	const std::vector<CEntity *> &QueryEntities(int Type, vec2 Min, vec2 Max);
+
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
 
+	// the grids are kept up to date incrementally: the entity currently being ticked is checked by
+	// every query and its cell is updated when its callback returns, every other move has to go
+	// through CEntity::SetPos. Tick still synchronizes all positions once to pick up direct writes.
+	CEntityGrid<CEntity> m_aGrids[NUM_ENTTYPES];
+	CEntity *m_pTraverseEntity = nullptr;
+	int64_t m_NextGridOrder = 0;
+	std::vector<CEntity *> m_vpQueryEntities;
+
+	// tick profiler sections of the entity types
+	int m_aProfileSections[NUM_ENTTYPES];
+
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
 	class IServer *m_pServer;
@@ -144,9 +160,26 @@ public:
 	*/
 	void RemoveEntity(CEntity *pEntity);
 
+	/*
+		Function: UpdateEntityGrid
+			Moves an entity to the grid cell of its current position.
+			Called by CEntity::SetPos.
+
+		Arguments:
+			pEntity - Entity that moved
+	*/
+	void UpdateEntityGrid(CEntity *pEntity);
+
 	void RemoveEntitiesFromPlayer(int PlayerId);
 	void RemoveEntitiesFromPlayers(int PlayerIds[], int NumPlayers);
 
+	/*
+		Function: PreSnap
+			Calls PreSnap on all the entities in the world once
+			before the snapshots for all clients are created.
+	*/
+	void PreSnap();
+
 	/*
 		Function: Snap
 			Calls Snap on all the entities in the world to create
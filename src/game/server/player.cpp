@@ -666,6 +666,7 @@ CCharacter *CPlayer::ForceSpawn(vec2 Pos)
 	m_pCharacter = new(m_ClientId) CCharacter(&GameServer()->m_World, GameServer()->GetLastPlayerInput(m_ClientId));
 	m_pCharacter->Spawn(this, Pos);
 	m_Team = TEAM_GAME;
+	GameServer()->m_pController->Teams().InvalidateTeamMasks();
 	return m_pCharacter;
 }
 
@@ -879,6 +880,7 @@ int CPlayer::Pause(int State, bool Force)
 		// Update state
 		m_Paused = State;
 		m_LastPause = Server()->Tick();
+		GameServer()->m_pController->Teams().InvalidateTeamMasks();
 
 		// Sixup needs a teamchange
 		protocol7::CNetMsg_Sv_Team Msg;
@@ -935,6 +937,7 @@ void CPlayer::SpectatePlayerName(const char *pName)
 void CPlayer::SetSpectatorId(int Id)
 {
 	m_SpectatorId = Id;
+	GameServer()->m_pController->Teams().InvalidateTeamMasks();
 }
 
 void CPlayer::ProcessScoreResult(CScorePlayerResult &Result)
@@ -12,6 +12,21 @@
 
 #include <cstdio> // sscanf
 
+// the binary encoding keeps floats bit-exact
+static int FloatToBits(float Value)
+{
+	int Bits;
+	mem_copy(&Bits, &Value, sizeof(Bits));
+	return Bits;
+}
+
+static float BitsToFloat(int Bits)
+{
+	float Value;
+	mem_copy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
 CSaveTee::CSaveTee() = default;
 
 void CSaveTee::Save(CCharacter *pChr, bool AddPenalty)
@@ -192,7 +207,7 @@ bool CSaveTee::Load(CCharacter *pChr, std::optional<int> Team)
 	if(m_Time)
 		pChr->m_StartTime = pChr->Server()->Tick() - m_Time;
 
-	pChr->m_Pos = m_Pos;
+	pChr->SetPos(m_Pos);
 	pChr->m_PrevPos = m_PrevPos;
 	pChr->m_TeleCheckpoint = m_TeleCheckpoint;
 	pChr->m_LastPenalty = m_LastPenalty;
@@ -263,20 +278,21 @@ bool CSaveTee::Load(CCharacter *pChr, std::optional<int> Team)
 	return Valid;
 }
 
-char *CSaveTee::GetString(const CSaveTeam *pTeam)
+int CSaveTee::HookedPlayerIndex(const CSaveTeam *pTeam) const
 {
-	int HookedPlayer = -1;
-	if(m_HookedPlayer != -1)
+	if(m_HookedPlayer == -1)
+		return -1;
+	for(int n = 0; n < pTeam->GetMembersCount(); n++)
 	{
-		for(int n = 0; n < pTeam->GetMembersCount(); n++)
-		{
-			if(m_HookedPlayer == pTeam->m_pSavedTees[n].GetClientId())
-			{
-				HookedPlayer = n;
-				break;
-			}
-		}
+		if(m_HookedPlayer == pTeam->m_pSavedTees[n].GetClientId())
+			return n;
 	}
+	return -1;
+}
+
+char *CSaveTee::GetString(const CSaveTeam *pTeam)
+{
+	const int HookedPlayer = HookedPlayerIndex(pTeam);
 
 	str_format(m_aString, sizeof(m_aString),
 		"%s\t%d\t%d\t%d\t%d\t%d\t"
@@ -473,6 +489,184 @@ int CSaveTee::FromString(const char *pString)
 	}
 }
 
+void CSaveTee::GetBinary(const CSaveTeam *pTeam, CAbstractPacker *pPacker) const
+{
+	// same fields in the same order as GetString, positions are truncated like there
+	pPacker->AddString(m_aName);
+	pPacker->AddInt(m_Alive);
+	pPacker->AddInt(m_Paused);
+	pPacker->AddInt(m_NeededFaketuning);
+	pPacker->AddInt(m_TeeFinished);
+	pPacker->AddInt(m_IsSolo);
+	for(const CWeaponStat &Weapon : m_aWeapons)
+	{
+		pPacker->AddInt(Weapon.m_AmmoRegenStart);
+		pPacker->AddInt(Weapon.m_Ammo);
+		pPacker->AddInt(Weapon.m_Ammocost);
+		pPacker->AddInt(Weapon.m_Got);
+	}
+	pPacker->AddInt(m_LastWeapon);
+	pPacker->AddInt(m_QueuedWeapon);
+	// tee states
+	pPacker->AddInt(m_EndlessJump);
+	pPacker->AddInt(m_Jetpack);
+	pPacker->AddInt(m_NinjaJetpack);
+	pPacker->AddInt(m_FreezeTime);
+	pPacker->AddInt(m_FreezeStart);
+	pPacker->AddInt(m_DeepFrozen);
+	pPacker->AddInt(m_EndlessHook);
+	pPacker->AddInt(m_DDRaceState);
+	pPacker->AddInt(m_HitDisabledFlags);
+	pPacker->AddInt(m_CollisionEnabled);
+	pPacker->AddInt(m_TuneZone);
+	pPacker->AddInt(m_TuneZoneOld);
+	pPacker->AddInt(m_HookHitEnabled);
+	pPacker->AddInt(m_Time);
+	pPacker->AddInt((int)m_Pos.x);
+	pPacker->AddInt((int)m_Pos.y);
+	pPacker->AddInt((int)m_PrevPos.x);
+	pPacker->AddInt((int)m_PrevPos.y);
+	pPacker->AddInt(m_TeleCheckpoint);
+	pPacker->AddInt(m_LastPenalty);
+	pPacker->AddInt((int)m_CorePos.x);
+	pPacker->AddInt((int)m_CorePos.y);
+	pPacker->AddInt(FloatToBits(m_Vel.x));
+	pPacker->AddInt(FloatToBits(m_Vel.y));
+	pPacker->AddInt(m_ActiveWeapon);
+	pPacker->AddInt(m_Jumped);
+	pPacker->AddInt(m_JumpedTotal);
+	pPacker->AddInt(m_Jumps);
+	pPacker->AddInt((int)m_HookPos.x);
+	pPacker->AddInt((int)m_HookPos.y);
+	pPacker->AddInt(FloatToBits(m_HookDir.x));
+	pPacker->AddInt(FloatToBits(m_HookDir.y));
+	pPacker->AddInt((int)m_HookTeleBase.x);
+	pPacker->AddInt((int)m_HookTeleBase.y);
+	pPacker->AddInt(m_HookTick);
+	pPacker->AddInt(m_HookState);
+	// time checkpoints
+	pPacker->AddInt(m_TimeCpBroadcastEndTime);
+	pPacker->AddInt(m_LastTimeCp);
+	pPacker->AddInt(m_LastTimeCpBroadcasted);
+	for(float TimeCp : m_aCurrentTimeCp)
+		pPacker->AddInt(FloatToBits(TimeCp));
+	pPacker->AddInt(m_NotEligibleForFinish);
+	pPacker->AddInt(m_HasTelegunGun);
+	pPacker->AddInt(m_HasTelegunLaser);
+	pPacker->AddInt(m_HasTelegunGrenade);
+	pPacker->AddString(m_aGameUuid);
+	pPacker->AddInt(HookedPlayerIndex(pTeam));
+	pPacker->AddInt(m_NewHook);
+	pPacker->AddInt(m_InputDirection);
+	pPacker->AddInt(m_InputJump);
+	pPacker->AddInt(m_InputFire);
+	pPacker->AddInt(m_InputHook);
+	pPacker->AddInt(m_ReloadTimer);
+	pPacker->AddInt(m_TeeStarted);
+	pPacker->AddInt(m_LiveFrozen);
+	pPacker->AddInt(FloatToBits(m_Ninja.m_ActivationDir.x));
+	pPacker->AddInt(FloatToBits(m_Ninja.m_ActivationDir.y));
+	pPacker->AddInt(m_Ninja.m_ActivationTick);
+	pPacker->AddInt(m_Ninja.m_CurrentMoveTime);
+	pPacker->AddInt(m_Ninja.m_OldVelAmount);
+}
+
+int CSaveTee::FromBinary(const CSaveTeam *pTeam, CUnpacker *pUnpacker)
+{
+	str_copy(m_aName, pUnpacker->GetString(0));
+	str_sanitize_cc(m_aName);
+	m_Alive = pUnpacker->GetInt();
+	m_Paused = pUnpacker->GetInt();
+	m_NeededFaketuning = pUnpacker->GetInt();
+	m_TeeFinished = pUnpacker->GetInt();
+	m_IsSolo = pUnpacker->GetInt();
+	for(CWeaponStat &Weapon : m_aWeapons)
+	{
+		Weapon.m_AmmoRegenStart = pUnpacker->GetInt();
+		Weapon.m_Ammo = pUnpacker->GetInt();
+		Weapon.m_Ammocost = pUnpacker->GetInt();
+		Weapon.m_Got = pUnpacker->GetInt();
+	}
+	m_LastWeapon = pUnpacker->GetInt();
+	m_QueuedWeapon = pUnpacker->GetInt();
+	// tee states
+	m_EndlessJump = pUnpacker->GetInt();
+	m_Jetpack = pUnpacker->GetInt();
+	m_NinjaJetpack = pUnpacker->GetInt();
+	m_FreezeTime = pUnpacker->GetInt();
+	m_FreezeStart = pUnpacker->GetInt();
+	m_DeepFrozen = pUnpacker->GetInt();
+	m_EndlessHook = pUnpacker->GetInt();
+	m_DDRaceState = pUnpacker->GetInt();
+	m_HitDisabledFlags = pUnpacker->GetInt();
+	m_CollisionEnabled = pUnpacker->GetInt();
+	m_TuneZone = pUnpacker->GetInt();
+	m_TuneZoneOld = pUnpacker->GetInt();
+	m_HookHitEnabled = pUnpacker->GetInt();
+	m_Time = pUnpacker->GetInt();
+	m_Pos.x = pUnpacker->GetInt();
+	m_Pos.y = pUnpacker->GetInt();
+	m_PrevPos.x = pUnpacker->GetInt();
+	m_PrevPos.y = pUnpacker->GetInt();
+	m_TeleCheckpoint = pUnpacker->GetInt();
+	m_LastPenalty = pUnpacker->GetInt();
+	m_CorePos.x = pUnpacker->GetInt();
+	m_CorePos.y = pUnpacker->GetInt();
+	m_Vel.x = BitsToFloat(pUnpacker->GetInt());
+	m_Vel.y = BitsToFloat(pUnpacker->GetInt());
+	m_ActiveWeapon = pUnpacker->GetInt();
+	m_Jumped = pUnpacker->GetInt();
+	m_JumpedTotal = pUnpacker->GetInt();
+	m_Jumps = pUnpacker->GetInt();
+	m_HookPos.x = pUnpacker->GetInt();
+	m_HookPos.y = pUnpacker->GetInt();
+	m_HookDir.x = BitsToFloat(pUnpacker->GetInt());
+	m_HookDir.y = BitsToFloat(pUnpacker->GetInt());
+	m_HookTeleBase.x = pUnpacker->GetInt();
+	m_HookTeleBase.y = pUnpacker->GetInt();
+	m_HookTick = pUnpacker->GetInt();
+	m_HookState = pUnpacker->GetInt();
+	// time checkpoints
+	m_TimeCpBroadcastEndTime = pUnpacker->GetInt();
+	m_LastTimeCp = pUnpacker->GetInt();
+	m_LastTimeCpBroadcasted = pUnpacker->GetInt();
+	for(float &TimeCp : m_aCurrentTimeCp)
+		TimeCp = BitsToFloat(pUnpacker->GetInt());
+	m_NotEligibleForFinish = pUnpacker->GetInt();
+	m_HasTelegunGun = pUnpacker->GetInt();
+	m_HasTelegunLaser = pUnpacker->GetInt();
+	m_HasTelegunGrenade = pUnpacker->GetInt();
+	str_copy(m_aGameUuid, pUnpacker->GetString(0));
+	str_sanitize_cc(m_aGameUuid);
+	m_HookedPlayer = pUnpacker->GetInt();
+	m_NewHook = pUnpacker->GetInt();
+	m_InputDirection = pUnpacker->GetInt();
+	m_InputJump = pUnpacker->GetInt();
+	m_InputFire = pUnpacker->GetInt();
+	m_InputHook = pUnpacker->GetInt();
+	m_ReloadTimer = pUnpacker->GetInt();
+	m_TeeStarted = pUnpacker->GetInt();
+	m_LiveFrozen = pUnpacker->GetInt();
+	m_Ninja.m_ActivationDir.x = BitsToFloat(pUnpacker->GetInt());
+	m_Ninja.m_ActivationDir.y = BitsToFloat(pUnpacker->GetInt());
+	m_Ninja.m_ActivationTick = pUnpacker->GetInt();
+	m_Ninja.m_CurrentMoveTime = pUnpacker->GetInt();
+	m_Ninja.m_OldVelAmount = pUnpacker->GetInt();
+
+	if(pUnpacker->Error())
+	{
+		dbg_msg("load", "failed to load binary tee");
+		return 1;
+	}
+	// an index into the team, LoadHookedPlayer looks it up there
+	if(m_HookedPlayer < -1 || m_HookedPlayer >= pTeam->GetMembersCount())
+	{
+		dbg_msg("load", "savegame: hooked player index %d out of range", m_HookedPlayer);
+		return 1;
+	}
+	return 0;
+}
+
 void CSaveTee::LoadHookedPlayer(const CSaveTeam *pTeam)
 {
 	if(m_HookedPlayer == -1)
@@ -849,6 +1043,93 @@ int CSaveTeam::FromString(const char *pString)
 	return 0;
 }
 
+void CSaveTeam::GetBinary(CAbstractPacker *pPacker) const
+{
+	pPacker->Reset();
+	pPacker->AddInt(BINARY_VERSION);
+	pPacker->AddInt(static_cast<int>(m_TeamState));
+	pPacker->AddInt(m_MembersCount);
+	pPacker->AddInt(m_HighestSwitchNumber);
+	pPacker->AddInt(m_TeamLocked);
+	pPacker->AddInt(m_Practice);
+
+	for(int i = 0; i < m_MembersCount; i++)
+		m_pSavedTees[i].GetBinary(this, pPacker);
+
+	for(int i = 1; i < m_HighestSwitchNumber + 1; i++)
+	{
+		const SSimpleSwitchers Switcher = m_pSwitchers ? m_pSwitchers[i] : SSimpleSwitchers{0, 0, 0};
+		pPacker->AddInt(Switcher.m_Status);
+		pPacker->AddInt(Switcher.m_EndTime);
+		pPacker->AddInt(Switcher.m_Type);
+	}
+}
+
+int CSaveTeam::FromBinary(const void *pData, int Size)
+{
+	CUnpacker Unpacker;
+	Unpacker.Reset(pData, Size);
+
+	const int Version = Unpacker.GetInt();
+	if(Unpacker.Error() || Version != BINARY_VERSION)
+	{
+		dbg_msg("load", "savegame: unknown binary version %d", Version);
+		return 1;
+	}
+
+	m_TeamState = static_cast<ETeamState>(Unpacker.GetInt());
+	m_MembersCount = Unpacker.GetInt();
+	m_HighestSwitchNumber = Unpacker.GetInt();
+	m_TeamLocked = Unpacker.GetInt();
+	m_Practice = Unpacker.GetInt();
+	if(Unpacker.Error())
+	{
+		dbg_msg("load", "failed to load binary teamstats");
+		return 1;
+	}
+
+	delete[] m_pSavedTees;
+	m_pSavedTees = nullptr;
+	delete[] m_pSwitchers;
+	m_pSwitchers = nullptr;
+
+	if(m_MembersCount < 0 || m_MembersCount > 64)
+	{
+		dbg_msg("load", "savegame: team has too many players");
+		return 1;
+	}
+	// every switcher takes at least three bytes
+	if(m_HighestSwitchNumber < 0 || m_HighestSwitchNumber > Size)
+	{
+		dbg_msg("load", "savegame: wrong format (too many switchers)");
+		return 1;
+	}
+
+	if(m_MembersCount)
+		m_pSavedTees = new CSaveTee[m_MembersCount];
+	for(int n = 0; n < m_MembersCount; n++)
+	{
+		if(m_pSavedTees[n].FromBinary(this, &Unpacker))
+			return 1;
+	}
+
+	if(m_HighestSwitchNumber)
+		m_pSwitchers = new SSimpleSwitchers[m_HighestSwitchNumber + 1];
+	for(int n = 1; n < m_HighestSwitchNumber + 1; n++)
+	{
+		m_pSwitchers[n].m_Status = Unpacker.GetInt();
+		m_pSwitchers[n].m_EndTime = Unpacker.GetInt();
+		m_pSwitchers[n].m_Type = Unpacker.GetInt();
+	}
+
+	if(Unpacker.Error())
+	{
+		dbg_msg("load", "failed to load binary switchers");
+		return 1;
+	}
+	return 0;
+}
+
 bool CSaveTeam::MatchPlayers(const char (*paNames)[MAX_NAME_LENGTH], const int *pClientId, int NumPlayer, char *pMessage, int MessageLen) const
 {
 	if(NumPlayer > m_MembersCount)
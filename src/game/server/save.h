@@ -3,6 +3,7 @@
 
 #include <base/vmath.h>
 
+#include <engine/shared/packer.h>
 #include <engine/shared/protocol.h>
 
 #include <generated/protocol.h>
@@ -44,6 +45,8 @@ public:
 	bool Load(CCharacter *pChr, std::optional<int> Team = std::nullopt);
 	char *GetString(const CSaveTeam *pTeam);
 	int FromString(const char *pString);
+	void GetBinary(const CSaveTeam *pTeam, CAbstractPacker *pPacker) const;
+	int FromBinary(const CSaveTeam *pTeam, CUnpacker *pUnpacker);
 	void LoadHookedPlayer(const CSaveTeam *pTeam);
 	bool IsHooking() const;
 	vec2 GetPos() const { return m_Pos; }
@@ -61,6 +64,8 @@ public:
 	};
 
 private:
+	int HookedPlayerIndex(const CSaveTeam *pTeam) const;
+
 	int m_ClientId;
 
 	char m_aString[2048];
@@ -170,6 +175,19 @@ private:
 	std::optional<CSaveTee> m_LastDeath;
 };
 
+// big enough for the binary encoding of any team that fits into CSaveTeam::GetString
+class CSaveTeamPacker : public CAbstractPacker
+{
+public:
+	CSaveTeamPacker() :
+		CAbstractPacker(m_aBuffer, sizeof(m_aBuffer))
+	{
+	}
+
+private:
+	unsigned char m_aBuffer[1024 * 64];
+};
+
 class CSaveTeam
 {
 public:
@@ -179,6 +197,10 @@ public:
 	int GetMembersCount() const { return m_MembersCount; }
 	// MatchPlayers has to be called afterwards
 	int FromString(const char *pString);
+	// resets pPacker and writes a compact versioned encoding of the same state as GetString
+	void GetBinary(CAbstractPacker *pPacker) const;
+	// MatchPlayers has to be called afterwards
+	int FromBinary(const void *pData, int Size);
 	// returns true if a team can load, otherwise writes a nice error Message in pMessage
 	bool MatchPlayers(const char (*paNames)[MAX_NAME_LENGTH], const int *pClientId, int NumPlayer, char *pMessage, int MessageLen) const;
 	ESaveResult Save(CGameContext *pGameServer, int Team, bool Dry = false, bool Force = false);
@@ -202,6 +224,11 @@ private:
 	};
 	SSimpleSwitchers *m_pSwitchers = nullptr;
 
+	enum
+	{
+		BINARY_VERSION = 1,
+	};
+
 	ETeamState m_TeamState = ETeamState::EMPTY;
 	int m_MembersCount = 0;
 	int m_HighestSwitchNumber = 0;
@@ -46,6 +46,7 @@ void CScore::ExecPlayerThread(
 	str_copy(Tmp->m_aServer, g_Config.m_SvSqlServerName, sizeof(Tmp->m_aServer));
 	str_copy(Tmp->m_aRequestingPlayer, Server()->ClientName(ClientId), sizeof(Tmp->m_aRequestingPlayer));
 	Tmp->m_Offset = Offset;
+	Tmp->m_pMapRanks = m_pMapRanks;
 
 	m_pPool->Execute(pFuncPtr, std::move(Tmp), pThreadName);
 }
@@ -79,6 +80,7 @@ CScore::CScore(CGameContext *pGameServer, CDbConnectionPool *pPool) :
 	m_pServer(pGameServer->Server())
 {
 	LoadBestTime();
+	LoadMapRanks();
 
 	uint64_t aSeed[2];
 	secure_random_fill(aSeed, sizeof(aSeed));
@@ -122,6 +124,15 @@ void CScore::LoadBestTime()
 	m_pPool->Execute(CScoreWorker::LoadBestTime, std::move(Tmp), "load best time");
 }
 
+void CScore::LoadMapRanks()
+{
+	if(!g_Config.m_SvSqlRankCache)
+		return;
+
+	m_pMapRanks = std::make_shared<CMapRanks>(Server()->GetMapName(), g_Config.m_SvSqlServerName);
+	m_pPool->Execute(CScoreWorker::LoadMapRanks, std::make_unique<CSqlLoadMapRanksRequest>(m_pMapRanks), "load map ranks");
+}
+
 void CScore::LoadPlayerData(int ClientId, const char *pName)
 {
 	ExecPlayerThread(CScoreWorker::LoadPlayerData, "load player data", ClientId, pName, 0);
@@ -168,6 +179,9 @@ void CScore::SaveScore(int ClientId, int TimeTicks, const char *pTimestamp, cons
 	for(int i = 0; i < NUM_CHECKPOINTS; i++)
 		Tmp->m_aCurrentTimeCp[i] = aTimeCp[i];
 
+	if(m_pMapRanks != nullptr)
+		m_pMapRanks->AddFinish(Tmp->m_aName, Tmp->m_Time);
+
 	m_pPool->ExecuteWrite(CScoreWorker::SaveScore, std::move(Tmp), "save score");
 }
 
@@ -15,6 +15,8 @@ class CScore
 {
 	CPlayerData m_aPlayerData[MAX_CLIENTS];
 	CDbConnectionPool *m_pPool;
+	// ranks of the current map, nullptr if sv_sql_rank_cache is off
+	std::shared_ptr<CMapRanks> m_pMapRanks;
 
 	CGameContext *GameServer() const { return m_pGameServer; }
 	IServer *Server() const { return m_pServer; }
@@ -44,6 +46,7 @@ public:
 	CPlayerData *PlayerData(int Id) { return &m_aPlayerData[Id]; }
 
 	void LoadBestTime();
+	void LoadMapRanks();
 	void MapInfo(int ClientId, const char *pMapName);
 	void MapVote(int ClientId, const char *pMapName);
 	void LoadPlayerData(int ClientId, const char *pName = "");
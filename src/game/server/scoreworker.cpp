@@ -8,6 +8,7 @@
 #include <engine/server/sql_string_helpers.h>
 #include <engine/shared/config.h>
 
+#include <algorithm>
 #include <cmath>
 
 // "6b407e81-8b77-3e04-a207-8da17f37d000"
@@ -142,6 +143,133 @@ bool CTeamrank::GetSqlTop5Team(IDbConnection *pSqlServer, bool *pEnd, char *pErr
 	return true;
 }
 
+static bool CompareEntries(const CMapRanks::CEntry &Left, const CMapRanks::CEntry &Right)
+{
+	if(Left.m_Time != Right.m_Time)
+		return Left.m_Time < Right.m_Time;
+	return str_comp(Left.m_aName, Right.m_aName) < 0;
+}
+
+void CMapRanks::CBoard::Add(const char *pName, float Time)
+{
+	auto [It, Inserted] = m_BestTimes.emplace(pName, Time);
+	CEntry Entry;
+	str_copy(Entry.m_aName, pName);
+	if(!Inserted)
+	{
+		if(It->second <= Time)
+			return;
+		Entry.m_Time = It->second;
+		m_vEntries.erase(std::lower_bound(m_vEntries.begin(), m_vEntries.end(), Entry, CompareEntries));
+		It->second = Time;
+	}
+	Entry.m_Time = Time;
+	m_vEntries.insert(std::upper_bound(m_vEntries.begin(), m_vEntries.end(), Entry, CompareEntries), Entry);
+}
+
+void CMapRanks::CBoard::AddAll(const std::vector<CEntry> &vEntries)
+{
+	for(const CEntry &Entry : vEntries)
+	{
+		auto [It, Inserted] = m_BestTimes.emplace(Entry.m_aName, Entry.m_Time);
+		if(!Inserted)
+			It->second = std::min(It->second, Entry.m_Time);
+	}
+	m_vEntries.clear();
+	m_vEntries.reserve(m_BestTimes.size());
+	for(const auto &[Name, Time] : m_BestTimes)
+	{
+		CEntry &Entry = m_vEntries.emplace_back();
+		Entry.m_Time = Time;
+		str_copy(Entry.m_aName, Name.c_str());
+	}
+	std::sort(m_vEntries.begin(), m_vEntries.end(), CompareEntries);
+}
+
+int CMapRanks::CBoard::RankAt(int Index) const
+{
+	const float Time = m_vEntries[Index].m_Time;
+	return 1 + std::partition_point(m_vEntries.begin(), m_vEntries.begin() + Index, [Time](const CEntry &Entry) {
+		return Entry.m_Time < Time;
+	}) - m_vEntries.begin();
+}
+
+std::optional<CMapRanks::CRank> CMapRanks::CBoard::Rank(const char *pName) const
+{
+	auto It = m_BestTimes.find(pName);
+	if(It == m_BestTimes.end())
+		return std::nullopt;
+	CEntry Entry;
+	Entry.m_Time = It->second;
+	str_copy(Entry.m_aName, pName);
+	const int Index = std::lower_bound(m_vEntries.begin(), m_vEntries.end(), Entry, CompareEntries) - m_vEntries.begin();
+
+	CRank Rank;
+	Rank.m_Rank = RankAt(Index);
+	Rank.m_Time = Entry.m_Time;
+	const int NumEntries = m_vEntries.size();
+	Rank.m_PercentRank = NumEntries > 1 ? (double)(Rank.m_Rank - 1) / (NumEntries - 1) : 0.0;
+	return Rank;
+}
+
+int CMapRanks::CBoard::Top(int Offset, CEntry *pEntries, int *pRanks, int Num) const
+{
+	const int NumEntries = m_vEntries.size();
+	const int LimitStart = maximum(absolute(Offset) - 1, 0);
+	int NumFound = 0;
+	for(int i = LimitStart; i < NumEntries && NumFound < Num; i++, NumFound++)
+	{
+		const int Index = Offset >= 0 ? i : NumEntries - 1 - i;
+		pEntries[NumFound] = m_vEntries[Index];
+		pRanks[NumFound] = RankAt(Index);
+	}
+	return NumFound;
+}
+
+CMapRanks::CMapRanks(const char *pMap, const char *pServer)
+{
+	str_copy(m_aMap, pMap);
+	str_copy(m_aServer, pServer);
+}
+
+bool CMapRanks::Covers(const char *pMap, const char *pServer) const
+{
+	const CLockScope LockScope(m_Lock);
+	return m_Loaded && str_comp(m_aMap, pMap) == 0 && str_comp(m_aServer, pServer) == 0;
+}
+
+void CMapRanks::Load(const std::vector<CEntry> &vGlobal, const std::vector<CEntry> &vRegional)
+{
+	const CLockScope LockScope(m_Lock);
+	m_Global.AddAll(vGlobal);
+	m_Regional.AddAll(vRegional);
+	m_Loaded = true;
+}
+
+void CMapRanks::AddFinish(const char *pName, float Time)
+{
+	// the time is stored with two decimals
+	char aTime[32];
+	str_format(aTime, sizeof(aTime), "%.2f", Time);
+	Time = str_tofloat(aTime);
+
+	const CLockScope LockScope(m_Lock);
+	m_Global.Add(pName, Time);
+	m_Regional.Add(pName, Time);
+}
+
+std::optional<CMapRanks::CRank> CMapRanks::Rank(const char *pName, bool Regional) const
+{
+	const CLockScope LockScope(m_Lock);
+	return Regional ? m_Regional.Rank(pName) : m_Global.Rank(pName);
+}
+
+int CMapRanks::Top(int Offset, bool Regional, CEntry *pEntries, int *pRanks, int Num) const
+{
+	const CLockScope LockScope(m_Lock);
+	return Regional ? m_Regional.Top(Offset, pEntries, pRanks, Num) : m_Global.Top(Offset, pEntries, pRanks, Num);
+}
+
 bool CScoreWorker::LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlLoadBestTimeRequest *>(pGameData);
@@ -171,6 +299,50 @@ bool CScoreWorker::LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+bool CScoreWorker::LoadMapRanks(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
+{
+	const auto *pData = dynamic_cast<const CSqlLoadMapRanksRequest *>(pGameData);
+	CMapRanks *pMapRanks = pData->m_pMapRanks.get();
+
+	char aServerLike[16];
+	str_format(aServerLike, sizeof(aServerLike), "%%%s%%", pMapRanks->Server());
+
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf),
+		"SELECT Name, MIN(Time), MIN(CASE WHEN Server LIKE ? THEN Time END) "
+		"FROM %s_race "
+		"WHERE Map = ? "
+		"GROUP BY Name",
+		pSqlServer->GetPrefix());
+	if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	{
+		return false;
+	}
+	pSqlServer->BindString(1, aServerLike);
+	pSqlServer->BindString(2, pMapRanks->Map());
+
+	std::vector<CMapRanks::CEntry> vGlobal;
+	std::vector<CMapRanks::CEntry> vRegional;
+	bool End;
+	while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
+	{
+		CMapRanks::CEntry &Entry = vGlobal.emplace_back();
+		pSqlServer->GetString(1, Entry.m_aName, sizeof(Entry.m_aName));
+		Entry.m_Time = pSqlServer->GetFloat(2);
+		if(!pSqlServer->IsNull(3))
+		{
+			CMapRanks::CEntry &Regional = vRegional.emplace_back(Entry);
+			Regional.m_Time = pSqlServer->GetFloat(3);
+		}
+	}
+	if(!End)
+	{
+		return false;
+	}
+	pMapRanks->Load(vGlobal, vRegional);
+	return true;
+}
+
 // update stuff
 bool CScoreWorker::LoadPlayerData(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
@@ -819,72 +991,87 @@ bool CScoreWorker::SaveTeamScore(IDbConnection *pSqlServer, const ISqlData *pGam
 	return true;
 }
 
+// the ranks of the current map if they can answer the request
+static const CMapRanks *MapRanks(const CSqlPlayerRequest *pData)
+{
+	if(pData->m_pMapRanks == nullptr || !pData->m_pMapRanks->Covers(pData->m_aMap, pData->m_aServer))
+		return nullptr;
+	return pData->m_pMapRanks.get();
+}
+
 bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
 
-	char aServerLike[16];
-	str_format(aServerLike, sizeof(aServerLike), "%%%s%%", pData->m_aServer);
-
-	// check sort method
 	char aBuf[600];
-	str_format(aBuf, sizeof(aBuf),
-		"SELECT Ranking, Time, PercentRank "
-		"FROM ("
-		"  SELECT RANK() OVER w AS Ranking, PERCENT_RANK() OVER w as PercentRank, MIN(Time) AS Time, Name "
-		"  FROM %s_race "
-		"  WHERE Map = ? "
-		"  AND Server LIKE ? "
-		"  GROUP BY Name "
-		"  WINDOW w AS (ORDER BY MIN(Time))"
-		") as a "
-		"WHERE Name = ?",
-		pSqlServer->GetPrefix());
-
-	if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	std::optional<CMapRanks::CRank> RegionalRank;
+	std::optional<CMapRanks::CRank> GlobalRank;
+	if(const CMapRanks *pMapRanks = MapRanks(pData))
 	{
-		return false;
+		RegionalRank = pMapRanks->Rank(pData->m_aName, true);
+		GlobalRank = pMapRanks->Rank(pData->m_aName, false);
 	}
-	pSqlServer->BindString(1, pData->m_aMap);
-	pSqlServer->BindString(2, aServerLike);
-	pSqlServer->BindString(3, pData->m_aName);
-
-	bool End;
-	if(!pSqlServer->Step(&End, pError, ErrorSize))
+	else
 	{
-		return false;
+		char aServerLike[16];
+		str_format(aServerLike, sizeof(aServerLike), "%%%s%%", pData->m_aServer);
+
+		// check sort method
+		str_format(aBuf, sizeof(aBuf),
+			"SELECT Ranking, Time, PercentRank "
+			"FROM ("
+			"  SELECT RANK() OVER w AS Ranking, PERCENT_RANK() OVER w as PercentRank, MIN(Time) AS Time, Name "
+			"  FROM %s_race "
+			"  WHERE Map = ? "
+			"  AND Server LIKE ? "
+			"  GROUP BY Name "
+			"  WINDOW w AS (ORDER BY MIN(Time))"
+			") as a "
+			"WHERE Name = ?",
+			pSqlServer->GetPrefix());
+
+		const auto &&ReadRank = [&](const char *pServerLike, std::optional<CMapRanks::CRank> *pRank) {
+			if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+			{
+				return false;
+			}
+			pSqlServer->BindString(1, pData->m_aMap);
+			pSqlServer->BindString(2, pServerLike);
+			pSqlServer->BindString(3, pData->m_aName);
+
+			bool End;
+			if(!pSqlServer->Step(&End, pError, ErrorSize))
+			{
+				return false;
+			}
+			if(!End)
+			{
+				*pRank = CMapRanks::CRank{pSqlServer->GetInt(1), pSqlServer->GetFloat(2), pSqlServer->GetFloat(3)};
+			}
+			return true;
+		};
+		const char *pAny = "%";
+		if(!ReadRank(aServerLike, &RegionalRank) || !ReadRank(pAny, &GlobalRank))
+		{
+			return false;
+		}
 	}
 
 	char aRegionalRank[16];
-	if(End)
+	if(!RegionalRank)
 	{
 		str_copy(aRegionalRank, "unranked", sizeof(aRegionalRank));
 	}
 	else
 	{
-		str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", pSqlServer->GetInt(1));
+		str_format(aRegionalRank, sizeof(aRegionalRank), "rank %d", RegionalRank->m_Rank);
 	}
 
-	const char *pAny = "%";
-
-	if(!pSqlServer->PrepareStatement(aBuf, pError, ErrorSize))
+	if(GlobalRank)
 	{
-		return false;
-	}
-	pSqlServer->BindString(1, pData->m_aMap);
-	pSqlServer->BindString(2, pAny);
-	pSqlServer->BindString(3, pData->m_aName);
-
-	if(!pSqlServer->Step(&End, pError, ErrorSize))
-	{
-		return false;
-	}
-
-	if(!End)
-	{
-		int Rank = pSqlServer->GetInt(1);
-		float Time = pSqlServer->GetFloat(2);
+		int Rank = GlobalRank->m_Rank;
+		float Time = GlobalRank->m_Time;
 		str_time_float(Time, TIME_HOURS_CENTISECS, aBuf, sizeof(aBuf));
 
 		if(g_Config.m_SvHideScore)
@@ -896,7 +1083,7 @@ bool CScoreWorker::ShowRank(IDbConnection *pSqlServer, const ISqlData *pGameData
 		{
 			pResult->m_MessageKind = CScorePlayerResult::ALL;
 			// CEIL and FLOOR are not supported in SQLite
-			int BetterThanPercent = std::floor(100.0f - 100.0f * pSqlServer->GetFloat(3));
+			int BetterThanPercent = std::floor(100.0f - 100.0f * GlobalRank->m_PercentRank);
 
 			if(str_comp_nocase(pData->m_aRequestingPlayer, pData->m_aName) == 0)
 			{
@@ -1015,11 +1202,50 @@ bool CScoreWorker::ShowTeamRank(IDbConnection *pSqlServer, const ISqlData *pGame
 	return true;
 }
 
+static void FormatTopRank(char *pMessage, int MessageSize, int Rank, const char *pName, float Time)
+{
+	char aTime[32];
+	str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
+	str_format(pMessage, MessageSize, "%d. %s Time: %s", Rank, pName, aTime);
+}
+
 bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize)
 {
 	const auto *pData = dynamic_cast<const CSqlPlayerRequest *>(pGameData);
 	auto *pResult = dynamic_cast<CScorePlayerResult *>(pGameData->m_pResult.get());
 
+	if(const CMapRanks *pMapRanks = MapRanks(pData))
+	{
+		CMapRanks::CEntry aEntries[5];
+		int aRanks[5];
+		int Line = 0;
+		str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+		Line++;
+		const int NumGlobal = pMapRanks->Top(pData->m_Offset, false, aEntries, aRanks, 5);
+		for(int i = 0; i < NumGlobal; i++, Line++)
+		{
+			FormatTopRank(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+				aRanks[i], aEntries[i].m_aName, aEntries[i].m_Time);
+		}
+
+		if(!g_Config.m_SvRegionalRankings)
+		{
+			str_copy(pResult->m_Data.m_aaMessages[Line], "-----------------------------------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
+			return true;
+		}
+
+		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			"------------ %s Top ------------", pData->m_aServer);
+		Line++;
+		const int NumRegional = pMapRanks->Top(pData->m_Offset, true, aEntries, aRanks, 3);
+		for(int i = 0; i < NumRegional; i++, Line++)
+		{
+			FormatTopRank(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+				aRanks[i], aEntries[i].m_aName, aEntries[i].m_Time);
+		}
+		return true;
+	}
+
 	int LimitStart = maximum(absolute(pData->m_Offset) - 1, 0);
 	const char *pOrder = pData->m_Offset >= 0 ? "ASC" : "DESC";
 	const char *pAny = "%";
@@ -1055,18 +1281,14 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	str_copy(pResult->m_Data.m_aaMessages[Line], "------------ Global Top ------------", sizeof(pResult->m_Data.m_aaMessages[Line]));
 	Line++;
 
-	char aTime[32];
 	bool End = false;
 
 	while(pSqlServer->Step(&End, pError, ErrorSize) && !End)
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopRank(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 
 		Line++;
 	}
@@ -1097,11 +1319,8 @@ bool CScoreWorker::ShowTop(IDbConnection *pSqlServer, const ISqlData *pGameData,
 	{
 		char aName[MAX_NAME_LENGTH];
 		pSqlServer->GetString(1, aName, sizeof(aName));
-		float Time = pSqlServer->GetFloat(2);
-		str_time_float(Time, TIME_HOURS_CENTISECS, aTime, sizeof(aTime));
-		int Rank = pSqlServer->GetInt(3);
-		str_format(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
-			"%d. %s Time: %s", Rank, aName, aTime);
+		FormatTopRank(pResult->m_Data.m_aaMessages[Line], sizeof(pResult->m_Data.m_aaMessages[Line]),
+			pSqlServer->GetInt(3), aName, pSqlServer->GetFloat(2));
 		Line++;
 	}
 
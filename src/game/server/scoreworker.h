@@ -1,6 +1,8 @@
 #ifndef GAME_SERVER_SCOREWORKER_H
 #define GAME_SERVER_SCOREWORKER_H
 
+#include <base/lock.h>
+
 #include <engine/map.h>
 #include <engine/server/databases/connection_pool.h>
 #include <engine/shared/protocol.h>
@@ -12,6 +14,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -80,6 +83,88 @@ struct CSqlLoadBestTimeRequest : ISqlData
 	char m_aMap[MAX_MAP_LENGTH];
 };
 
+// The best time of every player on the current map, so that rank and top
+// queries of the current map don't need the database. It is loaded when the
+// map starts and updated with the finishes of this server, finishes on other
+// servers sharing the database show up with the next map.
+class CMapRanks
+{
+public:
+	struct CEntry
+	{
+		float m_Time;
+		char m_aName[MAX_NAME_LENGTH];
+	};
+
+	struct CRank
+	{
+		int m_Rank;
+		float m_Time;
+		// equivalent to `PERCENT_RANK()` in SQL
+		float m_PercentRank;
+	};
+
+	// `pServer` is the server name which regional ranks are shown for
+	CMapRanks(const char *pMap, const char *pServer);
+
+	// Returns whether the ranks are loaded for `pMap` with regional ranks of `pServer`.
+	bool Covers(const char *pMap, const char *pServer) const REQUIRES(!m_Lock);
+
+	// Adds the best times of all players loaded from the database, the finishes
+	// added before are kept if they are better.
+	void Load(const std::vector<CEntry> &vGlobal, const std::vector<CEntry> &vRegional) REQUIRES(!m_Lock);
+	// Adds a finish of this server, rounded like it is stored in the database.
+	void AddFinish(const char *pName, float Time) REQUIRES(!m_Lock);
+
+	std::optional<CRank> Rank(const char *pName, bool Regional) const REQUIRES(!m_Lock);
+	// Gets the ranks like `ORDER BY Ranking LIMIT`, descending for a negative
+	// `Offset`. Returns the number of entries written to `pEntries` and `pRanks`.
+	int Top(int Offset, bool Regional, CEntry *pEntries, int *pRanks, int Num) const REQUIRES(!m_Lock);
+
+	const char *Map() const { return m_aMap; }
+	const char *Server() const { return m_aServer; }
+
+private:
+	class CBoard
+	{
+	public:
+		void Add(const char *pName, float Time);
+		// adds many times at once without keeping the entries sorted in between
+		void AddAll(const std::vector<CEntry> &vEntries);
+
+		std::optional<CRank> Rank(const char *pName) const;
+		int Top(int Offset, CEntry *pEntries, int *pRanks, int Num) const;
+
+	private:
+		// the rank of the entry at `Index`, equal times share the rank
+		int RankAt(int Index) const;
+
+		// best time by name
+		std::unordered_map<std::string, float> m_BestTimes;
+		// ordered by time and name
+		std::vector<CEntry> m_vEntries;
+	};
+
+	char m_aMap[MAX_MAP_LENGTH];
+	char m_aServer[5];
+
+	mutable CLock m_Lock;
+	bool m_Loaded GUARDED_BY(m_Lock) = false;
+	CBoard m_Global GUARDED_BY(m_Lock);
+	// best times set on `m_aServer`
+	CBoard m_Regional GUARDED_BY(m_Lock);
+};
+
+struct CSqlLoadMapRanksRequest : ISqlData
+{
+	CSqlLoadMapRanksRequest(std::shared_ptr<CMapRanks> pMapRanks) :
+		ISqlData(nullptr), m_pMapRanks(std::move(pMapRanks))
+	{
+	}
+
+	std::shared_ptr<CMapRanks> m_pMapRanks;
+};
+
 struct CSqlPlayerRequest : ISqlData
 {
 	CSqlPlayerRequest(std::shared_ptr<CScorePlayerResult> pResult) :
@@ -95,6 +180,8 @@ struct CSqlPlayerRequest : ISqlData
 	// relevant for /top5 kind of requests
 	int m_Offset;
 	char m_aServer[5];
+	// answers rank and top queries of the current map if loaded
+	std::shared_ptr<const CMapRanks> m_pMapRanks;
 };
 
 struct CScoreRandomMapResult : ISqlResult
@@ -290,6 +377,7 @@ struct CTeamrank
 struct CScoreWorker
 {
 	static bool LoadBestTime(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
+	static bool LoadMapRanks(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 
 	static bool RandomMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
 	static bool RandomUnfinishedMap(IDbConnection *pSqlServer, const ISqlData *pGameData, char *pError, int ErrorSize);
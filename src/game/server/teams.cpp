@@ -14,6 +14,84 @@
 #include <game/server/entities/character.h>
 #include <game/team_state.h>
 
+void CTeamVisibility::Update(const CClientState *pClients)
+{
+	*this = CTeamVisibility();
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(pClients[i].m_Solo)
+			m_SoloMask.set(i);
+	}
+
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		const CClientState &Client = pClients[i];
+		if(!Client.m_Exists)
+			continue;
+		(Client.m_Sixup ? m_SixupMask : m_SixMask).set(i);
+
+		if(Client.m_Spectating && Client.m_SpectatorId == SPEC_FREEVIEW)
+		{
+			if(Client.m_Team >= 0 && Client.m_Team < NUM_DDRACE_TEAMS)
+				m_aTeamFollowers[Client.m_Team].set(i);
+			(Client.m_SpecTeam ? m_FreeviewTeamMask : m_FreeviewAllMask).set(i);
+			continue;
+		}
+
+		// the tee of the client itself, or the spectated tee
+		const int Followed = Client.m_Spectating ? Client.m_SpectatorId : i;
+		if(Followed < 0 || Followed >= MAX_CLIENTS)
+			continue;
+		const CClientState &FollowedClient = pClients[Followed];
+		m_aFollowers[Followed].set(i);
+		if(FollowedClient.m_Team >= 0 && FollowedClient.m_Team < NUM_DDRACE_TEAMS)
+			m_aTeamFollowers[FollowedClient.m_Team].set(i);
+		if(!FollowedClient.m_Alive)
+			continue;
+		if(Client.m_ShowOthers == SHOW_OTHERS_ONLY_TEAM)
+			m_FollowTeamMask.set(i);
+		else if(Client.m_ShowOthers == SHOW_OTHERS_OFF)
+		{
+			if(!FollowedClient.m_Solo)
+				m_FollowNotSoloMask.set(i);
+		}
+		else
+			m_FollowAllMask.set(i);
+	}
+}
+
+CClientMask CTeamVisibility::TeamMask(int Team, int ExceptId, int Asker, int VersionFlags) const
+{
+	CClientMask Mask;
+	if(Team == TEAM_SUPER)
+	{
+		Mask.set();
+	}
+	else
+	{
+		CClientMask InTeam = m_aTeamFollowers[TEAM_SUPER];
+		if(Team >= 0 && Team < NUM_DDRACE_TEAMS)
+			InTeam |= m_aTeamFollowers[Team];
+
+		Mask = m_FreeviewAllMask | (m_FreeviewTeamMask & InTeam) | m_FollowAllMask | (m_FollowTeamMask & InTeam);
+		const bool AskerSolo = Asker >= 0 && Asker < MAX_CLIENTS && m_SoloMask.test(Asker);
+		if(!AskerSolo)
+			Mask |= m_FollowNotSoloMask & InTeam;
+		if(Asker >= 0 && Asker < MAX_CLIENTS)
+			Mask |= m_aFollowers[Asker]; // See everything of yourself or the player you're spectating
+
+		CClientMask VersionMask;
+		if(VersionFlags & CGameContext::FLAG_SIX)
+			VersionMask |= m_SixMask;
+		if(VersionFlags & CGameContext::FLAG_SIXUP)
+			VersionMask |= m_SixupMask;
+		Mask &= VersionMask;
+	}
+	if(ExceptId >= 0 && ExceptId < MAX_CLIENTS)
+		Mask.reset(ExceptId);
+	return Mask;
+}
+
 CGameTeams::CGameTeams(CGameContext *pGameContext) :
 	m_pGameContext(pGameContext)
 {
@@ -23,6 +101,7 @@ CGameTeams::CGameTeams(CGameContext *pGameContext) :
 void CGameTeams::Reset()
 {
 	m_Core.Reset();
+	m_TeamVisibilityValid = false;
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 	{
 		m_aTeeStarted[i] = false;
@@ -221,6 +300,7 @@ void CGameTeams::OnCharacterFinish(int ClientId)
 void CGameTeams::Tick()
 {
 	int Now = Server()->Tick();
+	InvalidateTeamMasks();
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
 	{
@@ -473,6 +553,7 @@ void CGameTeams::SetForceCharacterTeam(int ClientId, int Team)
 	}
 
 	m_Core.Team(ClientId, Team);
+	InvalidateTeamMasks();
 
 	if(OldTeam != Team)
 	{
@@ -555,80 +636,34 @@ bool CGameTeams::TeamFinished(int Team)
 
 CClientMask CGameTeams::TeamMask(int Team, int ExceptId, int Asker, int VersionFlags)
 {
-	if(Team == TEAM_SUPER)
-	{
-		if(ExceptId == -1)
-			return CClientMask().set();
-		return CClientMask().set().reset(ExceptId);
-	}
-
-	CClientMask Mask;
-	for(int i = 0; i < MAX_CLIENTS; ++i)
+	if(!m_TeamVisibilityValid)
 	{
-		if(i == ExceptId)
-			continue; // Explicitly excluded
-		if(!GetPlayer(i))
-			continue; // Player doesn't exist
-		if(!((Server()->IsSixup(i) && (VersionFlags & CGameContext::FLAG_SIXUP)) ||
-			   (!Server()->IsSixup(i) && (VersionFlags & CGameContext::FLAG_SIX))))
-			continue;
-
-		if(!(GetPlayer(i)->GetTeam() == TEAM_SPECTATORS || GetPlayer(i)->IsPaused()))
-		{ // Not spectator
-			if(i != Asker)
-			{ // Actions of other players
-				if(!Character(i))
-					continue; // Player is currently dead
-				if(GetPlayer(i)->m_ShowOthers == SHOW_OTHERS_ONLY_TEAM)
-				{
-					if(m_Core.Team(i) != Team && m_Core.Team(i) != TEAM_SUPER)
-						continue; // In different teams
-				}
-				else if(GetPlayer(i)->m_ShowOthers == SHOW_OTHERS_OFF)
-				{
-					if(m_Core.GetSolo(Asker))
-						continue; // When in solo part don't show others
-					if(m_Core.GetSolo(i))
-						continue; // When in solo part don't show others
-					if(m_Core.Team(i) != Team && m_Core.Team(i) != TEAM_SUPER)
-						continue; // In different teams
-				}
-			} // See everything of yourself
-		}
-		else if(GetPlayer(i)->SpectatorId() != SPEC_FREEVIEW)
-		{ // Spectating specific player
-			if(GetPlayer(i)->SpectatorId() != Asker)
-			{ // Actions of other players
-				if(!Character(GetPlayer(i)->SpectatorId()))
-					continue; // Player is currently dead
-				if(GetPlayer(i)->m_ShowOthers == SHOW_OTHERS_ONLY_TEAM)
-				{
-					if(m_Core.Team(GetPlayer(i)->SpectatorId()) != Team && m_Core.Team(GetPlayer(i)->SpectatorId()) != TEAM_SUPER)
-						continue; // In different teams
-				}
-				else if(GetPlayer(i)->m_ShowOthers == SHOW_OTHERS_OFF)
-				{
-					if(m_Core.GetSolo(Asker))
-						continue; // When in solo part don't show others
-					if(m_Core.GetSolo(GetPlayer(i)->SpectatorId()))
-						continue; // When in solo part don't show others
-					if(m_Core.Team(GetPlayer(i)->SpectatorId()) != Team && m_Core.Team(GetPlayer(i)->SpectatorId()) != TEAM_SUPER)
-						continue; // In different teams
-				}
-			} // See everything of player you're spectating
-		}
-		else
-		{ // Freeview
-			if(GetPlayer(i)->m_SpecTeam)
-			{ // Show only players in own team when spectating
-				if(m_Core.Team(i) != Team && m_Core.Team(i) != TEAM_SUPER)
-					continue; // in different teams
-			}
+		CTeamVisibility::CClientState aClients[MAX_CLIENTS];
+		for(int i = 0; i < MAX_CLIENTS; ++i)
+		{
+			CTeamVisibility::CClientState &Client = aClients[i];
+			Client.m_Team = m_Core.Team(i);
+			Client.m_Solo = m_Core.GetSolo(i);
+			const CPlayer *pPlayer = GetPlayer(i);
+			if(!pPlayer)
+				continue;
+			Client.m_Exists = true;
+			Client.m_Sixup = Server()->IsSixup(i);
+			Client.m_Spectating = pPlayer->GetTeam() == TEAM_SPECTATORS || pPlayer->IsPaused();
+			Client.m_SpectatorId = pPlayer->SpectatorId();
+			Client.m_SpecTeam = pPlayer->m_SpecTeam;
+			Client.m_ShowOthers = pPlayer->m_ShowOthers;
+			Client.m_Alive = Character(i) != nullptr;
 		}
-
-		Mask.set(i);
+		m_TeamVisibility.Update(aClients);
+		m_TeamVisibilityValid = true;
 	}
-	return Mask;
+	return m_TeamVisibility.TeamMask(Team, ExceptId, Asker, VersionFlags);
+}
+
+void CGameTeams::InvalidateTeamMasks()
+{
+	m_TeamVisibilityValid = false;
 }
 
 void CGameTeams::SendTeamsState(int ClientId)
@@ -1055,6 +1090,15 @@ void CGameTeams::CancelTeamSwap(CPlayer *pPlayer, int Team)
 	pPlayer->m_SwapTargetsClientId = -1;
 }
 
+CSaveTeamPacker *CGameTeams::SaveTeamPacker()
+{
+	if(!m_pSaveTeamPacker)
+	{
+		m_pSaveTeamPacker = std::make_unique<CSaveTeamPacker>();
+	}
+	return m_pSaveTeamPacker.get();
+}
+
 void CGameTeams::ProcessSaveTeam()
 {
 	for(int Team = 0; Team < NUM_DDRACE_TEAMS; Team++)
@@ -1109,10 +1153,23 @@ void CGameTeams::ProcessSaveTeam()
 		{
 			if(GameServer()->TeeHistorianActive())
 			{
-				GameServer()->TeeHistorian()->RecordTeamSaveSuccess(
-					Team,
-					m_apSaveTeamResult[Team]->m_SaveId,
-					m_apSaveTeamResult[Team]->m_SavedTeam.GetString());
+				if(g_Config.m_SvTeeHistorianBinarySaves)
+				{
+					CSaveTeamPacker *pPacker = SaveTeamPacker();
+					m_apSaveTeamResult[Team]->m_SavedTeam.GetBinary(pPacker);
+					GameServer()->TeeHistorian()->RecordTeamSaveSuccessBinary(
+						Team,
+						m_apSaveTeamResult[Team]->m_SaveId,
+						pPacker->Data(),
+						pPacker->Size());
+				}
+				else
+				{
+					GameServer()->TeeHistorian()->RecordTeamSaveSuccess(
+						Team,
+						m_apSaveTeamResult[Team]->m_SaveId,
+						m_apSaveTeamResult[Team]->m_SavedTeam.GetString());
+				}
 			}
 			for(int i = 0; i < TeamSize; i++)
 			{
@@ -1142,10 +1199,23 @@ void CGameTeams::ProcessSaveTeam()
 		{
 			if(GameServer()->TeeHistorianActive())
 			{
-				GameServer()->TeeHistorian()->RecordTeamLoadSuccess(
-					Team,
-					m_apSaveTeamResult[Team]->m_SaveId,
-					m_apSaveTeamResult[Team]->m_SavedTeam.GetString());
+				if(g_Config.m_SvTeeHistorianBinarySaves)
+				{
+					CSaveTeamPacker *pPacker = SaveTeamPacker();
+					m_apSaveTeamResult[Team]->m_SavedTeam.GetBinary(pPacker);
+					GameServer()->TeeHistorian()->RecordTeamLoadSuccessBinary(
+						Team,
+						m_apSaveTeamResult[Team]->m_SaveId,
+						pPacker->Data(),
+						pPacker->Size());
+				}
+				else
+				{
+					GameServer()->TeeHistorian()->RecordTeamLoadSuccess(
+						Team,
+						m_apSaveTeamResult[Team]->m_SaveId,
+						m_apSaveTeamResult[Team]->m_SavedTeam.GetString());
+				}
 			}
 
 			bool TeamValid = false;
@@ -1180,6 +1250,7 @@ void CGameTeams::ProcessSaveTeam()
 void CGameTeams::OnCharacterSpawn(int ClientId)
 {
 	m_Core.SetSolo(ClientId, false);
+	InvalidateTeamMasks();
 	int Team = m_Core.Team(ClientId);
 
 	if(GetSaving(Team))
@@ -1199,6 +1270,7 @@ void CGameTeams::OnCharacterSpawn(int ClientId)
 void CGameTeams::OnCharacterDeath(int ClientId, int Weapon)
 {
 	m_Core.SetSolo(ClientId, false);
+	InvalidateTeamMasks();
 
 	int Team = m_Core.Team(ClientId);
 	if(GetSaving(Team))
@@ -6,6 +6,7 @@
 
 #include <game/race_state.h>
 #include <game/server/gamecontext.h>
+#include <game/server/save.h>
 #include <game/team_state.h>
 #include <game/teamscore.h>
 
@@ -13,6 +14,57 @@ class CCharacter;
 class CPlayer;
 struct CScoreSaveResult;
 
+/**
+ * Which clients see the events caused by which other clients. It is computed
+ * once from the state of all clients, so that team masks only combine bitsets.
+ */
+class CTeamVisibility
+{
+public:
+	class CClientState
+	{
+	public:
+		bool m_Exists = false;
+		bool m_Sixup = false;
+		// in the spectators team or paused
+		bool m_Spectating = false;
+		int m_SpectatorId = SPEC_FREEVIEW;
+		bool m_SpecTeam = false;
+		int m_ShowOthers = SHOW_OTHERS_OFF;
+		bool m_Alive = false;
+		int m_Team = TEAM_FLOCK;
+		bool m_Solo = false;
+	};
+
+	/**
+	 * Computes the visibility from the state of all clients.
+	 *
+	 * @param pClients The state of `MAX_CLIENTS` clients.
+	 */
+	void Update(const CClientState *pClients);
+
+	/**
+	 * @see CGameTeams::TeamMask
+	 */
+	CClientMask TeamMask(int Team, int ExceptId, int Asker, int VersionFlags) const;
+
+private:
+	CClientMask m_SixMask;
+	CClientMask m_SixupMask;
+	CClientMask m_SoloMask;
+	// freeview spectators, which either see everything or only the given team
+	CClientMask m_FreeviewAllMask;
+	CClientMask m_FreeviewTeamMask;
+	// clients following a living tee, i.e. their own or the spectated one, by their show others setting
+	CClientMask m_FollowAllMask;
+	CClientMask m_FollowTeamMask;
+	CClientMask m_FollowNotSoloMask;
+	// clients following a tee, which always see everything of that tee
+	CClientMask m_aFollowers[MAX_CLIENTS];
+	// clients following a tee in a team, or freeview spectators in a team
+	CClientMask m_aTeamFollowers[NUM_DDRACE_TEAMS];
+};
+
 class CGameTeams
 {
 	// `m_TeeStarted` is used to keep track whether a given tee has hit the
@@ -32,6 +84,8 @@ class CGameTeams
 	CClientMask m_aInvited[NUM_DDRACE_TEAMS];
 	bool m_aPractice[NUM_DDRACE_TEAMS];
 	std::shared_ptr<CScoreSaveResult> m_apSaveTeamResult[NUM_DDRACE_TEAMS];
+	// buffer for binary teehistorian saves, too large for the stack and only allocated when needed
+	std::unique_ptr<CSaveTeamPacker> m_pSaveTeamPacker;
 	uint64_t m_aLastSwap[MAX_CLIENTS]; // index is id of player who initiated swap
 	bool m_aTeamSentStartWarning[NUM_DDRACE_TEAMS];
 	// `m_aTeamUnfinishableKillTick` is -1 by default and gets set when a
@@ -42,6 +96,9 @@ class CGameTeams
 
 	CGameContext *m_pGameContext;
 
+	CTeamVisibility m_TeamVisibility;
+	bool m_TeamVisibilityValid;
+
 	/**
 	 * Kill the whole team.
 	 * @param Team The team id to kill
@@ -52,6 +109,7 @@ class CGameTeams
 	bool TeamFinished(int Team);
 	void OnTeamFinish(int Team, CPlayer **Players, unsigned int Size, int TimeTicks, const char *pTimestamp);
 	void OnFinish(CPlayer *Player, int TimeTicks, const char *pTimestamp);
+	CSaveTeamPacker *SaveTeamPacker();
 
 public:
 	CTeamsCore m_Core;
@@ -83,6 +141,13 @@ public:
 	void ChangeTeamState(int Team, ETeamState State);
 
 	CClientMask TeamMask(int Team, int ExceptId = -1, int Asker = -1, int VersionFlags = CGameContext::FLAG_SIX | CGameContext::FLAG_SIXUP);
+	/**
+	 * Must be called when the state that `TeamMask` depends on changes, e.g. the
+	 * team, spectator, pause, solo or show others state of a client, or when a
+	 * client joins, leaves, spawns or dies. The masks are recomputed once per
+	 * tick or on the first use after a change.
+	 */
+	void InvalidateTeamMasks();
 
 	int Count(int Team) const;
 
@@ -24,7 +24,7 @@ private:
 static const char TEEHISTORIAN_NAME[] = "teehistorian@ddnet.tw";
 static const CUuid TEEHISTORIAN_UUID = CalculateUuid(TEEHISTORIAN_NAME);
 static const char TEEHISTORIAN_VERSION[] = "2";
-static const char TEEHISTORIAN_VERSION_MINOR[] = "17";
+static const char TEEHISTORIAN_VERSION_MINOR[] = "18";
 
 #define UUID(id, name) static const CUuid UUID_##id = CalculateUuid(name);
 #include <engine/shared/teehistorian_ex_chunks.h>
@@ -670,6 +670,26 @@ void CTeeHistorian::RecordTeamSaveSuccess(int Team, CUuid SaveId, const char *pT
 	WriteExtra(UUID_TEEHISTORIAN_SAVE_SUCCESS, Buffer.Data(), Buffer.Size());
 }
 
+void CTeeHistorian::RecordTeamSaveSuccessBinary(int Team, CUuid SaveId, const void *pTeamSave, int TeamSaveSize)
+{
+	EnsureTickWritten();
+
+	CTeehistorianPacker Buffer;
+	Buffer.Reset();
+	Buffer.AddInt(Team);
+	Buffer.AddRaw(&SaveId, sizeof(SaveId));
+	Buffer.AddRaw(pTeamSave, TeamSaveSize);
+
+	if(m_Debug)
+	{
+		char aSaveId[UUID_MAXSTRSIZE];
+		FormatUuid(SaveId, aSaveId, sizeof(aSaveId));
+		dbg_msg("teehistorian", "save_success_binary team=%d save_id=%s team_save_size=%d", Team, aSaveId, TeamSaveSize);
+	}
+
+	WriteExtra(UUID_TEEHISTORIAN_SAVE_SUCCESS_BINARY, Buffer.Data(), Buffer.Size());
+}
+
 void CTeeHistorian::RecordTeamSaveFailure(int Team)
 {
 	EnsureTickWritten();
@@ -706,6 +726,26 @@ void CTeeHistorian::RecordTeamLoadSuccess(int Team, CUuid SaveId, const char *pT
 	WriteExtra(UUID_TEEHISTORIAN_LOAD_SUCCESS, Buffer.Data(), Buffer.Size());
 }
 
+void CTeeHistorian::RecordTeamLoadSuccessBinary(int Team, CUuid SaveId, const void *pTeamSave, int TeamSaveSize)
+{
+	EnsureTickWritten();
+
+	CTeehistorianPacker Buffer;
+	Buffer.Reset();
+	Buffer.AddInt(Team);
+	Buffer.AddRaw(&SaveId, sizeof(SaveId));
+	Buffer.AddRaw(pTeamSave, TeamSaveSize);
+
+	if(m_Debug)
+	{
+		char aSaveId[UUID_MAXSTRSIZE];
+		FormatUuid(SaveId, aSaveId, sizeof(aSaveId));
+		dbg_msg("teehistorian", "load_success_binary team=%d save_id=%s team_save_size=%d", Team, aSaveId, TeamSaveSize);
+	}
+
+	WriteExtra(UUID_TEEHISTORIAN_LOAD_SUCCESS_BINARY, Buffer.Data(), Buffer.Size());
+}
+
 void CTeeHistorian::RecordTeamLoadFailure(int Team)
 {
 	EnsureTickWritten();
@@ -77,8 +77,11 @@ public:
 	void RecordTestExtra();
 	void RecordPlayerSwap(int ClientId1, int ClientId2);
 	void RecordTeamSaveSuccess(int Team, CUuid SaveId, const char *pTeamSave);
+	// pTeamSave is the output of CSaveTeam::GetBinary
+	void RecordTeamSaveSuccessBinary(int Team, CUuid SaveId, const void *pTeamSave, int TeamSaveSize);
 	void RecordTeamSaveFailure(int Team);
 	void RecordTeamLoadSuccess(int Team, CUuid SaveId, const char *pTeamSave);
+	void RecordTeamLoadSuccessBinary(int Team, CUuid SaveId, const void *pTeamSave, int TeamSaveSize);
 	void RecordTeamLoadFailure(int Team);
 	void EndInputs();
 
@@ -0,0 +1,287 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <memory>
+
+// Checks every position along the line like the line intersection functions did
+// before they skipped positions on already checked tiles. Check returns whether
+// the position is a hit and the value to return for it.
+static int ReferenceIntersect(vec2 Pos0, vec2 Pos1, bool Inclusive, vec2 *pOutCollision, vec2 *pOutBeforeCollision, const std::function<bool(vec2, int *)> &Check)
+{
+	float Distance = distance(Pos0, Pos1);
+	vec2 Last = Pos0;
+	if(Inclusive)
+	{
+		int End(Distance + 1);
+		for(int i = 0; i <= End; i++)
+		{
+			float a = i / (float)End;
+			vec2 Pos = mix(Pos0, Pos1, a);
+			int Hit;
+			if(Check(Pos, &Hit))
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return Hit;
+			}
+			Last = Pos;
+		}
+	}
+	else
+	{
+		const int DistanceRounded = std::ceil(Distance);
+		for(int i = 0; i < DistanceRounded; i++)
+		{
+			float a = (float)i / Distance;
+			vec2 Pos = mix(Pos0, Pos1, a);
+			int Hit;
+			if(Check(Pos, &Hit))
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return Hit;
+			}
+			Last = Pos;
+		}
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+class CollisionIntersect : public ::testing::Test
+{
+protected:
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IKernel> m_pKernel;
+	std::unique_ptr<IStorage> m_pStorage;
+	IEngineMap *m_pMap = nullptr;
+	CLayers m_Layers;
+	CCollision m_Collision;
+	CPrng m_Prng;
+	int m_OldTeleportHook = 0;
+	int m_OldTeleportWeapons = 0;
+
+	void SetUp() override
+	{
+		// the tests change the config, it is restored afterwards
+		m_OldTeleportHook = g_Config.m_SvOldTeleportHook;
+		m_OldTeleportWeapons = g_Config.m_SvOldTeleportWeapons;
+
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		ASSERT_NE(m_pStorage, nullptr);
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+		ASSERT_TRUE(m_pMap->Load("maps/coverage.map"));
+		m_Layers.Init(m_pMap, true);
+		m_Collision.Init(&m_Layers);
+
+		uint64_t aSeed[2] = {0x1f2e3d4c5b6a7988, 0x0123456789abcdef};
+		m_Prng.Seed(aSeed);
+	}
+
+	void TearDown() override
+	{
+		g_Config.m_SvOldTeleportHook = m_OldTeleportHook;
+		g_Config.m_SvOldTeleportWeapons = m_OldTeleportWeapons;
+		m_Collision.Unload();
+		m_pMap->Unload();
+	}
+
+	float RandomFloat(float Min, float Max)
+	{
+		return Min + (Max - Min) * (m_Prng.RandomBits() / (float)0xffffffffu);
+	}
+
+	vec2 RandomPos()
+	{
+		// mostly inside the map, sometimes outside of it
+		const float Margin = 200.0f;
+		return vec2(RandomFloat(-Margin, m_Collision.GetWidth() * 32 + Margin), RandomFloat(-Margin, m_Collision.GetHeight() * 32 + Margin));
+	}
+
+	void RandomLine(vec2 *pPos0, vec2 *pPos1)
+	{
+		*pPos0 = RandomPos();
+		switch(m_Prng.RandomBits() % 6)
+		{
+		case 0: // short
+			*pPos1 = *pPos0 + vec2(RandomFloat(-40, 40), RandomFloat(-40, 40));
+			break;
+		case 1: // horizontal
+			*pPos1 = vec2(RandomFloat(-200, m_Collision.GetWidth() * 32 + 200), pPos0->y);
+			break;
+		case 2: // vertical
+			*pPos1 = vec2(pPos0->x, RandomFloat(-200, m_Collision.GetHeight() * 32 + 200));
+			break;
+		case 3: // diagonal
+		{
+			const float Length = RandomFloat(-800, 800);
+			*pPos1 = *pPos0 + vec2(Length, (m_Prng.RandomBits() % 2) ? Length : -Length);
+			break;
+		}
+		case 4: // empty
+			*pPos1 = *pPos0;
+			break;
+		default: // long
+			*pPos1 = RandomPos();
+			break;
+		}
+		if(m_Prng.RandomBits() % 4 == 0)
+		{
+			// tile aligned coordinates hit the rounding boundaries exactly
+			*pPos0 = vec2(std::round(pPos0->x / 16) * 16 - 0.5f, std::round(pPos0->y / 16) * 16);
+		}
+	}
+
+	template<typename TIntersect>
+	void ExpectEqual(const char *pName, vec2 Pos0, vec2 Pos1, bool Inclusive, TIntersect &&Intersect, const std::function<bool(vec2, int *)> &Check)
+	{
+		SCOPED_TRACE(pName);
+		vec2 Collision, BeforeCollision, RefCollision, RefBeforeCollision;
+		const int Hit = Intersect(Pos0, Pos1, &Collision, &BeforeCollision);
+		const int RefHit = ReferenceIntersect(Pos0, Pos1, Inclusive, &RefCollision, &RefBeforeCollision, Check);
+		EXPECT_EQ(Hit, RefHit) << "from (" << Pos0.x << ", " << Pos0.y << ") to (" << Pos1.x << ", " << Pos1.y << ")";
+		EXPECT_EQ(Collision, RefCollision);
+		EXPECT_EQ(BeforeCollision, RefBeforeCollision);
+	}
+};
+
+TEST_F(CollisionIntersect, MatchesCheckingEveryPosition)
+{
+	const CCollision &Col = m_Collision;
+	for(int Round = 0; Round < 20000; Round++)
+	{
+		vec2 Pos0, Pos1;
+		RandomLine(&Pos0, &Pos1);
+
+		ExpectEqual(
+			"IntersectLine", Pos0, Pos1, true, [&](vec2 From, vec2 To, vec2 *pCol, vec2 *pBefore) { return Col.IntersectLine(From, To, pCol, pBefore); },
+			[&](vec2 Pos, int *pHit) {
+				int ix = round_to_int(Pos.x);
+				int iy = round_to_int(Pos.y);
+				*pHit = Col.GetCollisionAt(ix, iy);
+				return Col.CheckPoint(ix, iy);
+			});
+
+		ExpectEqual(
+			"IntersectNoLaser", Pos0, Pos1, false, [&](vec2 From, vec2 To, vec2 *pCol, vec2 *pBefore) { return Col.IntersectNoLaser(From, To, pCol, pBefore); },
+			[&](vec2 Pos, int *pHit) {
+				int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, Col.GetWidth() - 1);
+				int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, Col.GetHeight() - 1);
+				if(Col.GetIndex(Nx, Ny) == TILE_SOLID || Col.GetIndex(Nx, Ny) == TILE_NOHOOK || Col.GetIndex(Nx, Ny) == TILE_NOLASER || Col.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+				{
+					*pHit = Col.GetFrontIndex(Nx, Ny) == TILE_NOLASER ? Col.GetFrontCollisionAt(Pos.x, Pos.y) : Col.GetCollisionAt(Pos.x, Pos.y);
+					return true;
+				}
+				return false;
+			});
+
+		ExpectEqual(
+			"IntersectNoLaserNoWalls", Pos0, Pos1, false, [&](vec2 From, vec2 To, vec2 *pCol, vec2 *pBefore) { return Col.IntersectNoLaserNoWalls(From, To, pCol, pBefore); },
+			[&](vec2 Pos, int *pHit) {
+				int ix = round_to_int(Pos.x);
+				int iy = round_to_int(Pos.y);
+				*pHit = Col.IsNoLaser(ix, iy) ? Col.GetCollisionAt(Pos.x, Pos.y) : Col.GetFrontCollisionAt(Pos.x, Pos.y);
+				return Col.IsNoLaser(ix, iy) || Col.IsFrontNoLaser(ix, iy);
+			});
+
+		ExpectEqual(
+			"IntersectAir", Pos0, Pos1, false, [&](vec2 From, vec2 To, vec2 *pCol, vec2 *pBefore) { return Col.IntersectAir(From, To, pCol, pBefore); },
+			[&](vec2 Pos, int *pHit) {
+				int ix = round_to_int(Pos.x);
+				int iy = round_to_int(Pos.y);
+				if(!Col.GetTile(ix, iy) && !Col.GetFrontTile(ix, iy))
+					*pHit = -1;
+				else if(!Col.GetTile(ix, iy))
+					*pHit = Col.GetTile(ix, iy);
+				else
+					*pHit = Col.GetFrontTile(ix, iy);
+				return Col.IsSolid(ix, iy) || *pHit == -1;
+			});
+	}
+}
+
+TEST_F(CollisionIntersect, TeleMatchesCheckingEveryPosition)
+{
+	const CCollision &Col = m_Collision;
+	for(int Round = 0; Round < 20000; Round++)
+	{
+		vec2 Pos0, Pos1;
+		RandomLine(&Pos0, &Pos1);
+		const bool OldTeleport = m_Prng.RandomBits() % 2;
+		g_Config.m_SvOldTeleportHook = OldTeleport;
+		g_Config.m_SvOldTeleportWeapons = OldTeleport;
+
+		for(bool WithTeleNr : {false, true})
+		{
+			int TeleNr = -1;
+			int RefTeleNr = -1;
+			int *pTeleNr = WithTeleNr ? &TeleNr : nullptr;
+			int *pRefTeleNr = WithTeleNr ? &RefTeleNr : nullptr;
+
+			int dx = 0, dy = 0;
+			ThroughOffset(Pos0, Pos1, &dx, &dy);
+			ExpectEqual(
+				"IntersectLineTeleHook", Pos0, Pos1, true, [&](vec2 From, vec2 To, vec2 *pCol, vec2 *pBefore) { return Col.IntersectLineTeleHook(From, To, pCol, pBefore, pTeleNr); },
+				[&](vec2 Pos, int *pHit) {
+					int ix = round_to_int(Pos.x);
+					int iy = round_to_int(Pos.y);
+					int Index = Col.GetPureMapIndex(Pos);
+					if(pRefTeleNr)
+					{
+						*pRefTeleNr = OldTeleport ? Col.IsTeleport(Index) : Col.IsTeleportHook(Index);
+						*pHit = TILE_TELEINHOOK;
+						if(*pRefTeleNr)
+							return true;
+					}
+					*pHit = 0;
+					if(Col.CheckPoint(ix, iy))
+					{
+						if(!Col.IsThrough(ix, iy, dx, dy, Pos0, Pos1))
+							*pHit = Col.GetCollisionAt(ix, iy);
+					}
+					else if(Col.IsHookBlocker(ix, iy, Pos0, Pos1))
+						*pHit = TILE_NOHOOK;
+					return *pHit != 0;
+				});
+			EXPECT_EQ(TeleNr, RefTeleNr);
+
+			TeleNr = RefTeleNr = -1;
+			ExpectEqual(
+				"IntersectLineTeleWeapon", Pos0, Pos1, true, [&](vec2 From, vec2 To, vec2 *pCol, vec2 *pBefore) { return Col.IntersectLineTeleWeapon(From, To, pCol, pBefore, pTeleNr); },
+				[&](vec2 Pos, int *pHit) {
+					int ix = round_to_int(Pos.x);
+					int iy = round_to_int(Pos.y);
+					int Index = Col.GetPureMapIndex(Pos);
+					if(pRefTeleNr)
+					{
+						*pRefTeleNr = OldTeleport ? Col.IsTeleport(Index) : Col.IsTeleportWeapon(Index);
+						*pHit = TILE_TELEINWEAPON;
+						if(*pRefTeleNr)
+							return true;
+					}
+					*pHit = Col.GetCollisionAt(ix, iy);
+					return Col.CheckPoint(ix, iy);
+				});
+			EXPECT_EQ(TeleNr, RefTeleNr);
+		}
+	}
+}
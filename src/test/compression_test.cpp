@@ -1,7 +1,15 @@
+#include <base/math.h>
+#include <base/system.h>
+
 #include <engine/shared/compression.h>
+#include <engine/shared/simd.h>
+
+#include <game/prng.h>
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 static const int DATA[] = {0, 1, -1, 32, 64, 256, -512, 12345, -123456, 1234567, 12345678, 123456789, 2147483647, (-2147483647 - 1)};
 static const int NUM = std::size(DATA);
 static const int SIZES[NUM] = {1, 1, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4, 5, 5};
@@ -82,3 +90,66 @@ TEST(CVariableInt, DecompressBufferTooSmall)
 	long CompressedSize = CVariableInt::Decompress(aCompressed, sizeof(aCompressed), aUncompressed, sizeof(aUncompressed));
 	ASSERT_EQ(CompressedSize, -1);
 }
+
+static int RandomInt(CPrng &Prng, int SmallPercentage)
+{
+	// snapshot deltas mostly consist of small values
+	if((int)(Prng.RandomBits() % 100) < SmallPercentage)
+		return (int)(Prng.RandomBits() % 128) - 64;
+	return (int)Prng.RandomBits() >> (Prng.RandomBits() % 32);
+}
+
+TEST(CVariableInt, SimdMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+	const CSimd::ELevel OldLevel = CSimd::Level();
+
+	for(int SmallPercentage : {0, 50, 90, 100})
+	{
+		for(int Num = 0; Num < 150; Num++)
+		{
+			std::vector<int> vData(Num);
+			for(int &Value : vData)
+				Value = RandomInt(Prng, SmallPercentage);
+
+			unsigned char aExpected[150 * CVariableInt::MAX_BYTES_PACKED];
+			ASSERT_TRUE(CSimd::SetLevel(CSimd::LEVEL_SCALAR));
+			const long ExpectedSize = CVariableInt::Compress(vData.data(), Num * sizeof(int), aExpected, sizeof(aExpected));
+			ASSERT_GE(ExpectedSize, 0);
+			// too small for the last packed int
+			unsigned char aShort[sizeof(aExpected)];
+			const long ExpectedShortSize = CVariableInt::Compress(vData.data(), Num * sizeof(int), aShort, maximum<long>(ExpectedSize - 1, 0));
+
+			for(int Level = CSimd::LEVEL_SSE2; Level <= CSimd::LEVEL_NEON; Level++)
+			{
+				if(!CSimd::SetLevel((CSimd::ELevel)Level))
+					continue;
+
+				unsigned char aCompressed[150 * CVariableInt::MAX_BYTES_PACKED];
+				const long CompressedSize = CVariableInt::Compress(vData.data(), Num * sizeof(int), aCompressed, sizeof(aCompressed));
+				ASSERT_EQ(CompressedSize, ExpectedSize) << CSimd::LevelName((CSimd::ELevel)Level);
+				EXPECT_EQ(mem_comp(aCompressed, aExpected, ExpectedSize), 0) << CSimd::LevelName((CSimd::ELevel)Level);
+				EXPECT_EQ(CVariableInt::Compress(vData.data(), Num * sizeof(int), aShort, maximum<long>(ExpectedSize - 1, 0)), ExpectedShortSize);
+
+				std::vector<int> vDecompressed(Num + 1);
+				const long DecompressedSize = CVariableInt::Decompress(aExpected, ExpectedSize, vDecompressed.data(), Num * sizeof(int));
+				ASSERT_EQ(DecompressedSize, (long)(Num * sizeof(int))) << CSimd::LevelName((CSimd::ELevel)Level);
+				for(int i = 0; i < Num; i++)
+					EXPECT_EQ(vDecompressed[i], vData[i]);
+				if(Num > 0)
+				{
+					// destination too small, source truncated
+					EXPECT_EQ(CVariableInt::Decompress(aExpected, ExpectedSize, vDecompressed.data(), (Num - 1) * sizeof(int)), -1);
+					ASSERT_TRUE(CSimd::SetLevel(CSimd::LEVEL_SCALAR));
+					const long ExpectedTruncated = CVariableInt::Decompress(aExpected, ExpectedSize - 1, vDecompressed.data(), Num * sizeof(int));
+					ASSERT_TRUE(CSimd::SetLevel((CSimd::ELevel)Level));
+					EXPECT_EQ(CVariableInt::Decompress(aExpected, ExpectedSize - 1, vDecompressed.data(), Num * sizeof(int)), ExpectedTruncated);
+				}
+			}
+		}
+	}
+
+	CSimd::SetLevel(OldLevel);
+}
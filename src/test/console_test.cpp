@@ -0,0 +1,153 @@
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/shared/config.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+class CConsoleTest : public ::testing::Test
+{
+protected:
+	std::unique_ptr<IConsole> m_pConsole = CreateConsole(CFGFLAG_SERVER);
+	std::vector<std::string> m_vCalls;
+	int m_NumChainCalls = 0;
+
+	static void ConRecord(IConsole::IResult *pResult, void *pUserData)
+	{
+		CConsoleTest *pSelf = static_cast<CConsoleTest *>(pUserData);
+		std::string Call;
+		for(int i = 0; i < pResult->NumArguments(); i++)
+		{
+			if(i > 0)
+				Call += ",";
+			Call += pResult->GetString(i);
+		}
+		pSelf->m_vCalls.push_back(Call);
+	}
+
+	static void ConchainCount(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
+	{
+		static_cast<CConsoleTest *>(pUserData)->m_NumChainCalls++;
+		pfnCallback(pResult, pCallbackUserData);
+	}
+
+	void RegisterRecord(const char *pName, const char *pParams)
+	{
+		m_pConsole->Register(pName, pParams, CFGFLAG_SERVER, ConRecord, this, "");
+	}
+};
+
+TEST_F(CConsoleTest, ExecuteLine)
+{
+	RegisterRecord("record", "s[a] ?i[b]");
+	m_pConsole->ExecuteLine("record foo 5; RECORD \"bar baz\"");
+	m_pConsole->ExecuteLine("record");
+	ASSERT_EQ(m_vCalls.size(), 2u);
+	EXPECT_EQ(m_vCalls[0], "foo,5");
+	EXPECT_EQ(m_vCalls[1], "bar baz");
+}
+
+TEST_F(CConsoleTest, CompiledLineRepeated)
+{
+	RegisterRecord("record", "s[a] ?i[b]");
+	std::unique_ptr<IConsole::ICompiledLine> pLine = m_pConsole->CompileLine("record foo 5; Record bar;; record");
+	EXPECT_STREQ(pLine->Line(), "record foo 5; Record bar;; record");
+	for(int i = 0; i < 3; i++)
+	{
+		m_vCalls.clear();
+		m_pConsole->ExecuteCompiledLine(pLine.get());
+		ASSERT_EQ(m_vCalls.size(), 2u);
+		EXPECT_EQ(m_vCalls[0], "foo,5");
+		EXPECT_EQ(m_vCalls[1], "bar");
+	}
+}
+
+TEST_F(CConsoleTest, CompiledLineStroke)
+{
+	RegisterRecord("+record", "?s[a]");
+	RegisterRecord("record", "?s[a]");
+	std::unique_ptr<IConsole::ICompiledLine> pLine = m_pConsole->CompileLine("+record x; record y");
+	m_pConsole->ExecuteCompiledLineStroked(1, pLine.get());
+	m_pConsole->ExecuteCompiledLineStroked(0, pLine.get());
+	m_pConsole->ExecuteCompiledLineStroked(1, pLine.get());
+	ASSERT_EQ(m_vCalls.size(), 5u);
+	EXPECT_EQ(m_vCalls[0], "1,x");
+	EXPECT_EQ(m_vCalls[1], "y");
+	EXPECT_EQ(m_vCalls[2], "0,x");
+	EXPECT_EQ(m_vCalls[3], "1,x");
+	EXPECT_EQ(m_vCalls[4], "y");
+}
+
+TEST_F(CConsoleTest, CompiledLineResolvesLater)
+{
+	std::unique_ptr<IConsole::ICompiledLine> pLine = m_pConsole->CompileLine("later 1");
+	m_pConsole->ExecuteCompiledLine(pLine.get());
+	EXPECT_TRUE(m_vCalls.empty());
+
+	RegisterRecord("later", "i[a]");
+	m_pConsole->ExecuteCompiledLine(pLine.get());
+	ASSERT_EQ(m_vCalls.size(), 1u);
+	EXPECT_EQ(m_vCalls[0], "1");
+
+	m_pConsole->Chain("later", ConchainCount, this);
+	m_pConsole->ExecuteCompiledLine(pLine.get());
+	EXPECT_EQ(m_vCalls.size(), 2u);
+	EXPECT_EQ(m_NumChainCalls, 1);
+}
+
+TEST_F(CConsoleTest, CompiledLineInvalidArguments)
+{
+	RegisterRecord("record", "i[a]");
+	std::unique_ptr<IConsole::ICompiledLine> pLine = m_pConsole->CompileLine("record; record 3");
+	m_pConsole->ExecuteCompiledLine(pLine.get());
+	m_pConsole->ExecuteCompiledLine(pLine.get());
+	ASSERT_EQ(m_vCalls.size(), 2u);
+	EXPECT_EQ(m_vCalls[0], "3");
+	EXPECT_EQ(m_vCalls[1], "3");
+}
+
+TEST_F(CConsoleTest, CompiledLineSemicolons)
+{
+	RegisterRecord("record", "r[a]");
+	std::unique_ptr<IConsole::ICompiledLine> pLine = m_pConsole->CompileLine("record a; record b", false);
+	m_pConsole->ExecuteCompiledLine(pLine.get());
+	ASSERT_EQ(m_vCalls.size(), 1u);
+	EXPECT_EQ(m_vCalls[0], "a; record b");
+}
+
+TEST_F(CConsoleTest, ParseLine)
+{
+	RegisterRecord("record", "s[a] ?i[b]");
+	RegisterRecord("other", "i[a]");
+	std::vector<std::string> vParsed;
+	m_pConsole->ParseLine("mc;record foo 5; unknown x; other nope; record \"bar; baz\"; RECORD qux", [](const IConsole::ICommandInfo *pCommand, IConsole::IResult *pResult, void *pUser) {
+		std::string Parsed = pCommand->Name();
+		for(int i = 0; i < pResult->NumArguments(); i++)
+			Parsed += std::string(",") + pResult->GetString(i);
+		static_cast<std::vector<std::string> *>(pUser)->push_back(Parsed);
+	},
+		&vParsed);
+	EXPECT_TRUE(m_vCalls.empty());
+	ASSERT_EQ(vParsed.size(), 3u);
+	EXPECT_EQ(vParsed[0], "record,foo,5");
+	EXPECT_EQ(vParsed[1], "record,bar; baz");
+	EXPECT_EQ(vParsed[2], "record,qux");
+}
+
+TEST_F(CConsoleTest, GetCommandInfo)
+{
+	RegisterRecord("record", "");
+	EXPECT_NE(m_pConsole->GetCommandInfo("record", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_NE(m_pConsole->GetCommandInfo("RECORD", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_EQ(m_pConsole->GetCommandInfo("record", CFGFLAG_CLIENT, false), nullptr);
+	EXPECT_EQ(m_pConsole->GetCommandInfo("recor", CFGFLAG_SERVER, false), nullptr);
+
+	m_pConsole->RegisterTemp("temp", "", CFGFLAG_SERVER, "");
+	EXPECT_NE(m_pConsole->GetCommandInfo("temp", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(m_pConsole->GetCommandInfo("temp", CFGFLAG_SERVER, false), nullptr);
+	m_pConsole->DeregisterTemp("temp");
+	EXPECT_EQ(m_pConsole->GetCommandInfo("temp", CFGFLAG_SERVER, true), nullptr);
+}
@@ -1,5 +1,8 @@
 #include "test.h"
 
+#include <base/system.h>
+
+#include <engine/engine.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
@@ -8,6 +11,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 TEST(Datafile, ExtendedType)
 {
@@ -112,3 +116,311 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+static const char s_aUncompressedData[] = "abc\0xy\0wxyz";
+static const int s_UncompressedHeaderSize = 36 + 40;
+
+// version 3 datafiles store the data uncompressed, so it can be used directly from the file buffer
+static void WriteUncompressedDatafile(const char *pFilename)
+{
+	int aHeader[] = {
+		0x41544144, // "DATA"
+		3, // version
+		36 + 40 + 11 - 16, // size
+		36 + 40 - 16, // swaplen
+		1, // num item types
+		1, // num items
+		3, // num data
+		12, // item size
+		11, // data size
+		// item type, start, num
+		1,
+		0,
+		1,
+		// item offset
+		0,
+		// data offsets
+		0,
+		4,
+		7,
+		// item type and ID, size, data
+		(1 << 16) | 5,
+		4,
+		1234,
+	};
+	static_assert(sizeof(aHeader) == s_UncompressedHeaderSize);
+#if defined(CONF_ARCH_ENDIAN_BIG)
+	swap_endian(aHeader, sizeof(int), std::size(aHeader));
+#endif
+	IOHANDLE File = io_open(pFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, aHeader, sizeof(aHeader)), sizeof(aHeader));
+	EXPECT_EQ(io_write(File, s_aUncompressedData, 11), 11u);
+	EXPECT_FALSE(io_close(File));
+}
+
+TEST(Datafile, UncompressedData)
+{
+	CTestInfo Info;
+
+	WriteUncompressedDatafile(Info.m_aFilename);
+
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+	EXPECT_EQ(Reader.MapSize(), s_UncompressedHeaderSize + 11);
+	EXPECT_EQ(*(const int *)Reader.FindItem(1, 5), 1234);
+	EXPECT_STREQ(Reader.GetDataString(0), "abc");
+	EXPECT_STREQ(Reader.GetDataString(1), "xy");
+	ASSERT_EQ(Reader.GetDataSize(2), 4);
+	// not aligned in the file, so it is copied
+	const char *pData = static_cast<const char *>(Reader.GetData(2));
+	ASSERT_TRUE(pData);
+	EXPECT_EQ((uintptr_t)pData % sizeof(int), 0u);
+	EXPECT_TRUE(mem_comp(pData, "wxyz", 4) == 0);
+
+	// the data can be modified, unloaded and replaced
+	char *pString = static_cast<char *>(Reader.GetData(0));
+	ASSERT_TRUE(pString);
+	pString[0] = 'A';
+	EXPECT_STREQ(Reader.GetDataString(0), "Abc");
+	Reader.UnloadData(0);
+	Reader.UnloadData(2);
+	EXPECT_TRUE(mem_comp(Reader.GetData(2), "wxyz", 4) == 0);
+	char *pReplacement = static_cast<char *>(malloc(4));
+	str_copy(pReplacement, "def", 4);
+	Reader.ReplaceData(0, pReplacement, 4);
+	EXPECT_STREQ(Reader.GetDataString(0), "def");
+	Reader.Close();
+
+	// the file is never modified
+	{
+		IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_READ);
+		ASSERT_TRUE(File);
+		char aBuf[s_UncompressedHeaderSize + 11];
+		EXPECT_EQ(io_read(File, aBuf, sizeof(aBuf)), sizeof(aBuf));
+		EXPECT_TRUE(mem_comp(aBuf + s_UncompressedHeaderSize, s_aUncompressedData, 11) == 0);
+		EXPECT_FALSE(io_close(File));
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, SharedFileData)
+{
+	CTestInfo Info;
+	WriteUncompressedDatafile(Info.m_aFilename);
+
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+
+	// aligned in the file, so it is used in place before the content is shared
+	char *pString = static_cast<char *>(Reader.GetData(0));
+	ASSERT_TRUE(pString);
+	const unsigned char *pFileData = Reader.FileData();
+	ASSERT_TRUE(pFileData);
+	EXPECT_EQ(Reader.FileData(), pFileData);
+	EXPECT_TRUE(mem_comp(pFileData + s_UncompressedHeaderSize, s_aUncompressedData, 11) == 0);
+
+	// the data that was used in place has been copied, so changing it does not change the content
+	pString = static_cast<char *>(Reader.GetData(0));
+	ASSERT_TRUE(pString);
+	EXPECT_FALSE((const unsigned char *)pString >= pFileData && (const unsigned char *)pString < pFileData + Reader.MapSize());
+	pString[0] = 'A';
+	EXPECT_STREQ(Reader.GetDataString(0), "Abc");
+	char *pOther = static_cast<char *>(Reader.GetData(1));
+	ASSERT_TRUE(pOther);
+	EXPECT_FALSE((const unsigned char *)pOther >= pFileData && (const unsigned char *)pOther < pFileData + Reader.MapSize());
+	pOther[0] = 'X';
+	EXPECT_TRUE(mem_comp(pFileData + s_UncompressedHeaderSize, s_aUncompressedData, 11) == 0);
+	Reader.Close();
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, FileTruncatedWhileOpen)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		EXPECT_EQ(Writer.AddDataString("Abc"), 0);
+		EXPECT_EQ(Writer.AddDataString("Def"), 1);
+		Writer.Finish();
+	}
+
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+	const int Size = Reader.MapSize();
+	EXPECT_STREQ(Reader.GetDataString(0), "Abc");
+
+	// the file is read into memory when it is opened, so truncating it does not affect the reader
+	{
+		IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+		ASSERT_TRUE(File);
+		EXPECT_FALSE(io_close(File));
+	}
+	EXPECT_STREQ(Reader.GetDataString(1), "Def");
+	const unsigned char *pFileData = Reader.FileData();
+	ASSERT_TRUE(pFileData);
+	EXPECT_EQ(mem_comp(pFileData, "DATA", 4), 0);
+	EXPECT_EQ(Reader.MapSize(), Size);
+	Reader.Close();
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, LoadDataInParallel)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	std::vector<std::vector<int>> vvData(64);
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		for(size_t i = 0; i < vvData.size(); i++)
+		{
+			vvData[i].resize(1 + i * i * 16);
+			for(size_t j = 0; j < vvData[i].size(); j++)
+				vvData[i][j] = (j * j) % (i + 7);
+			EXPECT_EQ(Writer.AddData(vvData[i].size() * sizeof(int), vvData[i].data()), (int)i);
+		}
+		Writer.Finish();
+	}
+
+	std::unique_ptr<IEngine> pEngine(CreateTestEngine("test"));
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+	const auto &&ExpectData = [&](int Index) {
+		ASSERT_EQ(Reader.GetDataSize(Index), (int)(vvData[Index].size() * sizeof(int)));
+		EXPECT_TRUE(mem_comp(Reader.GetData(Index), vvData[Index].data(), Reader.GetDataSize(Index)) == 0);
+	};
+
+	// invalid, duplicate and already loaded indices are skipped
+	ExpectData(3);
+	std::vector<int> vIndices = {-1, 3, 1000};
+	for(int i = 0; i < (int)vvData.size(); i++)
+		vIndices.push_back(i % 2 == 0 ? i : vvData.size() - i);
+	Reader.LoadData(pEngine.get(), vIndices);
+	for(int i = 0; i < (int)vvData.size(); i++)
+		ExpectData(i);
+
+	// unloaded data can be loaded again, also without the engine
+	Reader.UnloadData(5);
+	Reader.UnloadData(6);
+	Reader.LoadData(pEngine.get(), {5});
+	Reader.LoadData(nullptr, {6});
+	ExpectData(5);
+	ExpectData(6);
+	Reader.Close();
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, FinishIsDeterministic)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	std::vector<std::vector<int>> vvData(40);
+	for(size_t i = 0; i < vvData.size(); i++)
+	{
+		vvData[i].resize(1 + (i * 7919) % 40000);
+		for(size_t j = 0; j < vvData[i].size(); j++)
+			vvData[i][j] = (j * (i + 3)) % 251;
+	}
+
+	std::vector<unsigned char> vFirstFile;
+	for(int MaxThreads : {1, 2, 3, 16, 0})
+	{
+		SCOPED_TRACE(MaxThreads);
+		char aFilename[IO_MAX_PATH_LENGTH];
+		char aSuffix[32];
+		str_format(aSuffix, sizeof(aSuffix), "-%d.map", MaxThreads);
+		Info.Filename(aFilename, sizeof(aFilename), aSuffix);
+		{
+			CDataFileWriter Writer;
+			ASSERT_TRUE(Writer.Open(pStorage.get(), aFilename));
+			for(size_t i = 0; i < vvData.size(); i++)
+			{
+				Writer.AddItem(MAPITEMTYPE_TEST, i, sizeof(int), &vvData[i][0]);
+				Writer.AddData(vvData[i].size() * sizeof(int), vvData[i].data(), i % 3 == 0 ? CDataFileWriter::COMPRESSION_BEST : CDataFileWriter::COMPRESSION_DEFAULT);
+			}
+			Writer.Finish(MaxThreads);
+		}
+
+		void *pData;
+		unsigned Size;
+		ASSERT_TRUE(pStorage->ReadFile(aFilename, IStorage::TYPE_SAVE, &pData, &Size));
+		std::vector<unsigned char> vFile((unsigned char *)pData, (unsigned char *)pData + Size);
+		free(pData);
+		if(vFirstFile.empty())
+			vFirstFile = vFile;
+		else
+			EXPECT_EQ(vFile, vFirstFile);
+
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), aFilename, IStorage::TYPE_ALL));
+		ASSERT_EQ(Reader.NumData(), (int)vvData.size());
+		for(size_t i = 0; i < vvData.size(); i++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(i), (int)(vvData[i].size() * sizeof(int)));
+			EXPECT_TRUE(mem_comp(Reader.GetData(i), vvData[i].data(), Reader.GetDataSize(i)) == 0);
+		}
+		Reader.Close();
+
+		if(!HasFailure())
+		{
+			pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+		}
+	}
+}
+
+TEST(Datafile, FinishWithoutData)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		Writer.AddItem(MAPITEMTYPE_TEST, 0, 0, nullptr);
+		Writer.Finish(4);
+	}
+
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+	EXPECT_EQ(Reader.NumData(), 0);
+	EXPECT_GE(Reader.FindItemIndex(MAPITEMTYPE_TEST, 0), 0);
+	Reader.Close();
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
@@ -0,0 +1,209 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/demo.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <game/prng.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+static std::vector<unsigned char> ReadDemo(IStorage *pStorage, const char *pFilename)
+{
+	void *pData;
+	unsigned Size;
+	if(!pStorage->ReadFile(pFilename, IStorage::TYPE_SAVE, &pData, &Size))
+		return {};
+	std::vector<unsigned char> vData((unsigned char *)pData, (unsigned char *)pData + Size);
+	free(pData);
+	// the timestamp depends on when the recording was started
+	if(vData.size() >= sizeof(CDemoHeader))
+		std::fill_n(vData.begin() + offsetof(CDemoHeader, m_aTimestamp), sizeof(CDemoHeader::m_aTimestamp), 0);
+	return vData;
+}
+
+TEST(Demo, BackgroundWriterMatchesDirectWrites)
+{
+	CNetBase::Init();
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+
+	CSnapshotDelta SnapshotDelta;
+	CDemoRecordWriter Writer;
+	CDemoRecorder Direct(&SnapshotDelta, false);
+	// several recorders share the writer
+	CDemoRecorder aBackground[2] = {CDemoRecorder(&SnapshotDelta, false, &Writer), CDemoRecorder(&SnapshotDelta, false, &Writer)};
+	CDemoRecorder *apRecorders[] = {&Direct, &aBackground[0], &aBackground[1]};
+	const char *apFilenames[] = {"direct.demo", "background0.demo", "background1.demo"};
+
+	unsigned char aMapData[1000];
+	for(size_t i = 0; i < sizeof(aMapData); i++)
+		aMapData[i] = i * 7;
+	SHA256_DIGEST Sha256 = sha256(aMapData, sizeof(aMapData));
+	for(int i = 0; i < 3; i++)
+		ASSERT_EQ(apRecorders[i]->Start(pStorage.get(), nullptr, apFilenames[i], "0.6 626fce9a778df4d4", "map", Sha256, 0x1234, "server", sizeof(aMapData), aMapData, nullptr, nullptr, nullptr), 0);
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {1, 2};
+	Prng.Seed(aSeed);
+
+	CSnapshotBuilder Builder;
+	alignas(CSnapshot) char aSnapshot[CSnapshot::MAX_SIZE];
+	int aItems[64][8] = {};
+	std::vector<unsigned char> vMessage;
+	for(int Tick = 1; Tick <= 1000; Tick++)
+	{
+		Builder.Init();
+		for(int Item = 0; Item < 64; Item++)
+		{
+			if(Prng.RandomBits() % 4 == 0)
+				aItems[Item][Prng.RandomBits() % 8] = Prng.RandomBits();
+			if(Item % 8 == Tick % 8)
+				continue;
+			int *pData = (int *)Builder.NewItem(1 + Item % 5, Item, sizeof(aItems[Item]));
+			ASSERT_TRUE(pData);
+			mem_copy(pData, aItems[Item], sizeof(aItems[Item]));
+		}
+		const int SnapshotSize = Builder.Finish(aSnapshot);
+
+		// large incompressible messages fill the queues of the background recorders
+		const int MessageSize = Tick % 50 == 0 ? 30000 : Prng.RandomBits() % 300;
+		vMessage.resize(MessageSize);
+		for(auto &Byte : vMessage)
+			Byte = Prng.RandomBits();
+
+		for(CDemoRecorder *pRecorder : apRecorders)
+		{
+			pRecorder->RecordSnapshot(Tick, aSnapshot, SnapshotSize);
+			pRecorder->RecordMessage(vMessage.data(), vMessage.size());
+			if(Tick % 100 == 0)
+				pRecorder->AddDemoMarker(Tick);
+		}
+	}
+
+	for(CDemoRecorder *pRecorder : apRecorders)
+		EXPECT_EQ(pRecorder->Stop(IDemoRecorder::EStopMode::KEEP_FILE), 0);
+
+	const std::vector<unsigned char> vDirect = ReadDemo(pStorage.get(), apFilenames[0]);
+	ASSERT_GT(vDirect.size(), 1000000u);
+	EXPECT_EQ(ReadDemo(pStorage.get(), apFilenames[1]), vDirect);
+	EXPECT_EQ(ReadDemo(pStorage.get(), apFilenames[2]), vDirect);
+	// the index is only written when requested
+	for(const char *pFilename : apFilenames)
+	{
+		char aIndexFilename[IO_MAX_PATH_LENGTH];
+		str_format(aIndexFilename, sizeof(aIndexFilename), "%s.idx", pFilename);
+		EXPECT_FALSE(pStorage->FileExists(aIndexFilename, IStorage::TYPE_SAVE)) << aIndexFilename;
+	}
+
+	// recorders can be started again after stopping
+	ASSERT_EQ(aBackground[0].Start(pStorage.get(), nullptr, apFilenames[1], "0.6 626fce9a778df4d4", "map", Sha256, 0x1234, "server", sizeof(aMapData), aMapData, nullptr, nullptr, nullptr), 0);
+	aBackground[0].RecordMessage(aMapData, sizeof(aMapData));
+	EXPECT_EQ(aBackground[0].Stop(IDemoRecorder::EStopMode::REMOVE_FILE), 0);
+	EXPECT_FALSE(pStorage->FileExists(apFilenames[1], IStorage::TYPE_SAVE));
+}
+
+class CSnapshotListener : public CDemoPlayer::IListener
+{
+public:
+	std::vector<unsigned char> m_vLastSnapshot;
+	int m_NumSnapshots = 0;
+
+	void OnDemoPlayerSnapshot(void *pData, int Size) override
+	{
+		m_vLastSnapshot.assign((unsigned char *)pData, (unsigned char *)pData + Size);
+		m_NumSnapshots++;
+	}
+	void OnDemoPlayerMessage(void *pData, int Size) override {}
+};
+
+TEST(Demo, IndexSeeking)
+{
+	CNetBase::Init();
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_TRUE(pStorage);
+
+	CSnapshotDelta SnapshotDelta;
+	CDemoRecordWriter Writer;
+	CDemoRecorder Recorder(&SnapshotDelta, false, &Writer);
+	unsigned char aMapData[1000] = {};
+	ASSERT_EQ(Recorder.Start(pStorage.get(), nullptr, "indexed.demo", "0.6 626fce9a778df4d4", "map", sha256(aMapData, sizeof(aMapData)), 0x1234, "server", sizeof(aMapData), aMapData, nullptr, nullptr, nullptr, true), 0);
+
+	// the snapshot of every tick, keyframes are recorded every 5 seconds
+	std::vector<std::vector<unsigned char>> vvSnapshots(1001);
+	CSnapshotBuilder Builder;
+	alignas(CSnapshot) char aSnapshot[CSnapshot::MAX_SIZE];
+	for(int Tick = 1; Tick <= 1000; Tick++)
+	{
+		Builder.Init();
+		for(int Item = 0; Item < 64; Item++)
+		{
+			int *pData = (int *)Builder.NewItem(1 + Item % 5, Item, 4 * sizeof(int));
+			ASSERT_TRUE(pData);
+			for(int i = 0; i < 4; i++)
+				pData[i] = (Tick / (i + 1)) * Item;
+		}
+		const int SnapshotSize = Builder.Finish(aSnapshot);
+		vvSnapshots[Tick].assign(aSnapshot, aSnapshot + SnapshotSize);
+		Recorder.RecordSnapshot(Tick, aSnapshot, SnapshotSize);
+	}
+	ASSERT_EQ(Recorder.Stop(IDemoRecorder::EStopMode::KEEP_FILE, "renamed.demo"), 0);
+	EXPECT_TRUE(pStorage->FileExists("renamed.demo.idx", IStorage::TYPE_SAVE));
+	EXPECT_FALSE(pStorage->FileExists("indexed.demo.idx", IStorage::TYPE_SAVE));
+
+	// the index only stores a few snapshots between the keyframes, so it stays small compared to the demo
+	{
+		IOHANDLE DemoFile = pStorage->OpenFile("renamed.demo", IOFLAG_READ, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(DemoFile);
+		const int64_t DemoSize = io_length(DemoFile);
+		io_close(DemoFile);
+		IOHANDLE IndexFile = pStorage->OpenFile("renamed.demo.idx", IOFLAG_READ, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(IndexFile);
+		const int64_t IndexSize = io_length(IndexFile);
+		io_close(IndexFile);
+		EXPECT_LT(IndexSize * 10, DemoSize);
+	}
+
+	// returns the number of snapshots played while seeking
+	const auto &Seek = [&](const char *pFilename, int Tick) {
+		CSnapshotListener Listener;
+		CDemoPlayer Player(&SnapshotDelta, false);
+		Player.SetListener(&Listener);
+		EXPECT_EQ(Player.Load(pStorage.get(), nullptr, pFilename, IStorage::TYPE_SAVE), 0);
+		EXPECT_EQ(Player.BaseInfo()->m_FirstTick, 1);
+		EXPECT_EQ(Player.BaseInfo()->m_LastTick, 1000);
+		EXPECT_EQ(Player.SetPos(Tick), 0);
+		EXPECT_EQ(Player.BaseInfo()->m_CurrentTick, Tick - 1);
+		EXPECT_EQ(Listener.m_vLastSnapshot, vvSnapshots[Tick - 1]);
+		Player.Stop();
+		return Listener.m_NumSnapshots;
+	};
+
+	// seeking starts from the stored snapshots instead of the previous keyframe
+	for(int Tick : {7, 100, 250, 256, 480, 999})
+	{
+		SCOPED_TRACE(Tick);
+		EXPECT_LE(Seek("renamed.demo", Tick), CDemoRecorder::INDEX_SNAPSHOT_INTERVAL + 6);
+	}
+
+	// an index that does not match the demo is not used
+	IOHANDLE File = pStorage->OpenFile("renamed.demo", IOFLAG_APPEND, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, aMapData, 1);
+	io_close(File);
+	EXPECT_GT(Seek("renamed.demo", 480), 200);
+
+	ASSERT_TRUE(pStorage->RemoveFile("renamed.demo.idx", IStorage::TYPE_SAVE));
+	EXPECT_GT(Seek("renamed.demo", 480), 200);
+}
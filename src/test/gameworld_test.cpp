@@ -21,6 +21,7 @@
 #include <game/server/gamecontroller.h>
 #include <game/server/gameworld.h>
 #include <game/server/player.h>
+#include <game/prng.h>
 #include <game/version.h>
 
 #include <gtest/gtest.h>
@@ -255,6 +256,136 @@ TEST_F(CTestGameWorld, IntersectEntity)
 	EXPECT_EQ(pIntersectedChar, pChrRight);
 }
 
+TEST_F(CTestGameWorld, QueriesMatchLinearSearch)
+{
+	CGameWorld &World = GameServer()->m_World;
+	CNetObj_PlayerInput Input = {};
+	CPrng Prng;
+	uint64_t aSeed[2] = {9, 10};
+	Prng.Seed(aSeed);
+	auto RandomPos = [&]() {
+		return vec2((int)(Prng.RandomBits() % 4000) - 500, (int)(Prng.RandomBits() % 4000) - 500);
+	};
+
+	std::vector<CCharacter *> vpChrs;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CCharacter *pChr = new(i) CCharacter(&World, Input);
+		pChr->m_Pos = RandomPos();
+		World.InsertEntity(pChr);
+		vpChrs.push_back(pChr);
+	}
+
+	for(int Round = 0; Round < 500; Round++)
+	{
+		// characters are also moved from outside of the world, the queries have to pick that up
+		for(int i = 0; i < 4; i++)
+			vpChrs[Prng.RandomBits() % vpChrs.size()]->SetPos(RandomPos());
+
+		const vec2 Pos0 = RandomPos();
+		const vec2 Pos1 = Prng.RandomBits() % 2 ? Pos0 + vec2((int)(Prng.RandomBits() % 800) - 400, (int)(Prng.RandomBits() % 800) - 400) : RandomPos();
+		const float Radius = Prng.RandomBits() % 8 == 0 ? 3000.0f : Prng.RandomBits() % 300;
+		const CEntity *pNotThis = vpChrs[Prng.RandomBits() % vpChrs.size()];
+
+		std::vector<CEntity *> vpExpected;
+		CEntity *pExpectedClosest = nullptr;
+		float ClosestRange = Radius * 2;
+		CEntity *pExpectedIntersect = nullptr;
+		float ClosestLen = distance(Pos0, Pos1) * 100.0f;
+		std::vector<CCharacter *> vpExpectedIntersected;
+		for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+		{
+			const float Len = distance(pEnt->m_Pos, Pos0);
+			if(Len < Radius + pEnt->GetProximityRadius())
+			{
+				vpExpected.push_back(pEnt);
+				if(pEnt != pNotThis && Len < ClosestRange)
+				{
+					ClosestRange = Len;
+					pExpectedClosest = pEnt;
+				}
+			}
+
+			vec2 IntersectPos;
+			if(pEnt != pNotThis && closest_point_on_line(Pos0, Pos1, pEnt->m_Pos, IntersectPos) && distance(pEnt->m_Pos, IntersectPos) < pEnt->GetProximityRadius() + Radius)
+			{
+				vpExpectedIntersected.push_back((CCharacter *)pEnt);
+				if(distance(Pos0, IntersectPos) < ClosestLen)
+				{
+					ClosestLen = distance(Pos0, IntersectPos);
+					pExpectedIntersect = pEnt;
+				}
+			}
+		}
+
+		CEntity *apEnts[MAX_CLIENTS];
+		const int Num = World.FindEntities(Pos0, Radius, apEnts, MAX_CLIENTS, CGameWorld::ENTTYPE_CHARACTER);
+		EXPECT_EQ(std::vector<CEntity *>(apEnts, apEnts + Num), vpExpected);
+		if(vpExpected.size() > 1)
+		{
+			EXPECT_EQ(World.FindEntities(Pos0, Radius, apEnts, 1, CGameWorld::ENTTYPE_CHARACTER), 1);
+			EXPECT_EQ(apEnts[0], vpExpected[0]);
+		}
+		EXPECT_EQ(World.ClosestCharacter(Pos0, Radius, pNotThis), pExpectedClosest);
+		vec2 IntersectAt;
+		EXPECT_EQ(World.IntersectEntity(Pos0, Pos1, Radius, CGameWorld::ENTTYPE_CHARACTER, IntersectAt, pNotThis), pExpectedIntersect);
+		EXPECT_EQ(World.IntersectedCharacters(Pos0, Pos1, Radius, pNotThis), vpExpectedIntersected);
+
+		// replace a character, so insertion order and removal are covered as well
+		if(Round % 50 == 0)
+		{
+			const int Index = Prng.RandomBits() % vpChrs.size();
+			delete vpChrs[Index];
+			vpChrs[Index] = new(Index) CCharacter(&World, Input);
+			vpChrs[Index]->m_Pos = RandomPos();
+			World.InsertEntity(vpChrs[Index]);
+		}
+	}
+}
+
+class CMovingEntity : public CEntity
+{
+public:
+	CEntity *m_pTarget = nullptr;
+	vec2 m_TargetPos;
+	int m_NumFound = -1;
+
+	CMovingEntity(CGameWorld *pGameWorld, vec2 Pos) :
+		CEntity(pGameWorld, CGameWorld::ENTTYPE_LASER, Pos)
+	{
+		GameWorld()->InsertEntity(this);
+	}
+
+	void Tick() override
+	{
+		if(!m_pTarget)
+			return;
+		m_pTarget->SetPos(m_TargetPos);
+		m_NumFound = GameWorld()->FindEntities(m_TargetPos, 1.0f, nullptr, 2, CGameWorld::ENTTYPE_LASER);
+	}
+};
+
+TEST_F(CTestGameWorld, EntityMovedByAnother)
+{
+	CGameWorld &World = GameServer()->m_World;
+	CMovingEntity *pTarget = new CMovingEntity(&World, vec2(-3000, -3000));
+	// inserted later, so it is ticked first
+	CMovingEntity *pMover = new CMovingEntity(&World, vec2(-3000, 3000));
+	pMover->m_pTarget = pTarget;
+	pMover->m_TargetPos = vec2(3000, 3000);
+
+	World.Tick();
+	EXPECT_EQ(pMover->m_NumFound, 1);
+
+	// outside of a tick
+	pTarget->SetPos(vec2(3000, -3000));
+	EXPECT_EQ(World.FindEntities(vec2(3000, -3000), 1.0f, nullptr, 2, CGameWorld::ENTTYPE_LASER), 1);
+	EXPECT_EQ(World.FindEntities(vec2(3000, 3000), 1.0f, nullptr, 2, CGameWorld::ENTTYPE_LASER), 0);
+
+	delete pMover;
+	delete pTarget;
+}
+
 TEST_F(CTestGameWorld, BasicTick)
 {
 	int ClientId = 0;
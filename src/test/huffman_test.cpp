@@ -2,8 +2,12 @@
 
 #include <engine/shared/huffman.h>
 
+#include <game/prng.h>
+
 #include <gtest/gtest.h>
 
+#include <vector>
+
 TEST(Huffman, CompressionShouldNotChangeData)
 {
 	CHuffman Huffman;
@@ -47,3 +51,87 @@ TEST(Huffman, CompressionCompatible)
 	EXPECT_EQ(match, 0) << "The compression is not compatible with older/other implementations anymore";
 	EXPECT_EQ(Size, 15);
 }
+
+static void RandomInput(CPrng &Prng, std::vector<unsigned char> &vInput)
+{
+	// mix of mostly zero snapshot-like data, short runs and uniform noise
+	const unsigned Kind = Prng.RandomBits() % 3;
+	for(unsigned char &Byte : vInput)
+	{
+		if(Kind == 0)
+			Byte = Prng.RandomBits() % 4 == 0 ? Prng.RandomBits() % 256 : 0;
+		else if(Kind == 1)
+			Byte = Prng.RandomBits() % 16;
+		else
+			Byte = Prng.RandomBits() % 256;
+	}
+}
+
+TEST(Huffman, FuzzRoundTrip)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {5, 6};
+	Prng.Seed(aSeed);
+
+	// hash over all compressed outputs, recorded with the original byte-at-a-time implementation
+	uint64_t Hash = 14695981039346656037ULL;
+	for(int i = 0; i < 2000; i++)
+	{
+		std::vector<unsigned char> vInput(Prng.RandomBits() % 1500);
+		RandomInput(Prng, vInput);
+
+		std::vector<unsigned char> vCompressed(vInput.size() * 4 + 16);
+		const int Size = Huffman.Compress(vInput.data(), vInput.size(), vCompressed.data(), vCompressed.size());
+		ASSERT_GT(Size, 0);
+		for(int k = 0; k < Size; k++)
+			Hash = (Hash ^ vCompressed[k]) * 1099511628211ULL;
+
+		// the output buffer must fit exactly
+		EXPECT_EQ(Huffman.Compress(vInput.data(), vInput.size(), vCompressed.data(), Size), Size);
+		EXPECT_EQ(Huffman.Compress(vInput.data(), vInput.size(), vCompressed.data(), Size - 1), -1);
+
+		std::vector<unsigned char> vDecompressed(vInput.size() + 1);
+		ASSERT_EQ(Huffman.Decompress(vCompressed.data(), Size, vDecompressed.data(), vInput.size()), (int)vInput.size());
+		vDecompressed.resize(vInput.size());
+		EXPECT_EQ(vDecompressed, vInput);
+		if(!vInput.empty())
+		{
+			EXPECT_EQ(Huffman.Decompress(vCompressed.data(), Size, vDecompressed.data(), vInput.size() - 1), -1);
+		}
+	}
+	EXPECT_EQ(Hash, 10764132387786667157ULL) << "The compression is not compatible with older/other implementations anymore";
+}
+
+TEST(Huffman, FuzzInvalidInput)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	CPrng Prng;
+	uint64_t aSeed[2] = {7, 8};
+	Prng.Seed(aSeed);
+
+	for(int i = 0; i < 2000; i++)
+	{
+		std::vector<unsigned char> vInput(Prng.RandomBits() % 600);
+		RandomInput(Prng, vInput);
+		std::vector<unsigned char> vCompressed(vInput.size() * 4 + 16);
+		const int Size = Huffman.Compress(vInput.data(), vInput.size(), vCompressed.data(), vCompressed.size());
+		ASSERT_GT(Size, 0);
+
+		// truncate or corrupt the stream, decoding must stay within the output buffer
+		const int Corrupt = Prng.RandomBits() % Size;
+		if(Prng.RandomBits() % 2)
+			vCompressed[Corrupt] ^= 1 << (Prng.RandomBits() % 8);
+		const int InputSize = Prng.RandomBits() % 2 ? Size : Corrupt;
+
+		std::vector<unsigned char> vDecompressed(vInput.size() + 8, 0xAA);
+		const int Result = Huffman.Decompress(vCompressed.data(), InputSize, vDecompressed.data(), vInput.size());
+		EXPECT_LE(Result, (int)vInput.size());
+		for(size_t k = vInput.size(); k < vDecompressed.size(); k++)
+			EXPECT_EQ(vDecompressed[k], 0xAA);
+	}
+}
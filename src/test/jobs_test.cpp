@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 
 #include <functional>
+#include <vector>
 
 static const int TEST_NUM_THREADS = 4;
 
@@ -164,3 +165,163 @@ TEST_F(Jobs, Many)
 	}
 	SetUp();
 }
+
+TEST_F(Jobs, Priority)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+
+	// block the only worker until all jobs are queued
+	SEMAPHORE BlockSphore;
+	sphore_init(&BlockSphore);
+	Pool.Add(std::make_shared<CJob>([&] { sphore_wait(&BlockSphore); }));
+
+	std::vector<int> vOrder;
+	std::vector<std::shared_ptr<CJob>> vpJobs;
+	for(int i = 0; i < 4; i++)
+	{
+		auto pJob = std::make_shared<CJob>([&vOrder, i] { vOrder.push_back(i); });
+		pJob->SetPriority(i % 2 == 0 ? IJob::PRIORITY_BACKGROUND : IJob::PRIORITY_INTERACTIVE);
+		EXPECT_EQ(pJob->Priority(), i % 2 == 0 ? IJob::PRIORITY_BACKGROUND : IJob::PRIORITY_INTERACTIVE);
+		vpJobs.push_back(pJob);
+		Pool.Add(pJob);
+	}
+	sphore_signal(&BlockSphore);
+	Pool.Shutdown();
+	sphore_destroy(&BlockSphore);
+
+	EXPECT_EQ(vOrder, std::vector<int>({1, 3, 0, 2}));
+	for(auto &pJob : vpJobs)
+	{
+		EXPECT_EQ(pJob->State(), IJob::STATE_DONE);
+	}
+}
+
+TEST_F(Jobs, Continuation)
+{
+	SEMAPHORE BlockSphore;
+	sphore_init(&BlockSphore);
+	auto pFirst = std::make_shared<CJob>([&] { sphore_wait(&BlockSphore); });
+	auto pSecond = std::make_shared<CJob>([] {});
+	std::atomic<bool> DependenciesDone = false;
+	SEMAPHORE DoneSphore;
+	sphore_init(&DoneSphore);
+	auto pThen = std::make_shared<CJob>([&] {
+		DependenciesDone = pFirst->State() == IJob::STATE_DONE && pSecond->State() == IJob::STATE_DONE;
+		sphore_signal(&DoneSphore);
+	});
+
+	Add(pFirst);
+	m_Pool.AddAfter(pThen, {pFirst, pSecond});
+	EXPECT_EQ(pThen->State(), IJob::STATE_QUEUED);
+	Add(pSecond);
+	sphore_signal(&BlockSphore);
+	sphore_wait(&DoneSphore);
+	EXPECT_TRUE(DependenciesDone);
+
+	// continuations of done jobs are added immediately
+	std::atomic<bool> LateRun = false;
+	auto pLate = std::make_shared<CJob>([&] {
+		LateRun = true;
+		sphore_signal(&DoneSphore);
+	});
+	m_Pool.AddAfter(pLate, {pFirst});
+	sphore_wait(&DoneSphore);
+	EXPECT_TRUE(LateRun);
+
+	sphore_destroy(&DoneSphore);
+	sphore_destroy(&BlockSphore);
+}
+
+TEST_F(Jobs, ContinuationAborted)
+{
+	auto pAborted = std::make_shared<CJob>([] {});
+	pAborted->Abortable(true);
+	pAborted->Abort();
+	SEMAPHORE DoneSphore;
+	sphore_init(&DoneSphore);
+	std::atomic<IJob::EJobState> DependencyState = IJob::STATE_QUEUED;
+	auto pThen = std::make_shared<CJob>([&] {
+		DependencyState = pAborted->State();
+		sphore_signal(&DoneSphore);
+	});
+	m_Pool.AddAfter(pThen, {pAborted});
+	Add(pAborted);
+	sphore_wait(&DoneSphore);
+	sphore_destroy(&DoneSphore);
+	EXPECT_EQ(DependencyState, IJob::STATE_ABORTED);
+}
+
+TEST_F(Jobs, ContinuationAddedDuringShutdown)
+{
+	TearDown();
+	auto pFirst = std::make_shared<CJob>([] {});
+	pFirst->Abortable(true);
+	auto pThen = std::make_shared<CJob>([] {});
+	pThen->Abortable(true);
+	auto pLast = std::make_shared<CJob>([] {});
+	pLast->Abortable(true);
+	m_Pool.AddAfter(pThen, {pFirst});
+	m_Pool.AddAfter(pLast, {pThen});
+	EXPECT_EQ(pThen->State(), IJob::STATE_QUEUED);
+	EXPECT_EQ(pLast->State(), IJob::STATE_QUEUED);
+
+	// the job is rejected, so the jobs waiting for it must not wait forever
+	Add(pFirst);
+	EXPECT_EQ(pFirst->State(), IJob::STATE_ABORTED);
+	EXPECT_EQ(pThen->State(), IJob::STATE_ABORTED);
+	EXPECT_EQ(pLast->State(), IJob::STATE_ABORTED);
+
+	// continuations added afterwards are not held back either
+	auto pLate = std::make_shared<CJob>([] {});
+	pLate->Abortable(true);
+	m_Pool.AddAfter(pLate, {pFirst});
+	EXPECT_EQ(pLate->State(), IJob::STATE_ABORTED);
+	SetUp();
+}
+
+TEST_F(Jobs, ParallelFor)
+{
+	std::vector<std::atomic<int>> vCalls(1000);
+	m_Pool.ParallelFor(0, vCalls.size(), 7, [&](int Begin, int End) {
+		EXPECT_LE(End - Begin, 7);
+		for(int i = Begin; i < End; i++)
+		{
+			vCalls[i]++;
+		}
+	});
+	for(const std::atomic<int> &Calls : vCalls)
+	{
+		EXPECT_EQ(Calls, 1);
+	}
+
+	m_Pool.ParallelFor(5, 5, 1, [](int Begin, int End) { ADD_FAILURE() << "Function called for empty range"; });
+}
+
+TEST_F(Jobs, ParallelForNested)
+{
+	std::atomic<int> Sum = 0;
+	m_Pool.ParallelFor(0, 2 * TEST_NUM_THREADS, 1, [&](int OuterBegin, int OuterEnd) {
+		m_Pool.ParallelFor(0, 100, 10, [&](int Begin, int End) {
+			for(int i = Begin; i < End; i++)
+			{
+				Sum += i;
+			}
+		});
+	});
+	EXPECT_EQ(Sum, 2 * TEST_NUM_THREADS * 4950);
+}
+
+TEST_F(Jobs, ParallelForShutdown)
+{
+	TearDown();
+	int Sum = 0;
+	m_Pool.ParallelFor(0, 10, 3, [&](int Begin, int End) {
+		for(int i = Begin; i < End; i++)
+		{
+			Sum += i;
+		}
+	});
+	EXPECT_EQ(Sum, 45);
+	SetUp();
+}
@@ -212,3 +212,27 @@ TYPED_TEST(JsonWriters, Small)
 	this->Impl.m_pJson->WriteIntValue(std::numeric_limits<int>::min());
 	this->Impl.Expect("-2147483648\n");
 }
+
+TYPED_TEST(JsonWriters, DoubleWhole)
+{
+	this->Impl.m_pJson->WriteDoubleValue(2.0);
+	this->Impl.Expect("2\n");
+}
+
+TYPED_TEST(JsonWriters, DoubleFraction)
+{
+	this->Impl.m_pJson->WriteDoubleValue(0.4);
+	this->Impl.Expect("0.4\n");
+}
+
+TYPED_TEST(JsonWriters, DoubleNegative)
+{
+	this->Impl.m_pJson->WriteDoubleValue(-2.375);
+	this->Impl.Expect("-2.375\n");
+}
+
+TYPED_TEST(JsonWriters, DoubleInfinity)
+{
+	this->Impl.m_pJson->WriteDoubleValue(std::numeric_limits<double>::infinity());
+	this->Impl.Expect("null\n");
+}
@@ -52,3 +52,125 @@ TEST(Net, Ipv4AndIpv6Work)
 	net_udp_close(Socket1);
 	net_udp_close(Socket2);
 }
+
+static NETSOCKET CreateLocalSocket(NETADDR *pTarget)
+{
+	NETADDR Bindaddr = {};
+	Bindaddr.type = NETTYPE_IPV4;
+	NETSOCKET Socket;
+	do
+	{
+		Bindaddr.port = secure_rand() % 64511 + 1024;
+	} while(!(Socket = net_udp_create(Bindaddr)));
+
+	EXPECT_FALSE(net_addr_from_str(pTarget, "127.0.0.1"));
+	pTarget->port = Bindaddr.port;
+	return Socket;
+}
+
+static void ExpectReceived(NETSOCKET Socket, int Number)
+{
+	NETADDR Addr;
+	unsigned char *pData;
+	// the packets might already be buffered by a previous receive
+	int Bytes = net_udp_recv(Socket, &Addr, &pData);
+	if(Bytes == 0)
+	{
+		ASSERT_EQ(net_socket_read_wait(Socket, 10s), 1);
+		Bytes = net_udp_recv(Socket, &Addr, &pData);
+	}
+	ASSERT_EQ(Bytes, (int)sizeof(Number));
+	int Received;
+	mem_copy(&Received, pData, sizeof(Received));
+	EXPECT_EQ(Received, Number);
+}
+
+TEST(Net, SendBatchOrder)
+{
+	NETADDR Target;
+	NETSOCKET Receiver = CreateLocalSocket(&Target);
+	NETADDR Bindaddr = {};
+	Bindaddr.type = NETTYPE_IPV4;
+	NETSOCKET Sender = net_udp_create(Bindaddr);
+	ASSERT_TRUE(Sender);
+
+	// more packets than fit into a single system call, but few enough for
+	// the receive buffer of the socket
+	static const int NUM = 140;
+	int aNumbers[NUM];
+	NETUDPPACKET aPackets[NUM];
+	for(int i = 0; i < NUM; i++)
+	{
+		aNumbers[i] = i;
+		aPackets[i].addr = Target;
+		aPackets[i].data = &aNumbers[i];
+		aPackets[i].size = sizeof(aNumbers[i]);
+	}
+	EXPECT_EQ(net_udp_send_batch(Sender, aPackets, NUM), NUM);
+	for(int i = 0; i < NUM; i++)
+		ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, i));
+
+	net_udp_close(Sender);
+	net_udp_close(Receiver);
+}
+
+TEST(Net, SendBatchPartial)
+{
+	NETADDR Target;
+	NETSOCKET Receiver = CreateLocalSocket(&Target);
+	NETADDR Bindaddr = {};
+	Bindaddr.type = NETTYPE_IPV4;
+	NETSOCKET Sender = net_udp_create(Bindaddr);
+	ASSERT_TRUE(Sender);
+
+	// the ipv4 only socket cannot send the ipv6 packet in the middle
+	NETADDR TargetV6;
+	ASSERT_FALSE(net_addr_from_str(&TargetV6, "[::1]"));
+	TargetV6.port = Target.port;
+
+	int aNumbers[5] = {0, 1, 2, 3, 4};
+	NETUDPPACKET aPackets[5];
+	for(int i = 0; i < 5; i++)
+	{
+		aPackets[i].addr = i == 2 ? TargetV6 : Target;
+		aPackets[i].data = &aNumbers[i];
+		aPackets[i].size = sizeof(aNumbers[i]);
+	}
+	EXPECT_EQ(net_udp_send_batch(Sender, aPackets, 5), 4);
+	ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, 0));
+	ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, 1));
+	ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, 3));
+	ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, 4));
+
+	net_udp_close(Sender);
+	net_udp_close(Receiver);
+}
+
+TEST(Net, SendQueue)
+{
+	NETADDR Target;
+	NETSOCKET Receiver = CreateLocalSocket(&Target);
+	NETADDR Bindaddr = {};
+	Bindaddr.type = NETTYPE_IPV4;
+	NETSOCKET Sender = net_udp_create(Bindaddr);
+	ASSERT_TRUE(Sender);
+	net_udp_set_send_queue(Sender, true);
+
+	for(int i = 0; i < 3; i++)
+		EXPECT_EQ(net_udp_send(Sender, &Target, &i, sizeof(i)), (int)sizeof(i));
+	EXPECT_EQ(net_socket_read_wait(Receiver, 0ns), 0);
+	EXPECT_EQ(net_udp_flush(Sender), 3);
+	for(int i = 0; i < 3; i++)
+		ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, i));
+	EXPECT_EQ(net_udp_flush(Sender), 0);
+
+	// a full queue is sent automatically, closing sends the rest
+	static const int NUM = 140;
+	for(int i = 0; i < NUM; i++)
+		EXPECT_EQ(net_udp_send(Sender, &Target, &i, sizeof(i)), (int)sizeof(i));
+	net_udp_close(Sender);
+	for(int i = 0; i < NUM; i++)
+		ASSERT_NO_FATAL_FAILURE(ExpectReceived(Receiver, i));
+
+	net_udp_close(Receiver);
+}
@@ -0,0 +1,124 @@
+#include <base/system.h>
+
+#include <game/server/save.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+static const char TEAM_SAVE[] =
+	"2\t2\t3\t0\t1\n"
+	"brainless tee\t1\t0\t0\t0\t0\t"
+	"-1\t10\t0\t1\t-1\t10\t0\t1\t-1\t0\t0\t0\t-1\t0\t0\t0\t-1\t0\t0\t0\t-1\t0\t0\t0\t1\t0\t"
+	"0\t0\t0\t0\t0\t0\t0\t1\t0\t1\t0\t0\t1\t1234\t"
+	"1600\t-288\t1598\t-290\t0\t0\t1600\t-288\t-3.250000\t0.500000\t0\t3\t1\t2\t"
+	"1712\t-300\t0.707107\t-0.707107\t0\t0\t12\t5\t"
+	"0\t2\t-1\t0.000000\t1.250000\t2.500000\t0.000000\t0.000000\t"
+	"0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t"
+	"0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t"
+	"0\t0\t0\t0\t6fe24a74-4c75-43f2-9316-57e1ac6af2e6\t1\t0\t-1\t0\t0\t1\t0\t1\t0\t"
+	"0.000000\t0.000000\t0\t0\t0\n"
+	"nameless tee\t1\t0\t0\t0\t0\t"
+	"-1\t10\t0\t1\t-1\t10\t0\t1\t-1\t0\t0\t0\t-1\t0\t0\t0\t-1\t0\t0\t0\t-1\t0\t0\t0\t1\t0\t"
+	"0\t0\t0\t0\t0\t0\t0\t1\t0\t1\t0\t0\t1\t1241\t"
+	"1607\t-288\t1598\t-290\t0\t0\t1607\t-288\t-3.250000\t0.500000\t0\t3\t1\t2\t"
+	"1712\t-300\t0.707107\t-0.707107\t0\t0\t12\t3\t"
+	"0\t2\t-1\t0.000000\t1.250000\t2.500000\t0.000000\t0.000000\t"
+	"0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t"
+	"0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t0.000000\t"
+	"0\t0\t0\t0\t6fe24a74-4c75-43f2-9316-57e1ac6af2e6\t-1\t0\t-1\t0\t0\t1\t0\t1\t0\t"
+	"0.000000\t0.000000\t0\t0\t0\n"
+	"1\t0\t0\n"
+	"0\t50\t1\n"
+	"1\t0\t2";
+
+static const char TEAM_NAMES[][MAX_NAME_LENGTH] = {"nameless tee", "brainless tee"};
+static const int TEAM_CLIENT_IDS[] = {9, 5};
+
+static std::vector<unsigned char> Binary(const CSaveTeam &Team)
+{
+	CSaveTeamPacker Packer;
+	Team.GetBinary(&Packer);
+	EXPECT_FALSE(Packer.Error());
+	return std::vector<unsigned char>(Packer.Data(), Packer.Data() + Packer.Size());
+}
+
+TEST(SaveTeam, TextToBinaryToText)
+{
+	char aMessage[128];
+	CSaveTeam Text;
+	ASSERT_EQ(Text.FromString(TEAM_SAVE), 0);
+	ASSERT_TRUE(Text.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	std::vector<unsigned char> vBinary = Binary(Text);
+	EXPECT_LT(vBinary.size(), sizeof(TEAM_SAVE) / 2);
+
+	CSaveTeam Loaded;
+	ASSERT_EQ(Loaded.FromBinary(vBinary.data(), vBinary.size()), 0);
+	EXPECT_EQ(Loaded.GetMembersCount(), 2);
+	EXPECT_STREQ(Loaded.m_pSavedTees[1].GetName(), "nameless tee");
+	ASSERT_TRUE(Loaded.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	EXPECT_TRUE(Loaded.m_pSavedTees[0].IsHooking());
+	EXPECT_STREQ(Loaded.GetString(), TEAM_SAVE);
+}
+
+TEST(SaveTeam, BinaryToTextToBinary)
+{
+	char aMessage[128];
+	CSaveTeam Text;
+	ASSERT_EQ(Text.FromString(TEAM_SAVE), 0);
+	ASSERT_TRUE(Text.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	std::vector<unsigned char> vBinary = Binary(Text);
+
+	CSaveTeam Loaded;
+	ASSERT_EQ(Loaded.FromBinary(vBinary.data(), vBinary.size()), 0);
+	ASSERT_TRUE(Loaded.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	CSaveTeam Reloaded;
+	ASSERT_EQ(Reloaded.FromString(Loaded.GetString()), 0);
+	ASSERT_TRUE(Reloaded.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	EXPECT_EQ(Binary(Reloaded), vBinary);
+}
+
+TEST(SaveTeam, InvalidBinary)
+{
+	char aMessage[128];
+	CSaveTeam Text;
+	ASSERT_EQ(Text.FromString(TEAM_SAVE), 0);
+	ASSERT_TRUE(Text.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	std::vector<unsigned char> vBinary = Binary(Text);
+
+	CSaveTeam Loaded;
+	EXPECT_NE(Loaded.FromBinary(vBinary.data(), 0), 0);
+	for(size_t Size : {(size_t)1, vBinary.size() / 2, vBinary.size() - 1})
+		EXPECT_NE(Loaded.FromBinary(vBinary.data(), Size), 0) << Size;
+
+	// unknown version
+	vBinary[0] = 0x3f;
+	EXPECT_NE(Loaded.FromBinary(vBinary.data(), vBinary.size()), 0);
+}
+
+TEST(SaveTeam, InvalidBinaryHookedPlayer)
+{
+	char aMessage[128];
+	CSaveTeam Text;
+	ASSERT_EQ(Text.FromString(TEAM_SAVE), 0);
+	ASSERT_TRUE(Text.MatchPlayers(TEAM_NAMES, TEAM_CLIENT_IDS, 2, aMessage, sizeof(aMessage))) << aMessage;
+	std::vector<unsigned char> vBinary = Binary(Text);
+
+	// the hooked player index of the first tee directly follows its game uuid
+	static const char GAME_UUID[] = "6fe24a74-4c75-43f2-9316-57e1ac6af2e6";
+	auto HookedPlayer = std::search(vBinary.begin(), vBinary.end(), std::begin(GAME_UUID), std::end(GAME_UUID)) + sizeof(GAME_UUID);
+	ASSERT_LT(HookedPlayer, vBinary.end());
+	ASSERT_EQ(*HookedPlayer, 0x01);
+
+	CSaveTeam Loaded;
+	// 2, one past the last member
+	*HookedPlayer = 0x02;
+	EXPECT_NE(Loaded.FromBinary(vBinary.data(), vBinary.size()), 0);
+	// -2
+	*HookedPlayer = 0x41;
+	EXPECT_NE(Loaded.FromBinary(vBinary.data(), vBinary.size()), 0);
+	// -1, not hooking anyone
+	*HookedPlayer = 0x40;
+	EXPECT_EQ(Loaded.FromBinary(vBinary.data(), vBinary.size()), 0);
+}
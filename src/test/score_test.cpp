@@ -1,3 +1,5 @@
+#include "test.h"
+
 #include <base/detect.h>
 
 #include <engine/server/databases/connection.h>
@@ -10,6 +12,10 @@
 #include <gtest/gtest.h>
 #include <sqlite3.h>
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 #if defined(CONF_TEST_MYSQL)
 int DummyMysqlInit = (MysqlInit(), 1);
 #endif
@@ -624,6 +630,369 @@ TEST_P(RandomMap, UnfinishedDoesntExist)
 	EXPECT_STREQ(m_pRandomMapResult->m_aMessage, "nameless tee has no more unfinished maps on this server!");
 }
 
+struct Transaction : public Score
+{
+	int NumRaces()
+	{
+		EXPECT_TRUE(m_pConn->PrepareStatement("SELECT COUNT(*) FROM record_race", m_aError, sizeof(m_aError))) << m_aError;
+		bool End;
+		EXPECT_TRUE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+		EXPECT_FALSE(End);
+		return m_pConn->GetInt(1);
+	}
+};
+
+TEST_P(Transaction, Commit)
+{
+	ASSERT_TRUE(m_pConn->BeginTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	InsertRank(100.0);
+	InsertRank(98.0);
+	ASSERT_TRUE(m_pConn->CommitTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(NumRaces(), 2);
+}
+
+TEST_P(Transaction, Rollback)
+{
+	InsertRank(100.0);
+	ASSERT_TRUE(m_pConn->BeginTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	InsertRank(98.0);
+	EXPECT_EQ(NumRaces(), 2);
+	ASSERT_TRUE(m_pConn->RollbackTransaction(m_aError, sizeof(m_aError))) << m_aError;
+	EXPECT_EQ(NumRaces(), 1);
+}
+
+TEST_P(Transaction, StatementCache)
+{
+	InsertRank();
+	// more distinct statements than are cached, interleaved with a reused one
+	for(int i = 0; i < 100; i++)
+	{
+		char aBuf[64];
+		str_format(aBuf, sizeof(aBuf), "SELECT %d + ?", i);
+		ASSERT_TRUE(m_pConn->PrepareStatement(aBuf, m_aError, sizeof(m_aError))) << m_aError;
+		m_pConn->BindInt(1, 1000);
+		bool End;
+		ASSERT_TRUE(m_pConn->Step(&End, m_aError, sizeof(m_aError))) << m_aError;
+		ASSERT_FALSE(End);
+		EXPECT_EQ(m_pConn->GetInt(1), 1000 + i);
+		EXPECT_EQ(NumRaces(), 1);
+	}
+}
+
+struct MapRanks : public Score
+{
+	MapRanks()
+	{
+		str_copy(m_aSqlServerName, g_Config.m_SvSqlServerName);
+		InsertRank("nameless tee", 100.0f, "USA");
+		InsertRank("brainless tee", 110.0f, "GER");
+		InsertRank("nameless tee", 90.0f, "GER");
+		InsertRank("tee 3", 120.0f, "USA");
+		InsertRank("tee 4", 130.0f, "GER");
+		InsertRank("tee 4", 125.0f, "USA");
+		InsertRank("tee 5", 140.0f, "USA");
+		InsertRank("tee 6", 150.0f, "GER");
+		InsertRank("tee 7", 160.0f, "USA");
+
+		CSqlLoadMapRanksRequest Request(m_pMapRanks);
+		EXPECT_TRUE(CScoreWorker::LoadMapRanks(m_pConn, &Request, m_aError, sizeof(m_aError))) << m_aError;
+		EXPECT_TRUE(m_pMapRanks->Covers("Kobra 3", "GER"));
+	}
+
+	~MapRanks()
+	{
+		str_copy(g_Config.m_SvSqlServerName, m_aSqlServerName);
+	}
+
+	// InsertRank changes the server name
+	void InsertRank(const char *pName, float Time, const char *pServer)
+	{
+		str_copy(g_Config.m_SvSqlServerName, pServer);
+		CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
+		str_copy(ScoreData.m_aMap, "Kobra 3");
+		str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320");
+		str_copy(ScoreData.m_aName, pName);
+		ScoreData.m_ClientId = 0;
+		ScoreData.m_Time = Time;
+		str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08");
+		std::fill(std::begin(ScoreData.m_aCurrentTimeCp), std::end(ScoreData.m_aCurrentTimeCp), 0.0f);
+		str_copy(ScoreData.m_aRequestingPlayer, "deen");
+		ASSERT_TRUE(CScoreWorker::SaveScore(m_pConn, &ScoreData, Write::NORMAL, m_aError, sizeof(m_aError))) << m_aError;
+	}
+
+	// the request must give the same messages with and without the ranks in memory
+	void ExpectSameAsDatabase(bool (*pFunc)(IDbConnection *, const ISqlData *, char *, int), const char *pName, int Offset)
+	{
+		auto pDatabaseResult = std::make_shared<CScorePlayerResult>();
+		auto pMemoryResult = std::make_shared<CScorePlayerResult>();
+		CSqlPlayerRequest Request(pDatabaseResult);
+		str_copy(Request.m_aName, pName);
+		str_copy(Request.m_aMap, "Kobra 3");
+		str_copy(Request.m_aRequestingPlayer, "brainless tee");
+		Request.m_Offset = Offset;
+		str_copy(Request.m_aServer, "GER");
+		ASSERT_TRUE(pFunc(m_pConn, &Request, m_aError, sizeof(m_aError))) << m_aError;
+		Request.m_pResult = pMemoryResult;
+		Request.m_pMapRanks = m_pMapRanks;
+		ASSERT_TRUE(pFunc(m_pConn, &Request, m_aError, sizeof(m_aError))) << m_aError;
+
+		EXPECT_EQ(pMemoryResult->m_MessageKind, pDatabaseResult->m_MessageKind) << pName << " " << Offset;
+		for(int i = 0; i < CScorePlayerResult::MAX_MESSAGES; i++)
+			EXPECT_STREQ(pMemoryResult->m_Data.m_aaMessages[i], pDatabaseResult->m_Data.m_aaMessages[i]) << pName << " " << Offset;
+	}
+
+	void ExpectAllSameAsDatabase()
+	{
+		const int RegionalRankings = g_Config.m_SvRegionalRankings;
+		for(bool Regional : {false, true})
+		{
+			g_Config.m_SvRegionalRankings = Regional;
+			for(const char *pName : {"nameless tee", "brainless tee", "tee 3", "tee 4", "tee 7", "tee 8", "unknown tee"})
+				ExpectSameAsDatabase(CScoreWorker::ShowRank, pName, 0);
+			for(int Offset : {0, 1, 3, 7, 10, -1, -4, -10})
+				ExpectSameAsDatabase(CScoreWorker::ShowTop, "", Offset);
+		}
+		g_Config.m_SvRegionalRankings = RegionalRankings;
+	}
+
+	char m_aSqlServerName[sizeof(g_Config.m_SvSqlServerName)];
+	std::shared_ptr<CMapRanks> m_pMapRanks = std::make_shared<CMapRanks>("Kobra 3", "GER");
+};
+
+TEST_P(MapRanks, SameAsDatabase)
+{
+	ExpectAllSameAsDatabase();
+}
+
+TEST_P(MapRanks, Finishes)
+{
+	for(auto [pName, Time] : {std::pair{"tee 7", 95.0f}, std::pair{"tee 8", 100.504f}, std::pair{"tee 3", 135.0f}})
+	{
+		InsertRank(pName, Time, "GER");
+		m_pMapRanks->AddFinish(pName, Time);
+	}
+	ExpectAllSameAsDatabase();
+}
+
+TEST_P(MapRanks, OtherMap)
+{
+	EXPECT_FALSE(m_pMapRanks->Covers("Kobra 4", "GER"));
+	EXPECT_FALSE(m_pMapRanks->Covers("Kobra 3", "USA"));
+}
+
+TEST(MapRanks, SharedRanks)
+{
+	CMapRanks Ranks("Kobra 3", "GER");
+	EXPECT_FALSE(Ranks.Covers("Kobra 3", "GER"));
+	// finishes before the ranks are loaded are kept
+	Ranks.AddFinish("d", 25.0f);
+	Ranks.Load({{10.0f, "a"}, {20.0f, "b"}, {20.0f, "c"}, {30.0f, "d"}}, {});
+	EXPECT_TRUE(Ranks.Covers("Kobra 3", "GER"));
+	Ranks.AddFinish("a", 15.0f);
+
+	auto Rank = Ranks.Rank("c", false);
+	ASSERT_TRUE(Rank.has_value());
+	EXPECT_EQ(Rank->m_Rank, 2);
+	EXPECT_EQ(Rank->m_Time, 20.0f);
+	Rank = Ranks.Rank("d", false);
+	ASSERT_TRUE(Rank.has_value());
+	EXPECT_EQ(Rank->m_Rank, 4);
+	EXPECT_EQ(Rank->m_Time, 25.0f);
+	EXPECT_EQ(Rank->m_PercentRank, 1.0f);
+	EXPECT_FALSE(Ranks.Rank("e", false).has_value());
+	// the finishes of this server are regional ranks, too
+	EXPECT_FALSE(Ranks.Rank("b", true).has_value());
+	Rank = Ranks.Rank("a", true);
+	ASSERT_TRUE(Rank.has_value());
+	EXPECT_EQ(Rank->m_Rank, 1);
+
+	CMapRanks::CEntry aEntries[5];
+	int aRanks[5];
+	ASSERT_EQ(Ranks.Top(1, false, aEntries, aRanks, 5), 4);
+	EXPECT_STREQ(aEntries[0].m_aName, "a");
+	EXPECT_STREQ(aEntries[2].m_aName, "c");
+	EXPECT_EQ(aRanks[0], 1);
+	EXPECT_EQ(aRanks[1], 2);
+	EXPECT_EQ(aRanks[2], 2);
+	EXPECT_EQ(aRanks[3], 4);
+	ASSERT_EQ(Ranks.Top(-2, false, aEntries, aRanks, 5), 3);
+	EXPECT_STREQ(aEntries[0].m_aName, "c");
+	EXPECT_EQ(aRanks[0], 2);
+	EXPECT_EQ(aRanks[2], 1);
+	EXPECT_EQ(Ranks.Top(5, false, aEntries, aRanks, 5), 0);
+}
+
+static void RemoveSqliteFile(const char *pFilename)
+{
+	char aBuf[IO_MAX_PATH_LENGTH];
+	fs_remove(pFilename);
+	str_format(aBuf, sizeof(aBuf), "%s-wal", pFilename);
+	fs_remove(aBuf);
+	str_format(aBuf, sizeof(aBuf), "%s-shm", pFilename);
+	fs_remove(aBuf);
+}
+
+// restores the config the tests change
+struct SqlitePool : public testing::Test
+{
+	void SetUp() override
+	{
+		m_SqlReadWorkers = g_Config.m_SvSqlReadWorkers;
+	}
+
+	void TearDown() override
+	{
+		g_Config.m_SvSqlReadWorkers = m_SqlReadWorkers;
+	}
+
+	int m_SqlReadWorkers = 0;
+};
+
+TEST_F(SqlitePool, BatchedWrites)
+{
+	CTestInfo Info;
+	char aWriteFilename[64];
+	Info.Filename(aWriteFilename, sizeof(aWriteFilename), ".sqlite");
+	char aBackupFilename[64];
+	Info.Filename(aBackupFilename, sizeof(aBackupFilename), "-backup.sqlite");
+
+	char aError[256] = {};
+	// create the tables up front, the connections of the pool would race setting them up
+	for(const char *pFilename : {aWriteFilename, aBackupFilename})
+	{
+		auto pConn = CreateSqliteConnection(pFilename, true);
+		ASSERT_TRUE(pConn->Connect(aError, sizeof(aError))) << aError;
+		pConn->Disconnect();
+	}
+
+	const int NumWrites = 100;
+	std::vector<std::shared_ptr<CScorePlayerResult>> vpResults;
+	{
+		CDbConnectionPool Pool;
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, aWriteFilename);
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE_BACKUP, aBackupFilename);
+		for(int i = 0; i < NumWrites; i++)
+		{
+			vpResults.push_back(std::make_shared<CScorePlayerResult>());
+			auto pScoreData = std::make_unique<CSqlScoreData>(vpResults.back());
+			str_copy(pScoreData->m_aMap, "Kobra 3");
+			str_copy(pScoreData->m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320");
+			str_format(pScoreData->m_aName, sizeof(pScoreData->m_aName), "tee %d", i);
+			pScoreData->m_Time = 100.0f + i;
+			std::fill(std::begin(pScoreData->m_aCurrentTimeCp), std::end(pScoreData->m_aCurrentTimeCp), 0.0f);
+			str_copy(pScoreData->m_aTimestamp, "2021-11-24 19:24:08");
+			Pool.ExecuteWrite(CScoreWorker::SaveScore, std::move(pScoreData), "save score");
+		}
+		// the writes would go to the backup database during shutdown
+		for(const auto &pResult : vpResults)
+		{
+			while(!pResult->m_Completed.load())
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			EXPECT_TRUE(pResult->m_Success);
+		}
+		// the writes were queued faster than they were executed, so several were committed together
+		const CDbConnectionPool::CWriteStats Stats = Pool.WriteStats();
+		EXPECT_GE(Stats.m_NumTransactions, 1);
+		EXPECT_EQ(Stats.m_NumFailedTransactions, 0);
+		EXPECT_LE(Stats.m_NumBatchedWrites, NumWrites);
+		EXPECT_GE(Stats.m_NumBatchedWrites, NumWrites / 2);
+		EXPECT_GE(Stats.m_NumBatchedWrites, 2 * Stats.m_NumTransactions);
+	}
+
+	const auto &&Count = [&](IDbConnection *pConn, const char *pTable) {
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "SELECT COUNT(*) FROM %s", pTable);
+		EXPECT_TRUE(pConn->PrepareStatement(aBuf, aError, sizeof(aError))) << aError;
+		bool End;
+		EXPECT_TRUE(pConn->Step(&End, aError, sizeof(aError))) << aError;
+		return End ? -1 : pConn->GetInt(1);
+	};
+	auto pWrite = CreateSqliteConnection(aWriteFilename, false);
+	ASSERT_TRUE(pWrite->Connect(aError, sizeof(aError))) << aError;
+	EXPECT_EQ(Count(pWrite.get(), "record_race"), NumWrites);
+	pWrite->Disconnect();
+	auto pBackup = CreateSqliteConnection(aBackupFilename, false);
+	ASSERT_TRUE(pBackup->Connect(aError, sizeof(aError))) << aError;
+	EXPECT_EQ(Count(pBackup.get(), "record_race_backup"), 0);
+	EXPECT_EQ(Count(pBackup.get(), "record_race"), 0);
+	pBackup->Disconnect();
+
+	pWrite = nullptr;
+	pBackup = nullptr;
+	RemoveSqliteFile(aWriteFilename);
+	RemoveSqliteFile(aBackupFilename);
+}
+
+TEST_F(SqlitePool, ConcurrentReads)
+{
+	CTestInfo Info;
+	char aFilename[64];
+	Info.Filename(aFilename, sizeof(aFilename), ".sqlite");
+
+	char aError[256] = {};
+	{
+		auto pConn = CreateSqliteConnection(aFilename, true);
+		ASSERT_TRUE(pConn->Connect(aError, sizeof(aError))) << aError;
+		CSqlScoreData ScoreData(std::make_shared<CScorePlayerResult>());
+		str_copy(ScoreData.m_aMap, "Kobra 3");
+		str_copy(ScoreData.m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320");
+		str_copy(ScoreData.m_aName, "nameless tee");
+		ScoreData.m_Time = 100.0f;
+		std::fill(std::begin(ScoreData.m_aCurrentTimeCp), std::end(ScoreData.m_aCurrentTimeCp), 0.0f);
+		str_copy(ScoreData.m_aTimestamp, "2021-11-24 19:24:08");
+		ASSERT_TRUE(CScoreWorker::SaveScore(pConn.get(), &ScoreData, Write::NORMAL, aError, sizeof(aError))) << aError;
+		pConn->Disconnect();
+	}
+
+	g_Config.m_SvSqlReadWorkers = 4;
+	const int NumQueries = 64;
+	std::vector<std::shared_ptr<CScorePlayerResult>> vpReadResults;
+	std::vector<std::shared_ptr<CScorePlayerResult>> vpWriteResults;
+	{
+		CDbConnectionPool Pool;
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::READ, aFilename);
+		Pool.RegisterSqliteDatabase(CDbConnectionPool::WRITE, aFilename);
+		for(int i = 0; i < NumQueries; i++)
+		{
+			vpReadResults.push_back(std::make_shared<CScorePlayerResult>());
+			auto pRequest = std::make_unique<CSqlPlayerRequest>(vpReadResults.back());
+			str_copy(pRequest->m_aName, "nameless tee");
+			str_copy(pRequest->m_aMap, "Kobra 3");
+			str_copy(pRequest->m_aRequestingPlayer, "brainless tee");
+			pRequest->m_Offset = 0;
+			str_copy(pRequest->m_aServer, "GER");
+			Pool.Execute(CScoreWorker::ShowRank, std::move(pRequest), "show rank");
+
+			// the reads run next to the writes, which are still done in order
+			vpWriteResults.push_back(std::make_shared<CScorePlayerResult>());
+			auto pScoreData = std::make_unique<CSqlScoreData>(vpWriteResults.back());
+			str_copy(pScoreData->m_aMap, "Kobra 3");
+			str_copy(pScoreData->m_aGameUuid, "8d300ecf-5873-4297-bee5-95668fdff320");
+			str_format(pScoreData->m_aName, sizeof(pScoreData->m_aName), "tee %d", i);
+			pScoreData->m_Time = 200.0f + i;
+			std::fill(std::begin(pScoreData->m_aCurrentTimeCp), std::end(pScoreData->m_aCurrentTimeCp), 0.0f);
+			str_copy(pScoreData->m_aTimestamp, "2021-11-24 19:24:08");
+			Pool.ExecuteWrite(CScoreWorker::SaveScore, std::move(pScoreData), "save score");
+		}
+		// the reads would be dismissed during shutdown
+		for(const auto &vpResults : {vpReadResults, vpWriteResults})
+		{
+			for(const auto &pResult : vpResults)
+			{
+				while(!pResult->m_Completed.load())
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				EXPECT_TRUE(pResult->m_Success);
+			}
+		}
+	}
+	for(const auto &pResult : vpReadResults)
+	{
+		EXPECT_EQ(pResult->m_MessageKind, CScorePlayerResult::ALL);
+		EXPECT_TRUE(str_startswith(pResult->m_Data.m_aaMessages[0], "nameless tee - 01:40.00 - better than ")) << pResult->m_Data.m_aaMessages[0];
+	}
+	RemoveSqliteFile(aFilename);
+}
+
 auto g_pSqliteConn = CreateSqliteConnection(":memory:", true);
 #if defined(CONF_TEST_MYSQL)
 CMysqlConfig gMysqlConfig{
@@ -663,3 +1032,5 @@ INSTANTIATE(MapInfo);
 INSTANTIATE(MapVote);
 INSTANTIATE(Points);
 INSTANTIATE(RandomMap);
+INSTANTIATE(Transaction);
+INSTANTIATE(MapRanks);
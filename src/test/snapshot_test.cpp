@@ -1,7 +1,11 @@
+#include <base/math.h>
 #include <base/system.h>
 
+#include <engine/shared/simd.h>
 #include <engine/shared/snapshot.h>
 
+#include <game/prng.h>
+
 #include <generated/protocol.h>
 
 #include <gtest/gtest.h>
@@ -85,3 +89,247 @@ TEST(Snapshot, CrcOverflow)
 
 	ASSERT_EQ(pSnapshot->Crc(), 1);
 }
+
+TEST(Snapshot, KeyIndexMatchesLinearSearch)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+
+	// insert items out of key order
+	for(int Id = 63; Id >= 0; Id--)
+	{
+		CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, Id * 7 % 64, sizeof(CNetObj_Flag)));
+		ASSERT_TRUE(pFlag);
+		pFlag->m_X = Id;
+	}
+	for(int Id = 0; Id < 32; Id++)
+	{
+		ASSERT_TRUE(Builder.NewItem(CNetObj_Pickup::ms_MsgId, Id * 3, sizeof(CNetObj_Pickup)));
+	}
+	ASSERT_TRUE(Builder.NewItem(CNetObj_MyOwnObject::ms_MsgId, 5, sizeof(CNetObj_MyOwnObject)));
+
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	Builder.Finish(pSnapshot);
+
+	CSnapshotKeyIndex KeyIndex;
+	KeyIndex.Build(pSnapshot);
+
+	for(int Type : {(int)CNetObj_Flag::ms_MsgId, (int)CNetObj_Pickup::ms_MsgId, (int)CNetObj_Laser::ms_MsgId})
+	{
+		for(int Id = 0; Id < 128; Id++)
+		{
+			EXPECT_EQ(pSnapshot->FindItem(Type, Id), pSnapshot->FindItem(Type, Id, KeyIndex));
+		}
+	}
+	EXPECT_NE(pSnapshot->FindItem(CNetObj_MyOwnObject::ms_MsgId, 5, KeyIndex), nullptr);
+	EXPECT_EQ(pSnapshot->FindItem(CNetObj_MyOwnObject::ms_MsgId, 5), pSnapshot->FindItem(CNetObj_MyOwnObject::ms_MsgId, 5, KeyIndex));
+	EXPECT_EQ(pSnapshot->FindItem(CNetObj_MyOwnObject::ms_MsgId, 6, KeyIndex), nullptr);
+	EXPECT_EQ(pSnapshot->FindItem(CNetObj_DDNetCharacter::ms_MsgId, 5, KeyIndex), nullptr);
+
+	for(int i = 0; i < pSnapshot->NumItems(); i++)
+	{
+		EXPECT_EQ(pSnapshot->GetItemType(i), pSnapshot->GetItemType(i, KeyIndex));
+	}
+}
+
+TEST(SnapshotDelta, UnpackDeltaRoundTrip)
+{
+	CSnapshotBuilder Builder;
+	char aFrom[CSnapshot::MAX_SIZE];
+	char aTo[CSnapshot::MAX_SIZE];
+	char aUnpacked[CSnapshot::MAX_SIZE];
+	char aDelta[CSnapshot::MAX_SIZE];
+	CSnapshot *pFrom = (CSnapshot *)aFrom;
+	CSnapshot *pTo = (CSnapshot *)aTo;
+	CSnapshot *pUnpacked = (CSnapshot *)aUnpacked;
+
+	Builder.Init();
+	for(int Id = 0; Id < 100; Id++)
+	{
+		CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, Id, sizeof(CNetObj_Flag)));
+		ASSERT_TRUE(pFlag);
+		pFlag->m_X = Id;
+		pFlag->m_Y = -Id;
+	}
+	Builder.Finish(pFrom);
+
+	Builder.Init();
+	for(int Id = 200; Id >= 50; Id--)
+	{
+		CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, Id, sizeof(CNetObj_Flag)));
+		ASSERT_TRUE(pFlag);
+		pFlag->m_X = Id % 3 == 0 ? Id : Id * 11;
+		pFlag->m_Y = -Id;
+		pFlag->m_Team = Id % 2;
+	}
+	const int ToSize = Builder.Finish(pTo);
+
+	CSnapshotDelta Delta;
+	const int DeltaSize = Delta.CreateDelta(pFrom, pTo, aDelta);
+	ASSERT_GT(DeltaSize, 0);
+	const int UnpackedSize = Delta.UnpackDelta(pFrom, pUnpacked, aDelta, DeltaSize, false);
+	ASSERT_EQ(UnpackedSize, ToSize);
+	EXPECT_EQ(pUnpacked->Crc(), pTo->Crc());
+	for(int Id = 0; Id <= 200; Id++)
+	{
+		const void *pExpected = pTo->FindItem(CNetObj_Flag::ms_MsgId, Id);
+		const void *pActual = pUnpacked->FindItem(CNetObj_Flag::ms_MsgId, Id);
+		ASSERT_EQ(pExpected == nullptr, pActual == nullptr);
+		if(pExpected)
+		{
+			EXPECT_EQ(mem_comp(pExpected, pActual, sizeof(CNetObj_Flag)), 0);
+		}
+	}
+}
+
+static int AddStorageSnapshot(CSnapshotStorage &Storage, int Tick, int NumItems, bool Alt)
+{
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	for(int Id = 0; Id < NumItems; Id++)
+	{
+		CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, Id, sizeof(CNetObj_Flag)));
+		pFlag->m_X = Tick;
+		pFlag->m_Y = Id;
+	}
+	char aData[CSnapshot::MAX_SIZE];
+	const int Size = Builder.Finish(aData);
+	Storage.Add(Tick, Tick * 10, Size, aData, Alt ? Size : 0, Alt ? aData : nullptr);
+	return Size;
+}
+
+TEST(SnapshotStorage, AddGetPurge)
+{
+	CSnapshotStorage Storage;
+	EXPECT_EQ(Storage.Get(0, nullptr, nullptr, nullptr), -1);
+
+	// large snapshots wrap around the arena and partially spill to the heap
+	for(int Tick = 0; Tick < 1000; Tick += 2)
+	{
+		const int NumItems = 1 + (Tick * 37) % 1000;
+		const int Size = AddStorageSnapshot(Storage, Tick, NumItems, Tick % 4 == 0);
+		Storage.PurgeUntil(Tick - 150);
+
+		const CSnapshot *pSnap;
+		const CSnapshot *pAltSnap;
+		int64_t Tagtime;
+		ASSERT_EQ(Storage.Get(Tick, &Tagtime, &pSnap, &pAltSnap), Size);
+		EXPECT_EQ(Tagtime, Tick * 10);
+		EXPECT_EQ(pSnap->NumItems(), NumItems);
+		EXPECT_EQ(pAltSnap != nullptr, Tick % 4 == 0);
+		EXPECT_EQ(Storage.Get(Tick + 1, nullptr, nullptr, nullptr), -1);
+
+		for(int PastTick = maximum(0, Tick - 150); PastTick <= Tick; PastTick += 2)
+		{
+			ASSERT_GE(Storage.Get(PastTick, nullptr, &pSnap, nullptr), 0);
+			const CNetObj_Flag *pFlag = static_cast<const CNetObj_Flag *>(pSnap->FindItem(CNetObj_Flag::ms_MsgId, 0));
+			ASSERT_TRUE(pFlag);
+			EXPECT_EQ(pFlag->m_X, PastTick);
+		}
+		EXPECT_EQ(Storage.Get(Tick - 152, nullptr, nullptr, nullptr), -1);
+	}
+
+	Storage.PurgeAll();
+	EXPECT_EQ(Storage.m_pFirst, nullptr);
+	EXPECT_EQ(Storage.m_pLast, nullptr);
+	EXPECT_EQ(Storage.Get(998, nullptr, nullptr, nullptr), -1);
+}
+
+TEST(SnapshotStorage, ArenaGrowsOnDemand)
+{
+	CSnapshotStorage Storage;
+	EXPECT_EQ(Storage.ArenaSize(), 0);
+
+	// small snapshots fit into the smallest arena
+	for(int Tick = 0; Tick < 100; Tick++)
+	{
+		AddStorageSnapshot(Storage, Tick, 4, false);
+		Storage.PurgeUntil(Tick - 10);
+	}
+	EXPECT_EQ(Storage.ArenaSize(), (int)CSnapshotStorage::MIN_ARENA_SIZE);
+
+	// larger snapshots spill to the heap until the arena has grown enough
+	for(int Tick = 100; Tick < 300; Tick++)
+	{
+		AddStorageSnapshot(Storage, Tick, 500, Tick % 2 == 0);
+		Storage.PurgeUntil(Tick - 10);
+		ASSERT_GE(Storage.Get(Tick - 10, nullptr, nullptr, nullptr), 0);
+	}
+	const int GrownSize = Storage.ArenaSize();
+	EXPECT_GT(GrownSize, (int)CSnapshotStorage::MIN_ARENA_SIZE);
+	EXPECT_LE(GrownSize, (int)CSnapshotStorage::MAX_ARENA_SIZE);
+
+	// the arena does not grow further once the snapshots fit
+	for(int Tick = 300; Tick < 500; Tick++)
+	{
+		AddStorageSnapshot(Storage, Tick, 500, Tick % 2 == 0);
+		Storage.PurgeUntil(Tick - 10);
+	}
+	EXPECT_EQ(Storage.ArenaSize(), GrownSize);
+}
+
+TEST(SnapshotStorage, SparseTicks)
+{
+	CSnapshotStorage Storage;
+	for(int Tick = 0; Tick < 2000; Tick += 100)
+		AddStorageSnapshot(Storage, Tick, 4, false);
+	for(int Tick = 0; Tick < 2000; Tick++)
+		EXPECT_EQ(Storage.Get(Tick, nullptr, nullptr, nullptr) >= 0, Tick % 100 == 0);
+}
+
+TEST(SnapshotDelta, SimdDiffMatchesScalar)
+{
+	CPrng Prng;
+	uint64_t aSeed[2] = {3, 4};
+	Prng.Seed(aSeed);
+	const CSimd::ELevel OldLevel = CSimd::Level();
+
+	int aPast[100];
+	int aCurrent[100];
+	for(int Size = 0; Size <= 100; Size++)
+	{
+		for(int i = 0; i < Size; i++)
+		{
+			aPast[i] = Prng.RandomBits();
+			// most ints of an item do not change between snapshots
+			switch(Prng.RandomBits() % 4)
+			{
+			case 0: aCurrent[i] = Prng.RandomBits(); break;
+			case 1: aCurrent[i] = aPast[i] + (int)(Prng.RandomBits() % 256) - 128; break;
+			default: aCurrent[i] = aPast[i];
+			}
+		}
+		// an item with a single changed int
+		if(Size > 0 && Prng.RandomBits() % 2)
+		{
+			mem_copy(aCurrent, aPast, Size * sizeof(int));
+			aCurrent[Prng.RandomBits() % Size] ^= 1;
+		}
+
+		ASSERT_TRUE(CSimd::SetLevel(CSimd::LEVEL_SCALAR));
+		int aExpectedDiff[100];
+		int aExpectedUndiff[100];
+		uint64_t ExpectedDataRate = 0;
+		const int ExpectedNeeded = CSnapshotDelta::DiffItem(aPast, aCurrent, aExpectedDiff, Size);
+		CSnapshotDelta::UndiffItem(aPast, aExpectedDiff, aExpectedUndiff, Size, &ExpectedDataRate);
+		ASSERT_EQ(mem_comp(aExpectedUndiff, aCurrent, Size * sizeof(int)), 0);
+
+		for(int Level = CSimd::LEVEL_SSE2; Level <= CSimd::LEVEL_NEON; Level++)
+		{
+			if(!CSimd::SetLevel((CSimd::ELevel)Level))
+				continue;
+
+			int aDiff[100];
+			int aUndiff[100];
+			uint64_t DataRate = 0;
+			EXPECT_EQ(CSnapshotDelta::DiffItem(aPast, aCurrent, aDiff, Size), ExpectedNeeded) << CSimd::LevelName((CSimd::ELevel)Level);
+			EXPECT_EQ(mem_comp(aDiff, aExpectedDiff, Size * sizeof(int)), 0) << CSimd::LevelName((CSimd::ELevel)Level);
+			CSnapshotDelta::UndiffItem(aPast, aDiff, aUndiff, Size, &DataRate);
+			EXPECT_EQ(mem_comp(aUndiff, aCurrent, Size * sizeof(int)), 0) << CSimd::LevelName((CSimd::ELevel)Level);
+			EXPECT_EQ(DataRate, ExpectedDataRate) << CSimd::LevelName((CSimd::ELevel)Level);
+		}
+	}
+
+	CSimd::SetLevel(OldLevel);
+}
@@ -0,0 +1,175 @@
+#include <base/system.h>
+
+#include <game/server/teams.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+// the logic of `CGameTeams::TeamMask` before the visibility was precomputed
+static CClientMask ReferenceTeamMask(const CTeamVisibility::CClientState *pClients, int Team, int ExceptId, int Asker, int VersionFlags)
+{
+	if(Team == TEAM_SUPER)
+	{
+		if(ExceptId == -1)
+			return CClientMask().set();
+		return CClientMask().set().reset(ExceptId);
+	}
+
+	const auto &&Alive = [&](int ClientId) {
+		return ClientId >= 0 && ClientId < MAX_CLIENTS && pClients[ClientId].m_Exists && pClients[ClientId].m_Alive;
+	};
+	const auto &&Solo = [&](int ClientId) {
+		return ClientId >= 0 && ClientId < MAX_CLIENTS && pClients[ClientId].m_Solo;
+	};
+
+	CClientMask Mask;
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		const CTeamVisibility::CClientState &Client = pClients[i];
+		if(i == ExceptId)
+			continue;
+		if(!Client.m_Exists)
+			continue;
+		if(!((Client.m_Sixup && (VersionFlags & CGameContext::FLAG_SIXUP)) ||
+			   (!Client.m_Sixup && (VersionFlags & CGameContext::FLAG_SIX))))
+			continue;
+
+		if(!Client.m_Spectating)
+		{
+			if(i != Asker)
+			{
+				if(!Alive(i))
+					continue;
+				if(Client.m_ShowOthers == SHOW_OTHERS_ONLY_TEAM)
+				{
+					if(Client.m_Team != Team && Client.m_Team != TEAM_SUPER)
+						continue;
+				}
+				else if(Client.m_ShowOthers == SHOW_OTHERS_OFF)
+				{
+					if(Solo(Asker))
+						continue;
+					if(Solo(i))
+						continue;
+					if(Client.m_Team != Team && Client.m_Team != TEAM_SUPER)
+						continue;
+				}
+			}
+		}
+		else if(Client.m_SpectatorId != SPEC_FREEVIEW)
+		{
+			const int SpectatorId = Client.m_SpectatorId;
+			if(SpectatorId != Asker)
+			{
+				if(!Alive(SpectatorId))
+					continue;
+				if(Client.m_ShowOthers == SHOW_OTHERS_ONLY_TEAM)
+				{
+					if(pClients[SpectatorId].m_Team != Team && pClients[SpectatorId].m_Team != TEAM_SUPER)
+						continue;
+				}
+				else if(Client.m_ShowOthers == SHOW_OTHERS_OFF)
+				{
+					if(Solo(Asker))
+						continue;
+					if(Solo(SpectatorId))
+						continue;
+					if(pClients[SpectatorId].m_Team != Team && pClients[SpectatorId].m_Team != TEAM_SUPER)
+						continue;
+				}
+			}
+		}
+		else
+		{
+			if(Client.m_SpecTeam)
+			{
+				if(Client.m_Team != Team && Client.m_Team != TEAM_SUPER)
+					continue;
+			}
+		}
+
+		Mask.set(i);
+	}
+	return Mask;
+}
+
+static void RandomClientStates(std::mt19937 &Random, CTeamVisibility::CClientState *pClients)
+{
+	// few teams, so that clients often share them
+	const int aTeams[] = {TEAM_FLOCK, 1, 2, 3, TEAM_SUPER};
+	const int aShowOthers[] = {SHOW_OTHERS_OFF, SHOW_OTHERS_ON, SHOW_OTHERS_ONLY_TEAM};
+	std::uniform_int_distribution<int> Percent(0, 99);
+	std::uniform_int_distribution<int> ClientId(0, MAX_CLIENTS - 1);
+	for(int i = 0; i < MAX_CLIENTS; ++i)
+	{
+		CTeamVisibility::CClientState &Client = pClients[i];
+		Client = CTeamVisibility::CClientState();
+		Client.m_Team = aTeams[Random() % std::size(aTeams)];
+		Client.m_Solo = Percent(Random) < 20;
+		Client.m_Exists = Percent(Random) < 80;
+		if(!Client.m_Exists)
+			continue;
+		Client.m_Sixup = Percent(Random) < 30;
+		Client.m_Spectating = Percent(Random) < 30;
+		Client.m_SpectatorId = Percent(Random) < 50 ? SPEC_FREEVIEW : ClientId(Random);
+		Client.m_SpecTeam = Percent(Random) < 50;
+		Client.m_ShowOthers = aShowOthers[Random() % std::size(aShowOthers)];
+		Client.m_Alive = Percent(Random) < 70;
+	}
+}
+
+TEST(TeamVisibility, Empty)
+{
+	CTeamVisibility::CClientState aClients[MAX_CLIENTS];
+	CTeamVisibility Visibility;
+	Visibility.Update(aClients);
+	EXPECT_TRUE(Visibility.TeamMask(TEAM_FLOCK, -1, -1, CGameContext::FLAG_SIX | CGameContext::FLAG_SIXUP).none());
+	EXPECT_TRUE(Visibility.TeamMask(TEAM_SUPER, -1, -1, CGameContext::FLAG_SIX).all());
+	EXPECT_EQ(Visibility.TeamMask(TEAM_SUPER, 5, -1, CGameContext::FLAG_SIX), CClientMask().set().reset(5));
+}
+
+TEST(TeamVisibility, SeeOwnEvents)
+{
+	CTeamVisibility::CClientState aClients[MAX_CLIENTS];
+	// dead and solo, with other players hidden
+	aClients[3].m_Exists = true;
+	aClients[3].m_Solo = true;
+	aClients[3].m_Team = 2;
+	// spectating that player
+	aClients[7].m_Exists = true;
+	aClients[7].m_Sixup = true;
+	aClients[7].m_Spectating = true;
+	aClients[7].m_SpectatorId = 3;
+
+	CTeamVisibility Visibility;
+	Visibility.Update(aClients);
+	EXPECT_EQ(Visibility.TeamMask(TEAM_FLOCK, -1, 3, CGameContext::FLAG_SIX | CGameContext::FLAG_SIXUP), CClientMask().set(3).set(7));
+	EXPECT_EQ(Visibility.TeamMask(TEAM_FLOCK, 3, 3, CGameContext::FLAG_SIXUP), CClientMask().set(7));
+	EXPECT_TRUE(Visibility.TeamMask(2, -1, -1, CGameContext::FLAG_SIX | CGameContext::FLAG_SIXUP).none());
+}
+
+TEST(TeamVisibility, Random)
+{
+	std::mt19937 Random(1337);
+	const int aTeams[] = {-1, TEAM_FLOCK, 1, 2, 3, 4, TEAM_SUPER};
+	const int aVersionFlags[] = {CGameContext::FLAG_SIX, CGameContext::FLAG_SIXUP, CGameContext::FLAG_SIX | CGameContext::FLAG_SIXUP};
+	std::uniform_int_distribution<int> ClientIdOrNone(-1, MAX_CLIENTS - 1);
+
+	CTeamVisibility::CClientState aClients[MAX_CLIENTS];
+	CTeamVisibility Visibility;
+	for(int State = 0; State < 200; ++State)
+	{
+		RandomClientStates(Random, aClients);
+		Visibility.Update(aClients);
+		for(int Query = 0; Query < 200; ++Query)
+		{
+			const int Team = aTeams[Random() % std::size(aTeams)];
+			const int ExceptId = ClientIdOrNone(Random);
+			const int Asker = ClientIdOrNone(Random);
+			const int VersionFlags = aVersionFlags[Random() % std::size(aVersionFlags)];
+			ASSERT_EQ(Visibility.TeamMask(Team, ExceptId, Asker, VersionFlags), ReferenceTeamMask(aClients, Team, ExceptId, Asker, VersionFlags))
+				<< "State=" << State << " Team=" << Team << " ExceptId=" << ExceptId << " Asker=" << Asker << " VersionFlags=" << VersionFlags;
+		}
+	}
+}
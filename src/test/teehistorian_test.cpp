@@ -1,18 +1,95 @@
+#include "test.h"
+
 #include <base/detect.h>
 
 #include <engine/external/json-parser/json.h>
 #include <engine/server.h>
 #include <engine/shared/config.h>
+#include <engine/shared/gzip_frame_writer.h>
 
 #include <game/gamecore.h>
+#include <game/prng.h>
 #include <game/server/teehistorian.h>
 
 #include <gtest/gtest.h>
 
+#include <zlib.h>
+
+#include <memory>
 #include <vector>
 
 void RegisterGameUuids(CUuidManager *pManager);
 
+static std::vector<unsigned char> ReadAll(const char *pFilename)
+{
+	std::vector<unsigned char> vData;
+	IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+	if(!File)
+		return vData;
+	void *pData;
+	unsigned Size;
+	io_read_all(File, &pData, &Size);
+	io_close(File);
+	vData.assign((unsigned char *)pData, (unsigned char *)pData + Size);
+	free(pData);
+	return vData;
+}
+
+// decompresses the file like gzip does, reading all members
+static std::vector<unsigned char> GzipDecompress(const std::vector<unsigned char> &vCompressed)
+{
+	std::vector<unsigned char> vData;
+	z_stream Stream = {};
+	EXPECT_EQ(inflateInit2(&Stream, 16 + MAX_WBITS), Z_OK);
+	Stream.next_in = (Bytef *)vCompressed.data();
+	Stream.avail_in = vCompressed.size();
+	unsigned char aBuffer[4096];
+	while(Stream.avail_in > 0)
+	{
+		Stream.next_out = aBuffer;
+		Stream.avail_out = sizeof(aBuffer);
+		const int Result = inflate(&Stream, Z_NO_FLUSH);
+		vData.insert(vData.end(), aBuffer, aBuffer + sizeof(aBuffer) - Stream.avail_out);
+		if(Result == Z_STREAM_END)
+			inflateReset(&Stream);
+		else if(Result != Z_OK)
+		{
+			ADD_FAILURE() << "inflate failed: " << Result;
+			break;
+		}
+	}
+	inflateEnd(&Stream);
+	return vData;
+}
+
+// walks the members using the sizes and offsets in their extra fields
+static void ExpectFrames(const std::vector<unsigned char> &vCompressed, size_t DecompressedSize)
+{
+	const auto &LittleEndian = [&](size_t Pos, int Size) {
+		uint64_t Value = 0;
+		for(int i = Size - 1; i >= 0; i--)
+			Value = (Value << 8) | vCompressed[Pos + i];
+		return Value;
+	};
+	size_t Pos = 0;
+	uint64_t Offset = 0;
+	while(Pos < vCompressed.size())
+	{
+		ASSERT_LE(Pos + 28, vCompressed.size());
+		EXPECT_EQ(vCompressed[Pos], 0x1f);
+		EXPECT_EQ(vCompressed[Pos + 1], 0x8b);
+		EXPECT_EQ(vCompressed[Pos + 3], 4);
+		EXPECT_EQ(vCompressed[Pos + 12], 'T');
+		EXPECT_EQ(vCompressed[Pos + 13], 'H');
+		EXPECT_EQ(LittleEndian(Pos + 20, 8), Offset);
+		const uint64_t MemberSize = LittleEndian(Pos + 16, 4);
+		ASSERT_LE(Pos + MemberSize, vCompressed.size());
+		Offset += LittleEndian(Pos + MemberSize - 4, 4);
+		Pos += MemberSize;
+	}
+	EXPECT_EQ(Offset, DecompressedSize);
+}
+
 class TeeHistorian : public ::testing::Test
 {
 protected:
@@ -24,6 +101,11 @@ protected:
 
 	std::vector<unsigned char> m_vBuffer;
 
+	// everything is also written compressed, which must result in the same data
+	CTestInfo m_TestInfo;
+	char m_aCompressedFilename[IO_MAX_PATH_LENGTH];
+	std::unique_ptr<CGzipFrameWriter> m_pCompressed;
+
 	enum
 	{
 		STATE_NONE,
@@ -78,9 +160,20 @@ protected:
 		m_GameInfo.m_pTuning = &m_Tuning;
 		m_GameInfo.m_pUuids = &m_UuidManager;
 
+		m_TestInfo.Filename(m_aCompressedFilename, sizeof(m_aCompressedFilename), ".teehistorian.gz");
 		Reset(&m_GameInfo);
 	}
 
+	void TearDown() override
+	{
+		m_pCompressed->Close();
+		EXPECT_FALSE(m_pCompressed->Error());
+		const std::vector<unsigned char> vCompressed = ReadAll(m_aCompressedFilename);
+		EXPECT_EQ(GzipDecompress(vCompressed), m_vBuffer);
+		ExpectFrames(vCompressed, m_vBuffer.size());
+		fs_remove(m_aCompressedFilename);
+	}
+
 	static void WriteBuffer(std::vector<unsigned char> &vBuffer, const void *pData, size_t DataSize)
 	{
 		if(DataSize <= 0)
@@ -95,11 +188,15 @@ protected:
 	{
 		TeeHistorian *pThis = (TeeHistorian *)pUser;
 		WriteBuffer(pThis->m_vBuffer, pData, DataSize);
+		pThis->m_pCompressed->Write(pData, DataSize);
 	}
 
 	void Reset(const CTeeHistorian::CGameInfo *pGameInfo)
 	{
 		m_vBuffer.clear();
+		// small frames, so the records are split across them
+		m_pCompressed.reset();
+		m_pCompressed = std::make_unique<CGzipFrameWriter>(io_open(m_aCompressedFilename, IOFLAG_WRITE), 9, 64);
 		m_TH.Reset(pGameInfo, Write, this);
 		m_State = STATE_NONE;
 	}
@@ -107,7 +204,7 @@ protected:
 	void Expect(const unsigned char *pOutput, size_t OutputSize)
 	{
 		static CUuid TEEHISTORIAN_UUID = CalculateUuid("teehistorian@ddnet.tw");
-		static const char PREFIX1[] = "{\"comment\":\"teehistorian@ddnet.tw\",\"version\":\"2\",\"version_minor\":\"17\",\"game_uuid\":\"a1eb7182-796e-3b3e-941d-38ca71b2a4a8\",\"server_version\":\"DDNet test\",\"start_time\":\"";
+		static const char PREFIX1[] = "{\"comment\":\"teehistorian@ddnet.tw\",\"version\":\"2\",\"version_minor\":\"18\",\"game_uuid\":\"a1eb7182-796e-3b3e-941d-38ca71b2a4a8\",\"server_version\":\"DDNet test\",\"start_time\":\"";
 		static const char PREFIX2[] = "\",\"server_name\":\"server name\",\"server_port\":\"8303\",\"game_type\":\"game type\",\"map_name\":\"Kobra 3 Solo\",\"map_size\":\"903514\",\"map_sha256\":\"0123456789012345678901234567890123456789012345678901234567890123\",\"map_crc\":\"eceaf25c\",\"prng_description\":\"test-prng:02468ace\",\"config\":{},\"tuning\":{},\"uuids\":[";
 		static const char PREFIX3[] = "]}";
 
@@ -544,6 +641,33 @@ TEST_F(TeeHistorian, SaveSuccess)
 	Expect(EXPECTED, sizeof(EXPECTED));
 }
 
+TEST_F(TeeHistorian, SaveSuccessBinary)
+{
+	const unsigned char EXPECTED[] = {
+		// EX uuid=a0fb64f8-759e-37c0-b780-47b8d4faa4bc datalen=21
+		0x4a,
+		0xa0, 0xfb, 0x64, 0xf8, 0x75, 0x9e, 0x37, 0xc0,
+		0xb7, 0x80, 0x47, 0xb8, 0xd4, 0xfa, 0xa4, 0xbc,
+		0x15,
+		// team=21
+		0x15,
+		// save_id
+		0xfb, 0x13, 0xa5, 0x76, 0xd3, 0x5f, 0x48, 0x93,
+		0xb8, 0x15, 0xee, 0xdc, 0x6d, 0x98, 0x01, 0x5b,
+		// team_save
+		0x01, 0x02, 0x00, 0x40,
+		// FINISH
+		0x40};
+
+	CUuid SaveId = {
+		0xfb, 0x13, 0xa5, 0x76, 0xd3, 0x5f, 0x48, 0x93,
+		0xb8, 0x15, 0xee, 0xdc, 0x6d, 0x98, 0x01, 0x5b};
+	const unsigned char aTeamSave[] = {0x01, 0x02, 0x00, 0x40};
+	m_TH.RecordTeamSaveSuccessBinary(21, SaveId, aTeamSave, sizeof(aTeamSave));
+	Finish();
+	Expect(EXPECTED, sizeof(EXPECTED));
+}
+
 TEST_F(TeeHistorian, SaveFailed)
 {
 	const unsigned char EXPECTED[] = {
@@ -588,6 +712,33 @@ TEST_F(TeeHistorian, LoadSuccess)
 	Expect(EXPECTED, sizeof(EXPECTED));
 }
 
+TEST_F(TeeHistorian, LoadSuccessBinary)
+{
+	const unsigned char EXPECTED[] = {
+		// EX uuid=fb2cde3c-3a75-34b9-af2c-8f14b2058018 datalen=21
+		0x4a,
+		0xfb, 0x2c, 0xde, 0x3c, 0x3a, 0x75, 0x34, 0xb9,
+		0xaf, 0x2c, 0x8f, 0x14, 0xb2, 0x05, 0x80, 0x18,
+		0x15,
+		// team=21
+		0x15,
+		// save_id
+		0xfb, 0x13, 0xa5, 0x76, 0xd3, 0x5f, 0x48, 0x93,
+		0xb8, 0x15, 0xee, 0xdc, 0x6d, 0x98, 0x01, 0x5b,
+		// team_save
+		0x01, 0x02, 0x00, 0x40,
+		// FINISH
+		0x40};
+
+	CUuid SaveId = {
+		0xfb, 0x13, 0xa5, 0x76, 0xd3, 0x5f, 0x48, 0x93,
+		0xb8, 0x15, 0xee, 0xdc, 0x6d, 0x98, 0x01, 0x5b};
+	const unsigned char aTeamSave[] = {0x01, 0x02, 0x00, 0x40};
+	m_TH.RecordTeamLoadSuccessBinary(21, SaveId, aTeamSave, sizeof(aTeamSave));
+	Finish();
+	Expect(EXPECTED, sizeof(EXPECTED));
+}
+
 TEST_F(TeeHistorian, LoadFailed)
 {
 	const unsigned char EXPECTED[] = {
@@ -906,3 +1057,35 @@ TEST_F(TeeHistorian, PrevGameUuid)
 	EXPECT_STREQ(JsonPrevGameUuid, "fe19c218-f555-4002-a273-126c59ccc17a");
 	json_value_free(pJson);
 }
+
+TEST(TeeHistorianCompression, LargeStream)
+{
+	CTestInfo Info;
+	char aFilename[IO_MAX_PATH_LENGTH];
+	Info.Filename(aFilename, sizeof(aFilename), ".teehistorian.gz");
+
+	// more than fits into the buffer at once, in writes of different sizes
+	CPrng Prng;
+	uint64_t aSeed[2] = {3, 4};
+	Prng.Seed(aSeed);
+	std::vector<unsigned char> vData(3 * CGzipFrameWriter::BUFFER_SIZE);
+	for(size_t i = 0; i < vData.size(); i++)
+		vData[i] = Prng.RandomBits() % 16 + i / 4096;
+
+	CGzipFrameWriter Writer(io_open(aFilename, IOFLAG_WRITE), 1);
+	size_t Pos = 0;
+	while(Pos < vData.size())
+	{
+		const int Size = std::min<size_t>(Prng.RandomBits() % 100000, vData.size() - Pos);
+		Writer.Write(&vData[Pos], Size);
+		Pos += Size;
+	}
+	Writer.Close();
+	EXPECT_FALSE(Writer.Error());
+
+	const std::vector<unsigned char> vCompressed = ReadAll(aFilename);
+	EXPECT_LT(vCompressed.size(), vData.size());
+	EXPECT_EQ(GzipDecompress(vCompressed), vData);
+	ExpectFrames(vCompressed, vData.size());
+	fs_remove(aFilename);
+}
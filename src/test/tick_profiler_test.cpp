@@ -0,0 +1,109 @@
+#include <engine/shared/tick_profiler.h>
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+TEST(TickProfiler, Sections)
+{
+	CTickProfiler Profiler;
+	EXPECT_EQ(Profiler.AddSection("a"), 0);
+	EXPECT_EQ(Profiler.AddSection("b"), 1);
+	EXPECT_EQ(Profiler.AddSection("a"), 0);
+	EXPECT_EQ(Profiler.NumSections(), 2);
+	EXPECT_STREQ(Profiler.SectionName(1), "b");
+
+	char aName[16];
+	for(int i = Profiler.NumSections(); i < CTickProfiler::MAX_SECTIONS; i++)
+	{
+		str_format(aName, sizeof(aName), "%d", i);
+		EXPECT_EQ(Profiler.AddSection(aName), i);
+	}
+	EXPECT_EQ(Profiler.AddSection("full"), -1);
+	Profiler.Add(-1, 1ns);
+}
+
+TEST(TickProfiler, Percentiles)
+{
+	CTickProfiler Profiler;
+	const int Section = Profiler.AddSection("section");
+	const int Unused = Profiler.AddSection("unused");
+	Profiler.SetEnabled(true);
+	for(int i = 100; i >= 1; i--)
+	{
+		// summed up per frame
+		Profiler.Add(Section, std::chrono::nanoseconds(i * 1000 - 1));
+		Profiler.Add(Section, 1ns);
+		Profiler.EndFrame();
+	}
+	// frames in which a section did not run are no samples
+	Profiler.EndFrame();
+	Profiler.Summarize();
+
+	EXPECT_EQ(Profiler.NumFrames(), 101);
+	EXPECT_EQ(Profiler.Stats(Section).m_NumSamples, 100);
+	EXPECT_EQ(Profiler.Stats(Section).m_P50Ns, 50000);
+	EXPECT_EQ(Profiler.Stats(Section).m_P99Ns, 99000);
+	EXPECT_EQ(Profiler.Stats(Section).m_MaxNs, 100000);
+	EXPECT_EQ(Profiler.Stats(Section).m_TotalNs, 5050000);
+	EXPECT_EQ(Profiler.Stats(Unused).m_NumSamples, 0);
+
+	// the next summary only contains the new samples
+	Profiler.Add(Section, 7ns);
+	Profiler.EndFrame();
+	Profiler.Summarize();
+	EXPECT_EQ(Profiler.NumFrames(), 1);
+	EXPECT_EQ(Profiler.Stats(Section).m_NumSamples, 1);
+	EXPECT_EQ(Profiler.Stats(Section).m_P50Ns, 7);
+	EXPECT_EQ(Profiler.Stats(Section).m_P99Ns, 7);
+	EXPECT_EQ(Profiler.Stats(Section).m_MaxNs, 7);
+}
+
+TEST(TickProfiler, Disabled)
+{
+	CTickProfiler Profiler;
+	const int Section = Profiler.AddSection("section");
+	{
+		CTickProfileScope Scope(&Profiler, Section);
+	}
+	Profiler.EndFrame();
+	Profiler.Summarize();
+	EXPECT_EQ(Profiler.NumFrames(), 0);
+	EXPECT_EQ(Profiler.Stats(Section).m_NumSamples, 0);
+
+	Profiler.SetEnabled(true);
+	{
+		CTickProfileScope Scope(&Profiler, Section);
+		Scope.Stop();
+		// stopping again or leaving the scope does not add another sample
+		Scope.Stop();
+	}
+	Profiler.EndFrame();
+	Profiler.Add(Section, 1ns);
+	// disabling discards everything collected so far
+	Profiler.SetEnabled(false);
+	Profiler.SetEnabled(true);
+	Profiler.EndFrame();
+	Profiler.Summarize();
+	EXPECT_EQ(Profiler.NumFrames(), 1);
+	EXPECT_EQ(Profiler.Stats(Section).m_NumSamples, 0);
+}
+
+TEST(TickProfiler, Scope)
+{
+	CTickProfiler Profiler;
+	const int Section = Profiler.AddSection("section");
+	Profiler.SetEnabled(true);
+	{
+		CTickProfileScope Scope(&Profiler, Section);
+		// wait on the clock the scope measures with
+		const std::chrono::nanoseconds Start = time_get_nanoseconds();
+		while(time_get_nanoseconds() - Start < 1ms)
+		{
+		}
+	}
+	Profiler.EndFrame();
+	Profiler.Summarize();
+	EXPECT_EQ(Profiler.Stats(Section).m_NumSamples, 1);
+	EXPECT_GE(Profiler.Stats(Section).m_MaxNs, 1000000);
+}